@@ -0,0 +1,413 @@
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <algorithm>
+#include <vector>
+
+#include "../src/barcode/BarcodeDecoder.h"
+#include "../src/barcode/BarcodeScanner.h"
+#include "../src/barcode/ImagePreprocessor.h"
+#include "synthetic_barcodes.h"
+
+/**
+ * 条码解码基准
+ *
+ * 把语料目录中的图片全部读入内存，然后在单线程中：
+ *   1. 对每个解码阶段单独跑一遍整个语料，输出每秒解码数和漏读率；
+ *   2. 按渐进策略跑一遍，输出每个阶段命中的比例、整体每秒解码数和漏读率；
+ *   3. 用每种可用的指令集跑一遍预处理，输出每秒处理的百万像素数，并检查结果与标量实现一致；
+ * 最后用BarcodeScanner的批量扫描（线程池、缩小加载、渐进解码）扫一遍语料目录，输出识别率、
+ * 正确率、每秒图片数和单张图片耗时（加载+解码）的分位数，可用--json写成JSON文件做回归比较。
+ *
+ * 不指定--corpus时按--seed生成合成标签（EAN-13、UPC-A、Code128，随机尺寸、旋转、模糊和噪声），
+ * 写到--generate目录或临时目录。文件名为<码制>_<序号>_<内容>.<扩展名>，据此核对解码结果。
+ * 需要QGuiApplication，无显示环境下请设置QT_QPA_PLATFORM=offscreen。
+ *
+ *   BarcodeBench --corpus /path/to/labels --symbologies EAN-13,EAN-8,UPC-A,Code128
+ *   BarcodeBench --count 300 --seed 1 --max-rotation 8 --format jpg --json barcode_bench.json
+ */
+
+namespace {
+
+struct StageResult
+{
+    QString name;
+    int images = 0;
+    int hits = 0;
+    double seconds = 0.0;
+};
+
+QList<QImage> loadCorpus(const QString& folderPath, QStringList* names)
+{
+    const QStringList filters = {"*.png", "*.jpg", "*.jpeg", "*.bmp"};
+    QList<QImage> images;
+    for (const QFileInfo& info : QDir(folderPath).entryInfoList(filters, QDir::Files, QDir::Name)) {
+        QImage image(info.absoluteFilePath());
+        if (!image.isNull()) {
+            images.append(image);
+            names->append(info.fileName());
+        }
+    }
+    return images;
+}
+
+// 按码制统计的扫描结果
+struct SymbologyResult
+{
+    int images = 0;
+    int decoded = 0;
+    int correct = 0;
+};
+
+qint64 percentile(std::vector<qint64>& sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// 按种子生成合成标签，三种码制轮流
+bool generateCorpus(const QString& folderPath, int count, quint32 seed, double maxRotation,
+                    const QString& format, QTextStream& out)
+{
+    if (!QDir().mkpath(folderPath)) {
+        out << "cannot create " << folderPath << Qt::endl;
+        return false;
+    }
+
+    QRandomGenerator random(seed);
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < count; ++i) {
+        const auto symbology = static_cast<SyntheticBarcodes::Symbology>(i % SyntheticBarcodes::SymbologyCount);
+        const QString payload = SyntheticBarcodes::randomPayload(symbology, random);
+        const SyntheticBarcodes::LabelStyle style = SyntheticBarcodes::randomStyle(random, maxRotation);
+        const QImage image = SyntheticBarcodes::render(symbology, payload, style, random);
+        const QString fileName = QString("%1_%2_%3.%4")
+                                 .arg(SyntheticBarcodes::filePrefix(symbology))
+                                 .arg(i, 4, 10, QChar('0'))
+                                 .arg(payload, format);
+        if (image.isNull() || !image.save(QDir(folderPath).filePath(fileName), nullptr, 90)) {
+            out << "cannot write " << fileName << Qt::endl;
+            return false;
+        }
+    }
+    out << "generated " << count << " labels in " << folderPath
+        << QString(" (%1 s)\n\n").arg(timer.nsecsElapsed() / 1e9, 0, 'f', 1);
+    return true;
+}
+
+// 从合成标签的文件名取出码制和内容，不是合成标签时返回false
+bool expectedFromFileName(const QString& filePath, SyntheticBarcodes::Symbology* symbology, QString* payload)
+{
+    const QStringList parts = QFileInfo(filePath).completeBaseName().split('_');
+    if (parts.size() != 3) {
+        return false;
+    }
+    *symbology = SyntheticBarcodes::symbologyFromFilePrefix(parts.first());
+    *payload = parts.last();
+    return *symbology != SyntheticBarcodes::SymbologyCount && !payload->isEmpty();
+}
+
+void printRow(QTextStream& out, const StageResult& result)
+{
+    const double missRate = result.images > 0 ? 100.0 * (result.images - result.hits) / result.images : 0.0;
+    out << QString("%1 %2 %3 %4 %5 %6\n")
+           .arg(result.name, -16)
+           .arg(result.images, 7)
+           .arg(result.hits, 7)
+           .arg(missRate, 8, 'f', 1)
+           .arg(result.seconds > 0 ? result.images / result.seconds : 0.0, 10, 'f', 1)
+           .arg(result.images > 0 ? result.seconds * 1000.0 / result.images : 0.0, 9, 'f', 2);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QGuiApplication app(argc, argv);
+    app.setApplicationName("BarcodeBench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Barcode decoding benchmark");
+    parser.addHelpOption();
+    QCommandLineOption corpusOption("corpus", "Folder of barcode images (generated when omitted).", "path");
+    QCommandLineOption symbologiesOption("symbologies", "Store symbologies for the fast stages.", "list",
+                                         "EAN-13,EAN-8,UPC-A,Code128");
+    QCommandLineOption fastPassOption("fast-pass-size", "Maximum image dimension of the fast pass.", "pixels", "1024");
+    QCommandLineOption generateOption("generate", "Write the synthetic labels to this folder.", "path");
+    QCommandLineOption countOption("count", "Number of synthetic labels.", "count", "300");
+    QCommandLineOption seedOption("seed", "Random seed for the synthetic labels.", "seed", "1");
+    QCommandLineOption rotationOption("max-rotation", "Maximum label rotation in degrees.", "degrees", "8");
+    QCommandLineOption formatOption("format", "Image format of the synthetic labels (png or jpg).", "format", "png");
+    QCommandLineOption threadsOption("threads", "Decode threads of the scanner pass.", "count",
+                                     QString::number(QThread::idealThreadCount()));
+    QCommandLineOption jsonOption("json", "Write the scanner pass report to this JSON file.", "file");
+    parser.addOptions({corpusOption, symbologiesOption, fastPassOption, generateOption, countOption, seedOption,
+                       rotationOption, formatOption, threadsOption, jsonOption});
+    parser.process(app);
+
+    QTextStream out(stdout);
+    const QString format = parser.value(formatOption);
+    if (format != "png" && format != "jpg") {
+        out << "invalid format " << format << Qt::endl;
+        return 1;
+    }
+
+    QString corpusPath = parser.value(corpusOption);
+    QTemporaryDir temporaryDir;
+    const bool generated = corpusPath.isEmpty();
+    if (generated) {
+        corpusPath = parser.isSet(generateOption) ? parser.value(generateOption) : temporaryDir.path();
+        if (!generateCorpus(corpusPath, qMax(1, parser.value(countOption).toInt()), parser.value(seedOption).toUInt(),
+                            parser.value(rotationOption).toDouble(), format, out)) {
+            return 1;
+        }
+    }
+
+    BarcodeDecoder decoder;
+    if (!decoder.setSymbologies(parser.value(symbologiesOption))) {
+        out << "invalid symbologies " << parser.value(symbologiesOption) << Qt::endl;
+        return 1;
+    }
+    decoder.setFastPassMaxDimension(parser.value(fastPassOption).toInt());
+
+    QStringList names;
+    const QList<QImage> corpus = loadCorpus(corpusPath, &names);
+    if (corpus.isEmpty()) {
+        out << "no images in " << corpusPath << Qt::endl;
+        return 1;
+    }
+
+    const QString header = QString("%1 %2 %3 %4 %5 %6\n")
+                           .arg("stage", -16).arg("images", 7).arg("hits", 7)
+                           .arg("miss(%)", 8).arg("decodes/s", 10).arg("ms/image", 9);
+
+    // 每个阶段单独跑：衡量该阶段自身的速度和识别率
+    out << "isolated stages\n" << header;
+    QElapsedTimer timer;
+    for (int stage = BarcodeDecoder::FastPass; stage < BarcodeDecoder::StageCount; ++stage) {
+        StageResult result;
+        result.name = BarcodeDecoder::stageName(static_cast<BarcodeDecoder::Stage>(stage));
+        result.images = corpus.size();
+        timer.start();
+        for (const QImage& image : corpus) {
+            if (!decoder.decodeAt(image, static_cast<BarcodeDecoder::Stage>(stage)).isEmpty()) {
+                ++result.hits;
+            }
+        }
+        result.seconds = timer.nsecsElapsed() / 1e9;
+        printRow(out, result);
+        out.flush();
+    }
+
+    // 渐进策略：每张图片在哪个阶段命中
+    std::vector<int> stageHits(BarcodeDecoder::StageCount + 1, 0);
+    StageResult progressive;
+    progressive.name = "progressive";
+    progressive.images = corpus.size();
+    timer.start();
+    for (const QImage& image : corpus) {
+        BarcodeDecoder::Stage stage = BarcodeDecoder::NotFound;
+        decoder.decode(image, &stage);
+        ++stageHits[stage];
+    }
+    progressive.seconds = timer.nsecsElapsed() / 1e9;
+    progressive.hits = corpus.size() - stageHits[BarcodeDecoder::NotFound];
+
+    out << "\nprogressive\n" << header;
+    printRow(out, progressive);
+    for (int stage = BarcodeDecoder::FastPass; stage <= BarcodeDecoder::NotFound; ++stage) {
+        out << QString("  %1 %2 (%3%)\n")
+               .arg(BarcodeDecoder::stageName(static_cast<BarcodeDecoder::Stage>(stage)), -16)
+               .arg(stageHits[stage], 7)
+               .arg(100.0 * stageHits[stage] / corpus.size(), 5, 'f', 1);
+    }
+
+    // 预处理内核：各指令集的吞吐量，结果必须与标量实现逐字节一致
+    out << "\npreprocessing (normalize contrast)\n";
+    out << QString("%1 %2 %3\n").arg("isa", -16).arg("MP/s", 10).arg("matches", 8);
+    qint64 pixels = 0;
+    for (const QImage& image : corpus) {
+        pixels += static_cast<qint64>(image.width()) * image.height();
+    }
+    std::vector<std::vector<uchar>> reference;
+    for (int isa = ImagePreprocessor::Scalar; isa <= ImagePreprocessor::supportedInstructionSet(); ++isa) {
+        ImagePreprocessor preprocessor;
+        preprocessor.setInstructionSet(static_cast<ImagePreprocessor::InstructionSet>(isa));
+        int matches = 0;
+        qint64 nsecs = 0;
+        for (qsizetype i = 0; i < corpus.size(); ++i) {
+            timer.start();
+            const LuminanceImage luminance = preprocessor.process(corpus.at(i));
+            nsecs += timer.nsecsElapsed();
+            const uchar* begin = luminance.data;
+            const uchar* end = begin + static_cast<size_t>(luminance.width) * luminance.height;
+            if (isa == ImagePreprocessor::Scalar) {
+                reference.emplace_back(begin, end);
+                ++matches;
+            } else if (std::equal(begin, end, reference[i].begin(), reference[i].end())) {
+                ++matches;
+            }
+        }
+        const double seconds = nsecs / 1e9;
+        out << QString("%1 %2 %3\n")
+               .arg(ImagePreprocessor::instructionSetName(static_cast<ImagePreprocessor::InstructionSet>(isa)), -16)
+               .arg(seconds > 0 ? pixels / seconds / 1e6 : 0.0, 10, 'f', 1)
+               .arg(QString("%1/%2").arg(matches).arg(corpus.size()), 8);
+        out.flush();
+    }
+
+    // 扫描器批量扫描：从文件加载到解码的完整路径，不使用解码缓存
+    BarcodeScanner scanner;
+    scanner.setSymbologies(parser.value(symbologiesOption));
+    scanner.setFastPassMaxDimension(decoder.fastPassMaxDimension());
+    const int threads = qMax(1, parser.value(threadsOption).toInt());
+    scanner.setMaxDecodeThreads(threads);
+
+    QList<BarcodeScanResult> results;
+    double seconds = 0.0;
+    QString scanError;
+    QEventLoop loop;
+    QObject::connect(&scanner, &BarcodeScanner::folderScanFinished,
+                     [&](const QList<BarcodeScanResult>& finished, double elapsed) {
+        results = finished;
+        seconds = elapsed;
+        loop.quit();
+    });
+    QObject::connect(&scanner, &BarcodeScanner::scannerError, [&](const QString& message) {
+        scanError = message;
+        loop.quit();
+    });
+    if (!scanner.scanImageFromFolder(corpusPath)) {
+        out << "scanner: " << scanError << Qt::endl;
+        return 1;
+    }
+    loop.exec();
+    if (results.isEmpty()) {
+        out << "scanner: " << scanError << Qt::endl;
+        return 1;
+    }
+
+    std::vector<qint64> latencies;
+    latencies.reserve(results.size());
+    std::vector<int> scanStageHits(BarcodeDecoder::StageCount + 1, 0);
+    std::vector<SymbologyResult> bySymbology(SyntheticBarcodes::SymbologyCount);
+    int decoded = 0;
+    int labelled = 0;
+    int correct = 0;
+    for (const BarcodeScanResult& result : results) {
+        latencies.push_back(static_cast<qint64>((result.loadMsecs + result.decodeMsecs) * 1000.0));
+        ++scanStageHits[result.stage];
+        if (result.found()) {
+            ++decoded;
+        }
+
+        SyntheticBarcodes::Symbology symbology;
+        QString expected;
+        if (expectedFromFileName(result.filePath, &symbology, &expected)) {
+            SymbologyResult& bucket = bySymbology[symbology];
+            const bool isCorrect = SyntheticBarcodes::matches(expected, result.barcode);
+            ++labelled;
+            ++bucket.images;
+            bucket.decoded += result.found() ? 1 : 0;
+            bucket.correct += isCorrect ? 1 : 0;
+            correct += isCorrect ? 1 : 0;
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    const int images = results.size();
+    const double decodeRate = 100.0 * decoded / images;
+    const double imagesPerSecond = seconds > 0 ? images / seconds : 0.0;
+    out << QString("\nscanner (%1 threads)\n").arg(threads);
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+           .arg("images", 7).arg("decoded", 8).arg("rate(%)", 8).arg("images/s", 9)
+           .arg("p50(ms)", 8).arg("p95(ms)", 8).arg("p99(ms)", 8).arg("max(ms)", 8);
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+           .arg(images, 7).arg(decoded, 8).arg(decodeRate, 8, 'f', 1).arg(imagesPerSecond, 9, 'f', 1)
+           .arg(percentile(latencies, 0.50) / 1000.0, 8, 'f', 2)
+           .arg(percentile(latencies, 0.95) / 1000.0, 8, 'f', 2)
+           .arg(percentile(latencies, 0.99) / 1000.0, 8, 'f', 2)
+           .arg(latencies.back() / 1000.0, 8, 'f', 2);
+    if (labelled > 0) {
+        out << QString("%1 %2 %3 %4\n").arg("symbology", -16).arg("images", 7).arg("decoded", 8).arg("correct", 8);
+        for (int i = 0; i < SyntheticBarcodes::SymbologyCount; ++i) {
+            const SymbologyResult& bucket = bySymbology[i];
+            out << QString("%1 %2 %3 %4\n")
+                   .arg(SyntheticBarcodes::symbologyName(static_cast<SyntheticBarcodes::Symbology>(i)), -16)
+                   .arg(bucket.images, 7).arg(bucket.decoded, 8).arg(bucket.correct, 8);
+        }
+    }
+    out.flush();
+
+    if (parser.isSet(jsonOption)) {
+        QJsonObject latency;
+        latency["p50"] = percentile(latencies, 0.50) / 1000.0;
+        latency["p95"] = percentile(latencies, 0.95) / 1000.0;
+        latency["p99"] = percentile(latencies, 0.99) / 1000.0;
+        latency["max"] = latencies.back() / 1000.0;
+
+        QJsonObject stages;
+        for (int stage = BarcodeDecoder::FastPass; stage <= BarcodeDecoder::NotFound; ++stage) {
+            stages[BarcodeDecoder::stageName(static_cast<BarcodeDecoder::Stage>(stage))] = scanStageHits[stage];
+        }
+
+        QJsonArray symbologies;
+        for (int i = 0; i < SyntheticBarcodes::SymbologyCount; ++i) {
+            const SymbologyResult& bucket = bySymbology[i];
+            if (bucket.images == 0) {
+                continue;
+            }
+            QJsonObject entry;
+            entry["name"] = SyntheticBarcodes::symbologyName(static_cast<SyntheticBarcodes::Symbology>(i));
+            entry["images"] = bucket.images;
+            entry["decoded"] = bucket.decoded;
+            entry["correct"] = bucket.correct;
+            symbologies.append(entry);
+        }
+
+        QJsonObject report;
+        report["corpus"] = generated && !parser.isSet(generateOption) ? QString("generated") : corpusPath;
+        if (generated) {
+            report["seed"] = parser.value(seedOption).toDouble();
+            report["maxRotation"] = parser.value(rotationOption).toDouble();
+            report["format"] = format;
+        }
+        report["symbologyFilter"] = parser.value(symbologiesOption);
+        report["fastPassSize"] = decoder.fastPassMaxDimension();
+        report["threads"] = threads;
+        report["images"] = images;
+        report["decoded"] = decoded;
+        report["decodeRate"] = decodeRate / 100.0;
+        report["labelled"] = labelled;
+        report["correct"] = correct;
+        report["seconds"] = seconds;
+        report["imagesPerSecond"] = imagesPerSecond;
+        report["latencyMsecs"] = latency;
+        report["stageHits"] = stages;
+        report["symbologies"] = symbologies;
+
+        QFile file(parser.value(jsonOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            out << "cannot write " << file.fileName() << Qt::endl;
+            return 1;
+        }
+        file.write(QJsonDocument(report).toJson());
+        out << "report written to " << file.fileName() << Qt::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,124 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QFileInfo>
+#include <algorithm>
+#include <vector>
+
+#include "../src/receipt/EscPosRenderer.h"
+#include "../src/receipt/ReceiptData.h"
+#include "../src/receipt/ThermalPrintSpooler.h"
+
+/**
+ * @brief ESC/POS热敏小票的基准测试
+ *
+ * 测量把小票快照渲染成ESC/POS字节流的耗时，以及经打印队列写入设备（这里用临时文件代替）
+ * 从入队到首字节写入的延迟。目标：首字节延迟在2毫秒以内。
+ */
+class EscPosBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void render_data();
+    void render();
+
+    void spoolFirstByte_data();
+    void spoolFirstByte();
+};
+
+namespace {
+
+ReceiptData makeReceipt(int lineCount)
+{
+    ReceiptData receipt;
+    receipt.transactionId = 10086;
+    receipt.cashierName = "收银员01";
+    receipt.timestamp = QDateTime(QDate(2024, 6, 1), QTime(12, 30, 0));
+    receipt.paymentMethod = "现金";
+    for (int i = 0; i < lineCount; ++i) {
+        const int quantity = 1 + i % 4;
+        const Money unitPrice = Money::fromMinorUnits(150 + (i % 20) * 135);
+        // 每隔几行放一个超长的商品名，覆盖折行
+        QString name = i % 7 == 0 ? QString("进口特级初榨橄榄油礼盒装（限量版）%1号").arg(i)
+                                  : QString("商品%1").arg(i);
+        receipt.lines.append(ReceiptLine{name, quantity, unitPrice, unitPrice * quantity});
+        receipt.totalAmount += unitPrice * quantity;
+        receipt.totalQuantity += quantity;
+    }
+    receipt.promotionDiscount = Money::fromMinorUnits(500);
+    receipt.finalAmount = receipt.totalAmount - receipt.promotionDiscount;
+    return receipt;
+}
+
+void addReceiptSizes()
+{
+    QTest::addColumn<int>("lineCount");
+    QTest::newRow("lines-10") << 10;
+    QTest::newRow("lines-50") << 50;
+    QTest::newRow("lines-300") << 300;
+}
+
+}
+
+void EscPosBenchmark::render_data()
+{
+    addReceiptSizes();
+}
+
+void EscPosBenchmark::render()
+{
+    QFETCH(int, lineCount);
+    const ReceiptData receipt = makeReceipt(lineCount);
+    EscPosRenderer renderer;
+
+    qsizetype size = 0;
+    QBENCHMARK {
+        size = renderer.render(receipt).size();
+    }
+    QVERIFY(size > lineCount * 2);
+}
+
+void EscPosBenchmark::spoolFirstByte_data()
+{
+    addReceiptSizes();
+}
+
+void EscPosBenchmark::spoolFirstByte()
+{
+    QFETCH(int, lineCount);
+    const ReceiptData receipt = makeReceipt(lineCount);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString devicePath = dir.filePath("printer.escpos");
+
+    const int jobs = 200;
+    std::vector<qint64> latencies;
+    latencies.reserve(jobs);
+    qint64 totalBytes = 0;
+    {
+        ThermalPrintSpooler spooler(devicePath);
+        // 在打印线程中直接记录；waitForIdle返回后读取
+        connect(&spooler, &ThermalPrintSpooler::jobCompleted, &spooler,
+                [&](int, qint64, qint64 firstByteNsecs, qint64 bytesWritten) {
+            latencies.push_back(firstByteNsecs);
+            totalBytes += bytesWritten;
+        }, Qt::DirectConnection);
+
+        // 逐张打印，测量的是空闲打印线程的响应延迟，而不是排队时间
+        for (int i = 0; i < jobs; ++i) {
+            spooler.enqueue(receipt);
+            QVERIFY(spooler.waitForIdle(5000));
+        }
+    }
+
+    QCOMPARE(static_cast<int>(latencies.size()), jobs);
+    QCOMPARE(QFileInfo(devicePath).size(), totalBytes);
+
+    std::sort(latencies.begin(), latencies.end());
+    qInfo("first byte: p50 %.1f us, p99 %.1f us, max %.1f us",
+          latencies[jobs / 2] / 1000.0, latencies[jobs * 99 / 100] / 1000.0, latencies.back() / 1000.0);
+}
+
+QTEST_GUILESS_MAIN(EscPosBenchmark)
+#include "escpos_benchmark.moc"
@@ -0,0 +1,146 @@
+#include <QTest>
+#include <QTemporaryDir>
+#include <QRandomGenerator>
+#include <QElapsedTimer>
+
+#include "../src/receipt/ElectronicJournal.h"
+#include "../src/receipt/ReceiptData.h"
+
+/**
+ * @brief 电子存根的基准测试
+ *
+ * 写入约一年的小票（默认每天300笔），测量追加、按交易号补打查找和重新打开（加载索引）的耗时，
+ * 并输出每张小票平均占用的磁盘字节数。目标：补打查找在毫秒级。
+ */
+class JournalBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void append();
+    void reprintLookup();
+    void reopen();
+    void dayListing();
+
+private:
+    QTemporaryDir m_dir;
+    QString m_basePath;
+    QDateTime m_start;
+    int m_receiptCount = 0;
+};
+
+namespace {
+
+const int DaysPerYear = 365;
+const int SalesPerDay = 300;
+
+ReceiptData makeReceipt(int transactionId, const QDateTime& timestamp)
+{
+    ReceiptData receipt;
+    receipt.transactionId = transactionId;
+    receipt.cashierName = QString("收银员%1").arg(transactionId % 4 + 1);
+    receipt.timestamp = timestamp;
+    receipt.paymentMethod = transactionId % 3 == 0 ? "现金" : "微信支付";
+    const int lineCount = 3 + transactionId % 15;
+    for (int i = 0; i < lineCount; ++i) {
+        const int productId = (transactionId * 7 + i * 13) % 2000;
+        const int quantity = 1 + (productId % 3);
+        const Money unitPrice = Money::fromMinorUnits(150 + (productId % 40) * 55);
+        receipt.lines.append(ReceiptLine{QString("商品%1").arg(productId), quantity, unitPrice, unitPrice * quantity});
+        receipt.totalAmount += unitPrice * quantity;
+        receipt.totalQuantity += quantity;
+    }
+    receipt.finalAmount = receipt.totalAmount;
+    return receipt;
+}
+
+}
+
+void JournalBenchmark::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_basePath = m_dir.filePath("receipts");
+    m_start = QDateTime(QDate(2024, 1, 1), QTime(8, 0, 0));
+
+    // 批量生成语料，不逐张同步到磁盘
+    ElectronicJournal journal(m_basePath);
+    journal.setSyncWrites(false);
+    QVERIFY(journal.open());
+
+    QElapsedTimer timer;
+    timer.start();
+    int transactionId = 0;
+    for (int day = 0; day < DaysPerYear; ++day) {
+        const QDateTime opening = m_start.addDays(day);
+        for (int sale = 0; sale < SalesPerDay; ++sale) {
+            ++transactionId;
+            QVERIFY(journal.append(makeReceipt(transactionId, opening.addSecs(sale * 120))));
+        }
+    }
+    QVERIFY(journal.flush());
+    m_receiptCount = transactionId;
+
+    const qint64 bytes = journal.diskSize();
+    qInfo("journal: %d receipts in %.1f s, %.1f MB on disk, %.0f bytes/receipt",
+          m_receiptCount, timer.elapsed() / 1000.0, bytes / (1024.0 * 1024.0),
+          static_cast<double>(bytes) / m_receiptCount);
+}
+
+void JournalBenchmark::append()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    ElectronicJournal journal(dir.filePath("append"));
+    QVERIFY(journal.open());
+
+    const ReceiptData receipt = makeReceipt(42, m_start);
+    QBENCHMARK {
+        journal.append(receipt);
+    }
+    QVERIFY(journal.flush());
+}
+
+void JournalBenchmark::reprintLookup()
+{
+    ElectronicJournal journal(m_basePath);
+    QVERIFY(journal.open());
+    QCOMPARE(journal.entryCount(), m_receiptCount);
+
+    // 随机交易号，基本不会命中数据块缓存
+    QRandomGenerator random(20240601);
+    QString text;
+    QBENCHMARK {
+        const int transactionId = 1 + static_cast<int>(random.bounded(static_cast<quint32>(m_receiptCount)));
+        text = journal.receiptText(transactionId);
+    }
+    QVERIFY(!text.isEmpty());
+}
+
+void JournalBenchmark::reopen()
+{
+    int entries = 0;
+    QBENCHMARK {
+        ElectronicJournal journal(m_basePath);
+        QVERIFY(journal.open());
+        entries = journal.entryCount();
+    }
+    QCOMPARE(entries, m_receiptCount);
+}
+
+void JournalBenchmark::dayListing()
+{
+    ElectronicJournal journal(m_basePath);
+    QVERIFY(journal.open());
+
+    const QDateTime day = m_start.addDays(200);
+    QList<JournalEntry> entries;
+    QBENCHMARK {
+        entries = journal.entries(day, day.addDays(1));
+    }
+    QCOMPARE(entries.size(), SalesPerDay);
+}
+
+QTEST_GUILESS_MAIN(JournalBenchmark)
+#include "journal_benchmark.moc"
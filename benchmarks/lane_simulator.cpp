@@ -0,0 +1,223 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QLoggingCategory>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include <vector>
+
+#include "../src/controllers/LaneManager.h"
+#include "../src/controllers/ProductManager.h"
+#include "../src/database/DatabaseManager.h"
+#include "../src/models/Product.h"
+
+/**
+ * 无界面的多通道收银模拟器
+ *
+ * 用合成的扫码流驱动1..N个收银通道（轮流向每个通道送一次扫码，模拟多个顾客同时结账），
+ * 每个通道达到设定件数后结账。对每个通道数输出每秒完成的销售数和单次扫码延迟的分位数。
+ *
+ *   LaneSimulator --lanes 1,2,4,8,16 --sales-per-lane 200 --items-per-sale 20
+ *
+ * 默认使用内存数据库，只衡量收银流程本身；用 --db 指定文件可以把SQLite写入也计算在内。
+ */
+
+namespace {
+
+struct RunResult
+{
+    int lanes = 0;
+    int sales = 0;
+    int scans = 0;
+    double seconds = 0.0;
+    qint64 p50 = 0;
+    qint64 p95 = 0;
+    qint64 p99 = 0;
+    qint64 max = 0;
+};
+
+QString barcodeFor(int index)
+{
+    return QString("69%1").arg(index, 11, 10, QChar('0'));
+}
+
+qint64 percentile(std::vector<qint64>& sorted, double fraction)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+// 把合成商品写入数据库，然后等待ProductManager加载并发布目录
+bool seedCatalog(int catalogSize)
+{
+    DatabaseManager& db = DatabaseManager::getInstance();
+    QEventLoop loop;
+    int pending = catalogSize;
+    int failed = 0;
+    QObject::connect(&db, &DatabaseManager::productSaved, &loop, [&](bool success, int) {
+        if (!success) {
+            ++failed;
+        }
+        if (--pending == 0) {
+            loop.quit();
+        }
+    });
+
+    for (int i = 1; i <= catalogSize; ++i) {
+        Product product(-1, barcodeFor(i), QString("模拟商品%1").arg(i), QString(),
+                        Money::fromMinorUnits(150 + (i * 37) % 5000), 100000000, QString("分类%1").arg(i % 12));
+        db.saveProduct(product);
+    }
+    if (pending > 0) {
+        loop.exec();
+    }
+    return failed == 0;
+}
+
+RunResult runLanes(ProductManager* productManager, int laneCount, int salesPerLane, int itemsPerSale,
+                   int catalogSize, quint32 seed)
+{
+    LaneManager lanes(productManager);
+    std::vector<int> laneIds;
+    for (int i = 0; i < laneCount; ++i) {
+        laneIds.push_back(lanes.openLane());
+    }
+
+    QObject::connect(&lanes, &LaneManager::laneError, [](int laneId, const QString& message) {
+        qWarning() << "通道" << laneId << "错误:" << message;
+    });
+
+    QRandomGenerator random(seed);
+    std::vector<int> itemsInCart(laneCount, 0);
+    std::vector<int> salesDone(laneCount, 0);
+    std::vector<int> lastScanned(laneCount, 1);
+    std::vector<qint64> latencies;
+    latencies.reserve(static_cast<size_t>(laneCount) * salesPerLane * itemsPerSale);
+
+    RunResult result;
+    result.lanes = laneCount;
+
+    QElapsedTimer total;
+    QElapsedTimer timer;
+    total.start();
+    int activeLanes = laneCount;
+    while (activeLanes > 0) {
+        for (int i = 0; i < laneCount; ++i) {
+            if (salesDone[i] >= salesPerLane) {
+                continue;
+            }
+
+            if (itemsInCart[i] >= itemsPerSale) {
+                if (lanes.checkout(laneIds[i]) >= 0) {
+                    ++result.sales;
+                }
+                itemsInCart[i] = 0;
+                if (++salesDone[i] == salesPerLane) {
+                    --activeLanes;
+                }
+                continue;
+            }
+
+            // 约五分之一的扫码是同一商品的重复扫描
+            int productIndex = random.bounded(5) == 0
+                               ? lastScanned[i]
+                               : 1 + static_cast<int>(random.bounded(static_cast<quint32>(catalogSize)));
+            lastScanned[i] = productIndex;
+            const QString barcode = barcodeFor(productIndex);
+
+            timer.start();
+            lanes.scan(laneIds[i], barcode);
+            latencies.push_back(timer.nsecsElapsed());
+            ++itemsInCart[i];
+        }
+    }
+    result.seconds = total.nsecsElapsed() / 1e9;
+    result.scans = static_cast<int>(latencies.size());
+
+    std::sort(latencies.begin(), latencies.end());
+    result.p50 = percentile(latencies, 0.50);
+    result.p95 = percentile(latencies, 0.95);
+    result.p99 = percentile(latencies, 0.99);
+    result.max = latencies.empty() ? 0 : latencies.back();
+    return result;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("LaneSimulator");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless multi-lane checkout simulator");
+    parser.addHelpOption();
+    QCommandLineOption lanesOption("lanes", "Comma separated lane counts to run.", "list", "1,2,4,8,16");
+    QCommandLineOption salesOption("sales-per-lane", "Sales completed by every lane.", "count", "200");
+    QCommandLineOption itemsOption("items-per-sale", "Scans per sale.", "count", "20");
+    QCommandLineOption catalogOption("catalog", "Number of synthetic products.", "count", "2000");
+    QCommandLineOption dbOption("db", "SQLite database path.", "path", ":memory:");
+    QCommandLineOption seedOption("seed", "Random seed for the scan stream.", "seed", "20240601");
+    parser.addOptions({lanesOption, salesOption, itemsOption, catalogOption, dbOption, seedOption});
+    parser.process(app);
+
+    // 模拟器只关心结果表，关掉逐笔调试输出
+    QLoggingCategory::setFilterRules("*.debug=false\nsmartpos.*.info=false");
+
+    const int salesPerLane = qMax(1, parser.value(salesOption).toInt());
+    const int itemsPerSale = qMax(1, parser.value(itemsOption).toInt());
+    const int catalogSize = qMax(1, parser.value(catalogOption).toInt());
+    const quint32 seed = parser.value(seedOption).toUInt();
+
+    QList<int> laneCounts;
+    for (const QString& value : parser.value(lanesOption).split(',', Qt::SkipEmptyParts)) {
+        int count = value.trimmed().toInt();
+        if (count > 0) {
+            laneCounts.append(count);
+        }
+    }
+
+    QTextStream out(stdout);
+    if (!DatabaseManager::getInstance().openDatabase(parser.value(dbOption))) {
+        out << "failed to open database " << parser.value(dbOption) << Qt::endl;
+        return 1;
+    }
+    if (!seedCatalog(catalogSize)) {
+        out << "failed to seed the catalog" << Qt::endl;
+        return 1;
+    }
+
+    ProductManager productManager;
+    if (productManager.catalogSnapshot()->size() < catalogSize) {
+        QEventLoop loop;
+        QObject::connect(&productManager, &ProductManager::allProductsChanged, &loop, &QEventLoop::quit);
+        QTimer::singleShot(30000, &loop, &QEventLoop::quit);
+        loop.exec();
+    }
+
+    out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+           .arg("lanes", 6).arg("sales", 8).arg("seconds", 9).arg("sales/s", 10)
+           .arg("p50(us)", 9).arg("p95(us)", 9).arg("p99(us)", 9).arg("max(us)", 9);
+    for (int laneCount : std::as_const(laneCounts)) {
+        RunResult result = runLanes(&productManager, laneCount, salesPerLane, itemsPerSale, catalogSize, seed);
+        out << QString("%1 %2 %3 %4 %5 %6 %7 %8\n")
+               .arg(result.lanes, 6)
+               .arg(result.sales, 8)
+               .arg(result.seconds, 9, 'f', 3)
+               .arg(result.seconds > 0 ? result.sales / result.seconds : 0.0, 10, 'f', 1)
+               .arg(result.p50 / 1000.0, 9, 'f', 1)
+               .arg(result.p95 / 1000.0, 9, 'f', 1)
+               .arg(result.p99 / 1000.0, 9, 'f', 1)
+               .arg(result.max / 1000.0, 9, 'f', 1);
+        out.flush();
+    }
+
+    DatabaseManager::getInstance().closeDatabase();
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <QTest>
+#include <QList>
+#include <QVector>
+
+#include "../src/models/Money.h"
+#include "../src/models/Product.h"
+#include "../src/models/Sale.h"
+
+/**
+ * @brief 金额累加的微基准测试
+ *
+ * 比较定点整数求和与double累加在大购物篮上的开销，并测量Sale在
+ * 大购物篮上重新同步总额（calculateTotal）的耗时。
+ */
+class MoneyBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sumMoney_data();
+    void sumMoney();
+
+    void sumDouble_data();
+    void sumDouble();
+
+    void saleCalculateTotal_data();
+    void saleCalculateTotal();
+};
+
+namespace {
+void addBasketSizes()
+{
+    QTest::addColumn<int>("basketSize");
+    QTest::newRow("basket-100") << 100;
+    QTest::newRow("basket-1000") << 1000;
+    QTest::newRow("basket-100000") << 100000;
+}
+
+// 价格在 ¥0.99 - ¥99.99 之间的伪随机序列，保证每次运行相同
+qint64 priceInMinorUnits(int index)
+{
+    return 99 + (static_cast<qint64>(index) * 7919) % 9901;
+}
+}
+
+void MoneyBenchmark::sumMoney_data()
+{
+    addBasketSizes();
+}
+
+void MoneyBenchmark::sumMoney()
+{
+    QFETCH(int, basketSize);
+    QVector<Money> subtotals;
+    subtotals.reserve(basketSize);
+    for (int i = 0; i < basketSize; ++i) {
+        subtotals.append(Money::fromMinorUnits(priceInMinorUnits(i)));
+    }
+
+    Money total;
+    QBENCHMARK {
+        total = Money::sum(subtotals.constData(), subtotals.size());
+    }
+    QVERIFY(total.isPositive());
+}
+
+void MoneyBenchmark::sumDouble_data()
+{
+    addBasketSizes();
+}
+
+void MoneyBenchmark::sumDouble()
+{
+    QFETCH(int, basketSize);
+    QVector<double> subtotals;
+    subtotals.reserve(basketSize);
+    for (int i = 0; i < basketSize; ++i) {
+        subtotals.append(priceInMinorUnits(i) / 100.0);
+    }
+
+    double total = 0.0;
+    QBENCHMARK {
+        total = 0.0;
+        for (double subtotal : std::as_const(subtotals)) {
+            total += subtotal;
+        }
+    }
+    QVERIFY(total > 0.0);
+}
+
+void MoneyBenchmark::saleCalculateTotal_data()
+{
+    QTest::addColumn<int>("basketSize");
+    QTest::newRow("basket-100") << 100;
+    QTest::newRow("basket-1000") << 1000;
+}
+
+void MoneyBenchmark::saleCalculateTotal()
+{
+    QFETCH(int, basketSize);
+    QList<Product*> products;
+    Sale sale;
+    sale.beginUpdate();
+    for (int i = 0; i < basketSize; ++i) {
+        auto* product = new Product(i + 1, QString::number(6900000000000LL + i), QString("商品%1").arg(i),
+                                    QString(), Money::fromMinorUnits(priceInMinorUnits(i)), 1000, QString());
+        products.append(product);
+        sale.addItem(product, 1 + i % 3);
+    }
+    sale.endUpdate();
+
+    QBENCHMARK {
+        sale.calculateTotal();
+    }
+    QVERIFY(sale.getTotalAmount().isPositive());
+
+    sale.clearItems();
+    qDeleteAll(products);
+}
+
+QTEST_GUILESS_MAIN(MoneyBenchmark)
+#include "money_benchmark.moc"
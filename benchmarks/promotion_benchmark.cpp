@@ -0,0 +1,111 @@
+#include <QTest>
+#include <QList>
+
+#include "../src/controllers/PromotionEngine.h"
+
+/**
+ * @brief 促销规则引擎的微基准测试
+ *
+ * 在数千条生效规则下测量编译决策表的耗时，以及扫码改变一行时
+ * 增量重新计算优惠的耗时（应与规则总数无关）。
+ */
+class PromotionBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void compileRules_data();
+    void compileRules();
+
+    void repriceOnScan_data();
+    void repriceOnScan();
+};
+
+namespace {
+const int ProductsPerRule = 4;
+
+qint64 priceInMinorUnits(int productId)
+{
+    return 99 + (static_cast<qint64>(productId) * 7919) % 9901;
+}
+
+// 轮流生成四种促销，每条规则覆盖ProductsPerRule个连续的商品
+QList<PromotionRule> makeRules(int ruleCount)
+{
+    QList<PromotionRule> rules;
+    rules.reserve(ruleCount);
+    for (int i = 0; i < ruleCount; ++i) {
+        PromotionRule rule;
+        rule.ruleId = i + 1;
+        rule.name = QString("促销%1").arg(i + 1);
+        rule.type = static_cast<PromotionRule::Type>(i % 4);
+        rule.priority = i % 7;
+        for (int p = 0; p < ProductsPerRule; ++p) {
+            rule.productIds.append(i * ProductsPerRule + p + 1);
+        }
+        rule.buyQuantity = rule.type == PromotionRule::MixAndMatch ? 3 : 2;
+        rule.getQuantity = 1;
+        rule.dealPrice = Money::fromMinorUnits(1000);
+        rule.tiers = {{3, 5.0}, {6, 10.0}, {12, 15.0}};
+        rules.append(rule);
+    }
+    return rules;
+}
+
+void addRuleCounts()
+{
+    QTest::addColumn<int>("ruleCount");
+    QTest::newRow("rules-100") << 100;
+    QTest::newRow("rules-1000") << 1000;
+    QTest::newRow("rules-10000") << 10000;
+}
+}
+
+void PromotionBenchmark::compileRules_data()
+{
+    addRuleCounts();
+}
+
+void PromotionBenchmark::compileRules()
+{
+    QFETCH(int, ruleCount);
+    const QList<PromotionRule> rules = makeRules(ruleCount);
+
+    PromotionEngine engine;
+    QBENCHMARK {
+        engine.compile(rules);
+    }
+    QCOMPARE(engine.ruleCount(), ruleCount);
+}
+
+void PromotionBenchmark::repriceOnScan_data()
+{
+    addRuleCounts();
+}
+
+void PromotionBenchmark::repriceOnScan()
+{
+    QFETCH(int, ruleCount);
+    PromotionEngine engine;
+    engine.compile(makeRules(ruleCount));
+
+    // 购物车中已有50行，分散在不同的规则上
+    const int productCount = ruleCount * ProductsPerRule;
+    for (int i = 0; i < 50; ++i) {
+        int productId = (i * 7919) % productCount + 1;
+        engine.updateLine(productId, 1 + i % 4, Money::fromMinorUnits(priceInMinorUnits(productId)));
+    }
+
+    // 反复扫描同一商品，每次只重新计算它所属的规则
+    const int scannedId = 1;
+    const Money price = Money::fromMinorUnits(priceInMinorUnits(scannedId));
+    int quantity = 0;
+    QBENCHMARK {
+        quantity = quantity % 24 + 1;
+        engine.updateLine(scannedId, quantity, price);
+    }
+    QVERIFY(!engine.totalDiscount().isNegative());
+}
+
+QTEST_GUILESS_MAIN(PromotionBenchmark)
+#include "promotion_benchmark.moc"
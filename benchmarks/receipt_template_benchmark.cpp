@@ -0,0 +1,129 @@
+#include <QTest>
+
+#include "../src/receipt/ReceiptData.h"
+#include "../src/receipt/ReceiptTemplate.h"
+
+/**
+ * @brief 预编译小票模板的基准测试
+ *
+ * 测量默认HTML和纯文本版式渲染10到300行小票的耗时，并检查复用输出缓冲区时
+ * 渲染不再重新分配内存（缓冲区地址和容量保持不变）。
+ */
+class ReceiptTemplateBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void compile();
+
+    void renderHtml_data();
+    void renderHtml();
+
+    void renderText_data();
+    void renderText();
+
+private:
+    void renderWith(const ReceiptTemplate& compiled);
+
+    ReceiptTemplate m_html;
+    ReceiptTemplate m_text;
+};
+
+namespace {
+
+ReceiptData makeReceipt(int lineCount)
+{
+    ReceiptData receipt;
+    receipt.transactionId = 10086;
+    receipt.cashierName = "收银员01";
+    receipt.timestamp = QDateTime(QDate(2024, 6, 1), QTime(12, 30, 0));
+    receipt.paymentMethod = "微信支付";
+    for (int i = 0; i < lineCount; ++i) {
+        const int quantity = 1 + i % 4;
+        const Money unitPrice = Money::fromMinorUnits(150 + (i % 20) * 135);
+        QString name = i % 7 == 0 ? QString("进口特级初榨橄榄油礼盒装 <限量版> %1号").arg(i)
+                                  : QString("商品%1").arg(i);
+        receipt.lines.append(ReceiptLine{name, quantity, unitPrice, unitPrice * quantity});
+        receipt.totalAmount += unitPrice * quantity;
+        receipt.totalQuantity += quantity;
+    }
+    receipt.discountAmount = Money::fromMinorUnits(200);
+    receipt.promotionDiscount = Money::fromMinorUnits(500);
+    receipt.finalAmount = receipt.totalAmount - receipt.discountAmount - receipt.promotionDiscount;
+    return receipt;
+}
+
+void addReceiptSizes()
+{
+    QTest::addColumn<int>("lineCount");
+    QTest::newRow("lines-10") << 10;
+    QTest::newRow("lines-50") << 50;
+    QTest::newRow("lines-100") << 100;
+    QTest::newRow("lines-300") << 300;
+}
+
+}
+
+void ReceiptTemplateBenchmark::initTestCase()
+{
+    QString error;
+    m_html = ReceiptTemplate::compile(ReceiptTemplate::defaultHtmlSource(), ReceiptTemplate::Html, &error);
+    QVERIFY2(m_html.isValid(), qPrintable(error));
+    m_text = ReceiptTemplate::compile(ReceiptTemplate::defaultTextSource(), ReceiptTemplate::PlainText, &error);
+    QVERIFY2(m_text.isValid(), qPrintable(error));
+}
+
+void ReceiptTemplateBenchmark::compile()
+{
+    const QString source = ReceiptTemplate::defaultHtmlSource();
+    int instructions = 0;
+    QBENCHMARK {
+        instructions = ReceiptTemplate::compile(source, ReceiptTemplate::Html).instructionCount();
+    }
+    QVERIFY(instructions > 0);
+}
+
+void ReceiptTemplateBenchmark::renderWith(const ReceiptTemplate& compiled)
+{
+    QFETCH(int, lineCount);
+    const ReceiptData receipt = makeReceipt(lineCount);
+
+    // 先渲染一次把缓冲区扩容到位
+    QString out;
+    compiled.render(receipt, &out);
+    const QChar* buffer = out.constData();
+    const qsizetype capacity = out.capacity();
+
+    QBENCHMARK {
+        compiled.render(receipt, &out);
+    }
+
+    QCOMPARE(out.constData(), buffer);
+    QCOMPARE(out.capacity(), capacity);
+    QVERIFY(out.contains(receipt.lines.last().name.left(4)));
+}
+
+void ReceiptTemplateBenchmark::renderHtml_data()
+{
+    addReceiptSizes();
+}
+
+void ReceiptTemplateBenchmark::renderHtml()
+{
+    renderWith(m_html);
+}
+
+void ReceiptTemplateBenchmark::renderText_data()
+{
+    addReceiptSizes();
+}
+
+void ReceiptTemplateBenchmark::renderText()
+{
+    renderWith(m_text);
+}
+
+QTEST_GUILESS_MAIN(ReceiptTemplateBenchmark)
+#include "receipt_template_benchmark.moc"
@@ -0,0 +1,140 @@
+#include <QTest>
+#include <QSignalSpy>
+#include <QList>
+
+#include "../src/models/Money.h"
+#include "../src/models/Product.h"
+#include "../src/models/Sale.h"
+#include "../src/models/SaleCodec.h"
+
+/**
+ * @brief 挂单编解码的微基准测试
+ *
+ * 测量编码、解码，以及把解码结果恢复为购物车（创建全部项目）的耗时。
+ * 目标：100行的购物车恢复在5毫秒以内，并且只触发一次界面刷新。
+ */
+class SaleCodecBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void encode_data();
+    void encode();
+
+    void decode_data();
+    void decode();
+
+    void resume_data();
+    void resume();
+
+private:
+    void fillSale(Sale* sale, int lineCount);
+
+    QList<Product*> m_products;
+};
+
+namespace {
+const int CatalogSize = 1000;
+
+void addCartSizes()
+{
+    QTest::addColumn<int>("lineCount");
+    QTest::newRow("lines-10") << 10;
+    QTest::newRow("lines-100") << 100;
+    QTest::newRow("lines-500") << 500;
+}
+}
+
+void SaleCodecBenchmark::initTestCase()
+{
+    for (int i = 1; i <= CatalogSize; ++i) {
+        m_products.append(new Product(i, QString("69%1").arg(i, 11, 10, QChar('0')),
+                                      QString("商品%1").arg(i), QString(), Money::fromMinorUnits(150 + (i % 20) * 100),
+                                      1000000, QString("分类%1").arg(i % 10)));
+    }
+}
+
+void SaleCodecBenchmark::cleanupTestCase()
+{
+    qDeleteAll(m_products);
+    m_products.clear();
+}
+
+void SaleCodecBenchmark::fillSale(Sale* sale, int lineCount)
+{
+    sale->beginUpdate();
+    for (int i = 0; i < lineCount; ++i) {
+        sale->addItem(m_products.at(i), 1 + i % 5);
+    }
+    sale->endUpdate();
+}
+
+void SaleCodecBenchmark::encode_data()
+{
+    addCartSizes();
+}
+
+void SaleCodecBenchmark::encode()
+{
+    QFETCH(int, lineCount);
+    Sale sale;
+    fillSale(&sale, lineCount);
+
+    QByteArray payload;
+    QBENCHMARK {
+        payload = SaleCodec::encode(sale);
+    }
+    QVERIFY(!payload.isEmpty());
+}
+
+void SaleCodecBenchmark::decode_data()
+{
+    addCartSizes();
+}
+
+void SaleCodecBenchmark::decode()
+{
+    QFETCH(int, lineCount);
+    Sale sale;
+    fillSale(&sale, lineCount);
+    const QByteArray payload = SaleCodec::encode(sale);
+
+    ParkedSaleData data;
+    QBENCHMARK {
+        QVERIFY(SaleCodec::decode(payload, &data));
+    }
+    QCOMPARE(data.lines.size(), lineCount);
+}
+
+void SaleCodecBenchmark::resume_data()
+{
+    addCartSizes();
+}
+
+void SaleCodecBenchmark::resume()
+{
+    QFETCH(int, lineCount);
+    Sale original;
+    fillSale(&original, lineCount);
+    const QByteArray payload = SaleCodec::encode(original);
+    auto lookup = [this](int productId) { return m_products.value(productId - 1, nullptr); };
+
+    Sale resumed;
+    QSignalSpy saleChanged(&resumed, &Sale::saleChanged);
+    QBENCHMARK {
+        resumed.clearItems();
+        saleChanged.clear();
+        ParkedSaleData data;
+        SaleCodec::decode(payload, &data);
+        SaleCodec::restore(data, &resumed, lookup);
+    }
+    QCOMPARE(resumed.itemCount(), lineCount);
+    QCOMPARE(resumed.getTotalAmount(), original.getTotalAmount());
+    QCOMPARE(saleChanged.count(), 1);
+}
+
+QTEST_GUILESS_MAIN(SaleCodecBenchmark)
+#include "sale_codec_benchmark.moc"
@@ -0,0 +1,120 @@
+#include <QTest>
+#include <QList>
+#include <memory>
+
+#include "../src/controllers/CheckoutController.h"
+#include "../src/models/CatalogSnapshot.h"
+#include "../src/models/Product.h"
+#include "../src/models/Sale.h"
+
+/**
+ * @brief 扫码加购路径的微基准测试
+ *
+ * 测量一次扫码从条码查找到加入购物车（库存检查、合并到已有项目、
+ * 增量更新总额）的耗时，以及遍历购物车项目的开销。
+ * 运行: ./ScanToCartBenchmark [-iterations N]
+ */
+class ScanToCartBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void scanExistingItem_data();
+    void scanExistingItem();
+
+    void iterateCartItems_data();
+    void iterateCartItems();
+
+private:
+    void fillCart(int distinctItems);
+
+    QList<Product*> m_products;
+    CatalogSnapshotPtr m_catalog;
+    std::unique_ptr<CheckoutController> m_controller;
+    std::unique_ptr<Sale> m_sale;   ///< startNewSale创建的销售没有父对象，由基准自己释放
+};
+
+namespace {
+const int CatalogSize = 1000;
+}
+
+void ScanToCartBenchmark::initTestCase()
+{
+    for (int i = 1; i <= CatalogSize; ++i) {
+        auto* product = new Product(i, QString("69%1").arg(i, 11, 10, QChar('0')),
+                                    QString("商品%1").arg(i), QString(), Money::fromMinorUnits(150 + (i % 20) * 100),
+                                    1000000, QString("分类%1").arg(i % 10));
+        m_products.append(product);
+    }
+    m_catalog = CatalogSnapshot::build(m_products, 1);
+    m_controller = std::make_unique<CheckoutController>();
+}
+
+void ScanToCartBenchmark::cleanupTestCase()
+{
+    m_controller.reset();
+    m_sale.reset();
+    qDeleteAll(m_products);
+    m_products.clear();
+}
+
+void ScanToCartBenchmark::fillCart(int distinctItems)
+{
+    // 控制器先切换到新销售，再释放上一个
+    m_sale.reset(m_controller->startNewSale());
+    for (int i = 0; i < distinctItems; ++i) {
+        m_controller->addItemToSale(m_products.at(i), 1);
+    }
+}
+
+void ScanToCartBenchmark::scanExistingItem_data()
+{
+    QTest::addColumn<int>("cartSize");
+    QTest::newRow("cart-10") << 10;
+    QTest::newRow("cart-50") << 50;
+    QTest::newRow("cart-200") << 200;
+    QTest::newRow("cart-500") << 500;
+}
+
+void ScanToCartBenchmark::scanExistingItem()
+{
+    QFETCH(int, cartSize);
+    fillCart(cartSize);
+
+    // 重复扫描购物车中最后一个商品：最坏情况下的合并查找
+    const QString barcode = m_products.at(cartSize - 1)->getBarcode();
+    Sale* sale = m_controller->getCurrentSale();
+
+    QBENCHMARK {
+        const ProductRecord* record = m_catalog->findByBarcode(barcode);
+        m_controller->addItemToSale(m_products.at(record->productId - 1), 1);
+    }
+
+    QVERIFY(sale->itemCount() == cartSize);
+}
+
+void ScanToCartBenchmark::iterateCartItems_data()
+{
+    scanExistingItem_data();
+}
+
+void ScanToCartBenchmark::iterateCartItems()
+{
+    QFETCH(int, cartSize);
+    fillCart(cartSize);
+    Sale* sale = m_controller->getCurrentSale();
+
+    int quantity = 0;
+    QBENCHMARK {
+        for (const SaleItem* item : sale->getItems()) {
+            quantity += item->getQuantity();
+        }
+    }
+    QVERIFY(quantity > 0);
+}
+
+QTEST_GUILESS_MAIN(ScanToCartBenchmark)
+#include "scan_to_cart_benchmark.moc"
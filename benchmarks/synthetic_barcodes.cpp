@@ -0,0 +1,320 @@
+#include "synthetic_barcodes.h"
+
+#include <QFont>
+#include <QPainter>
+#include <QTransform>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace SyntheticBarcodes {
+
+namespace {
+
+// EAN/UPC左侧奇校验（L）编码；右侧（R）是L取反，左侧偶校验（G）是R倒序
+const char* const kEanLeftOdd[10] = {
+    "0001101", "0011001", "0010011", "0111101", "0100011",
+    "0110001", "0101111", "0111011", "0110111", "0001011"
+};
+
+// EAN-13首位数字决定左侧6位的奇偶校验组合
+const char* const kEanParity[10] = {
+    "LLLLLL", "LLGLGG", "LLGGLG", "LLGGGL", "LGLLGG",
+    "LGGLLG", "LGGGLL", "LGLGLG", "LGLGGL", "LGGLGL"
+};
+
+// Code128各码值的条空宽度（条、空交替，从条开始）；103~105为起始符A/B/C，106为终止符
+const char* const kCode128Widths[107] = {
+    "212222", "222122", "222221", "121223", "121322", "131222", "122213", "122312", "132212", "221213",
+    "221312", "231212", "112232", "122132", "122231", "113222", "123122", "123221", "223211", "221132",
+    "221231", "213212", "223112", "312131", "311222", "321122", "321221", "312212", "322112", "322211",
+    "212123", "212321", "232121", "111323", "131123", "131321", "112313", "132113", "132311", "211313",
+    "231113", "231311", "112133", "112331", "132131", "113123", "113321", "133121", "313121", "211331",
+    "231131", "213113", "213311", "213131", "311123", "311321", "331121", "312113", "312311", "332111",
+    "314111", "221411", "431111", "111224", "111422", "121124", "121421", "141122", "141221", "112214",
+    "112412", "122114", "122411", "142112", "142211", "241211", "221114", "413111", "241112", "134111",
+    "111242", "121142", "121241", "114212", "124112", "124211", "411212", "421112", "421211", "212141",
+    "214121", "412121", "111143", "111341", "131141", "114113", "114311", "411113", "411311", "113141",
+    "114131", "311141", "411131", "211412", "211214", "211232", "2331112"
+};
+
+const int kCode128StartB = 104;
+const int kCode128Stop = 106;
+const int kQuietZoneModules = 12;
+
+bool isDigits(const QString& text, int length)
+{
+    if (text.size() != length) {
+        return false;
+    }
+    return std::all_of(text.begin(), text.end(), [](QChar c) { return c >= '0' && c <= '9'; });
+}
+
+// 按EAN-13规则计算前12位的校验位（UPC-A在前面补0即可）
+int eanCheckDigit(const QString& digits)
+{
+    int sum = 0;
+    for (int i = 0; i < 12; ++i) {
+        sum += (digits.at(i).unicode() - '0') * (i % 2 == 0 ? 1 : 3);
+    }
+    return (10 - sum % 10) % 10;
+}
+
+void appendPattern(QVector<bool>& modules, const char* pattern, bool invert = false, bool reverse = false)
+{
+    const int length = static_cast<int>(qstrlen(pattern));
+    for (int i = 0; i < length; ++i) {
+        const char c = pattern[reverse ? length - 1 - i : i];
+        modules.append((c == '1') != invert);
+    }
+}
+
+void appendWidths(QVector<bool>& modules, const char* widths)
+{
+    bool bar = true;
+    for (const char* w = widths; *w; ++w) {
+        for (int i = 0; i < *w - '0'; ++i) {
+            modules.append(bar);
+        }
+        bar = !bar;
+    }
+}
+
+QVector<bool> encodeEan13(const QString& payload)
+{
+    if (!isDigits(payload, 13) || eanCheckDigit(payload) != payload.at(12).unicode() - '0') {
+        return {};
+    }
+
+    QVector<bool> modules;
+    modules.reserve(95);
+    const char* parity = kEanParity[payload.at(0).unicode() - '0'];
+    appendPattern(modules, "101");
+    for (int i = 1; i <= 6; ++i) {
+        const char* code = kEanLeftOdd[payload.at(i).unicode() - '0'];
+        const bool even = parity[i - 1] == 'G';
+        appendPattern(modules, code, even, even);
+    }
+    appendPattern(modules, "01010");
+    for (int i = 7; i <= 12; ++i) {
+        appendPattern(modules, kEanLeftOdd[payload.at(i).unicode() - '0'], true);
+    }
+    appendPattern(modules, "101");
+    return modules;
+}
+
+QVector<bool> encodeCode128(const QString& payload)
+{
+    if (payload.isEmpty()) {
+        return {};
+    }
+
+    QVector<bool> modules;
+    modules.reserve((payload.size() + 3) * 11 + 2);
+    appendWidths(modules, kCode128Widths[kCode128StartB]);
+    int checksum = kCode128StartB;
+    for (int i = 0; i < payload.size(); ++i) {
+        const ushort c = payload.at(i).unicode();
+        if (c < 32 || c > 126) {
+            return {};
+        }
+        const int value = c - 32;
+        appendWidths(modules, kCode128Widths[value]);
+        checksum += (i + 1) * value;
+    }
+    appendWidths(modules, kCode128Widths[checksum % 103]);
+    appendWidths(modules, kCode128Widths[kCode128Stop]);
+    return modules;
+}
+
+// 可分离的盒式模糊，边缘按最近像素延伸
+void boxBlur(QImage& image, int radius)
+{
+    const int width = image.width();
+    const int height = image.height();
+    const int window = 2 * radius + 1;
+    std::vector<uchar> line(static_cast<size_t>(qMax(width, height)));
+
+    for (int y = 0; y < height; ++y) {
+        uchar* row = image.scanLine(y);
+        std::copy(row, row + width, line.begin());
+        int sum = 0;
+        for (int i = -radius; i <= radius; ++i) {
+            sum += line[qBound(0, i, width - 1)];
+        }
+        for (int x = 0; x < width; ++x) {
+            row[x] = static_cast<uchar>(sum / window);
+            sum += line[qMin(x + radius + 1, width - 1)] - line[qMax(x - radius, 0)];
+        }
+    }
+
+    for (int x = 0; x < width; ++x) {
+        for (int y = 0; y < height; ++y) {
+            line[y] = image.constScanLine(y)[x];
+        }
+        int sum = 0;
+        for (int i = -radius; i <= radius; ++i) {
+            sum += line[qBound(0, i, height - 1)];
+        }
+        for (int y = 0; y < height; ++y) {
+            image.scanLine(y)[x] = static_cast<uchar>(sum / window);
+            sum += line[qMin(y + radius + 1, height - 1)] - line[qMax(y - radius, 0)];
+        }
+    }
+}
+
+void addNoise(QImage& image, double sigma, QRandomGenerator& random)
+{
+    std::normal_distribution<double> noise(0.0, sigma);
+    for (int y = 0; y < image.height(); ++y) {
+        uchar* row = image.scanLine(y);
+        for (int x = 0; x < image.width(); ++x) {
+            row[x] = static_cast<uchar>(qBound(0, qRound(row[x] + noise(random)), 255));
+        }
+    }
+}
+
+}
+
+QString symbologyName(Symbology symbology)
+{
+    switch (symbology) {
+    case Ean13: return "EAN-13";
+    case UpcA: return "UPC-A";
+    case Code128: return "Code128";
+    default: return QString();
+    }
+}
+
+QString filePrefix(Symbology symbology)
+{
+    switch (symbology) {
+    case Ean13: return "ean13";
+    case UpcA: return "upca";
+    case Code128: return "code128";
+    default: return QString();
+    }
+}
+
+Symbology symbologyFromFilePrefix(const QString& prefix)
+{
+    for (int i = 0; i < SymbologyCount; ++i) {
+        if (filePrefix(static_cast<Symbology>(i)) == prefix) {
+            return static_cast<Symbology>(i);
+        }
+    }
+    return SymbologyCount;
+}
+
+QString randomPayload(Symbology symbology, QRandomGenerator& random)
+{
+    QString payload;
+    switch (symbology) {
+    case Ean13:
+        payload.append(QChar('1' + random.bounded(9)));
+        for (int i = 0; i < 11; ++i) {
+            payload.append(QChar('0' + random.bounded(10)));
+        }
+        payload.append(QChar('0' + eanCheckDigit(payload)));
+        break;
+    case UpcA:
+        for (int i = 0; i < 11; ++i) {
+            payload.append(QChar('0' + random.bounded(10)));
+        }
+        payload.append(QChar('0' + eanCheckDigit("0" + payload)));
+        break;
+    case Code128: {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+        const int length = random.bounded(6, 17);
+        for (int i = 0; i < length; ++i) {
+            payload.append(QChar(alphabet[random.bounded(36)]));
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return payload;
+}
+
+QVector<bool> encode(Symbology symbology, const QString& payload)
+{
+    switch (symbology) {
+    case Ean13: return encodeEan13(payload);
+    case UpcA: return isDigits(payload, 12) ? encodeEan13("0" + payload) : QVector<bool>();
+    case Code128: return encodeCode128(payload);
+    default: return {};
+    }
+}
+
+LabelStyle randomStyle(QRandomGenerator& random, double maxRotationDegrees)
+{
+    LabelStyle style;
+    style.moduleWidth = random.bounded(1, 5);
+    style.barHeight = random.bounded(40, 161);
+    style.rotationDegrees = maxRotationDegrees > 0 ? random.bounded(2.0 * maxRotationDegrees) - maxRotationDegrees : 0.0;
+    style.blurRadius = random.bounded(3);
+    style.noiseSigma = random.bounded(12.0);
+    return style;
+}
+
+QImage render(Symbology symbology, const QString& payload, const LabelStyle& style, QRandomGenerator& random)
+{
+    const QVector<bool> modules = encode(symbology, payload);
+    if (modules.isEmpty()) {
+        return QImage();
+    }
+
+    const int moduleWidth = qMax(1, style.moduleWidth);
+    const int quietZone = kQuietZoneModules * moduleWidth;
+    const int margin = 4 * moduleWidth;
+    const int textHeight = qMax(10, 6 * moduleWidth);
+    QImage label((modules.size() + 2 * kQuietZoneModules) * moduleWidth,
+                 margin + style.barHeight + textHeight + margin, QImage::Format_RGB32);
+    label.fill(Qt::white);
+
+    {
+        QPainter painter(&label);
+        for (int i = 0; i < modules.size(); ++i) {
+            if (modules.at(i)) {
+                painter.fillRect(quietZone + i * moduleWidth, margin, moduleWidth, style.barHeight, Qt::black);
+            }
+        }
+        QFont font = painter.font();
+        font.setPixelSize(textHeight - 2);
+        painter.setFont(font);
+        painter.setPen(Qt::black);
+        painter.drawText(QRect(0, margin + style.barHeight, label.width(), textHeight), Qt::AlignCenter, payload);
+    }
+
+    // 旋转后的标签画在刚好容纳它的白底画布上
+    if (!qFuzzyIsNull(style.rotationDegrees)) {
+        const QRect bounds = QTransform().rotate(style.rotationDegrees).mapRect(label.rect());
+        QImage rotated(bounds.size(), QImage::Format_RGB32);
+        rotated.fill(Qt::white);
+        QPainter painter(&rotated);
+        painter.setRenderHint(QPainter::SmoothPixmapTransform);
+        painter.translate(rotated.width() / 2.0, rotated.height() / 2.0);
+        painter.rotate(style.rotationDegrees);
+        painter.drawImage(QPointF(-label.width() / 2.0, -label.height() / 2.0), label);
+        painter.end();
+        label = rotated;
+    }
+
+    QImage gray = label.convertToFormat(QImage::Format_Grayscale8);
+    if (style.blurRadius > 0) {
+        boxBlur(gray, style.blurRadius);
+    }
+    if (style.noiseSigma > 0) {
+        addNoise(gray, style.noiseSigma, random);
+    }
+    return gray;
+}
+
+bool matches(const QString& expected, const QString& decoded)
+{
+    return decoded == expected || decoded == "0" + expected || "0" + decoded == expected;
+}
+
+}
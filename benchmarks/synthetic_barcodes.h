@@ -0,0 +1,75 @@
+#ifndef SYNTHETIC_BARCODES_H
+#define SYNTHETIC_BARCODES_H
+
+#include <QImage>
+#include <QRandomGenerator>
+#include <QString>
+#include <QVector>
+
+/**
+ * 合成条码标签生成器（BarcodeBench使用）
+ *
+ * 按码制规范直接计算条空模块（EAN-13、UPC-A、Code128 B字符集），用QPainter画成标签，
+ * 再按标签样式旋转、模糊并加噪声。同一个随机数种子总是生成同样的语料。
+ */
+namespace SyntheticBarcodes {
+
+enum Symbology {
+    Ean13 = 0,
+    UpcA,
+    Code128,
+    SymbologyCount
+};
+
+/**
+ * @brief 标签的绘制和退化参数
+ */
+struct LabelStyle
+{
+    int moduleWidth = 2;            ///< 最窄条宽（像素），决定图片大小
+    int barHeight = 80;             ///< 条高（像素）
+    double rotationDegrees = 0.0;   ///< 旋转角度
+    int blurRadius = 0;             ///< 盒式模糊半径（像素），0表示不模糊
+    double noiseSigma = 0.0;        ///< 高斯噪声标准差（灰度级），0表示无噪声
+};
+
+/**
+ * @brief 码制名称，与ZXing的名称一致（"EAN-13"、"UPC-A"、"Code128"）
+ */
+QString symbologyName(Symbology symbology);
+
+/**
+ * @brief 文件名前缀（"ean13"、"upca"、"code128"），无法识别时返回SymbologyCount
+ */
+QString filePrefix(Symbology symbology);
+Symbology symbologyFromFilePrefix(const QString& prefix);
+
+/**
+ * @brief 随机内容：EAN-13为13位（首位非0），UPC-A为12位，均含校验位；Code128为6~16位大写字母和数字
+ */
+QString randomPayload(Symbology symbology, QRandomGenerator& random);
+
+/**
+ * @brief 计算条空模块（true为条），不含静区；内容不合法时返回空
+ */
+QVector<bool> encode(Symbology symbology, const QString& payload);
+
+/**
+ * @brief 随机标签样式
+ * @param maxRotationDegrees 最大旋转角度（正负）
+ */
+LabelStyle randomStyle(QRandomGenerator& random, double maxRotationDegrees);
+
+/**
+ * @brief 画出标签（8位灰度图）
+ */
+QImage render(Symbology symbology, const QString& payload, const LabelStyle& style, QRandomGenerator& random);
+
+/**
+ * @brief 解码结果是否与生成的内容一致（UPC-A可能被读成带前导0的EAN-13，反之亦然）
+ */
+bool matches(const QString& expected, const QString& decoded);
+
+}
+
+#endif // SYNTHETIC_BARCODES_H
@@ -0,0 +1,361 @@
+#include "BarcodeDecodeCache.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QtEndian>
+#include <QDebug>
+#include <cstring>
+
+namespace {
+
+// 文件头：魔数 + 格式版本，小端
+constexpr quint32 FileMagic = 0x31434253;       // "SBC1"
+constexpr quint32 FormatVersion = 1;
+constexpr qint64 FileHeaderSize = 8;
+
+// 记录：负载长度(4) + 负载；负载第一个字节是记录类型
+constexpr qint64 RecordHeaderSize = 4;
+constexpr quint8 FileRecordKind = 1;            // 大小(8) 修改时间(8) 内容哈希(8) 路径(UTF-8)
+constexpr quint8 ResultRecordKind = 2;          // 缓存键(8) 阶段(1) 条码(UTF-8)
+constexpr qint64 FileRecordFixedSize = 1 + 24;
+constexpr qint64 ResultRecordFixedSize = 1 + 9;
+
+// 重复记录超过这个数量且超过有效记录数时，打开时重写压缩
+constexpr int CompactThreshold = 4096;
+
+constexpr quint64 Prime1 = 11400714785074694791ULL;
+constexpr quint64 Prime2 = 14029467366897019727ULL;
+constexpr quint64 Prime3 = 1609587929392839161ULL;
+constexpr quint64 Prime4 = 9650029242287828579ULL;
+constexpr quint64 Prime5 = 2870177450012600261ULL;
+
+inline quint64 rotateLeft(quint64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline quint64 roundStep(quint64 accumulator, quint64 input)
+{
+    accumulator += input * Prime2;
+    return rotateLeft(accumulator, 31) * Prime1;
+}
+
+inline quint64 mergeRound(quint64 accumulator, quint64 value)
+{
+    accumulator ^= roundStep(0, value);
+    return accumulator * Prime1 + Prime4;
+}
+
+QByteArray fileRecord(const QString& path, qint64 size, qint64 modifiedMsecs, quint64 contentHash)
+{
+    const QByteArray utf8 = path.toUtf8();
+    QByteArray record(RecordHeaderSize + FileRecordFixedSize + utf8.size(), Qt::Uninitialized);
+    uchar* p = reinterpret_cast<uchar*>(record.data());
+    qToLittleEndian(static_cast<quint32>(FileRecordFixedSize + utf8.size()), p);
+    p[4] = FileRecordKind;
+    qToLittleEndian(size, p + 5);
+    qToLittleEndian(modifiedMsecs, p + 13);
+    qToLittleEndian(contentHash, p + 21);
+    memcpy(p + 29, utf8.constData(), utf8.size());
+    return record;
+}
+
+QByteArray resultRecord(quint64 key, const QString& barcode, BarcodeDecoder::Stage stage)
+{
+    const QByteArray utf8 = barcode.toUtf8();
+    QByteArray record(RecordHeaderSize + ResultRecordFixedSize + utf8.size(), Qt::Uninitialized);
+    uchar* p = reinterpret_cast<uchar*>(record.data());
+    qToLittleEndian(static_cast<quint32>(ResultRecordFixedSize + utf8.size()), p);
+    p[4] = ResultRecordKind;
+    qToLittleEndian(key, p + 5);
+    p[13] = static_cast<uchar>(stage);
+    memcpy(p + 14, utf8.constData(), utf8.size());
+    return record;
+}
+
+QByteArray fileHeader()
+{
+    QByteArray header(FileHeaderSize, Qt::Uninitialized);
+    qToLittleEndian(FileMagic, header.data());
+    qToLittleEndian(FormatVersion, header.data() + 4);
+    return header;
+}
+
+}
+
+BarcodeDecodeCache::BarcodeDecodeCache(const QString& filePath)
+    : m_filePath(filePath)
+{
+}
+
+BarcodeDecodeCache::~BarcodeDecodeCache()
+{
+    close();
+}
+
+bool BarcodeDecodeCache::open(QString* errorMessage)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen()) {
+        return true;
+    }
+
+    QString error;
+    if (!loadLocked(&error)) {
+        qWarning() << error;
+        if (errorMessage) {
+            *errorMessage = error;
+        }
+        m_file.close();
+        m_files.clear();
+        m_results.clear();
+        return false;
+    }
+    return true;
+}
+
+void BarcodeDecodeCache::close()
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_file.isOpen()) {
+        m_file.close();
+    }
+}
+
+bool BarcodeDecodeCache::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_file.isOpen();
+}
+
+bool BarcodeDecodeCache::loadLocked(QString* errorMessage)
+{
+    QDir().mkpath(QFileInfo(m_filePath).absolutePath());
+    m_file.setFileName(m_filePath);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        *errorMessage = QString("无法打开条码缓存文件 %1: %2").arg(m_filePath, m_file.errorString());
+        return false;
+    }
+
+    const QByteArray raw = m_file.readAll();
+    if (raw.isEmpty()) {
+        return m_file.write(fileHeader()) == FileHeaderSize;
+    }
+    if (raw.size() < FileHeaderSize
+        || qFromLittleEndian<quint32>(raw.constData()) != FileMagic
+        || qFromLittleEndian<quint32>(raw.constData() + 4) != FormatVersion) {
+        // 缓存随时可以重建，格式不对就清空重来
+        qWarning() << "条码缓存文件格式不正确，已清空:" << m_filePath;
+        m_file.resize(0);
+        m_file.seek(0);
+        return m_file.write(fileHeader()) == FileHeaderSize;
+    }
+
+    // 逐条读取，后出现的记录覆盖先出现的；不完整的尾部是写了一半的记录
+    const uchar* data = reinterpret_cast<const uchar*>(raw.constData());
+    qint64 offset = FileHeaderSize;
+    int recordCount = 0;
+    while (offset + RecordHeaderSize <= raw.size()) {
+        const qint64 length = qFromLittleEndian<quint32>(data + offset);
+        if (length < 1 || offset + RecordHeaderSize + length > raw.size()) {
+            break;
+        }
+        const uchar* p = data + offset + RecordHeaderSize;
+        if (p[0] == FileRecordKind && length >= FileRecordFixedSize) {
+            FileRecord record;
+            record.size = qFromLittleEndian<qint64>(p + 1);
+            record.modifiedMsecs = qFromLittleEndian<qint64>(p + 9);
+            record.contentHash = qFromLittleEndian<quint64>(p + 17);
+            const QString path = QString::fromUtf8(reinterpret_cast<const char*>(p + FileRecordFixedSize),
+                                                   length - FileRecordFixedSize);
+            m_files.insert(path, record);
+        } else if (p[0] == ResultRecordKind && length >= ResultRecordFixedSize) {
+            ResultRecord record;
+            record.stage = static_cast<BarcodeDecoder::Stage>(qMin<int>(p[9], BarcodeDecoder::NotFound));
+            record.barcode = QString::fromUtf8(reinterpret_cast<const char*>(p + ResultRecordFixedSize),
+                                               length - ResultRecordFixedSize);
+            m_results.insert(qFromLittleEndian<quint64>(p + 1), record);
+        }
+        offset += RecordHeaderSize + length;
+        ++recordCount;
+    }
+
+    const int duplicates = recordCount - m_files.size() - m_results.size();
+    if (duplicates > CompactThreshold && duplicates > m_files.size() + m_results.size()) {
+        return rewriteLocked(errorMessage);
+    }
+    if (offset < raw.size()) {
+        m_file.resize(offset);
+    }
+    return m_file.seek(offset);
+}
+
+bool BarcodeDecodeCache::rewriteLocked(QString* errorMessage)
+{
+    QByteArray compacted = fileHeader();
+    for (auto it = m_files.cbegin(); it != m_files.cend(); ++it) {
+        compacted += fileRecord(it.key(), it->size, it->modifiedMsecs, it->contentHash);
+    }
+    for (auto it = m_results.cbegin(); it != m_results.cend(); ++it) {
+        compacted += resultRecord(it.key(), it->barcode, it->stage);
+    }
+
+    m_file.close();
+    QSaveFile file(m_filePath);
+    if (!file.open(QIODevice::WriteOnly) || file.write(compacted) != compacted.size() || !file.commit()) {
+        *errorMessage = QString("无法重写条码缓存文件 %1: %2").arg(m_filePath, file.errorString());
+        return false;
+    }
+    if (!m_file.open(QIODevice::ReadWrite) || !m_file.seek(m_file.size())) {
+        *errorMessage = QString("无法打开条码缓存文件 %1: %2").arg(m_filePath, m_file.errorString());
+        return false;
+    }
+    return true;
+}
+
+quint64 BarcodeDecodeCache::hash(const void* data, qsizetype length, quint64 seed)
+{
+    const uchar* p = static_cast<const uchar*>(data);
+    const uchar* const end = p + length;
+    quint64 h;
+
+    if (length >= 32) {
+        quint64 v1 = seed + Prime1 + Prime2;
+        quint64 v2 = seed + Prime2;
+        quint64 v3 = seed;
+        quint64 v4 = seed - Prime1;
+        const uchar* const limit = end - 32;
+        do {
+            v1 = roundStep(v1, qFromLittleEndian<quint64>(p));
+            v2 = roundStep(v2, qFromLittleEndian<quint64>(p + 8));
+            v3 = roundStep(v3, qFromLittleEndian<quint64>(p + 16));
+            v4 = roundStep(v4, qFromLittleEndian<quint64>(p + 24));
+            p += 32;
+        } while (p <= limit);
+
+        h = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    } else {
+        h = seed + Prime5;
+    }
+
+    h += static_cast<quint64>(length);
+    for (; p + 8 <= end; p += 8) {
+        h ^= roundStep(0, qFromLittleEndian<quint64>(p));
+        h = rotateLeft(h, 27) * Prime1 + Prime4;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<quint64>(qFromLittleEndian<quint32>(p)) * Prime1;
+        h = rotateLeft(h, 23) * Prime2 + Prime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= *p * Prime5;
+        h = rotateLeft(h, 11) * Prime1;
+    }
+
+    h ^= h >> 33;
+    h *= Prime2;
+    h ^= h >> 29;
+    h *= Prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+quint64 BarcodeDecodeCache::contentKey(const QString& filePath, quint64 settingsHash)
+{
+    const QFileInfo info(filePath);
+    const QString path = info.absoluteFilePath();
+    const qint64 size = info.size();
+    const qint64 modifiedMsecs = info.lastModified().toMSecsSinceEpoch();
+
+    quint64 contentHash = 0;
+    bool known = false;
+    {
+        QMutexLocker locker(&m_mutex);
+        const auto it = m_files.constFind(path);
+        if (it != m_files.cend() && it->size == size && it->modifiedMsecs == modifiedMsecs) {
+            contentHash = it->contentHash;
+            known = true;
+        }
+    }
+
+    if (!known) {
+        // 文件是新的或改过：读入整个文件计算哈希（在锁外，多个工作线程可以同时计算）
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly)) {
+            return 0;
+        }
+        if (uchar* mapped = file.map(0, file.size())) {
+            contentHash = hash(mapped, file.size());
+            file.unmap(mapped);
+        } else {
+            const QByteArray bytes = file.readAll();
+            contentHash = hash(bytes.constData(), bytes.size());
+        }
+
+        QMutexLocker locker(&m_mutex);
+        m_files.insert(path, FileRecord{size, modifiedMsecs, contentHash});
+        appendRecordLocked(fileRecord(path, size, modifiedMsecs, contentHash));
+    }
+
+    // 内容哈希和设置哈希再混合一次；0保留表示无效
+    const quint64 parts[2] = {qToLittleEndian(contentHash), qToLittleEndian(settingsHash)};
+    const quint64 key = hash(parts, sizeof(parts));
+    return key ? key : 1;
+}
+
+bool BarcodeDecodeCache::find(quint64 key, QString* barcode, BarcodeDecoder::Stage* stage) const
+{
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_results.constFind(key);
+    if (it == m_results.cend()) {
+        return false;
+    }
+    if (barcode) {
+        *barcode = it->barcode;
+    }
+    if (stage) {
+        *stage = it->stage;
+    }
+    return true;
+}
+
+void BarcodeDecodeCache::insert(quint64 key, const QString& barcode, BarcodeDecoder::Stage stage)
+{
+    if (key == 0) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    const auto it = m_results.constFind(key);
+    if (it != m_results.cend() && it->barcode == barcode && it->stage == stage) {
+        return;
+    }
+    m_results.insert(key, ResultRecord{barcode, stage});
+    appendRecordLocked(resultRecord(key, barcode, stage));
+}
+
+bool BarcodeDecodeCache::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    return !m_file.isOpen() || m_file.flush();
+}
+
+int BarcodeDecodeCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_results.size();
+}
+
+void BarcodeDecodeCache::appendRecordLocked(const QByteArray& record)
+{
+    // 没有打开文件时只缓存在内存中
+    if (m_file.isOpen() && m_file.write(record) != record.size()) {
+        qWarning() << "写入条码缓存失败:" << m_file.errorString();
+    }
+}
@@ -0,0 +1,113 @@
+#ifndef BARCODEDECODECACHE_H
+#define BARCODEDECODECACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include "BarcodeDecoder.h"
+
+/**
+ * @brief BarcodeDecodeCache类 - 按文件内容缓存的条码解码结果
+ *
+ * 缓存键是图片文件内容的xxHash64与解码设置指纹的组合，同一张图片换了路径或复制一份也能命中，
+ * 改了码制等设置则自然失效。为了不必每次都读整个文件计算哈希，另外按路径记住上次的文件大小、
+ * 修改时间和内容哈希，两者都没变时直接用记住的哈希。未识别的结果也缓存（同样设置下重扫结果不变）。
+ *
+ * 磁盘上是一个只追加的记录文件，打开时整个读入内存；重复的记录过多时重写压缩，
+ * 写了一半的尾部在打开时丢弃。所有方法都是线程安全的，批量扫描的工作线程可以同时使用。
+ */
+class BarcodeDecodeCache
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param filePath 缓存文件路径
+     */
+    explicit BarcodeDecodeCache(const QString& filePath);
+
+    /**
+     * @brief 析构函数（刷新并关闭缓存文件）
+     */
+    ~BarcodeDecodeCache();
+
+    BarcodeDecodeCache(const BarcodeDecodeCache&) = delete;
+    BarcodeDecodeCache& operator=(const BarcodeDecodeCache&) = delete;
+
+    /**
+     * @brief 打开（不存在时创建）缓存文件并加载全部记录
+     * @param errorMessage 如果不为空，失败时写入错误消息
+     * @return 如果成功返回true
+     */
+    bool open(QString* errorMessage = nullptr);
+
+    void close();
+    bool isOpen() const;
+
+    /**
+     * @brief xxHash64
+     */
+    static quint64 hash(const void* data, qsizetype length, quint64 seed = 0);
+
+    /**
+     * @brief 计算图片文件在指定解码设置下的缓存键
+     *
+     * 文件大小和修改时间与上次相同时不读文件，否则读入整个文件计算内容哈希并记住。
+     * @param filePath 图片文件路径
+     * @param settingsHash 解码设置指纹的哈希
+     * @return 缓存键，文件无法读取时返回0
+     */
+    quint64 contentKey(const QString& filePath, quint64 settingsHash);
+
+    /**
+     * @brief 查找缓存的解码结果
+     * @param key contentKey()返回的缓存键
+     * @param barcode 命中时写入条码（未识别时为空）
+     * @param stage 如果不为空，命中时写入当初识别成功的阶段
+     * @return 如果命中返回true
+     */
+    bool find(quint64 key, QString* barcode, BarcodeDecoder::Stage* stage = nullptr) const;
+
+    /**
+     * @brief 记录解码结果
+     */
+    void insert(quint64 key, const QString& barcode, BarcodeDecoder::Stage stage);
+
+    /**
+     * @brief 把缓冲的记录写入磁盘
+     */
+    bool flush();
+
+    /**
+     * @brief 缓存的解码结果数
+     */
+    int size() const;
+
+private:
+    struct FileRecord
+    {
+        qint64 size = -1;
+        qint64 modifiedMsecs = 0;       ///< UTC毫秒
+        quint64 contentHash = 0;
+    };
+
+    struct ResultRecord
+    {
+        QString barcode;
+        BarcodeDecoder::Stage stage = BarcodeDecoder::NotFound;
+    };
+
+    bool loadLocked(QString* errorMessage);
+    bool rewriteLocked(QString* errorMessage);
+    void appendRecordLocked(const QByteArray& record);
+
+    QString m_filePath;                         ///< 缓存文件路径
+    QFile m_file;                               ///< 缓存文件（追加写）
+    QHash<QString, FileRecord> m_files;         ///< 图片路径到上次的大小、修改时间和内容哈希
+    QHash<quint64, ResultRecord> m_results;     ///< 缓存键到解码结果
+
+    mutable QMutex m_mutex;
+};
+
+#endif // BARCODEDECODECACHE_H
@@ -0,0 +1,292 @@
+#include "BarcodeDecoder.h"
+#include "ImagePreprocessor.h"
+#include <QDebug>
+
+#include "ReadBarcode.h"
+#include "BarcodeFormat.h"
+#include "Result.h"
+#include "ImageView.h"
+#include "ReaderOptions.h"
+
+struct BarcodeDecoder::Options
+{
+    QString symbologies = QStringLiteral("EAN-13,EAN-8,UPC-A,Code128");
+    ZXing::BarcodeFormats storeFormats = ZXing::BarcodeFormat::EAN13 | ZXing::BarcodeFormat::EAN8
+                                         | ZXing::BarcodeFormat::UPCA | ZXing::BarcodeFormat::Code128;
+    int fastPassMaxDimension = 1024;
+    Stage maxStage = AllFormats;
+    bool normalizeContrast = true;
+    bool sharpen = false;
+    bool binarize = false;
+    ZXing::ReaderOptions stages[StageCount];
+    ZXing::ReaderOptions multiCode;
+
+    void build()
+    {
+        // 亮度图已经缩小过，不让ZXing再做一次金字塔缩放
+        stages[FastPass].setFormats(storeFormats);
+        stages[FastPass].setTryHarder(false);
+        stages[FastPass].setTryRotate(false);
+        stages[FastPass].setTryDownscale(false);
+        stages[FastPass].setMaxNumberOfSymbols(1);
+
+        stages[FullResolution].setFormats(storeFormats);
+        stages[FullResolution].setTryHarder(true);
+        stages[FullResolution].setTryRotate(true);
+        stages[FullResolution].setMaxNumberOfSymbols(1);
+
+        stages[AllFormats].setFormats(ZXing::BarcodeFormat::Any);
+        stages[AllFormats].setTryHarder(true);
+        stages[AllFormats].setTryRotate(true);
+        stages[AllFormats].setMaxNumberOfSymbols(1);
+
+        // 多码模式不限制条码个数（ZXing默认最多255个）
+        multiCode.setFormats(storeFormats);
+        multiCode.setTryHarder(true);
+        multiCode.setTryRotate(true);
+    }
+};
+
+namespace {
+
+ZXing::ImageView lumView(const LuminanceImage& luminance)
+{
+    return ZXing::ImageView{luminance.data, luminance.width, luminance.height,
+                            ZXing::ImageFormat::Lum, luminance.bytesPerLine};
+}
+
+QString readFirst(const LuminanceImage& luminance, const ZXing::ReaderOptions& options)
+{
+    // ZXing直接读取预处理后的亮度缓冲区
+    try {
+        auto results = ZXing::ReadBarcodes(lumView(luminance), options);
+        if (!results.empty() && results[0].isValid()) {
+            return QString::fromStdString(results[0].text());
+        }
+    }
+    catch (const std::exception& e) {
+        qWarning() << "ZXing-C++ exception: " << e.what();
+    }
+    return QString();
+}
+
+}
+
+QString BarcodeDecoder::stageName(Stage stage)
+{
+    switch (stage) {
+    case FastPass:
+        return QStringLiteral("fast-pass");
+    case FullResolution:
+        return QStringLiteral("full-resolution");
+    case AllFormats:
+        return QStringLiteral("all-formats");
+    default:
+        return QStringLiteral("not-found");
+    }
+}
+
+BarcodeDecoder::BarcodeDecoder()
+{
+    auto options = std::make_shared<Options>();
+    options->build();
+    m_options = options;
+}
+
+bool BarcodeDecoder::setSymbologies(const QString& symbologies)
+{
+    ZXing::BarcodeFormats formats;
+    try {
+        formats = ZXing::BarcodeFormatsFromString(symbologies.toStdString());
+    }
+    catch (const std::exception& e) {
+        qWarning() << "Invalid barcode symbologies" << symbologies << ":" << e.what();
+        return false;
+    }
+    if (formats.empty()) {
+        return false;
+    }
+
+    auto options = std::make_shared<Options>(*m_options);
+    options->symbologies = symbologies;
+    options->storeFormats = formats;
+    options->build();
+    m_options = options;
+    return true;
+}
+
+QString BarcodeDecoder::symbologies() const
+{
+    return m_options->symbologies;
+}
+
+void BarcodeDecoder::setFastPassMaxDimension(int pixels)
+{
+    auto options = std::make_shared<Options>(*m_options);
+    options->fastPassMaxDimension = qMax(64, pixels);
+    m_options = options;
+}
+
+int BarcodeDecoder::fastPassMaxDimension() const
+{
+    return m_options->fastPassMaxDimension;
+}
+
+void BarcodeDecoder::setMaxStage(Stage stage)
+{
+    auto options = std::make_shared<Options>(*m_options);
+    options->maxStage = qBound(FastPass, stage, AllFormats);
+    m_options = options;
+}
+
+BarcodeDecoder::Stage BarcodeDecoder::maxStage() const
+{
+    return m_options->maxStage;
+}
+
+void BarcodeDecoder::setPreprocessing(bool normalizeContrast, bool sharpen, bool binarize)
+{
+    auto options = std::make_shared<Options>(*m_options);
+    options->normalizeContrast = normalizeContrast;
+    options->sharpen = sharpen;
+    options->binarize = binarize;
+    m_options = options;
+}
+
+QString BarcodeDecoder::settingsFingerprint() const
+{
+    const Options& options = *m_options;
+    return QString("%1;%2;%3;%4%5%6").arg(options.symbologies).arg(options.fastPassMaxDimension)
+        .arg(options.maxStage).arg(int(options.normalizeContrast)).arg(int(options.sharpen)).arg(int(options.binarize));
+}
+
+ImagePreprocessor& BarcodeDecoder::preprocessor() const
+{
+    thread_local ImagePreprocessor threadPreprocessor;
+    threadPreprocessor.setNormalizeContrast(m_options->normalizeContrast);
+    threadPreprocessor.setSharpen(m_options->sharpen);
+    threadPreprocessor.setBinarize(m_options->binarize);
+    return threadPreprocessor;
+}
+
+QString BarcodeDecoder::decode(const QImage& image, Stage* stage) const
+{
+    return decode(image, std::function<QImage()>(), stage);
+}
+
+QString BarcodeDecoder::decode(const QImage& preview, const std::function<QImage()>& loadFullResolution,
+                               Stage* stage) const
+{
+    if (stage) {
+        *stage = NotFound;
+    }
+    if (preview.isNull()) {
+        return QString();
+    }
+
+    ImagePreprocessor& imagePreprocessor = preprocessor();
+    LuminanceImage luminance = imagePreprocessor.process(preview);
+    const QString barcode = decodeFastPass(luminance, imagePreprocessor, stage);
+    if (!barcode.isEmpty() || m_options->maxStage == FastPass) {
+        return barcode;
+    }
+
+    // 快速阶段没找到，才花代价加载原始分辨率图片
+    if (loadFullResolution) {
+        const QImage full = loadFullResolution();
+        if (!full.isNull()) {
+            luminance = imagePreprocessor.process(full);
+        }
+    }
+    return decodeFullResolution(luminance, stage);
+}
+
+QString BarcodeDecoder::decodeLuminance(const uchar* luminance, int width, int height, int bytesPerLine,
+                                        Stage* stage) const
+{
+    if (stage) {
+        *stage = NotFound;
+    }
+    if (!luminance || width <= 0 || height <= 0) {
+        return QString();
+    }
+
+    ImagePreprocessor& imagePreprocessor = preprocessor();
+    const LuminanceImage prepared = imagePreprocessor.process(LuminanceImage{luminance, width, height, bytesPerLine});
+    const QString barcode = decodeFastPass(prepared, imagePreprocessor, stage);
+    if (!barcode.isEmpty()) {
+        return barcode;
+    }
+    return decodeFullResolution(prepared, stage);
+}
+
+QList<DecodedBarcode> BarcodeDecoder::decodeAll(const QImage& image) const
+{
+    QList<DecodedBarcode> barcodes;
+    if (image.isNull()) {
+        return barcodes;
+    }
+
+    const LuminanceImage luminance = preprocessor().process(image);
+    try {
+        for (const ZXing::Result& result : ZXing::ReadBarcodes(lumView(luminance), m_options->multiCode)) {
+            if (!result.isValid()) {
+                continue;
+            }
+            const ZXing::Position& position = result.position();
+            DecodedBarcode barcode;
+            barcode.text = QString::fromStdString(result.text());
+            barcode.format = QString::fromStdString(ZXing::ToString(result.format()));
+            barcode.position << QPoint(position.topLeft().x, position.topLeft().y)
+                             << QPoint(position.topRight().x, position.topRight().y)
+                             << QPoint(position.bottomRight().x, position.bottomRight().y)
+                             << QPoint(position.bottomLeft().x, position.bottomLeft().y);
+            barcodes.append(barcode);
+        }
+    }
+    catch (const std::exception& e) {
+        qWarning() << "ZXing-C++ exception: " << e.what();
+    }
+    return barcodes;
+}
+
+QString BarcodeDecoder::decodeAt(const QImage& image, Stage stage) const
+{
+    if (image.isNull() || stage < FastPass || stage >= StageCount) {
+        return QString();
+    }
+
+    ImagePreprocessor& imagePreprocessor = preprocessor();
+    const LuminanceImage luminance = imagePreprocessor.process(image);
+    if (stage == FastPass) {
+        return readFirst(imagePreprocessor.downscale(luminance, m_options->fastPassMaxDimension), m_options->stages[FastPass]);
+    }
+    return readFirst(luminance, m_options->stages[stage]);
+}
+
+QString BarcodeDecoder::decodeFastPass(const LuminanceImage& luminance, ImagePreprocessor& imagePreprocessor,
+                                       Stage* stage) const
+{
+    const QString barcode = readFirst(imagePreprocessor.downscale(luminance, m_options->fastPassMaxDimension),
+                                      m_options->stages[FastPass]);
+    if (!barcode.isEmpty() && stage) {
+        *stage = FastPass;
+    }
+    return barcode;
+}
+
+QString BarcodeDecoder::decodeFullResolution(const LuminanceImage& luminance, Stage* stage) const
+{
+    // 后两个阶段共用同一份原始分辨率亮度图
+    const Options& options = *m_options;
+    for (int next = FullResolution; next <= options.maxStage; ++next) {
+        const QString barcode = readFirst(luminance, options.stages[next]);
+        if (!barcode.isEmpty()) {
+            if (stage) {
+                *stage = static_cast<Stage>(next);
+            }
+            return barcode;
+        }
+    }
+    return QString();
+}
@@ -0,0 +1,159 @@
+#ifndef BARCODEDECODER_H
+#define BARCODEDECODER_H
+
+#include <QString>
+#include <QImage>
+#include <QList>
+#include <QPolygon>
+#include <functional>
+#include <memory>
+
+struct LuminanceImage;
+class ImagePreprocessor;
+
+/**
+ * @brief 多码识别中的一个条码
+ */
+struct DecodedBarcode
+{
+    QString text;           ///< 条码内容
+    QString format;         ///< 码制名称，如"EAN-13"
+    QPolygon position;      ///< 条码四个角在图片中的坐标（左上、右上、右下、左下）
+};
+
+/**
+ * @brief BarcodeDecoder类 - 渐进式ZXing条码解码器
+ *
+ * 先走最便宜的路径，未识别时才逐级加码：
+ * 1. FastPass：缩小的灰度图，只找店铺使用的码制，不使用tryHarder
+ * 2. FullResolution：原始分辨率，店铺码制，tryHarder + tryRotate
+ * 3. AllFormats：原始分辨率，全部码制，tryHarder + tryRotate（兜底）
+ *
+ * 每张图片先由ImagePreprocessor一遍转换成8位亮度并拉伸对比度，三个阶段共用这份亮度图，
+ * FastPass在它上面做2x2均值缩小；ZXing直接读取亮度缓冲区，不再做ARGB32转换。
+ *
+ * 解码器没有可变状态，复制开销很小（选项共享），可以在多个线程中同时使用同一个实例；
+ * 预处理缓冲区按线程分配，在同一线程的多次解码（如视频帧）之间复用。
+ * 图片扫描、视频流扫描共用这一个解码入口。
+ */
+class BarcodeDecoder
+{
+public:
+    /**
+     * @brief 解码阶段
+     */
+    enum Stage {
+        FastPass = 0,       ///< 缩小的灰度图 + 店铺码制
+        FullResolution,     ///< 原始分辨率 + 店铺码制 + tryHarder/tryRotate
+        AllFormats,         ///< 原始分辨率 + 全部码制 + tryHarder/tryRotate
+        StageCount,
+        NotFound = StageCount   ///< 所有阶段都未识别
+    };
+
+    /**
+     * @brief 阶段名称（用于日志和基准测试输出）
+     */
+    static QString stageName(Stage stage);
+
+    BarcodeDecoder();
+
+    /**
+     * @brief 设置店铺使用的码制，FastPass和FullResolution阶段只找这些码制
+     * @param symbologies ZXing码制名称，逗号分隔，默认"EAN-13,EAN-8,UPC-A,Code128"
+     * @return 如果名称全部有效返回true，否则保持原设置
+     */
+    bool setSymbologies(const QString& symbologies);
+    QString symbologies() const;
+
+    /**
+     * @brief 设置FastPass阶段图片的最大边长（像素），默认1024
+     */
+    void setFastPassMaxDimension(int pixels);
+    int fastPassMaxDimension() const;
+
+    /**
+     * @brief 设置解码前的预处理
+     * @param normalizeContrast 拉伸对比度（默认开启）
+     * @param sharpen 3x3锐化（默认关闭）
+     * @param binarize Otsu二值化（默认关闭）
+     */
+    void setPreprocessing(bool normalizeContrast, bool sharpen = false, bool binarize = false);
+
+    /**
+     * @brief 设置最多执行到哪个阶段（视频流只用FastPass，靠后续帧补偿）
+     */
+    void setMaxStage(Stage stage);
+    Stage maxStage() const;
+
+    /**
+     * @brief 影响解码结果的全部设置，序列化成字符串（解码结果缓存用它区分不同设置下的结果）
+     */
+    QString settingsFingerprint() const;
+
+    /**
+     * @brief 从图片中渐进解码条码
+     * @param image 要扫描的图片
+     * @param stage 如果不为空，写入识别成功的阶段（未识别时为NotFound）
+     * @return 解码到的条码字符串，如果没有找到返回空字符串
+     */
+    QString decode(const QImage& image, Stage* stage = nullptr) const;
+
+    /**
+     * @brief 先在缩小的预览图上执行FastPass，未识别时才加载原始分辨率图片执行后续阶段
+     * @param preview 预览图（通常由BarcodeImageLoader按FastPass尺寸加载）
+     * @param loadFullResolution 加载原始分辨率图片的函数；为空时后续阶段直接使用预览图
+     * @param stage 如果不为空，写入识别成功的阶段
+     * @return 解码到的条码字符串，如果没有找到返回空字符串
+     */
+    QString decode(const QImage& preview, const std::function<QImage()>& loadFullResolution,
+                   Stage* stage = nullptr) const;
+
+    /**
+     * @brief 从8位灰度数据中渐进解码条码（不需要预处理时不复制数据）
+     * @param luminance 灰度数据（如YUV视频帧的Y平面）
+     * @param width 宽度
+     * @param height 高度
+     * @param bytesPerLine 每行字节数
+     * @param stage 如果不为空，写入识别成功的阶段
+     * @return 解码到的条码字符串，如果没有找到返回空字符串
+     */
+    QString decodeLuminance(const uchar* luminance, int width, int height, int bytesPerLine,
+                            Stage* stage = nullptr) const;
+
+    /**
+     * @brief 找出图片中的全部条码（多码模式，如传送带上的一排商品）
+     *
+     * 在原始分辨率上用店铺码制、tryHarder/tryRotate执行一遍，不做渐进；
+     * 同一条码出现在不同位置时每处各返回一项。
+     * @param image 要扫描的图片
+     * @return 按ZXing找到的顺序排列的条码，没有找到时为空列表
+     */
+    QList<DecodedBarcode> decodeAll(const QImage& image) const;
+
+    /**
+     * @brief 只执行指定的一个阶段（基准测试按阶段统计用）
+     */
+    QString decodeAt(const QImage& image, Stage stage) const;
+
+private:
+    struct Options;
+
+    /**
+     * @brief 在已预处理的亮度图上执行FastPass
+     */
+    QString decodeFastPass(const LuminanceImage& luminance, ImagePreprocessor& preprocessor, Stage* stage) const;
+
+    /**
+     * @brief 在已预处理的原始分辨率亮度图上依次执行FastPass之后的阶段
+     */
+    QString decodeFullResolution(const LuminanceImage& luminance, Stage* stage) const;
+
+    /**
+     * @brief 当前线程的预处理器（按本解码器的选项配置）
+     */
+    ImagePreprocessor& preprocessor() const;
+
+    std::shared_ptr<const Options> m_options;   ///< 各阶段预先构造的ZXing选项，副本之间共享
+};
+
+#endif // BARCODEDECODER_H
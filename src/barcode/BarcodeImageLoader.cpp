@@ -0,0 +1,48 @@
+#include "BarcodeImageLoader.h"
+#include <QImageReader>
+
+void BarcodeImageLoader::setRegionOfInterest(const QRectF& region)
+{
+    m_regionOfInterest = region.isEmpty() ? QRectF() : region.intersected(QRectF(0.0, 0.0, 1.0, 1.0));
+}
+
+QImage BarcodeImageLoader::load(const QString& filePath, int maxDimension, bool* downscaled,
+                                QString* errorMessage) const
+{
+    if (downscaled) {
+        *downscaled = false;
+    }
+
+    QImageReader reader(filePath);
+    reader.setAutoTransform(true);
+
+    // 读文件头就能得到尺寸；个别格式不支持时退回完整解码
+    const QSize originalSize = reader.size();
+    if (originalSize.isValid()) {
+        QRect clip(QPoint(0, 0), originalSize);
+        if (!m_regionOfInterest.isNull()) {
+            clip = QRect(qRound(m_regionOfInterest.x() * originalSize.width()),
+                         qRound(m_regionOfInterest.y() * originalSize.height()),
+                         qRound(m_regionOfInterest.width() * originalSize.width()),
+                         qRound(m_regionOfInterest.height() * originalSize.height()))
+                   .intersected(clip);
+            if (!clip.isEmpty()) {
+                reader.setClipRect(clip);
+            }
+        }
+
+        // 缩放尺寸是相对裁剪后的区域而言的
+        if (maxDimension > 0 && qMax(clip.width(), clip.height()) > maxDimension) {
+            reader.setScaledSize(clip.size().scaled(maxDimension, maxDimension, Qt::KeepAspectRatio));
+            if (downscaled) {
+                *downscaled = true;
+            }
+        }
+    }
+
+    QImage image = reader.read();
+    if (image.isNull() && errorMessage) {
+        *errorMessage = QString("Failed to load image: %1 (%2)").arg(filePath, reader.errorString());
+    }
+    return image;
+}
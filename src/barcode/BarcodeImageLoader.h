@@ -0,0 +1,44 @@
+#ifndef BARCODEIMAGELOADER_H
+#define BARCODEIMAGELOADER_H
+
+#include <QString>
+#include <QImage>
+#include <QRectF>
+
+/**
+ * @brief BarcodeImageLoader类 - 按需缩小的条码图片加载器
+ *
+ * 手机照片动辄1200万~5000万像素，而快速解码阶段只需要约1000像素的长边。
+ * 加载器用QImageReader的setScaledSize直接解码出小图（JPEG解码器会用DCT缩放，
+ * 根本不解出全部像素），并可以只解码感兴趣的区域。只有渐进解码器在小图上没找到条码时
+ * 才会要求按原始分辨率重新加载。
+ *
+ * 没有可变状态，可以在多个线程中同时使用。
+ */
+class BarcodeImageLoader
+{
+public:
+    /**
+     * @brief 设置感兴趣区域（相对图片宽高的比例，如QRectF(0.1, 0.25, 0.8, 0.5)），空矩形表示整张图片
+     *
+     * 区域按文件中存储的像素方向计算（EXIF旋转之前）。
+     */
+    void setRegionOfInterest(const QRectF& region);
+    QRectF regionOfInterest() const { return m_regionOfInterest; }
+
+    /**
+     * @brief 加载图片（按EXIF方向自动旋转）
+     * @param filePath 图片文件路径
+     * @param maxDimension 长边上限（像素），0表示原始分辨率
+     * @param downscaled 如果不为空，写入是否比原始分辨率小（为false时无需再按原始分辨率加载）
+     * @param errorMessage 如果不为空，失败时写入错误消息
+     * @return 加载的图片，失败时为空图片
+     */
+    QImage load(const QString& filePath, int maxDimension, bool* downscaled = nullptr,
+                QString* errorMessage = nullptr) const;
+
+private:
+    QRectF m_regionOfInterest;      ///< 感兴趣区域（比例）
+};
+
+#endif // BARCODEIMAGELOADER_H
@@ -1,4 +1,7 @@
 #include "BarcodeScanner.h"
+#include "VideoDecodePipeline.h"
+#include "BarcodeDecodeCache.h"
+#include "../utils/Logging.h"
 #include <QDebug>
 #include <QDir>
 #include <QFileInfo>
@@ -6,42 +9,172 @@
 #include <QPixmap>
 #include <QTime>
 #include <QRegularExpression>
+#include <QUrl>
+#include <QCamera>
+#include <QMediaDevices>
+#include <QMediaCaptureSession>
+#include <QMediaPlayer>
+#include <QVideoSink>
+#include <QtConcurrent>
+#include <QThread>
 
-#include "ReadBarcode.h"
-#include "BarcodeFormat.h"
-#include "Result.h"
-#include "ImageView.h"
-#include "ReaderOptions.h"
+namespace {
+
+/**
+ * @brief 解码已加载的图片并写入缓存（在线程池中执行）
+ *
+ * 预览图比原始分辨率小时，快速阶段没找到条码就按原始分辨率重新加载，
+ * 重新加载的耗时计入loadMsecs而不是decodeMsecs。
+ */
+void decodePreview(const BarcodeDecoder& decoder, const BarcodeImageLoader& loader, BarcodeDecodeCache* cache,
+                   quint64 cacheKey, const QImage& preview, bool downscaled, BarcodeScanResult* result)
+{
+    double reloadMsecs = 0.0;
+    std::function<QImage()> loadFullResolution;
+    if (downscaled) {
+        loadFullResolution = [&]() {
+            QElapsedTimer reloadTimer;
+            reloadTimer.start();
+            const QImage full = loader.load(result->filePath, 0);
+            reloadMsecs = reloadTimer.nsecsElapsed() / 1e6;
+            return full;
+        };
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    result->barcode = decoder.decode(preview, loadFullResolution, &result->stage);
+    result->decodeMsecs = timer.nsecsElapsed() / 1e6 - reloadMsecs;
+    result->loadMsecs += reloadMsecs;
+    if (cache) {
+        cache->insert(cacheKey, result->barcode, result->stage);
+    }
+}
+
+/**
+ * @brief 批量扫描中处理一张图片（在线程池中执行）
+ *
+ * 有缓存时先按文件内容查缓存，命中就不再加载和解码（计算哈希的耗时计入loadMsecs）。
+ * 否则先按快速阶段的尺寸加载再解码。
+ */
+BarcodeScanResult scanFile(const BarcodeDecoder& decoder, const BarcodeImageLoader& loader,
+                           BarcodeDecodeCache* cache, quint64 settingsHash, const QString& filePath)
+{
+    BarcodeScanResult result;
+    result.filePath = filePath;
+
+    QElapsedTimer timer;
+    timer.start();
+    const quint64 cacheKey = cache ? cache->contentKey(filePath, settingsHash) : 0;
+    if (cacheKey && cache->find(cacheKey, &result.barcode, &result.stage)) {
+        result.fromCache = true;
+        result.loadMsecs = timer.nsecsElapsed() / 1e6;
+        return result;
+    }
+
+    bool downscaled = false;
+    const QImage preview = loader.load(filePath, decoder.fastPassMaxDimension(), &downscaled, &result.errorMessage);
+    result.loadMsecs = timer.nsecsElapsed() / 1e6;
+    if (preview.isNull()) {
+        return result;
+    }
+
+    decodePreview(decoder, loader, cache, cacheKey, preview, downscaled, &result);
+    return result;
+}
+
+/**
+ * @brief 单张图片扫描：查缓存（计算文件内容哈希）并解码已加载的预览图（在线程池中执行）
+ */
+BarcodeScanResult scanLoadedImage(const BarcodeDecoder& decoder, const BarcodeImageLoader& loader,
+                                  BarcodeDecodeCache* cache, quint64 settingsHash,
+                                  const QString& filePath, const QImage& preview, bool downscaled)
+{
+    BarcodeScanResult result;
+    result.filePath = filePath;
+
+    QElapsedTimer timer;
+    timer.start();
+    const quint64 cacheKey = cache ? cache->contentKey(filePath, settingsHash) : 0;
+    if (cacheKey && cache->find(cacheKey, &result.barcode, &result.stage)) {
+        result.fromCache = true;
+        result.loadMsecs = timer.nsecsElapsed() / 1e6;
+        return result;
+    }
+    result.loadMsecs = timer.nsecsElapsed() / 1e6;
+
+    decodePreview(decoder, loader, cache, cacheKey, preview, downscaled, &result);
+    if (cache) {
+        cache->flush();
+    }
+    return result;
+}
+
+}
 
 BarcodeScanner::BarcodeScanner(QObject *parent)
     : QObject(parent),
       m_status(Stopped),
-      m_imageScanTimer(new QTimer(this)),
+      m_multiBarcodeMode(false),
+      m_imageWatcher(new QFutureWatcher<BarcodeScanResult>(this)),
+      m_multiImageWatcher(new QFutureWatcher<QList<DecodedBarcode>>(this)),
+      m_folderWatcher(new QFutureWatcher<BarcodeScanResult>(this)),
+      m_videoSink(nullptr),
+      m_videoPipeline(new VideoDecodePipeline(this)),
+      m_camera(nullptr),
+      m_captureSession(nullptr),
+      m_mediaPlayer(nullptr),
       m_scanAnimationTimer(new QTimer(this)),
-      m_scanProgress(0.0),
-      m_currentImageIndex(0)
+      m_scanProgress(0.0)
 {
     m_supportedImageFormats << "jpg" << "jpeg" << "png" << "bmp";
+    m_decodePool.setMaxThreadCount(QThread::idealThreadCount());
+    m_stageHits.fill(0, BarcodeDecoder::StageCount + 1);
     
-    connect(m_imageScanTimer, &QTimer::timeout, this, &BarcodeScanner::onImageScanTimer);
+    connect(m_imageWatcher, &QFutureWatcher<BarcodeScanResult>::finished, this, &BarcodeScanner::onImageDecodeFinished);
+    connect(m_multiImageWatcher, &QFutureWatcher<QList<DecodedBarcode>>::finished,
+            this, &BarcodeScanner::onMultiImageDecodeFinished);
+    connect(m_folderWatcher, &QFutureWatcher<BarcodeScanResult>::resultsReadyAt, this, &BarcodeScanner::onFolderResultsReady);
+    connect(m_folderWatcher, &QFutureWatcher<BarcodeScanResult>::finished, this, &BarcodeScanner::onFolderScanFinished);
     connect(m_scanAnimationTimer, &QTimer::timeout, this, &BarcodeScanner::onScanAnimationTimer);
+
+    // 流水线在解码线程中发射信号，这里排队回到界面线程
+    connect(m_videoPipeline, &VideoDecodePipeline::barcodeDetected, this, [this](const QString& barcode, double latencyMsecs) {
+        qCDebug(lcScanner) << "Video barcode detected:" << barcode << "latency" << latencyMsecs << "ms";
+        emit barcodeDetected(barcode);
+    });
+    connect(m_videoPipeline, &VideoDecodePipeline::statisticsUpdated, this,
+            [this](double framesPerSecond, double averageLatencyMsecs, qint64) {
+        emit videoStatisticsUpdated(framesPerSecond, averageLatencyMsecs);
+    });
     
-    qDebug() << "Barcode scanner initialized for image scanning.";
+    qCDebug(lcScanner) << "Barcode scanner initialized for image scanning.";
 }
 
 BarcodeScanner::~BarcodeScanner()
 {
     stopScanning();
-    qDebug() << "Barcode scanner destroyed.";
+    m_imageWatcher->waitForFinished();
+    m_multiImageWatcher->waitForFinished();
+    m_folderWatcher->waitForFinished();
+    qCDebug(lcScanner) << "Barcode scanner destroyed.";
 }
 
 void BarcodeScanner::stopScanning()
 {
     if (m_status == Stopped) return;
-    m_imageScanTimer->stop();
     m_scanAnimationTimer->stop();
+    if (m_folderWatcher->isRunning()) {
+        m_folderWatcher->cancel();  // 已开始的图片会做完，其余的不再解码
+    }
+    if (m_camera) {
+        m_camera->stop();
+    }
+    if (m_mediaPlayer) {
+        m_mediaPlayer->stop();
+    }
     setStatus(Stopped);
-    qDebug() << "All scanning activities stopped.";
+    qCDebug(lcScanner) << "All scanning activities stopped.";
 }
 
 bool BarcodeScanner::scanImageFromFile(const QString& filePath)
@@ -51,9 +184,14 @@ bool BarcodeScanner::scanImageFromFile(const QString& filePath)
         return false;
     }
 
-    QImage image(filePath);
+    // 按快速阶段的尺寸加载，大照片不必解出全部像素；显示也用这张图。
+    // 多码模式要找出远处的小条码，按原始分辨率加载
+    bool downscaled = false;
+    QString errorMessage;
+    const int maxDimension = m_multiBarcodeMode ? 0 : m_decoder.fastPassMaxDimension();
+    const QImage image = m_loader.load(filePath, maxDimension, &downscaled, &errorMessage);
     if (image.isNull()) {
-        emit scannerError(tr("Failed to load image: %1").arg(filePath));
+        emit scannerError(errorMessage);
         return false;
     }
 
@@ -64,87 +202,228 @@ bool BarcodeScanner::scanImageFromFile(const QString& filePath)
     m_scanProgress = 0.0;
     m_scanAnimationTimer->start(15);
 
-    QTimer::singleShot(100, this, [this, image]() {
-        QString barcode = decodeImageBarcode(image);
-        m_scanAnimationTimer->stop();
-        emit scanAnimationFinished();
-        
-        bool isLastImageInFolder = (m_currentImageIndex >= m_currentFolderImages.size() - 1);
-
-        if (!barcode.isEmpty()) {
-            emit barcodeDetected(barcode);
-            if(m_imageScanTimer->isActive()) {
-                m_imageScanTimer->stop();
-                setStatus(Stopped);
-                 qDebug() << "Barcode found, folder scan stopped.";
-            } else {
-                setStatus(Stopped);
-            }
-        } else {
-            if (!m_imageScanTimer->isActive()) {
-                 emit scannerError(tr("No barcode found in the image."));
-                 setStatus(Stopped);
-            } else if (isLastImageInFolder) {
-                qDebug() << "Finished scanning folder, no barcode found in last image.";
-                setStatus(Stopped);
-            }
-        }
+    if (m_multiBarcodeMode) {
+        // 原始分辨率的全图搜索很慢，放到线程池，界面线程只负责动画
+        const BarcodeDecoder decoder = m_decoder;
+        m_multiImageWatcher->setFuture(QtConcurrent::run(&m_decodePool, [decoder, image]() {
+            return decoder.decodeAll(image);
+        }));
+        return true;
+    }
 
-        if (m_imageScanTimer->isActive() && barcode.isEmpty()) {
-            QTimer::singleShot(500, this, &BarcodeScanner::onImageScanTimer);
-        }
-    });
+    // 查缓存要读整个文件计算哈希，和解码一起放到线程池，界面线程只负责动画
+    const BarcodeDecoder decoder = m_decoder;
+    const BarcodeImageLoader loader = m_loader;
+    const std::shared_ptr<BarcodeDecodeCache> cache = m_decodeCache;
+    const quint64 settingsHash = decodeSettingsHash();
+    m_imageWatcher->setFuture(QtConcurrent::run(&m_decodePool,
+        [decoder, loader, cache, settingsHash, filePath, image, downscaled]() {
+            return scanLoadedImage(decoder, loader, cache.get(), settingsHash, filePath, image, downscaled);
+        }));
+
+    return true;
+}
+
+bool BarcodeScanner::startCameraScan()
+{
+    if (QMediaDevices::videoInputs().isEmpty()) {
+        emit scannerError(tr("No camera available."));
+        return false;
+    }
+
+    stopScanning();
+    if (!m_camera) {
+        m_camera = new QCamera(QMediaDevices::defaultVideoInput(), this);
+        m_captureSession = new QMediaCaptureSession(this);
+        m_captureSession->setCamera(m_camera);
+        connect(m_camera, &QCamera::errorOccurred, this, [this](QCamera::Error, const QString& errorString) {
+            emit scannerError(tr("Camera error: %1").arg(errorString));
+            stopScanning();
+        });
+    }
 
+    // 同一个视频输出只能连接一个来源
+    if (m_mediaPlayer) {
+        m_mediaPlayer->setVideoSink(nullptr);
+    }
+    m_captureSession->setVideoSink(ensureVideoSink());
+    m_videoPipeline->reset();
+    m_camera->start();
+    setStatus(ScanningVideo);
+    qCDebug(lcScanner) << "Camera scan started.";
     return true;
 }
 
+bool BarcodeScanner::scanVideoFile(const QString& filePath)
+{
+    if (filePath.isEmpty() || !QFileInfo::exists(filePath)) {
+        emit scannerError(tr("Video file not found: %1").arg(filePath));
+        return false;
+    }
+
+    stopScanning();
+    if (!m_mediaPlayer) {
+        m_mediaPlayer = new QMediaPlayer(this);
+        connect(m_mediaPlayer, &QMediaPlayer::mediaStatusChanged, this, [this](QMediaPlayer::MediaStatus status) {
+            if (status == QMediaPlayer::EndOfMedia && m_status == ScanningVideo) {
+                qCDebug(lcScanner) << "Finished scanning video file.";
+                stopScanning();
+            }
+        });
+        connect(m_mediaPlayer, &QMediaPlayer::errorOccurred, this, [this](QMediaPlayer::Error, const QString& errorString) {
+            emit scannerError(tr("Video playback error: %1").arg(errorString));
+            stopScanning();
+        });
+    }
+
+    if (m_captureSession) {
+        m_captureSession->setVideoSink(nullptr);
+    }
+    m_mediaPlayer->setVideoSink(ensureVideoSink());
+    m_mediaPlayer->setSource(QUrl::fromLocalFile(filePath));
+    m_videoPipeline->reset();
+    m_mediaPlayer->play();
+    setStatus(ScanningVideo);
+    qCDebug(lcScanner) << "Video file scan started:" << filePath;
+    return true;
+}
+
+QVideoSink* BarcodeScanner::ensureVideoSink()
+{
+    if (!m_videoSink) {
+        m_videoSink = new QVideoSink(this);
+        m_videoPipeline->setVideoSink(m_videoSink);
+    }
+    return m_videoSink;
+}
+
 bool BarcodeScanner::scanImageFromFolder(const QString& folderPath)
 {
-    m_currentFolderImages = getImageFilesFromFolder(folderPath);
-    if (m_currentFolderImages.isEmpty()) {
+    if (m_status != Stopped) {
+        emit scannerError(tr("Scanner is busy."));
+        return false;
+    }
+
+    m_folderImages = getImageFilesFromFolder(folderPath);
+    if (m_folderImages.isEmpty()) {
         emit scannerError(tr("No supported image files found in the folder."));
         return false;
     }
-    
-    m_currentImageIndex = -1; // Will be incremented to 0 by the timer
-    m_imageScanTimer->start(10); // Start the scanning loop
+
+    m_folderResults.clear();
+    m_folderResults.reserve(m_folderImages.size());
+    m_folderTimer.start();
+    setStatus(ScanningFolder);
+
+    // 工作线程只使用解码器和加载器的副本，不访问扫描器对象
+    const BarcodeDecoder decoder = m_decoder;
+    const BarcodeImageLoader loader = m_loader;
+    const std::shared_ptr<BarcodeDecodeCache> cache = m_decodeCache;
+    const quint64 settingsHash = decodeSettingsHash();
+    m_folderWatcher->setFuture(QtConcurrent::mapped(&m_decodePool, m_folderImages,
+        [decoder, loader, cache, settingsHash](const QString& filePath) {
+            return scanFile(decoder, loader, cache.get(), settingsHash, filePath);
+        }));
+
+    qCInfo(lcScanner) << "Folder scan started:" << m_folderImages.size() << "images,"
+             << m_decodePool.maxThreadCount() << "threads";
     return true;
 }
 
-QString BarcodeScanner::decodeImageBarcode(const QImage& image)
+void BarcodeScanner::setMaxDecodeThreads(int threads)
 {
-    if (image.isNull()) {
-        return QString();
+    m_decodePool.setMaxThreadCount(qMax(1, threads));
+}
+
+void BarcodeScanner::onImageDecodeFinished()
+{
+    const BarcodeScanResult result = m_imageWatcher->result();
+    m_scanAnimationTimer->stop();
+    emit scanAnimationFinished();
+
+    if (result.fromCache) {
+        qCDebug(lcScanner) << "Decode result taken from cache:" << result.filePath;
+    } else {
+        recordStage(result.stage);
+        qCDebug(lcScanner) << "Decode stage:" << BarcodeDecoder::stageName(result.stage);
     }
 
-    try {
-        QImage convertedImage = image;
-        if (image.format() != QImage::Format_ARGB32) {
-             convertedImage = image.convertToFormat(QImage::Format_ARGB32);
-        }
-        
-        ZXing::ImageView imageView{
-            convertedImage.constBits(),
-            convertedImage.width(),
-            convertedImage.height(),
-            ZXing::ImageFormat::BGRX
-        };
+    if (result.found()) {
+        emit barcodeDetected(result.barcode);
+    } else {
+        emit scannerError(tr("No barcode found in the image."));
+    }
+    setStatus(Stopped);
+}
 
-        ZXing::ReaderOptions options;
-        options.setTryHarder(true);
-        options.setTryRotate(true);
-        options.setFormats(ZXing::BarcodeFormat::Any);
+void BarcodeScanner::onMultiImageDecodeFinished()
+{
+    const QList<DecodedBarcode> barcodes = m_multiImageWatcher->result();
+    m_scanAnimationTimer->stop();
+    emit scanAnimationFinished();
 
-        auto results = ZXing::ReadBarcodes(imageView, options);
+    qCDebug(lcScanner) << "Multi-barcode scan found" << barcodes.size() << "barcodes";
+    if (!barcodes.isEmpty()) {
+        emit barcodesDetected(barcodes);
+    } else {
+        emit scannerError(tr("No barcode found in the image."));
+    }
+    setStatus(Stopped);
+}
 
-        if (!results.empty() && results[0].isValid()) {
-            return QString::fromStdString(results[0].text());
-        }
+void BarcodeScanner::recordStage(BarcodeDecoder::Stage stage)
+{
+    ++m_stageHits[stage];
+}
+
+bool BarcodeScanner::setSymbologies(const QString& symbologies)
+{
+    if (!m_decoder.setSymbologies(symbologies)) {
+        emit scannerError(tr("Invalid barcode symbologies: %1").arg(symbologies));
+        return false;
+    }
+
+    // 视频流保持自己的阶段上限，只同步码制
+    BarcodeDecoder videoDecoder = m_decoder;
+    videoDecoder.setMaxStage(BarcodeDecoder::FastPass);
+    m_videoPipeline->setDecoder(videoDecoder);
+    return true;
+}
+
+void BarcodeScanner::setFastPassMaxDimension(int pixels)
+{
+    m_decoder.setFastPassMaxDimension(pixels);
+}
+
+void BarcodeScanner::setRegionOfInterest(const QRectF& region)
+{
+    m_loader.setRegionOfInterest(region);
+}
+
+bool BarcodeScanner::setDecodeCacheFile(const QString& filePath)
+{
+    if (filePath.isEmpty()) {
+        m_decodeCache.reset();
+        return true;
     }
-    catch (const std::exception& e) {
-        qWarning() << "ZXing-C++ exception: " << e.what();
+
+    // 正在进行的批量扫描仍持有旧缓存，扫描结束后才释放
+    auto cache = std::make_shared<BarcodeDecodeCache>(filePath);
+    if (!cache->open()) {
+        m_decodeCache.reset();
+        return false;
     }
-    return QString();
+    m_decodeCache = cache;
+    qCInfo(lcScanner) << "Barcode decode cache opened:" << filePath << cache->size() << "entries";
+    return true;
+}
+
+quint64 BarcodeScanner::decodeSettingsHash() const
+{
+    const QRectF region = m_loader.regionOfInterest();
+    const QByteArray settings = QString("%1;%2,%3,%4,%5").arg(m_decoder.settingsFingerprint())
+        .arg(region.x()).arg(region.y()).arg(region.width()).arg(region.height()).toUtf8();
+    return BarcodeDecodeCache::hash(settings.constData(), settings.size());
 }
 
 QStringList BarcodeScanner::getImageFilesFromFolder(const QString& folderPath) const
@@ -167,18 +446,39 @@ void BarcodeScanner::setSupportedImageFormats(const QStringList& formats)
     m_supportedImageFormats = formats;
 }
 
-void BarcodeScanner::onImageScanTimer()
+void BarcodeScanner::onFolderResultsReady()
 {
-    m_currentImageIndex++;
-    if (m_currentImageIndex < m_currentFolderImages.size()) {
-        scanImageFromFile(m_currentFolderImages[m_currentImageIndex]);
-    } else {
-        m_imageScanTimer->stop();
-        setStatus(Stopped);
-        qDebug() << "Finished scanning all images in the folder.";
+    // 线程池中的图片完成顺序不定，这里只发出从头开始连续完成的部分，保证按文件顺序
+    const QFuture<BarcodeScanResult> future = m_folderWatcher->future();
+    while (m_folderResults.size() < m_folderImages.size() && future.isResultReadyAt(m_folderResults.size())) {
+        BarcodeScanResult result = future.resultAt(m_folderResults.size());
+        result.index = m_folderResults.size();
+        m_folderResults.append(result);
+        if (!result.fromCache) {
+            recordStage(result.stage);
+        }
+
+        emit imageScanned(result, m_folderImages.size());
     }
 }
 
+void BarcodeScanner::onFolderScanFinished()
+{
+    if (!m_folderWatcher->isCanceled()) {
+        onFolderResultsReady();
+    }
+
+    if (m_decodeCache) {
+        m_decodeCache->flush();
+    }
+
+    const double seconds = m_folderTimer.nsecsElapsed() / 1e9;
+    qCInfo(lcScanner) << "Finished scanning folder:" << m_folderResults.size() << "of" << m_folderImages.size()
+             << "images in" << seconds << "s";
+    setStatus(Stopped);
+    emit folderScanFinished(m_folderResults, seconds);
+}
+
 void BarcodeScanner::onScanAnimationTimer()
 {
     m_scanProgress += 0.02;
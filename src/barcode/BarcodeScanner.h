@@ -6,18 +6,44 @@
 #include <QRectF>
 #include <QPixmap>
 #include <QStringList>
-// #include <QCamera>
-// #include <QVideoWidget>
+#include <QList>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
 #include <memory>
+#include "BarcodeDecoder.h"
+#include "BarcodeImageLoader.h"
 
 // 前向声明
 class QCamera;
-class QVideoWidget;
+class QMediaCaptureSession;
+class QMediaPlayer;
+class QVideoSink;
+class VideoDecodePipeline;
+class BarcodeDecodeCache;
+
+/**
+ * @brief 批量扫描中一张图片的结果
+ */
+struct BarcodeScanResult
+{
+    int index = -1;             ///< 图片在文件夹列表中的序号
+    QString filePath;           ///< 图片文件路径
+    QString barcode;            ///< 解码到的条码，未找到时为空
+    QString errorMessage;       ///< 图片无法加载时的错误消息
+    double loadMsecs = 0.0;     ///< 加载图片耗时（毫秒）
+    double decodeMsecs = 0.0;   ///< 解码耗时（毫秒）
+    BarcodeDecoder::Stage stage = BarcodeDecoder::NotFound;    ///< 识别成功的解码阶段
+    bool fromCache = false;     ///< 结果取自解码缓存，没有重新解码
+
+    bool found() const { return !barcode.isEmpty(); }
+};
 
 /**
  * @brief BarcodeScanner类 - 条形码扫描器
  * 
- * 基于图片文件的条码识别系统
+ * 支持图片文件扫描和视频流扫描（摄像头或视频文件），
+ * 视频帧在VideoDecodePipeline的解码线程中解码。
  */
 class BarcodeScanner : public QObject
 {
@@ -30,7 +56,9 @@ public:
     enum ScannerStatus {
         Stopped = 0,        ///< 已停止
         LoadingImage,       ///< 正在加载图片
-        ScanningImage       ///< 正在扫描图片
+        ScanningImage,      ///< 正在扫描图片
+        ScanningFolder,     ///< 正在批量扫描文件夹
+        ScanningVideo       ///< 正在扫描视频流
     };
     Q_ENUM(ScannerStatus)
 
@@ -64,12 +92,75 @@ public:
     bool scanImageFromFile(const QString& filePath);
 
     /**
-     * @brief 从文件夹选择图片进行扫描
+     * @brief 批量扫描文件夹中的全部图片
+     *
+     * 图片在有界线程池中并行加载和解码，没有扫描动画；结果按文件顺序通过imageScanned发出，
+     * 全部完成后发射folderScanFinished。识别出的条码不经过barcodeDetected，不会加入购物车。
      * @param folderPath 文件夹路径
-     * @return 如果成功选择文件夹返回true
+     * @return 如果成功开始扫描返回true
      */
     bool scanImageFromFolder(const QString& folderPath);
 
+    /**
+     * @brief 设置批量扫描的最大线程数（默认为CPU核数）
+     */
+    void setMaxDecodeThreads(int threads);
+
+    /**
+     * @brief 设置店铺使用的码制（图片和视频流扫描的快速阶段只找这些码制）
+     * @param symbologies ZXing码制名称，逗号分隔，如"EAN-13,EAN-8,UPC-A,Code128"
+     * @return 如果名称全部有效返回true
+     */
+    bool setSymbologies(const QString& symbologies);
+
+    /**
+     * @brief 设置图片扫描快速阶段的最大边长（像素），默认1024；视频流不受影响
+     */
+    void setFastPassMaxDimension(int pixels);
+
+    /**
+     * @brief 设置图片扫描的感兴趣区域（相对图片宽高的比例），只解码该区域；空矩形表示整张图片
+     */
+    void setRegionOfInterest(const QRectF& region);
+
+    /**
+     * @brief 启用按文件内容的解码结果缓存，图片扫描先查缓存再解码
+     * @param filePath 缓存文件路径，空字符串表示关闭缓存
+     * @return 如果缓存文件打开成功返回true
+     */
+    bool setDecodeCacheFile(const QString& filePath);
+
+    /**
+     * @brief 设置多码模式：单张图片扫描时找出图片中的全部条码，通过barcodesDetected一次发出
+     *
+     * 多码模式按原始分辨率加载图片，不使用解码结果缓存；批量扫描和视频流不受影响。
+     */
+    void setMultiBarcodeMode(bool enabled) { m_multiBarcodeMode = enabled; }
+    bool multiBarcodeMode() const { return m_multiBarcodeMode; }
+
+    /**
+     * @brief 各解码阶段识别成功的图片数（下标为BarcodeDecoder::Stage，最后一项为未识别数）
+     */
+    QList<int> stageHits() const { return m_stageHits; }
+
+    /**
+     * @brief 从默认摄像头实时扫描条码
+     * @return 如果成功启动摄像头返回true
+     */
+    bool startCameraScan();
+
+    /**
+     * @brief 从视频文件扫描条码（用录制的视频测试视频流扫描）
+     * @param filePath 视频文件路径
+     * @return 如果成功开始播放返回true
+     */
+    bool scanVideoFile(const QString& filePath);
+
+    /**
+     * @brief 获取视频流解码流水线（可调整去重窗口、读取统计）
+     */
+    VideoDecodePipeline* videoPipeline() const { return m_videoPipeline; }
+
     /**
      * @brief 获取当前显示的图片
      * @return 当前图片的QPixmap
@@ -96,6 +187,12 @@ signals:
      */
     void barcodeDetected(const QString& barcode);
 
+    /**
+     * @brief 多码模式下，一张图片中识别到的全部条码
+     * @param barcodes 条码及其在图片中的位置
+     */
+    void barcodesDetected(const QList<DecodedBarcode>& barcodes);
+
     /**
      * @brief 扫描器状态改变时发射的信号
      * @param status 新状态
@@ -131,11 +228,47 @@ signals:
      */
     void scanAnimationFinished();
 
+    /**
+     * @brief 批量扫描中一张图片处理完成的信号（按文件顺序发射）
+     * @param result 该图片的结果和耗时
+     * @param total 本次扫描的图片总数
+     */
+    void imageScanned(const BarcodeScanResult& result, int total);
+
+    /**
+     * @brief 批量扫描完成（或被停止）的信号
+     * @param results 已完成的图片结果（按文件顺序）
+     * @param seconds 总耗时（秒）
+     */
+    void folderScanFinished(const QList<BarcodeScanResult>& results, double seconds);
+
+    /**
+     * @brief 视频流解码统计信号（每秒一次）
+     * @param framesPerSecond 每秒解码的帧数
+     * @param latencyMsecs 平均解码延迟（毫秒）
+     */
+    void videoStatisticsUpdated(double framesPerSecond, double latencyMsecs);
+
 private slots:
     /**
-     * @brief 图片扫描定时器槽函数
+     * @brief 单张图片在线程池中解码完成
      */
-    void onImageScanTimer();
+    void onImageDecodeFinished();
+
+    /**
+     * @brief 多码模式的单张图片在线程池中解码完成
+     */
+    void onMultiImageDecodeFinished();
+
+    /**
+     * @brief 按顺序发出已完成的批量扫描结果
+     */
+    void onFolderResultsReady();
+
+    /**
+     * @brief 批量扫描结束
+     */
+    void onFolderScanFinished();
 
     /**
      * @brief 扫描动画定时器槽函数
@@ -150,23 +283,49 @@ private:
     void setStatus(ScannerStatus status);
 
     /**
-     * @brief 从图片中解码条码
-     * @param image 要扫描的图片
-     * @return 解码到的条码字符串，如果没有找到返回空字符串
+     * @brief 当前解码设置（码制、阶段、预处理和感兴趣区域）的哈希，作为缓存键的一部分
      */
-    QString decodeImageBarcode(const QImage& image);
+    quint64 decodeSettingsHash() const;
+
+    /**
+     * @brief 记录一张图片在哪个阶段识别成功
+     */
+    void recordStage(BarcodeDecoder::Stage stage);
+
+    /**
+     * @brief 创建视频输出并连接到解码流水线
+     */
+    QVideoSink* ensureVideoSink();
 
     // 状态
     ScannerStatus m_status;
     
     // 图片处理
     QPixmap m_currentImage;
-    QStringList m_currentFolderImages;
-    int m_currentImageIndex;
     QStringList m_supportedImageFormats;
+    BarcodeDecoder m_decoder;
+    BarcodeImageLoader m_loader;
+    std::shared_ptr<BarcodeDecodeCache> m_decodeCache;     ///< 解码结果缓存，批量扫描的工作线程共享
+    QList<int> m_stageHits;
+    bool m_multiBarcodeMode;
+    QFutureWatcher<BarcodeScanResult>* m_imageWatcher;     ///< 单张图片的解码任务
+    QFutureWatcher<QList<DecodedBarcode>>* m_multiImageWatcher;    ///< 多码模式单张图片的解码任务
+
+    // 批量扫描
+    QThreadPool m_decodePool;
+    QFutureWatcher<BarcodeScanResult>* m_folderWatcher;
+    QStringList m_folderImages;
+    QList<BarcodeScanResult> m_folderResults;
+    QElapsedTimer m_folderTimer;
+
+    // 视频流扫描
+    QVideoSink* m_videoSink;
+    VideoDecodePipeline* m_videoPipeline;
+    QCamera* m_camera;
+    QMediaCaptureSession* m_captureSession;
+    QMediaPlayer* m_mediaPlayer;
 
-    // 定时器
-    QTimer* m_imageScanTimer;
+    // 定时器（只用于单张图片的扫描动画）
     QTimer* m_scanAnimationTimer;
 
     // 扫描动画
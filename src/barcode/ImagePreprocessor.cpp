@@ -0,0 +1,587 @@
+#include "ImagePreprocessor.h"
+#include <algorithm>
+#include <cstring>
+
+#if !defined(SMARTPOS_NO_SIMD) && (defined(__x86_64__) || defined(_M_X64))
+#define SMARTPOS_X86_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SMARTPOS_TARGET_AVX2
+#else
+#define SMARTPOS_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace {
+
+// ITU-R BT.601亮度，权重之和为256：Y = (77R + 150G + 29B) >> 8
+constexpr int WeightR = 77;
+constexpr int WeightG = 150;
+constexpr int WeightB = 29;
+
+// 每行一个内核调用，行首地址和行宽由调用方给出，SIMD内核自己处理行尾
+using LumaRowFn = void (*)(const uchar* src, uchar* dst, int width);
+using StretchRowFn = void (*)(const uchar* src, uchar* dst, int width, int low, int scale);
+using SharpenRowFn = void (*)(const uchar* up, const uchar* mid, const uchar* down, uchar* dst, int width);
+using ThresholdRowFn = void (*)(const uchar* src, uchar* dst, int width, int threshold);
+using HalveRowFn = void (*)(const uchar* row0, const uchar* row1, uchar* dst, int dstWidth);
+
+struct Kernels
+{
+    LumaRowFn bgrxToLuma;
+    StretchRowFn stretch;
+    SharpenRowFn sharpen;
+    ThresholdRowFn threshold;
+    HalveRowFn halve;
+};
+
+// ---------------------------------------------------------------- 标量
+
+void bgrxToLumaScalar(const uchar* src, uchar* dst, int width)
+{
+    for (int x = 0; x < width; ++x, src += 4) {
+        dst[x] = static_cast<uchar>((src[0] * WeightB + src[1] * WeightG + src[2] * WeightR) >> 8);
+    }
+}
+
+void rgb888ToLumaScalar(const uchar* src, uchar* dst, int width)
+{
+    for (int x = 0; x < width; ++x, src += 3) {
+        dst[x] = static_cast<uchar>((src[0] * WeightR + src[1] * WeightG + src[2] * WeightB) >> 8);
+    }
+}
+
+// dst = min(255, max(0, src - low) * scale >> 8)，scale为8.8定点数，不超过0x7FFF（SIMD用有符号饱和打包）
+void stretchScalar(const uchar* src, uchar* dst, int width, int low, int scale)
+{
+    for (int x = 0; x < width; ++x) {
+        const int value = std::max(0, src[x] - low);
+        dst[x] = static_cast<uchar>(std::min(255, (value * scale) >> 8));
+    }
+}
+
+// 十字形锐化：5*中心 - 上下左右，首尾像素原样复制
+void sharpenScalarRange(const uchar* up, const uchar* mid, const uchar* down, uchar* dst, int from, int to)
+{
+    for (int x = from; x < to; ++x) {
+        const int value = 5 * mid[x] - mid[x - 1] - mid[x + 1] - up[x] - down[x];
+        dst[x] = static_cast<uchar>(std::clamp(value, 0, 255));
+    }
+}
+
+void sharpenScalar(const uchar* up, const uchar* mid, const uchar* down, uchar* dst, int width)
+{
+    dst[0] = mid[0];
+    dst[width - 1] = mid[width - 1];
+    sharpenScalarRange(up, mid, down, dst, 1, width - 1);
+}
+
+void thresholdScalar(const uchar* src, uchar* dst, int width, int threshold)
+{
+    for (int x = 0; x < width; ++x) {
+        dst[x] = src[x] >= threshold ? 255 : 0;
+    }
+}
+
+// 2x2均值：先上下两行取平均，再左右两列取平均（与SIMD的_mm_avg舍入方式一致）
+void halveScalarRange(const uchar* row0, const uchar* row1, uchar* dst, int from, int to)
+{
+    for (int x = from; x < to; ++x) {
+        const int left = (row0[2 * x] + row1[2 * x] + 1) >> 1;
+        const int right = (row0[2 * x + 1] + row1[2 * x + 1] + 1) >> 1;
+        dst[x] = static_cast<uchar>((left + right + 1) >> 1);
+    }
+}
+
+void halveScalar(const uchar* row0, const uchar* row1, uchar* dst, int dstWidth)
+{
+    halveScalarRange(row0, row1, dst, 0, dstWidth);
+}
+
+const Kernels ScalarKernels = {bgrxToLumaScalar, stretchScalar, sharpenScalar, thresholdScalar, halveScalar};
+
+#ifdef SMARTPOS_X86_SIMD
+
+// ---------------------------------------------------------------- SSE2
+
+// 4个BGRX像素 -> 4个32位亮度
+inline __m128i luma4Sse2(const uchar* src, __m128i weights, __m128i zero)
+{
+    const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+    // 每个像素的 B*29+G*150 和 R*77+X*0 分别落在相邻的两个32位通道
+    const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), weights);
+    const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), weights);
+    const __m128i evens = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0)));
+    const __m128i odds = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1)));
+    return _mm_srli_epi32(_mm_add_epi32(evens, odds), 8);
+}
+
+void bgrxToLumaSse2(const uchar* src, uchar* dst, int width)
+{
+    const __m128i weights = _mm_set_epi16(0, WeightR, WeightG, WeightB, 0, WeightR, WeightG, WeightB);
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 16 <= width; x += 16, src += 64) {
+        const __m128i y0 = _mm_packs_epi32(luma4Sse2(src, weights, zero), luma4Sse2(src + 16, weights, zero));
+        const __m128i y1 = _mm_packs_epi32(luma4Sse2(src + 32, weights, zero), luma4Sse2(src + 48, weights, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(y0, y1));
+    }
+    bgrxToLumaScalar(src, dst + x, width - x);
+}
+
+void stretchSse2(const uchar* src, uchar* dst, int width, int low, int scale)
+{
+    const __m128i lowValue = _mm_set1_epi8(static_cast<char>(low));
+    const __m128i scaleValue = _mm_set1_epi16(static_cast<short>(scale));
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i value = _mm_subs_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x)), lowValue);
+        // (value << 8) * scale >> 16 == value * scale >> 8
+        const __m128i lo = _mm_mulhi_epu16(_mm_unpacklo_epi8(zero, value), scaleValue);
+        const __m128i hi = _mm_mulhi_epu16(_mm_unpackhi_epi8(zero, value), scaleValue);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    stretchScalar(src + x, dst + x, width - x, low, scale);
+}
+
+inline __m128i sharpen8Sse2(__m128i up, __m128i mid, __m128i left, __m128i right, __m128i down)
+{
+    const __m128i center = _mm_add_epi16(_mm_slli_epi16(mid, 2), mid);
+    const __m128i sum = _mm_add_epi16(_mm_add_epi16(up, down), _mm_add_epi16(left, right));
+    return _mm_sub_epi16(center, sum);
+}
+
+void sharpenSse2(const uchar* up, const uchar* mid, const uchar* down, uchar* dst, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    dst[0] = mid[0];
+    dst[width - 1] = mid[width - 1];
+    int x = 1;
+    for (; x + 16 <= width - 1; x += 16) {
+        const __m128i u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(up + x));
+        const __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x));
+        const __m128i l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x - 1));
+        const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mid + x + 1));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(down + x));
+        const __m128i lo = sharpen8Sse2(_mm_unpacklo_epi8(u, zero), _mm_unpacklo_epi8(m, zero), _mm_unpacklo_epi8(l, zero),
+                                        _mm_unpacklo_epi8(r, zero), _mm_unpacklo_epi8(d, zero));
+        const __m128i hi = sharpen8Sse2(_mm_unpackhi_epi8(u, zero), _mm_unpackhi_epi8(m, zero), _mm_unpackhi_epi8(l, zero),
+                                        _mm_unpackhi_epi8(r, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(lo, hi));
+    }
+    sharpenScalarRange(up, mid, down, dst, x, width - 1);
+}
+
+void thresholdSse2(const uchar* src, uchar* dst, int width, int threshold)
+{
+    const __m128i thresholdValue = _mm_set1_epi8(static_cast<char>(threshold));
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        const __m128i value = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+        // max(value, threshold) == value 即 value >= threshold
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_cmpeq_epi8(_mm_max_epu8(value, thresholdValue), value));
+    }
+    thresholdScalar(src + x, dst + x, width - x, threshold);
+}
+
+inline __m128i halve8Sse2(__m128i vertical, __m128i lowBytes)
+{
+    return _mm_avg_epu16(_mm_and_si128(vertical, lowBytes), _mm_srli_epi16(vertical, 8));
+}
+
+void halveSse2(const uchar* row0, const uchar* row1, uchar* dst, int dstWidth)
+{
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    int x = 0;
+    for (; x + 16 <= dstWidth; x += 16) {
+        const uchar* a = row0 + 2 * x;
+        const uchar* b = row1 + 2 * x;
+        const __m128i v0 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)),
+                                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+        const __m128i v1 = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 16)),
+                                        _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 16)));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(halve8Sse2(v0, lowBytes), halve8Sse2(v1, lowBytes)));
+    }
+    halveScalarRange(row0, row1, dst, x, dstWidth);
+}
+
+const Kernels Sse2Kernels = {bgrxToLumaSse2, stretchSse2, sharpenSse2, thresholdSse2, halveSse2};
+
+// ---------------------------------------------------------------- AVX2
+
+// 8个BGRX像素 -> 8个32位亮度（按像素顺序）
+SMARTPOS_TARGET_AVX2 inline __m256i luma8Avx2(const uchar* src, __m256i weights, __m256i zero)
+{
+    const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src));
+    const __m256i lo = _mm256_madd_epi16(_mm256_unpacklo_epi8(pixels, zero), weights);
+    const __m256i hi = _mm256_madd_epi16(_mm256_unpackhi_epi8(pixels, zero), weights);
+    return _mm256_srli_epi32(_mm256_hadd_epi32(lo, hi), 8);
+}
+
+SMARTPOS_TARGET_AVX2 void bgrxToLumaAvx2(const uchar* src, uchar* dst, int width)
+{
+    const __m256i weights = _mm256_set_epi16(0, WeightR, WeightG, WeightB, 0, WeightR, WeightG, WeightB,
+                                             0, WeightR, WeightG, WeightB, 0, WeightR, WeightG, WeightB);
+    const __m256i zero = _mm256_setzero_si256();
+    // 两次pack都在128位通道内进行，最后按32位分组恢复像素顺序
+    const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+    int x = 0;
+    for (; x + 32 <= width; x += 32, src += 128) {
+        const __m256i y0 = _mm256_packus_epi32(luma8Avx2(src, weights, zero), luma8Avx2(src + 32, weights, zero));
+        const __m256i y1 = _mm256_packus_epi32(luma8Avx2(src + 64, weights, zero), luma8Avx2(src + 96, weights, zero));
+        const __m256i packed = _mm256_permutevar8x32_epi32(_mm256_packus_epi16(y0, y1), order);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), packed);
+    }
+    bgrxToLumaSse2(src, dst + x, width - x);
+}
+
+SMARTPOS_TARGET_AVX2 void stretchAvx2(const uchar* src, uchar* dst, int width, int low, int scale)
+{
+    const __m256i lowValue = _mm256_set1_epi8(static_cast<char>(low));
+    const __m256i scaleValue = _mm256_set1_epi16(static_cast<short>(scale));
+    const __m256i zero = _mm256_setzero_si256();
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const __m256i value = _mm256_subs_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x)), lowValue);
+        const __m256i lo = _mm256_mulhi_epu16(_mm256_unpacklo_epi8(zero, value), scaleValue);
+        const __m256i hi = _mm256_mulhi_epu16(_mm256_unpackhi_epi8(zero, value), scaleValue);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_packus_epi16(lo, hi));
+    }
+    stretchSse2(src + x, dst + x, width - x, low, scale);
+}
+
+SMARTPOS_TARGET_AVX2 inline __m256i sharpen16Avx2(__m256i up, __m256i mid, __m256i left, __m256i right, __m256i down)
+{
+    const __m256i center = _mm256_add_epi16(_mm256_slli_epi16(mid, 2), mid);
+    const __m256i sum = _mm256_add_epi16(_mm256_add_epi16(up, down), _mm256_add_epi16(left, right));
+    return _mm256_sub_epi16(center, sum);
+}
+
+SMARTPOS_TARGET_AVX2 void sharpenAvx2(const uchar* up, const uchar* mid, const uchar* down, uchar* dst, int width)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    dst[0] = mid[0];
+    dst[width - 1] = mid[width - 1];
+    int x = 1;
+    for (; x + 32 <= width - 1; x += 32) {
+        const __m256i u = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(up + x));
+        const __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mid + x));
+        const __m256i l = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mid + x - 1));
+        const __m256i r = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(mid + x + 1));
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(down + x));
+        const __m256i lo = sharpen16Avx2(_mm256_unpacklo_epi8(u, zero), _mm256_unpacklo_epi8(m, zero), _mm256_unpacklo_epi8(l, zero),
+                                         _mm256_unpacklo_epi8(r, zero), _mm256_unpacklo_epi8(d, zero));
+        const __m256i hi = sharpen16Avx2(_mm256_unpackhi_epi8(u, zero), _mm256_unpackhi_epi8(m, zero), _mm256_unpackhi_epi8(l, zero),
+                                         _mm256_unpackhi_epi8(r, zero), _mm256_unpackhi_epi8(d, zero));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_packus_epi16(lo, hi));
+    }
+    sharpenScalarRange(up, mid, down, dst, x, width - 1);
+}
+
+SMARTPOS_TARGET_AVX2 void thresholdAvx2(const uchar* src, uchar* dst, int width, int threshold)
+{
+    const __m256i thresholdValue = _mm256_set1_epi8(static_cast<char>(threshold));
+    int x = 0;
+    for (; x + 32 <= width; x += 32) {
+        const __m256i value = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + x));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x),
+                            _mm256_cmpeq_epi8(_mm256_max_epu8(value, thresholdValue), value));
+    }
+    thresholdSse2(src + x, dst + x, width - x, threshold);
+}
+
+SMARTPOS_TARGET_AVX2 inline __m256i halve16Avx2(__m256i vertical, __m256i lowBytes)
+{
+    return _mm256_avg_epu16(_mm256_and_si256(vertical, lowBytes), _mm256_srli_epi16(vertical, 8));
+}
+
+SMARTPOS_TARGET_AVX2 void halveAvx2(const uchar* row0, const uchar* row1, uchar* dst, int dstWidth)
+{
+    const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+    int x = 0;
+    for (; x + 32 <= dstWidth; x += 32) {
+        const uchar* a = row0 + 2 * x;
+        const uchar* b = row1 + 2 * x;
+        const __m256i v0 = _mm256_avg_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a)),
+                                           _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)));
+        const __m256i v1 = _mm256_avg_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 32)),
+                                           _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 32)));
+        // packus在128位通道内交错了两半，按64位分组换回顺序
+        const __m256i packed = _mm256_packus_epi16(halve16Avx2(v0, lowBytes), halve16Avx2(v1, lowBytes));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + x), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    halveSse2(row0 + 2 * x, row1 + 2 * x, dst + x, dstWidth - x);
+}
+
+const Kernels Avx2Kernels = {bgrxToLumaAvx2, stretchAvx2, sharpenAvx2, thresholdAvx2, halveAvx2};
+
+#endif // SMARTPOS_X86_SIMD
+
+const Kernels& kernelsFor(ImagePreprocessor::InstructionSet instructionSet)
+{
+#ifdef SMARTPOS_X86_SIMD
+    switch (instructionSet) {
+    case ImagePreprocessor::AVX2:
+        return Avx2Kernels;
+    case ImagePreprocessor::SSE2:
+        return Sse2Kernels;
+    default:
+        break;
+    }
+#else
+    Q_UNUSED(instructionSet);
+#endif
+    return ScalarKernels;
+}
+
+ImagePreprocessor::InstructionSet detectInstructionSet()
+{
+#ifdef SMARTPOS_X86_SIMD
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] >= 7) {
+        __cpuid(info, 1);
+        const bool osSavesAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        if (osSavesAvx && (info[1] & (1 << 5))) {
+            return ImagePreprocessor::AVX2;
+        }
+    }
+    return ImagePreprocessor::SSE2;     // x86-64的基线
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? ImagePreprocessor::AVX2 : ImagePreprocessor::SSE2;
+#endif
+#else
+    return ImagePreprocessor::Scalar;
+#endif
+}
+
+/**
+ * 每隔几行取样的亮度直方图（对比度和阈值只需要分布，不需要每个像素）
+ */
+void histogram(const uchar* data, int width, int height, int rowStep, int* bins)
+{
+    std::fill(bins, bins + 256, 0);
+    for (int y = 0; y < height; y += rowStep) {
+        const uchar* row = data + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; ++x) {
+            ++bins[row[x]];
+        }
+    }
+}
+
+/**
+ * Otsu阈值：使前景/背景类间方差最大的灰度
+ */
+int otsuThreshold(const int* bins)
+{
+    qint64 total = 0;
+    double sum = 0.0;
+    for (int i = 0; i < 256; ++i) {
+        total += bins[i];
+        sum += static_cast<double>(i) * bins[i];
+    }
+
+    qint64 background = 0;
+    double backgroundSum = 0.0;
+    double bestVariance = -1.0;
+    int threshold = 127;
+    for (int i = 0; i < 256; ++i) {
+        background += bins[i];
+        if (background == 0) {
+            continue;
+        }
+        const qint64 foreground = total - background;
+        if (foreground == 0) {
+            break;
+        }
+        backgroundSum += static_cast<double>(i) * bins[i];
+        const double meanBackground = backgroundSum / background;
+        const double meanForeground = (sum - backgroundSum) / foreground;
+        const double variance = static_cast<double>(background) * foreground
+                                * (meanBackground - meanForeground) * (meanBackground - meanForeground);
+        if (variance > bestVariance) {
+            bestVariance = variance;
+            threshold = i;
+        }
+    }
+    return threshold;
+}
+
+}
+
+ImagePreprocessor::ImagePreprocessor()
+    : m_instructionSet(supportedInstructionSet())
+    , m_normalizeContrast(true)
+    , m_sharpen(false)
+    , m_binarize(false)
+{
+}
+
+ImagePreprocessor::InstructionSet ImagePreprocessor::supportedInstructionSet()
+{
+    static const InstructionSet supported = detectInstructionSet();
+    return supported;
+}
+
+QString ImagePreprocessor::instructionSetName(InstructionSet instructionSet)
+{
+    switch (instructionSet) {
+    case AVX2:
+        return QStringLiteral("avx2");
+    case SSE2:
+        return QStringLiteral("sse2");
+    default:
+        return QStringLiteral("scalar");
+    }
+}
+
+void ImagePreprocessor::setInstructionSet(InstructionSet instructionSet)
+{
+    m_instructionSet = std::min(instructionSet, supportedInstructionSet());
+}
+
+LuminanceImage ImagePreprocessor::process(const QImage& image)
+{
+    if (image.isNull()) {
+        return LuminanceImage();
+    }
+
+    const Kernels& kernels = kernelsFor(m_instructionSet);
+    const int width = image.width();
+    const int height = image.height();
+    m_luminance.resize(static_cast<size_t>(width) * height);
+    uchar* dst = m_luminance.data();
+
+    switch (image.format()) {
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+    case QImage::Format_ARGB32_Premultiplied:
+        // 小端序下32位RGB在内存中就是B G R X
+        for (int y = 0; y < height; ++y) {
+            kernels.bgrxToLuma(image.constScanLine(y), dst + static_cast<size_t>(y) * width, width);
+        }
+        break;
+#endif
+    case QImage::Format_RGB888:
+        for (int y = 0; y < height; ++y) {
+            rgb888ToLumaScalar(image.constScanLine(y), dst + static_cast<size_t>(y) * width, width);
+        }
+        break;
+    case QImage::Format_Grayscale8:
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(dst + static_cast<size_t>(y) * width, image.constScanLine(y), width);
+        }
+        break;
+    default: {
+        const QImage gray = image.convertToFormat(QImage::Format_Grayscale8);
+        for (int y = 0; y < height; ++y) {
+            std::memcpy(dst + static_cast<size_t>(y) * width, gray.constScanLine(y), width);
+        }
+        break;
+    }
+    }
+
+    enhance(width, height);
+    return LuminanceImage{m_luminance.data(), width, height, width};
+}
+
+LuminanceImage ImagePreprocessor::process(const LuminanceImage& luminance)
+{
+    if (luminance.isNull() || (!m_normalizeContrast && !m_sharpen && !m_binarize)) {
+        return luminance;
+    }
+
+    const int width = luminance.width;
+    const int height = luminance.height;
+    m_luminance.resize(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(m_luminance.data() + static_cast<size_t>(y) * width,
+                    luminance.data + static_cast<size_t>(y) * luminance.bytesPerLine, width);
+    }
+
+    enhance(width, height);
+    return LuminanceImage{m_luminance.data(), width, height, width};
+}
+
+LuminanceImage ImagePreprocessor::downscale(const LuminanceImage& source, int maxDimension)
+{
+    if (source.isNull() || std::max(source.width, source.height) <= maxDimension) {
+        return source;
+    }
+
+    const Kernels& kernels = kernelsFor(m_instructionSet);
+    LuminanceImage current = source;
+    // 两个缓冲区轮流作为输入和输出
+    std::vector<uchar>* target = &m_downscaled;
+    std::vector<uchar>* spare = &m_halving;
+    while (std::max(current.width, current.height) > maxDimension && current.width >= 2 && current.height >= 2) {
+        const int width = current.width / 2;
+        const int height = current.height / 2;
+        target->resize(static_cast<size_t>(width) * height);
+        for (int y = 0; y < height; ++y) {
+            const uchar* row0 = current.data + static_cast<size_t>(2 * y) * current.bytesPerLine;
+            kernels.halve(row0, row0 + current.bytesPerLine, target->data() + static_cast<size_t>(y) * width, width);
+        }
+        current = LuminanceImage{target->data(), width, height, width};
+        std::swap(target, spare);
+    }
+    return current;
+}
+
+void ImagePreprocessor::enhance(int width, int height)
+{
+    const Kernels& kernels = kernelsFor(m_instructionSet);
+    const int rowStep = height > 256 ? 4 : 1;
+    int bins[256];
+
+    if (m_normalizeContrast) {
+        histogram(m_luminance.data(), width, height, rowStep, bins);
+        qint64 samples = 0;
+        for (int count : bins) {
+            samples += count;
+        }
+
+        // 两端各去掉1%的像素（反光点、阴影），把剩下的范围拉伸到0..255
+        const qint64 clip = samples / 100;
+        int low = 0;
+        for (qint64 seen = bins[0]; seen <= clip && low < 255; seen += bins[++low]) {}
+        int high = 255;
+        for (qint64 seen = bins[255]; seen <= clip && high > 0; seen += bins[--high]) {}
+
+        if (high - low >= 8 && (low > 0 || high < 255)) {
+            const int scale = std::min(0x7FFF, 255 * 256 / (high - low));
+            for (int y = 0; y < height; ++y) {
+                uchar* row = m_luminance.data() + static_cast<size_t>(y) * width;
+                kernels.stretch(row, row, width, low, scale);
+            }
+        }
+    }
+
+    if (m_sharpen && width >= 3 && height >= 3) {
+        m_scratch.resize(m_luminance.size());
+        const uchar* src = m_luminance.data();
+        uchar* dst = m_scratch.data();
+        std::memcpy(dst, src, width);
+        std::memcpy(dst + static_cast<size_t>(height - 1) * width, src + static_cast<size_t>(height - 1) * width, width);
+        for (int y = 1; y < height - 1; ++y) {
+            const uchar* mid = src + static_cast<size_t>(y) * width;
+            kernels.sharpen(mid - width, mid, mid + width, dst + static_cast<size_t>(y) * width, width);
+        }
+        m_luminance.swap(m_scratch);
+    }
+
+    if (m_binarize) {
+        histogram(m_luminance.data(), width, height, rowStep, bins);
+        const int threshold = std::min(255, otsuThreshold(bins) + 1);
+        for (int y = 0; y < height; ++y) {
+            uchar* row = m_luminance.data() + static_cast<size_t>(y) * width;
+            kernels.threshold(row, row, width, threshold);
+        }
+    }
+}
@@ -0,0 +1,110 @@
+#ifndef IMAGEPREPROCESSOR_H
+#define IMAGEPREPROCESSOR_H
+
+#include <QString>
+#include <QImage>
+#include <vector>
+
+/**
+ * @brief 8位灰度图的只读视图（不拥有数据）
+ */
+struct LuminanceImage
+{
+    const uchar* data = nullptr;
+    int width = 0;
+    int height = 0;
+    int bytesPerLine = 0;
+
+    bool isNull() const { return !data || width <= 0 || height <= 0; }
+};
+
+/**
+ * @brief ImagePreprocessor类 - 解码前的图片预处理
+ *
+ * 把BGRX/RGB图片一遍转换成8位亮度，然后按设置做对比度拉伸、锐化和二值化，
+ * 结果以LuminanceImage的形式直接交给ZXing，不再经过QImage格式转换。
+ *
+ * 内核有SSE2、AVX2和标量三种实现，运行时按CPU选择（构建时关闭SMARTPOS_SIMD则只用标量）。
+ * 缓冲区在多次调用之间复用，返回的视图在下一次调用前有效。
+ * 一个实例只能在一个线程中使用；解码线程各自持有一个。
+ */
+class ImagePreprocessor
+{
+public:
+    /**
+     * @brief 内核使用的指令集
+     */
+    enum InstructionSet {
+        Scalar = 0,
+        SSE2,
+        AVX2
+    };
+
+    ImagePreprocessor();
+
+    /**
+     * @brief 当前CPU和构建支持的最高指令集
+     */
+    static InstructionSet supportedInstructionSet();
+    static QString instructionSetName(InstructionSet instructionSet);
+
+    /**
+     * @brief 指定内核指令集（不超过supportedInstructionSet，用于对比测试）
+     */
+    void setInstructionSet(InstructionSet instructionSet);
+    InstructionSet instructionSet() const { return m_instructionSet; }
+
+    /**
+     * @brief 按亮度直方图的1%和99%分位拉伸对比度（默认开启，光线差的照片主要靠它）
+     */
+    void setNormalizeContrast(bool enabled) { m_normalizeContrast = enabled; }
+    bool normalizeContrast() const { return m_normalizeContrast; }
+
+    /**
+     * @brief 3x3锐化（默认关闭，用于轻微失焦的照片）
+     */
+    void setSharpen(bool enabled) { m_sharpen = enabled; }
+    bool sharpen() const { return m_sharpen; }
+
+    /**
+     * @brief 用Otsu全局阈值二值化（默认关闭）
+     */
+    void setBinarize(bool enabled) { m_binarize = enabled; }
+    bool binarize() const { return m_binarize; }
+
+    /**
+     * @brief 转换成亮度并预处理
+     * @param image 输入图片（32位RGB、RGB888和Grayscale8直接处理，其余格式先转换）
+     * @return 预处理后的灰度视图，在下一次调用前有效
+     */
+    LuminanceImage process(const QImage& image);
+
+    /**
+     * @brief 预处理已有的亮度数据（如视频帧的Y平面）；不需要任何处理时直接返回输入视图
+     */
+    LuminanceImage process(const LuminanceImage& luminance);
+
+    /**
+     * @brief 用2x2均值逐级缩小，直到长边不超过maxDimension
+     * @return 缩小后的视图（不需要缩小时返回输入视图），在下一次调用downscale前有效
+     */
+    LuminanceImage downscale(const LuminanceImage& source, int maxDimension);
+
+private:
+    /**
+     * @brief 在m_luminance中的图像上原地执行对比度拉伸、锐化和二值化
+     */
+    void enhance(int width, int height);
+
+    InstructionSet m_instructionSet;
+    bool m_normalizeContrast;
+    bool m_sharpen;
+    bool m_binarize;
+
+    std::vector<uchar> m_luminance;     ///< 预处理结果
+    std::vector<uchar> m_scratch;       ///< 锐化的临时缓冲区
+    std::vector<uchar> m_downscaled;    ///< 缩小结果
+    std::vector<uchar> m_halving;       ///< 逐级缩小的中间结果
+};
+
+#endif // IMAGEPREPROCESSOR_H
@@ -0,0 +1,210 @@
+#include "KeyboardWedgeFilter.h"
+#include <QApplication>
+#include <QKeyEvent>
+#include <QTimer>
+#include <QWidget>
+
+namespace {
+
+bool isTerminator(int key)
+{
+    return key == Qt::Key_Return || key == Qt::Key_Enter || key == Qt::Key_Tab;
+}
+
+}
+
+KeyboardWedgeFilter::KeyboardWedgeFilter(QObject *parent)
+    : QObject(parent)
+    , m_maxInterKeyMsecs(30)
+    , m_minimumLength(6)
+    , m_enabled(true)
+    , m_replaying(false)
+    , m_dispatching(false)
+    , m_length(0)
+    , m_burstTimer(new QTimer(this))
+{
+    m_burstTimer->setSingleShot(true);
+    m_burstTimer->setTimerType(Qt::PreciseTimer);
+    m_burstTimer->setInterval(m_maxInterKeyMsecs);
+    connect(m_burstTimer, &QTimer::timeout, this, &KeyboardWedgeFilter::onBurstTimeout);
+}
+
+void KeyboardWedgeFilter::setMaxInterKeyMsecs(int msecs)
+{
+    m_maxInterKeyMsecs = qMax(1, msecs);
+    m_burstTimer->setInterval(m_maxInterKeyMsecs);
+}
+
+void KeyboardWedgeFilter::setMinimumLength(int length)
+{
+    m_minimumLength = qBound(1, length, MaxCodeLength);
+}
+
+void KeyboardWedgeFilter::setScope(QWidget* window)
+{
+    m_scope = window;
+}
+
+void KeyboardWedgeFilter::setEnabled(bool enabled)
+{
+    if (!enabled && m_length > 0) {
+        replay();
+    }
+    m_enabled = enabled;
+}
+
+bool KeyboardWedgeFilter::eventFilter(QObject *watched, QEvent *event)
+{
+    // 按键先到达窗口再转给控件，只在控件这一站处理；补发的按键直接放行
+    if (event->type() != QEvent::KeyPress || !m_enabled || m_replaying || !watched->isWidgetType()) {
+        return false;
+    }
+
+    // 作用范围之外的按键放行；之前暂存的按键按原样补发
+    if (!acceptsTarget(static_cast<QWidget*>(watched))) {
+        if (m_length > 0) {
+            replay();
+        }
+        return false;
+    }
+
+    auto* keyEvent = static_cast<QKeyEvent*>(event);
+    const bool commandModifier = keyEvent->modifiers() & (Qt::ControlModifier | Qt::AltModifier | Qt::MetaModifier);
+
+    if (isTerminator(keyEvent->key()) && !commandModifier) {
+        if (isScanCandidate()) {
+            QElapsedTimer timer;
+            timer.start();
+            dispatch(timer);
+            return true;
+        }
+        if (m_length > 0) {
+            replay();
+        }
+        return false;
+    }
+
+    const QString text = keyEvent->text();
+    if (keyEvent->isAutoRepeat() || commandModifier || text.size() != 1 || !text.at(0).isPrint()) {
+        if (m_length > 0) {
+            replay();
+        }
+        return false;
+    }
+
+    // 间隔过长或换了控件：之前暂存的按键已经是完整的一段
+    if (m_length > 0
+        && (m_lastKey.nsecsElapsed() > m_maxInterKeyMsecs * 1000000LL || watched != m_target)) {
+        onBurstTimeout();
+    }
+    if (m_length == MaxCodeLength) {
+        replay();
+    }
+
+    if (m_length == 0) {
+        m_target = watched;
+    }
+    m_keys[m_length++] = BufferedKey{keyEvent->key(), keyEvent->modifiers(), text.at(0)};
+    m_lastKey.start();
+    m_burstTimer->start();
+    return true;
+}
+
+void KeyboardWedgeFilter::onBurstTimeout()
+{
+    if (m_length == 0) {
+        return;
+    }
+
+    // 没有结束键的扫码枪靠停顿结束
+    if (isScanCandidate()) {
+        QElapsedTimer timer;
+        timer.start();
+        dispatch(timer);
+    } else {
+        replay();
+    }
+}
+
+void KeyboardWedgeFilter::dispatch(const QElapsedTimer& timer)
+{
+    QString barcode;
+    barcode.reserve(m_length);
+    for (int i = 0; i < m_length; ++i) {
+        barcode.append(m_keys[i].text);
+    }
+    m_length = 0;
+    m_target.clear();
+    m_burstTimer->stop();
+
+    // 结果一直没来的扫码（如接收方没有调用lookupFinished）不无限累积
+    if (m_pendingLookups.size() == MaxPendingLookups) {
+        m_pendingLookups.removeFirst();
+    }
+    m_pendingLookups.append(PendingLookup{barcode, timer});
+    ++m_statistics.scans;
+
+    m_dispatching = true;
+    emit barcodeScanned(barcode);
+    m_dispatching = false;
+}
+
+void KeyboardWedgeFilter::lookupFinished(const QString& barcode)
+{
+    for (int i = 0; i < m_pendingLookups.size(); ++i) {
+        if (m_pendingLookups.at(i).barcode == barcode) {
+            const qint64 latency = m_pendingLookups.at(i).timer.nsecsElapsed();
+            m_pendingLookups.removeAt(i);
+            addSample(m_dispatching ? &m_statistics.cacheHit : &m_statistics.cacheMiss, latency);
+            return;
+        }
+    }
+}
+
+void KeyboardWedgeFilter::addSample(Latency* latency, qint64 nsecs)
+{
+    ++latency->samples;
+    latency->lastNsecs = nsecs;
+    latency->maxNsecs = qMax(latency->maxNsecs, nsecs);
+    latency->averageNsecs += (nsecs - latency->averageNsecs) / latency->samples;
+}
+
+bool KeyboardWedgeFilter::acceptsTarget(const QWidget* widget) const
+{
+    // 模态对话框中的输入（如商品对话框的条码框）原样交给控件
+    if (QApplication::activeModalWidget()) {
+        return false;
+    }
+    if (m_scope && widget->window() != m_scope) {
+        return false;
+    }
+    for (const QWidget* w = widget; w; w = w->parentWidget()) {
+        if (w->property(ExemptProperty).toBool()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void KeyboardWedgeFilter::replay()
+{
+    const int count = m_length;
+    QPointer<QObject> target = m_target;
+    m_length = 0;
+    m_target.clear();
+    m_burstTimer->stop();
+
+    // 控件已经销毁时丢弃
+    if (!target) {
+        return;
+    }
+
+    m_replaying = true;
+    for (int i = 0; i < count && target; ++i) {
+        const BufferedKey& key = m_keys[i];
+        QKeyEvent press(QEvent::KeyPress, key.key, key.modifiers, QString(key.text));
+        QCoreApplication::sendEvent(target, &press);
+    }
+    m_replaying = false;
+    m_statistics.replayedKeys += count;
+}
@@ -0,0 +1,175 @@
+#ifndef KEYBOARDWEDGEFILTER_H
+#define KEYBOARDWEDGEFILTER_H
+
+#include <QObject>
+#include <QString>
+#include <QPointer>
+#include <QElapsedTimer>
+#include <QList>
+#include <array>
+
+class QTimer;
+class QKeyEvent;
+class QWidget;
+
+/**
+ * @brief KeyboardWedgeFilter类 - 键盘模拟式扫码枪的输入识别
+ *
+ * 扫码枪模拟键盘，每个字符之间只隔几毫秒，人工打字则通常在50毫秒以上。
+ * 作为应用程序级事件过滤器安装后，可打印字符先暂存在定长缓冲区中而不交给控件：
+ * - 相邻按键间隔都不超过阈值、长度达到下限，并以回车/Tab结束（或停顿）时，判定为一次扫码，
+ *   直接发射barcodeScanned，不经过任何输入框，结束键也被吞掉
+ * - 否则判定为人工输入，按原顺序把暂存的按键补发给原来的控件（人工输入最多延迟一个阈值）
+ *
+ * 只处理发往作用窗口（setScope）中控件的按键；有模态对话框时、或控件及其上级设置了
+ * ExemptProperty属性时按键直接放行，例如商品对话框的条码输入框需要收到扫码内容。
+ *
+ * 从结束键到条码查找给出结果（接收方调用lookupFinished）的耗时记录在statistics()中：
+ * 在barcodeScanned返回前就得到结果的计为缓存命中（目标低于1毫秒），之后异步得到的计为缓存未命中，
+ * 两类分开统计。只在界面线程中使用。
+ */
+class KeyboardWedgeFilter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 从结束键到查找完成的耗时统计
+     */
+    struct Latency
+    {
+        qint64 samples = 0;                 ///< 样本数
+        qint64 lastNsecs = 0;               ///< 最近一次耗时（纳秒）
+        qint64 maxNsecs = 0;                ///< 最大耗时（纳秒）
+        double averageNsecs = 0.0;          ///< 平均耗时（纳秒）
+    };
+
+    /**
+     * @brief 扫码统计
+     */
+    struct Statistics
+    {
+        qint64 scans = 0;                   ///< 累计识别的扫码次数
+        qint64 replayedKeys = 0;            ///< 判定为人工输入后补发给控件的按键数
+        Latency cacheHit;                   ///< barcodeScanned返回前就得到结果的查找
+        Latency cacheMiss;                  ///< 异步（查询数据库）得到结果的查找
+    };
+
+    /**
+     * @brief 控件属性：为true时该控件及其子控件的按键不做扫码识别
+     */
+    static constexpr const char* ExemptProperty = "keyboardWedgeExempt";
+
+    /**
+     * @brief 构造函数（需要再用qApp->installEventFilter安装）
+     * @param parent 父对象指针
+     */
+    explicit KeyboardWedgeFilter(QObject *parent = nullptr);
+
+    /**
+     * @brief 设置相邻按键的最大间隔（毫秒），默认30
+     */
+    void setMaxInterKeyMsecs(int msecs);
+    int maxInterKeyMsecs() const { return m_maxInterKeyMsecs; }
+
+    /**
+     * @brief 设置条码的最短长度，默认6（短于它的快速输入按人工输入处理）
+     */
+    void setMinimumLength(int length);
+    int minimumLength() const { return m_minimumLength; }
+
+    /**
+     * @brief 设置作用窗口：只识别发往该窗口中控件的按键（为空时不限窗口）
+     */
+    void setScope(QWidget* window);
+
+    /**
+     * @brief 启用或停用（停用时所有按键直接交给控件）
+     */
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+
+    Statistics statistics() const { return m_statistics; }
+
+    /**
+     * @brief 条码查找给出结果（找到、未找到或查询失败）时由接收方调用，结束该次扫码的计时
+     * @param barcode 条码字符串；不是本过滤器发出的条码时忽略
+     */
+    void lookupFinished(const QString& barcode);
+
+signals:
+    /**
+     * @brief 识别到一次扫码时发射的信号（在事件过滤器中直接发射，请使用直接连接）
+     * @param barcode 条码字符串
+     */
+    void barcodeScanned(const QString& barcode);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    /**
+     * @brief 缓冲区中的一个按键（补发时按原样重建事件）
+     */
+    struct BufferedKey
+    {
+        int key = 0;
+        Qt::KeyboardModifiers modifiers;
+        QChar text;
+    };
+
+    static constexpr int MaxCodeLength = 64;
+    static constexpr int MaxPendingLookups = 16;
+
+    /**
+     * @brief 已发出、等待查找结果的扫码
+     */
+    struct PendingLookup
+    {
+        QString barcode;
+        QElapsedTimer timer;
+    };
+
+    static void addSample(Latency* latency, qint64 nsecs);
+
+    /**
+     * @brief 停顿超时：缓冲区是一次完整的扫码就发出，否则补发给控件
+     */
+    void onBurstTimeout();
+
+    /**
+     * @brief 把缓冲区中的字符作为条码发出，开始等待查找结果
+     * @param timer 从结束键（或停顿判定）开始计时
+     */
+    void dispatch(const QElapsedTimer& timer);
+
+    /**
+     * @brief 按原顺序把缓冲区中的按键补发给原来的控件
+     */
+    void replay();
+
+    bool isScanCandidate() const { return m_length >= m_minimumLength; }
+
+    /**
+     * @brief 发往该控件的按键是否参与扫码识别
+     */
+    bool acceptsTarget(const QWidget* widget) const;
+
+    int m_maxInterKeyMsecs;                             ///< 相邻按键的最大间隔
+    int m_minimumLength;                                ///< 条码最短长度
+    bool m_enabled;
+    bool m_replaying;                                   ///< 正在补发按键，过滤器放行
+    bool m_dispatching;                                 ///< 正在发射barcodeScanned
+
+    std::array<BufferedKey, MaxCodeLength> m_keys;      ///< 暂存的按键
+    int m_length;                                       ///< 暂存的按键数
+    QPointer<QObject> m_target;                         ///< 暂存按键原来的接收控件
+    QPointer<QWidget> m_scope;                          ///< 作用窗口
+    QElapsedTimer m_lastKey;                            ///< 上一个暂存按键的时间
+    QTimer* m_burstTimer;                               ///< 停顿超时
+    QList<PendingLookup> m_pendingLookups;              ///< 等待查找结果的扫码，按发出顺序
+
+    Statistics m_statistics;
+};
+
+#endif // KEYBOARDWEDGEFILTER_H
@@ -0,0 +1,214 @@
+#include "VideoDecodePipeline.h"
+#include <QThread>
+#include <QVideoSink>
+#include <QVideoFrameFormat>
+
+namespace {
+
+constexpr qint64 NsecsPerMsec = 1000000;
+constexpr qint64 StatisticsIntervalNsecs = 1000 * NsecsPerMsec;
+constexpr int MaxRememberedBarcodes = 64;
+
+bool hasLuminancePlane(QVideoFrameFormat::PixelFormat format)
+{
+    // 这些格式的第0个平面就是8位亮度（Y）
+    switch (format) {
+    case QVideoFrameFormat::Format_YUV420P:
+    case QVideoFrameFormat::Format_YUV422P:
+    case QVideoFrameFormat::Format_YV12:
+    case QVideoFrameFormat::Format_NV12:
+    case QVideoFrameFormat::Format_NV21:
+    case QVideoFrameFormat::Format_IMC1:
+    case QVideoFrameFormat::Format_IMC2:
+    case QVideoFrameFormat::Format_IMC3:
+    case QVideoFrameFormat::Format_IMC4:
+    case QVideoFrameFormat::Format_Y8:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * 解码一帧；8位YUV格式直接用Y平面作为灰度图，不做颜色转换
+ */
+QString decodeFrame(const BarcodeDecoder& decoder, QVideoFrame& frame)
+{
+    if (hasLuminancePlane(frame.pixelFormat()) && frame.map(QVideoFrame::ReadOnly)) {
+        const QString barcode = decoder.decodeLuminance(frame.bits(0), frame.width(), frame.height(), frame.bytesPerLine(0));
+        frame.unmap();
+        return barcode;
+    }
+    // 其他格式（RGB、硬件纹理等）交给Qt转换成QImage
+    return decoder.decode(frame.toImage());
+}
+
+}
+
+VideoDecodePipeline::VideoDecodePipeline(QObject *parent)
+    : QObject(parent)
+    , m_pendingArrivalNsecs(0)
+    , m_hasPendingFrame(false)
+    , m_stopping(false)
+    , m_duplicateWindowNsecs(1500 * NsecsPerMsec)
+    , m_thread(nullptr)
+{
+    m_decoder.setMaxStage(BarcodeDecoder::FastPass);
+    m_clock.start();
+
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("VideoDecodePipeline");
+    m_thread->start();
+}
+
+VideoDecodePipeline::~VideoDecodePipeline()
+{
+    setVideoSink(nullptr);
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_frameAvailable.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void VideoDecodePipeline::setVideoSink(QVideoSink* sink)
+{
+    if (m_sink == sink) {
+        return;
+    }
+    if (m_sink) {
+        disconnect(m_sink, nullptr, this, nullptr);
+    }
+    m_sink = sink;
+    if (m_sink) {
+        // 直接在产生帧的线程中入队，不经过界面线程的事件循环
+        connect(m_sink, &QVideoSink::videoFrameChanged, this, &VideoDecodePipeline::submitFrame, Qt::DirectConnection);
+    }
+}
+
+void VideoDecodePipeline::setDuplicateWindow(int msecs)
+{
+    QMutexLocker locker(&m_mutex);
+    m_duplicateWindowNsecs = qMax(0, msecs) * NsecsPerMsec;
+}
+
+int VideoDecodePipeline::duplicateWindow() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_duplicateWindowNsecs / NsecsPerMsec);
+}
+
+void VideoDecodePipeline::setDecoder(const BarcodeDecoder& decoder)
+{
+    QMutexLocker locker(&m_mutex);
+    m_decoder = decoder;
+}
+
+void VideoDecodePipeline::submitFrame(const QVideoFrame& frame)
+{
+    if (!frame.isValid()) {
+        return;
+    }
+
+    QMutexLocker locker(&m_mutex);
+    if (m_hasPendingFrame) {
+        ++m_statistics.framesDropped;   // 上一帧还没轮到解码，直接用新帧替换
+    }
+    m_pendingFrame = frame;
+    m_pendingArrivalNsecs = m_clock.nsecsElapsed();
+    m_hasPendingFrame = true;
+    m_frameAvailable.wakeOne();
+}
+
+void VideoDecodePipeline::reset()
+{
+    QMutexLocker locker(&m_mutex);
+    m_lastSeenNsecs.clear();
+    m_statistics = Statistics();
+}
+
+VideoDecodePipeline::Statistics VideoDecodePipeline::statistics() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_statistics;
+}
+
+void VideoDecodePipeline::run()
+{
+    qint64 windowStartNsecs = m_clock.nsecsElapsed();
+    int windowFrames = 0;
+    qint64 windowLatencyNsecs = 0;
+
+    QMutexLocker locker(&m_mutex);
+    forever {
+        while (!m_hasPendingFrame && !m_stopping) {
+            m_frameAvailable.wait(&m_mutex);
+        }
+        if (m_stopping) {
+            break;
+        }
+
+        QVideoFrame frame = std::move(m_pendingFrame);
+        m_pendingFrame = QVideoFrame();
+        m_hasPendingFrame = false;
+        const qint64 arrivalNsecs = m_pendingArrivalNsecs;
+        const BarcodeDecoder decoder = m_decoder;
+        locker.unlock();
+
+        const QString barcode = decodeFrame(decoder, frame);
+        frame = QVideoFrame();  // 尽早把帧缓冲还给采集端
+        const qint64 nowNsecs = m_clock.nsecsElapsed();
+        const qint64 latencyNsecs = nowNsecs - arrivalNsecs;
+
+        locker.relock();
+        ++m_statistics.framesDecoded;
+        ++windowFrames;
+        windowLatencyNsecs += latencyNsecs;
+
+        const bool report = !barcode.isEmpty() && !isDuplicateLocked(barcode, nowNsecs);
+        if (report) {
+            ++m_statistics.barcodesDetected;
+        }
+
+        const qint64 windowNsecs = nowNsecs - windowStartNsecs;
+        const bool publish = windowNsecs >= StatisticsIntervalNsecs;
+        if (publish) {
+            m_statistics.framesPerSecond = windowFrames * 1e9 / windowNsecs;
+            m_statistics.averageLatencyMsecs = windowLatencyNsecs / 1e6 / windowFrames;
+            windowStartNsecs = nowNsecs;
+            windowFrames = 0;
+            windowLatencyNsecs = 0;
+        }
+        const Statistics statistics = m_statistics;
+        locker.unlock();
+
+        if (report) {
+            emit barcodeDetected(barcode, latencyNsecs / 1e6);
+        }
+        if (publish) {
+            emit statisticsUpdated(statistics.framesPerSecond, statistics.averageLatencyMsecs, statistics.framesDropped);
+        }
+        locker.relock();
+    }
+}
+
+bool VideoDecodePipeline::isDuplicateLocked(const QString& barcode, qint64 nowNsecs)
+{
+    auto it = m_lastSeenNsecs.find(barcode);
+    const bool duplicate = it != m_lastSeenNsecs.end() && nowNsecs - it.value() < m_duplicateWindowNsecs;
+    // 每次看到都刷新时间：条码一直在画面中时持续被去重
+    m_lastSeenNsecs.insert(barcode, nowNsecs);
+
+    if (m_lastSeenNsecs.size() > MaxRememberedBarcodes) {
+        for (auto stale = m_lastSeenNsecs.begin(); stale != m_lastSeenNsecs.end();) {
+            if (nowNsecs - stale.value() >= m_duplicateWindowNsecs) {
+                stale = m_lastSeenNsecs.erase(stale);
+            } else {
+                ++stale;
+            }
+        }
+    }
+    return duplicate;
+}
@@ -0,0 +1,132 @@
+#ifndef VIDEODECODEPIPELINE_H
+#define VIDEODECODEPIPELINE_H
+
+#include <QObject>
+#include <QString>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QVideoFrame>
+#include "BarcodeDecoder.h"
+
+class QThread;
+class QVideoSink;
+
+/**
+ * @brief VideoDecodePipeline类 - 视频流条码解码流水线
+ *
+ * 从任意QVideoSink（摄像头、视频文件）接收帧，在专用解码线程中用ZXing解码。
+ * 只保留最新的一帧：解码线程忙时到达的帧会替换尚未解码的帧（计为丢帧），
+ * 因此解码速度跟不上帧率时延迟不会累积。
+ *
+ * 同一条码持续出现在画面中时只报告一次，离开画面超过去重窗口后才会再次报告。
+ * barcodeDetected和statisticsUpdated在解码线程中发射，连接到界面对象时自动排队到界面线程。
+ */
+class VideoDecodePipeline : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 解码统计
+     */
+    struct Statistics
+    {
+        double framesPerSecond = 0.0;       ///< 最近一秒每秒解码的帧数
+        double averageLatencyMsecs = 0.0;   ///< 最近一秒从帧到达到解码完成的平均耗时（毫秒）
+        qint64 framesDecoded = 0;           ///< 累计解码的帧数
+        qint64 framesDropped = 0;           ///< 累计因解码线程忙而丢弃的帧数
+        qint64 barcodesDetected = 0;        ///< 累计报告的条码数（去重后）
+    };
+
+    /**
+     * @brief 构造函数（启动解码线程）
+     * @param parent 父对象指针
+     */
+    explicit VideoDecodePipeline(QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数（停止解码线程）
+     */
+    ~VideoDecodePipeline();
+
+    /**
+     * @brief 设置帧来源，传入nullptr断开当前来源
+     * @param sink 视频输出（QCamera或QMediaPlayer的videoSink）
+     */
+    void setVideoSink(QVideoSink* sink);
+
+    /**
+     * @brief 设置重复条码的去重窗口（毫秒），默认1500
+     */
+    void setDuplicateWindow(int msecs);
+    int duplicateWindow() const;
+
+    /**
+     * @brief 设置解码器选项（视频帧默认只执行FastPass阶段，未识别时靠后续帧补偿）
+     */
+    void setDecoder(const BarcodeDecoder& decoder);
+
+    /**
+     * @brief 提交一帧（线程安全，可以在任意线程中调用）
+     * @param frame 视频帧
+     */
+    void submitFrame(const QVideoFrame& frame);
+
+    /**
+     * @brief 清空去重记录和统计
+     */
+    void reset();
+
+    /**
+     * @brief 获取解码统计
+     */
+    Statistics statistics() const;
+
+signals:
+    /**
+     * @brief 检测到条码时发射的信号
+     * @param barcode 条码字符串
+     * @param latencyMsecs 从帧到达到解码出条码的耗时（毫秒）
+     */
+    void barcodeDetected(const QString& barcode, double latencyMsecs);
+
+    /**
+     * @brief 每秒发射一次的统计信号
+     * @param framesPerSecond 每秒解码的帧数
+     * @param averageLatencyMsecs 平均解码延迟（毫秒）
+     * @param framesDropped 累计丢帧数
+     */
+    void statisticsUpdated(double framesPerSecond, double averageLatencyMsecs, qint64 framesDropped);
+
+private:
+    /**
+     * @brief 解码线程主循环
+     */
+    void run();
+
+    /**
+     * @brief 判断条码是否在去重窗口内出现过（调用时持有m_mutex）
+     */
+    bool isDuplicateLocked(const QString& barcode, qint64 nowNsecs);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_frameAvailable;        ///< 有新帧或要求停止
+    QVideoFrame m_pendingFrame;             ///< 最新的待解码帧
+    qint64 m_pendingArrivalNsecs;           ///< 待解码帧的到达时间
+    bool m_hasPendingFrame;                 ///< 是否有待解码帧
+    bool m_stopping;                        ///< 要求解码线程退出
+
+    BarcodeDecoder m_decoder;               ///< 解码器
+    qint64 m_duplicateWindowNsecs;          ///< 去重窗口（纳秒）
+    QHash<QString, qint64> m_lastSeenNsecs; ///< 条码最后一次出现的时间
+    Statistics m_statistics;                ///< 解码统计
+
+    QElapsedTimer m_clock;                  ///< 单调时钟
+    QPointer<QVideoSink> m_sink;            ///< 当前帧来源
+    QThread* m_thread;                      ///< 解码线程
+};
+
+#endif // VIDEODECODEPIPELINE_H
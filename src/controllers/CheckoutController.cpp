@@ -3,79 +3,86 @@
 #include "../models/Product.h"
 #include "../models/Customer.h"
 #include "../database/DatabaseManager.h"
-#include "../utils/ReceiptPrinter.h"
+#include "../utils/Logging.h"
 #include <QDebug>
+#include <QHash>
+#include <QSet>
+#include <utility>
 
 CheckoutController::CheckoutController(QObject *parent)
     : QObject(parent)
     , m_currentSale(nullptr)
     , m_databaseManager(&DatabaseManager::getInstance())
-    , m_receiptPrinter(std::make_unique<ReceiptPrinter>(this))
     , m_cashierName("收银员")
     , m_paymentProcessed(false)
-    , m_changeAmount(0.0)
+    , m_changeAmount()
 {
-    qDebug() << "收银控制器初始化完成";
+    qCDebug(lcCheckout) << "收银控制器初始化完成";
 }
 
 CheckoutController::~CheckoutController()
 {
-    qDebug() << "收银控制器析构";
+    qCDebug(lcCheckout) << "收银控制器析构";
 }
 
 void CheckoutController::setCurrentSale(Sale* sale)
 {
-    qDebug() << "CheckoutController::setCurrentSale called, sale:" << sale;
-    qDebug() << "CheckoutController::setCurrentSale this:" << this;
+    POS_TRACE(lcCheckout) << "CheckoutController::setCurrentSale called, sale:" << sale;
+    POS_TRACE(lcCheckout) << "CheckoutController::setCurrentSale this:" << this;
     
     // 先断开之前销售的信号连接
     if (m_currentSale) {
-        qDebug() << "CheckoutController::setCurrentSale disconnecting old sale:" << m_currentSale;
+        POS_TRACE(lcCheckout) << "CheckoutController::setCurrentSale disconnecting old sale:" << m_currentSale;
         // 只断开特定的信号连接，避免断开所有连接
         disconnect(m_currentSale, &Sale::saleChanged, this, &CheckoutController::onSaleChanged);
-        disconnect(m_currentSale, &Sale::totalChanged, this, &CheckoutController::saleUpdated);
+        disconnect(m_currentSale, &Sale::itemsChanged, this, &CheckoutController::saleItemsChanged);
+        disconnect(m_currentSale, &Sale::totalChanged, this, &CheckoutController::saleTotalChanged);
     }
     
     // 设置新的销售对象
     m_currentSale = sale;
-    qDebug() << "CheckoutController::setCurrentSale m_currentSale set to:" << m_currentSale;
+    POS_TRACE(lcCheckout) << "CheckoutController::setCurrentSale m_currentSale set to:" << m_currentSale;
     
     // 重置状态
     m_paymentProcessed = false;
-    m_changeAmount = 0.0;
+    m_changeAmount = Money();
     
     // 只有当新销售对象不为空时才进行连接
     if (m_currentSale) {
-        qDebug() << "CheckoutController::setCurrentSale connecting signals for sale:" << m_currentSale;
+        POS_TRACE(lcCheckout) << "CheckoutController::setCurrentSale connecting signals for sale:" << m_currentSale;
         // 连接新销售的信号
         connect(m_currentSale, &Sale::saleChanged,
                 this, &CheckoutController::onSaleChanged);
+        // 原地变化只通知变化的行，结构变化才整体刷新
+        connect(m_currentSale, &Sale::itemsChanged,
+                this, &CheckoutController::saleItemsChanged);
         connect(m_currentSale, &Sale::totalChanged,
-                this, &CheckoutController::saleUpdated);
+                this, &CheckoutController::saleTotalChanged);
         
         // 设置收银员名称
         m_currentSale->setCashierName(m_cashierName);
+        resyncPromotions();
         
-        qDebug() << "设置当前销售，ID:" << m_currentSale->getTransactionId();
+        qCDebug(lcCheckout) << "设置当前销售，ID:" << m_currentSale->getTransactionId();
     } else {
-        qDebug() << "设置当前销售为nullptr";
+        qCDebug(lcCheckout) << "设置当前销售为nullptr";
     }
     
-    qDebug() << "CheckoutController::setCurrentSale emitting saleUpdated";
+    POS_TRACE(lcCheckout) << "CheckoutController::setCurrentSale emitting saleUpdated";
     emit saleUpdated();
-    qDebug() << "CheckoutController::setCurrentSale finished";
+    POS_TRACE(lcCheckout) << "CheckoutController::setCurrentSale finished";
 }
 
 Sale* CheckoutController::startNewSale(Customer* customer)
 {
-    qDebug() << "CheckoutController::startNewSale called, customer:" << customer;
+    POS_TRACE(lcCheckout) << "CheckoutController::startNewSale called, customer:" << customer;
     Sale* sale = new Sale();
     setCurrentSale(sale);
-    qDebug() << "CheckoutController::startNewSale created and set new Sale:" << sale;
+    POS_TRACE(lcCheckout) << "CheckoutController::startNewSale created and set new Sale:" << sale;
     return sale;
 }
 
-bool CheckoutController::addItemToSale(Product* product, int quantity, double unitPrice)
+bool CheckoutController::addItemToSale(Product* product, int quantity, Money unitPrice)
 {
     if (!m_currentSale) {
         emit errorOccurred("当前没有活动的销售");
@@ -101,19 +108,68 @@ bool CheckoutController::addItemToSale(Product* product, int quantity, double un
     }
     
     // 如果没有指定单价，使用商品当前价格
-    if (unitPrice <= 0.0) {
+    if (!unitPrice.isPositive()) {
         unitPrice = product->getPrice();
     }
     
     // 添加到销售
     m_currentSale->addItem(product, quantity, unitPrice);
+    syncPromotionLine(product->getProductId());
     
     emit itemAdded(product->getName(), quantity);
-    logOperation(QString("添加商品：%1 x %2").arg(product->getName()).arg(quantity));
+    // 每次扫描都会执行：调试级别关闭时连消息都不格式化
+    if (lcCheckout().isDebugEnabled()) {
+        logOperation(QString("添加商品：%1 x %2").arg(product->getName()).arg(quantity), QtDebugMsg);
+    }
     
     return true;
 }
 
+int CheckoutController::addItemsToSale(const QList<Product*>& products)
+{
+    if (!m_currentSale) {
+        emit errorOccurred("当前没有活动的销售");
+        return 0;
+    }
+
+    // 按首次出现的顺序合并重复的商品
+    QList<Product*> distinct;
+    QHash<Product*, int> quantities;
+    for (Product* product : products) {
+        if (!product) {
+            continue;
+        }
+        if (!quantities.contains(product)) {
+            distinct.append(product);
+        }
+        ++quantities[product];
+    }
+
+    int added = 0;
+    QStringList outOfStock;
+    m_currentSale->beginUpdate();
+    for (Product* product : distinct) {
+        const int quantity = quantities.value(product);
+        if (!checkStock(product, quantity)) {
+            outOfStock << product->getName();
+            continue;
+        }
+        m_currentSale->addItem(product, quantity, product->getPrice());
+        syncPromotionLine(product->getProductId());
+        added += quantity;
+        emit itemAdded(product->getName(), quantity);
+    }
+    m_currentSale->endUpdate();
+
+    if (!outOfStock.isEmpty()) {
+        emit errorOccurred(QString("以下商品库存不足，未添加：%1").arg(outOfStock.join("、")));
+    }
+    if (lcCheckout().isDebugEnabled()) {
+        logOperation(QString("批量添加商品：%1 件，%2 种").arg(added).arg(distinct.size() - outOfStock.size()), QtDebugMsg);
+    }
+    return added;
+}
+
 bool CheckoutController::removeItemFromSale(int productId)
 {
     if (!m_currentSale) {
@@ -121,16 +177,16 @@ bool CheckoutController::removeItemFromSale(int productId)
         return false;
     }
 
-    const auto& items = m_currentSale->getItems();
-    for (int i = 0; i < items.size(); ++i) {
-        if (items.at(i)->getProduct()->getProductId() == productId) {
-            QString productName = items.at(i)->getProduct()->getName();
-            if (m_currentSale->removeItem(i)) {
-                emit itemRemoved(i);
-                logOperation(QString("移除商品：%1").arg(productName));
-                return true;
+    int index = m_currentSale->indexOfProduct(productId);
+    if (index >= 0) {
+        QString productName = m_currentSale->itemAt(index)->getProduct()->getName();
+        if (m_currentSale->removeItem(index)) {
+            syncPromotionLine(productId);
+            emit itemRemoved(index);
+            if (lcCheckout().isDebugEnabled()) {
+                logOperation(QString("移除商品：%1").arg(productName), QtDebugMsg);
             }
-            break; 
+            return true;
         }
     }
 
@@ -145,30 +201,29 @@ bool CheckoutController::updateItemQuantity(int productId, int quantity)
         return false;
     }
 
-    const auto& items = m_currentSale->getItems();
-    for (int i = 0; i < items.size(); ++i) {
-        if (items.at(i)->getProduct()->getProductId() == productId) {
-            Product* product = items.at(i)->getProduct();
-
-            if (quantity <= 0) {
-                return removeItemFromSale(productId);
-            }
+    int index = m_currentSale->indexOfProduct(productId);
+    if (index >= 0) {
+        SaleItem* item = m_currentSale->itemAt(index);
+        Product* product = item->getProduct();
 
-            int currentQuantity = items.at(i)->getQuantity();
-            int additionalQuantity = quantity - currentQuantity;
+        if (quantity <= 0) {
+            return removeItemFromSale(productId);
+        }
 
-            if (additionalQuantity > 0) {
-                if (!checkStock(product, additionalQuantity)) {
-                    emit errorOccurred(QString("商品 %1 库存不足").arg(product->getName()));
-                    return false;
-                }
+        int additionalQuantity = quantity - item->getQuantity();
+        if (additionalQuantity > 0) {
+            if (!checkStock(product, additionalQuantity)) {
+                emit errorOccurred(QString("商品 %1 库存不足").arg(product->getName()));
+                return false;
             }
+        }
 
-            if (m_currentSale->updateItemQuantity(i, quantity)) {
-                logOperation(QString("更新商品数量：%1 -> %2").arg(product->getName()).arg(quantity));
-                return true;
+        if (m_currentSale->updateItemQuantity(index, quantity)) {
+            syncPromotionLine(productId);
+            if (lcCheckout().isDebugEnabled()) {
+                logOperation(QString("更新商品数量：%1 -> %2").arg(product->getName()).arg(quantity), QtDebugMsg);
             }
-            break;
+            return true;
         }
     }
 
@@ -195,11 +250,12 @@ bool CheckoutController::applyDiscount(const QString& discountType, double disco
         }
         m_currentSale->applyPercentageDiscount(discountValue);
     } else if (discountType.toLower() == "fixed") {
-        if (discountValue > m_currentSale->getTotalAmount()) {
-            emit errorOccurred("固定折扣不能超过总金额");
+        Money discount = Money::fromDouble(discountValue, Money::Rounding::HalfUp);
+        // 促销优惠先扣，手工折扣只能作用于剩余金额
+        if (!m_currentSale->applyFixedDiscount(discount)) {
+            emit errorOccurred("固定折扣不能超过促销后的金额");
             return false;
         }
-        m_currentSale->applyFixedDiscount(discountValue);
     } else {
         emit errorOccurred("无效的折扣类型");
         return false;
@@ -209,13 +265,13 @@ bool CheckoutController::applyDiscount(const QString& discountType, double disco
     return true;
 }
 
-bool CheckoutController::processPayment(const QString& paymentMethod, double amount, double customerMoney)
+bool CheckoutController::processPayment(const QString& paymentMethod, Money amount, Money customerMoney)
 {
     if (!validateSale()) {
         return false;
     }
     
-    double totalAmount = m_currentSale->getFinalAmount();
+    Money totalAmount = m_currentSale->getFinalAmount();
     
     if (amount < totalAmount) {
         emit errorOccurred("支付金额不足");
@@ -234,7 +290,7 @@ bool CheckoutController::processPayment(const QString& paymentMethod, double amo
         }
         m_changeAmount = customerMoney - totalAmount;
     } else {
-        m_changeAmount = 0.0;
+        m_changeAmount = Money();
     }
     
     m_paymentProcessed = true;
@@ -242,58 +298,48 @@ bool CheckoutController::processPayment(const QString& paymentMethod, double amo
     emit paymentProcessed(true, m_changeAmount);
     logOperation(QString("处理支付：%1，找零：¥%2")
                 .arg(paymentMethod)
-                .arg(m_changeAmount, 0, 'f', 2));
+                .arg(m_changeAmount.toString()));
     
     return true;
 }
 
 bool CheckoutController::completeSale()
 {
-    qDebug() << "CheckoutController::completeSale called, m_currentSale:" << m_currentSale << ", m_databaseManager:" << m_databaseManager << ", m_receiptPrinter:" << (m_receiptPrinter ? m_receiptPrinter.get() : nullptr);
+    qCDebug(lcCheckout) << "CheckoutController::completeSale called, m_currentSale:" << m_currentSale << ", m_databaseManager:" << m_databaseManager;
     if (!validateSale()) {
-        qDebug() << "CheckoutController::completeSale validateSale failed";
+        qCDebug(lcCheckout) << "CheckoutController::completeSale validateSale failed";
         return false;
     }
     if (!m_paymentProcessed) {
         emit errorOccurred("支付尚未处理");
-        qDebug() << "CheckoutController::completeSale payment not processed";
+        qCDebug(lcCheckout) << "CheckoutController::completeSale payment not processed";
         return false;
     }
     if (!m_currentSale) {
         emit errorOccurred("当前没有活动的销售");
-        qDebug() << "CheckoutController::completeSale m_currentSale is null";
+        qCDebug(lcCheckout) << "CheckoutController::completeSale m_currentSale is null";
         return false;
     }
     if (!m_databaseManager) {
         emit errorOccurred("数据库管理器未初始化");
-        qDebug() << "CheckoutController::completeSale m_databaseManager is null";
-        return false;
-    }
-    if (!m_receiptPrinter) {
-        emit errorOccurred("票据打印器未初始化");
-        qDebug() << "CheckoutController::completeSale m_receiptPrinter is null";
+        qCDebug(lcCheckout) << "CheckoutController::completeSale m_databaseManager is null";
         return false;
     }
     // 设置交易状态为已完成
     m_currentSale->setStatus(Sale::Completed);
     // 保存到数据库
     int transactionId = m_databaseManager->saveTransaction(m_currentSale);
-    qDebug() << "CheckoutController::completeSale after saveTransaction, transactionId:" << transactionId;
+    qCDebug(lcCheckout) << "CheckoutController::completeSale after saveTransaction, transactionId:" << transactionId;
     if (transactionId < 0) {
         emit errorOccurred("保存交易到数据库失败");
         return false;
     }
-    // 打印票据
-    if (!m_receiptPrinter->printReceipt(*m_currentSale, m_currentSale->getItems())) {
-        qWarning() << "打印票据失败，但交易已保存";
-        // 注意：这里不返回false，因为交易已经成功保存
-    }
     emit saleCompleted(transactionId);
     emit saleSuccessfullyCompleted(m_currentSale); // 发射带有完整销售信息的信号
     logOperation(QString("完成销售，交易ID：%1").arg(transactionId));
     // 重置状态
     m_paymentProcessed = false;
-    m_changeAmount = 0.0;
+    m_changeAmount = Money();
     return true;
 }
 
@@ -302,9 +348,10 @@ void CheckoutController::cancelSale()
     if (m_currentSale) {
         m_currentSale->setStatus(Sale::Cancelled);
         m_currentSale->clearItems();
+        resyncPromotions();
         
         m_paymentProcessed = false;
-        m_changeAmount = 0.0;
+        m_changeAmount = Money();
         
         emit saleCancelled();
         logOperation("取消销售");
@@ -315,21 +362,96 @@ void CheckoutController::clearSale()
 {
     if (m_currentSale) {
         m_currentSale->clearItems();
+        resyncPromotions();
         m_paymentProcessed = false;
-        m_changeAmount = 0.0;
+        m_changeAmount = Money();
         
         logOperation("清空销售");
     }
 }
 
-double CheckoutController::getChangeAmount(double paymentAmount) const
+int CheckoutController::parkCurrentSale(const QString& label)
+{
+    if (!m_currentSale || m_currentSale->isEmpty()) {
+        emit errorOccurred("购物车为空，无需挂单");
+        return -1;
+    }
+
+    int parkedId = m_databaseManager->saveParkedSale(label, m_cashierName,
+                                                     m_currentSale->getTotalItemCount(),
+                                                     m_currentSale->getFinalAmount(),
+                                                     SaleCodec::encode(*m_currentSale));
+    if (parkedId < 0) {
+        emit errorOccurred("保存挂单失败");
+        return -1;
+    }
+
+    // 清空购物车和折扣，只发出一次界面更新
+    m_currentSale->beginUpdate();
+    m_currentSale->clearItems();
+    m_currentSale->setDiscountAmount(Money());
+    resyncPromotions();
+    m_currentSale->endUpdate();
+    m_paymentProcessed = false;
+    m_changeAmount = Money();
+
+    emit parkedSalesChanged();
+    logOperation(QString("挂单：%1 %2").arg(parkedId).arg(label));
+    return parkedId;
+}
+
+bool CheckoutController::resumeParkedSale(int parkedId, const std::function<Product*(int)>& productLookup)
 {
     if (!m_currentSale) {
-        return 0.0;
+        emit errorOccurred("当前没有活动的销售");
+        return false;
+    }
+    if (!m_currentSale->isEmpty()) {
+        emit errorOccurred("请先完成或挂起当前销售");
+        return false;
+    }
+
+    ParkedSaleData data;
+    if (!SaleCodec::decode(m_databaseManager->getParkedSalePayload(parkedId), &data)) {
+        emit errorOccurred("挂单不存在或已损坏");
+        return false;
+    }
+
+    // 先从挂单表中取走，删除失败时不恢复，避免同一笔挂单既在购物车中又仍可恢复
+    if (!m_databaseManager->deleteParkedSale(parkedId)) {
+        emit errorOccurred("无法取出挂单，请重试");
+        return false;
+    }
+
+    // 重建项目、折扣和促销都在同一个批量更新内，界面只刷新一次
+    m_currentSale->beginUpdate();
+    int missing = SaleCodec::restore(data, m_currentSale, productLookup);
+    resyncPromotions();
+    m_currentSale->endUpdate();
+    m_paymentProcessed = false;
+    m_changeAmount = Money();
+
+    emit parkedSalesChanged();
+    if (missing > 0) {
+        emit errorOccurred(QString("挂单中有 %1 个商品已不存在，未能恢复").arg(missing));
+    }
+    logOperation(QString("恢复挂单：%1").arg(parkedId));
+    return true;
+}
+
+QList<ParkedSaleInfo> CheckoutController::parkedSales() const
+{
+    return m_databaseManager->getParkedSales();
+}
+
+Money CheckoutController::getChangeAmount(Money paymentAmount) const
+{
+    if (!m_currentSale) {
+        return Money();
     }
     
-    double total = m_currentSale->getFinalAmount();
-    return qMax(0.0, paymentAmount - total);
+    Money change = paymentAmount - m_currentSale->getFinalAmount();
+    return change.isNegative() ? Money() : change;
 }
 
 bool CheckoutController::checkStock(Product* product, int quantity) const
@@ -343,11 +465,7 @@ bool CheckoutController::checkStock(Product* product, int quantity) const
     
     // 如果当前销售中已经包含了这个商品，需要考虑已使用的数量
     if (m_currentSale) {
-        for (auto* item : m_currentSale->getItems()) {
-            if (item->getProduct() == product) {
-                availableStock -= item->getQuantity();
-            }
-        }
+        availableStock -= m_currentSale->quantityOfProduct(product->getProductId());
     }
     
     return availableStock >= quantity;
@@ -361,7 +479,49 @@ void CheckoutController::setCashierName(const QString& cashierName)
         m_currentSale->setCashierName(cashierName);
     }
     
-    qDebug() << "设置收银员：" << cashierName;
+    qCDebug(lcCheckout) << "设置收银员：" << cashierName;
+}
+
+void CheckoutController::setPromotionRules(PromotionRuleSetPtr rules)
+{
+    m_promotionEngine.setRuleSet(std::move(rules));
+    resyncPromotions();
+    qCDebug(lcCheckout) << "加载促销规则：" << m_promotionEngine.ruleCount() << "条";
+}
+
+void CheckoutController::syncPromotionLine(int productId)
+{
+    // 不参与任何促销的商品直接跳过
+    if (!m_currentSale || !m_promotionEngine.hasRuleFor(productId)) {
+        return;
+    }
+
+    const SaleItem* item = m_currentSale->findItem(productId);
+    int quantity = m_currentSale->quantityOfProduct(productId);
+    Money unitPrice = item ? item->getUnitPrice() : Money();
+    m_currentSale->setPromotionDiscount(m_promotionEngine.updateLine(productId, quantity, unitPrice));
+}
+
+void CheckoutController::resyncPromotions()
+{
+    m_promotionEngine.clearCart();
+    if (!m_currentSale) {
+        return;
+    }
+
+    QSet<int> productIds;
+    for (const SaleItem* item : m_currentSale->getItems()) {
+        if (item->getProduct()) {
+            productIds.insert(item->getProduct()->getProductId());
+        }
+    }
+
+    m_currentSale->beginUpdate();
+    for (int productId : std::as_const(productIds)) {
+        syncPromotionLine(productId);
+    }
+    m_currentSale->setPromotionDiscount(m_promotionEngine.totalDiscount());
+    m_currentSale->endUpdate();
 }
 
 void CheckoutController::onSaleChanged()
@@ -381,7 +541,7 @@ bool CheckoutController::validateSale() const
         return false;
     }
     
-    if (m_currentSale->getFinalAmount() <= 0) {
+    if (!m_currentSale->getFinalAmount().isPositive()) {
         emit const_cast<CheckoutController*>(this)->errorOccurred("销售金额无效");
         return false;
     }
@@ -391,13 +551,13 @@ bool CheckoutController::validateSale() const
 
 bool CheckoutController::updateInventory()
 {
-    qDebug() << "CheckoutController::updateInventory called, m_currentSale:" << m_currentSale << ", m_databaseManager:" << m_databaseManager;
+    qCDebug(lcCheckout) << "CheckoutController::updateInventory called, m_currentSale:" << m_currentSale << ", m_databaseManager:" << m_databaseManager;
     if (!m_currentSale) {
-        qDebug() << "CheckoutController::updateInventory m_currentSale is null";
+        qCDebug(lcCheckout) << "CheckoutController::updateInventory m_currentSale is null";
         return false;
     }
     if (!m_databaseManager) {
-        qDebug() << "CheckoutController::updateInventory m_databaseManager is null";
+        qCDebug(lcCheckout) << "CheckoutController::updateInventory m_databaseManager is null";
         return false;
     }
     // 更新所有商品的库存
@@ -414,11 +574,19 @@ bool CheckoutController::updateInventory()
     return true;
 }
 
-void CheckoutController::logOperation(const QString& message)
+void CheckoutController::logOperation(const QString& message, QtMsgType level)
 {
+    if (!lcCheckout().isEnabled(level)) {
+        return;
+    }
+
     QString logMessage = QString("[%1] %2: %3")
                         .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss"))
                         .arg(m_cashierName)
                         .arg(message);
-    qDebug() << logMessage;
+    if (level == QtDebugMsg) {
+        qCDebug(lcCheckout) << logMessage;
+    } else {
+        qCInfo(lcCheckout) << logMessage;
+    }
 }
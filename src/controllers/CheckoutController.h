@@ -2,14 +2,17 @@
 #define CHECKOUTCONTROLLER_H
 
 #include <QObject>
+#include <functional>
 #include <memory>
+#include "../models/Money.h"
+#include "../models/SaleCodec.h"
+#include "PromotionEngine.h"
 
 // 前向声明
 class Sale;
 class Product;
 class Customer;
 class DatabaseManager;
-class ReceiptPrinter;
 
 /**
  * @brief CheckoutController类 - 收银流程控制器
@@ -58,7 +61,16 @@ public:
      * @param unitPrice 单价（如果为0则使用商品当前价格）
      * @return 如果添加成功返回true
      */
-    bool addItemToSale(Product* product, int quantity, double unitPrice = 0.0);
+    bool addItemToSale(Product* product, int quantity, Money unitPrice = Money());
+
+    /**
+     * @brief 一次添加多件商品（如一张照片中识别到的全部条码），界面只刷新一次
+     *
+     * 同一商品出现多次时合并为一行，数量为出现次数；库存不足的商品跳过，最后合并报告一次错误。
+     * @param products 商品列表（可重复）
+     * @return 添加成功的件数
+     */
+    int addItemsToSale(const QList<Product*>& products);
 
     /**
      * @brief 从销售中移除商品
@@ -78,7 +90,7 @@ public:
     /**
      * @brief 应用折扣
      * @param discountType 折扣类型（"percentage" 或 "fixed"）
-     * @param discountValue 折扣值
+     * @param discountValue 折扣值（百分比，或以元为单位的固定金额，四舍五入到分）
      * @return 如果应用成功返回true
      */
     bool applyDiscount(const QString& discountType, double discountValue);
@@ -90,10 +102,12 @@ public:
      * @param customerMoney 客户给的钱（现金支付时）
      * @return 如果支付处理成功返回true
      */
-    bool processPayment(const QString& paymentMethod, double amount, double customerMoney = 0.0);
+    bool processPayment(const QString& paymentMethod, Money amount, Money customerMoney = Money());
 
     /**
-     * @brief 完成销售（保存到数据库并打印票据）
+     * @brief 完成销售（保存到数据库）
+     *
+     * 控制器不负责打印；界面在收到saleSuccessfullyCompleted后打印票据。
      * @return 如果完成成功返回true
      */
     bool completeSale();
@@ -113,7 +127,7 @@ public:
      * @param paymentAmount 支付金额
      * @return 找零金额
      */
-    double getChangeAmount(double paymentAmount) const;
+    Money getChangeAmount(Money paymentAmount) const;
 
     /**
      * @brief 检查库存是否足够
@@ -129,12 +143,57 @@ public:
      */
     void setCashierName(const QString& cashierName);
 
+    /**
+     * @brief 换用新的促销规则集（由ProductManager加载，各通道共享），并按新规则重新计算当前销售的促销优惠
+     * @param rules 编译好的规则集
+     */
+    void setPromotionRules(PromotionRuleSetPtr rules);
+
+    /**
+     * @brief 获取当前销售中生效的促销
+     * @return 生效的促销及其优惠金额
+     */
+    QList<AppliedPromotion> appliedPromotions() const { return m_promotionEngine.appliedPromotions(); }
+
+    /**
+     * @brief 挂起当前销售：保存购物车内容并清空当前销售，以便接待下一位顾客
+     * @param label 备注（可为空）
+     * @return 如果成功返回挂单ID，失败返回-1
+     */
+    int parkCurrentSale(const QString& label = QString());
+
+    /**
+     * @brief 恢复挂单到当前销售（当前销售必须为空），界面只刷新一次
+     * @param parkedId 挂单ID
+     * @param productLookup 按商品ID查找商品
+     * @return 如果恢复成功返回true
+     */
+    bool resumeParkedSale(int parkedId, const std::function<Product*(int)>& productLookup);
+
+    /**
+     * @brief 获取所有挂单的摘要
+     * @return 挂单摘要列表
+     */
+    QList<ParkedSaleInfo> parkedSales() const;
+
 signals:
     /**
      * @brief 销售更新时发射的信号
      */
     void saleUpdated();
 
+    /**
+     * @brief 购物车中若干项目原地变化（数量、单价）时发射的信号
+     * @param rows 发生变化的项目索引（升序）
+     */
+    void saleItemsChanged(const QList<int>& rows);
+
+    /**
+     * @brief 销售应付总额变化时发射的信号
+     * @param newTotal 新的应付总额
+     */
+    void saleTotalChanged(Money newTotal);
+
     /**
      * @brief 商品添加到销售时发射的信号
      * @param productName 商品名称
@@ -153,7 +212,7 @@ signals:
      * @param success 是否成功
      * @param changeAmount 找零金额
      */
-    void paymentProcessed(bool success, double changeAmount);
+    void paymentProcessed(bool success, Money changeAmount);
 
     /**
      * @brief 销售完成时发射的信号
@@ -172,6 +231,11 @@ signals:
      */
     void saleCancelled();
 
+    /**
+     * @brief 挂单列表变化（挂起或恢复）时发射的信号
+     */
+    void parkedSalesChanged();
+
     /**
      * @brief 错误发生时发射的信号
      * @param errorMessage 错误消息
@@ -199,17 +263,32 @@ private:
 
     /**
      * @brief 记录日志
+     *
+     * 每次扫描都会执行的购物车操作以QtDebugMsg记录，调用处应先检查
+     * lcCheckout().isDebugEnabled()，避免在分类关闭时格式化消息。
      * @param message 日志消息
+     * @param level 日志级别
+     */
+    void logOperation(const QString& message, QtMsgType level = QtInfoMsg);
+
+    /**
+     * @brief 把购物车中某商品的数量同步给促销引擎，只重新计算该商品所属的规则
+     * @param productId 商品ID
+     */
+    void syncPromotionLine(int productId);
+
+    /**
+     * @brief 按当前销售的全部项目重新计算促销优惠（切换或清空销售时使用）
      */
-    void logOperation(const QString& message);
+    void resyncPromotions();
 
 private:
     Sale* m_currentSale;                        ///< 当前销售对象
     DatabaseManager* m_databaseManager;        ///< 数据库管理器
-    std::unique_ptr<ReceiptPrinter> m_receiptPrinter;  ///< 票据打印器
     QString m_cashierName;                      ///< 收银员名称
     bool m_paymentProcessed;                    ///< 支付是否已处理
-    double m_changeAmount;                      ///< 找零金额
+    Money m_changeAmount;                       ///< 找零金额
+    PromotionEngine m_promotionEngine;          ///< 促销规则引擎
 };
 
 #endif // CHECKOUTCONTROLLER_H
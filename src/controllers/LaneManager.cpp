@@ -0,0 +1,134 @@
+#include "LaneManager.h"
+#include "CheckoutController.h"
+#include "ProductManager.h"
+#include "../models/Sale.h"
+#include "../models/Product.h"
+#include "../utils/Logging.h"
+#include <QDebug>
+
+LaneManager::LaneManager(ProductManager* productManager, QObject *parent)
+    : QObject(parent)
+    , m_productManager(productManager)
+    , m_nextLaneId(1)
+{
+    // 促销规则由ProductManager加载一次，所有通道共享同一份规则集：
+    // 只订阅一次，新规则集到达时依次交给每个通道
+    if (m_productManager) {
+        connect(m_productManager, &ProductManager::promotionRulesChanged, this, [this](PromotionRuleSetPtr rules) {
+            for (auto& entry : m_lanes) {
+                entry.second.controller->setPromotionRules(rules);
+            }
+        });
+    }
+}
+
+LaneManager::~LaneManager()
+{
+    // 先让控制器放开销售，再释放销售对象
+    for (auto& entry : m_lanes) {
+        entry.second.controller->setCurrentSale(nullptr);
+    }
+    m_lanes.clear();
+}
+
+int LaneManager::openLane(const QString& cashierName)
+{
+    int laneId = m_nextLaneId++;
+    Lane& lane = m_lanes[laneId];
+    lane.controller = std::make_unique<CheckoutController>();
+    lane.controller->setCashierName(cashierName.isEmpty() ? QString("通道%1").arg(laneId) : cashierName);
+    connect(lane.controller.get(), &CheckoutController::errorOccurred, this, [this, laneId](const QString& message) {
+        emit laneError(laneId, message);
+    });
+    if (m_productManager) {
+        lane.controller->setPromotionRules(m_productManager->promotionRules());
+    }
+    startSale(lane);
+
+    qCDebug(lcCheckout) << "开设收银通道:" << laneId;
+    return laneId;
+}
+
+bool LaneManager::closeLane(int laneId)
+{
+    auto it = m_lanes.find(laneId);
+    if (it == m_lanes.end()) {
+        return false;
+    }
+    it->second.controller->setCurrentSale(nullptr);
+    m_lanes.erase(it);
+
+    qCDebug(lcCheckout) << "关闭收银通道:" << laneId;
+    return true;
+}
+
+CheckoutController* LaneManager::controller(int laneId) const
+{
+    auto it = m_lanes.find(laneId);
+    return it == m_lanes.end() ? nullptr : it->second.controller.get();
+}
+
+Sale* LaneManager::currentSale(int laneId) const
+{
+    auto it = m_lanes.find(laneId);
+    return it == m_lanes.end() ? nullptr : it->second.sale.get();
+}
+
+bool LaneManager::scan(int laneId, const QString& barcode, int quantity)
+{
+    Lane* lane = findLane(laneId);
+    if (!lane) {
+        qWarning() << "扫码的通道不存在:" << laneId;
+        return false;
+    }
+    if (!m_productManager) {
+        emit laneError(laneId, "商品目录不可用");
+        return false;
+    }
+
+    // 只读已发布的目录快照，多个通道并发扫码不会排队等数据库
+    CatalogSnapshotPtr catalog = m_productManager->catalogSnapshot();
+    const ProductRecord* record = catalog->findByBarcode(barcode);
+    Product* product = record ? m_productManager->getProductById(record->productId) : nullptr;
+    if (!product) {
+        emit laneError(laneId, QString("未找到条码对应的商品: %1").arg(barcode));
+        return false;
+    }
+
+    return lane->controller->addItemToSale(product, quantity);
+}
+
+int LaneManager::checkout(int laneId, const QString& paymentMethod)
+{
+    Lane* lane = findLane(laneId);
+    if (!lane) {
+        qWarning() << "结账的通道不存在:" << laneId;
+        return -1;
+    }
+
+    Money finalAmount = lane->sale->getFinalAmount();
+    if (!lane->controller->processPayment(paymentMethod, finalAmount, finalAmount)) {
+        return -1;
+    }
+    if (!lane->controller->completeSale()) {
+        return -1;
+    }
+
+    int transactionId = lane->sale->getTransactionId();
+    emit laneSaleCompleted(laneId, transactionId, finalAmount);
+    startSale(*lane);
+    return transactionId;
+}
+
+void LaneManager::startSale(Lane& lane)
+{
+    std::unique_ptr<Sale> previous = std::move(lane.sale);
+    lane.sale = std::make_unique<Sale>();
+    lane.controller->setCurrentSale(lane.sale.get());
+}
+
+LaneManager::Lane* LaneManager::findLane(int laneId)
+{
+    auto it = m_lanes.find(laneId);
+    return it == m_lanes.end() ? nullptr : &it->second;
+}
@@ -0,0 +1,126 @@
+#ifndef LANEMANAGER_H
+#define LANEMANAGER_H
+
+#include <QObject>
+#include <QString>
+#include <map>
+#include <memory>
+#include "../models/Money.h"
+
+class CheckoutController;
+class ProductManager;
+class Sale;
+
+/**
+ * @brief LaneManager类 - 多收银通道管理器
+ *
+ * 在一个进程中承载多个相互独立的收银通道。每个通道拥有自己的CheckoutController
+ * 和当前销售（购物车、折扣、促销、挂单状态），所有通道共享同一个ProductManager
+ * 发布的商品目录和同一个DatabaseManager。
+ *
+ * 所有通道都运行在LaneManager所在的线程中；扫码查找只读取已发布的目录快照，
+ * 不访问数据库，只有结账时才写数据库。
+ */
+class LaneManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数
+     * @param productManager 共享的商品管理器（不转移所有权）
+     * @param parent 父对象指针
+     */
+    explicit LaneManager(ProductManager* productManager, QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数
+     */
+    ~LaneManager();
+
+    /**
+     * @brief 开设一个新通道，并为其开始一笔新销售
+     * @param cashierName 收银员名称
+     * @return 通道ID
+     */
+    int openLane(const QString& cashierName = QString());
+
+    /**
+     * @brief 关闭通道（未结账的购物车被丢弃）
+     * @param laneId 通道ID
+     * @return 如果通道存在返回true
+     */
+    bool closeLane(int laneId);
+
+    /**
+     * @brief 当前开设的通道数
+     */
+    int laneCount() const { return static_cast<int>(m_lanes.size()); }
+
+    /**
+     * @brief 获取通道的收银控制器
+     * @param laneId 通道ID
+     * @return 控制器指针，通道不存在返回nullptr
+     */
+    CheckoutController* controller(int laneId) const;
+
+    /**
+     * @brief 获取通道的当前销售
+     * @param laneId 通道ID
+     * @return 销售指针，通道不存在返回nullptr
+     */
+    Sale* currentSale(int laneId) const;
+
+    /**
+     * @brief 在通道上扫码加购（只查目录快照）
+     * @param laneId 通道ID
+     * @param barcode 条形码
+     * @param quantity 数量
+     * @return 如果加购成功返回true
+     */
+    bool scan(int laneId, const QString& barcode, int quantity = 1);
+
+    /**
+     * @brief 在通道上以指定方式全额支付并完成销售，然后开始下一笔销售
+     * @param laneId 通道ID
+     * @param paymentMethod 支付方式
+     * @return 交易ID，失败返回-1
+     */
+    int checkout(int laneId, const QString& paymentMethod = "现金");
+
+signals:
+    /**
+     * @brief 通道完成一笔销售时发射的信号
+     * @param laneId 通道ID
+     * @param transactionId 交易ID
+     * @param finalAmount 实付金额
+     */
+    void laneSaleCompleted(int laneId, int transactionId, Money finalAmount);
+
+    /**
+     * @brief 通道发生错误时发射的信号
+     * @param laneId 通道ID
+     * @param errorMessage 错误消息
+     */
+    void laneError(int laneId, const QString& errorMessage);
+
+private:
+    struct Lane
+    {
+        std::unique_ptr<CheckoutController> controller;
+        std::unique_ptr<Sale> sale;
+    };
+
+    /**
+     * @brief 为通道开始一笔新销售（替换并释放旧的销售）
+     */
+    void startSale(Lane& lane);
+
+    Lane* findLane(int laneId);
+
+    ProductManager* m_productManager;       ///< 共享的商品管理器
+    std::map<int, Lane> m_lanes;            ///< 通道ID到通道
+    int m_nextLaneId;                       ///< 下一个通道ID
+};
+
+#endif // LANEMANAGER_H
@@ -2,16 +2,40 @@
 #include "../database/DatabaseManager.h"
 #include "../models/Product.h"
 #include <QDebug>
+#include <QTimer>
+#include <QtConcurrent>
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <utility>
+
+namespace {
+// Unknown barcodes are answered from memory for this long
+const int DefaultNegativeCacheTtlMs = 5000;
+// At most this many unknown barcodes are remembered
+const int MaxMissingBarcodes = 1024;
+}
+
+const QString ProductManager::UncategorizedFacet = QStringLiteral("\x1f" "uncategorized");
 
 ProductManager::ProductManager(QObject *parent)
     : QObject(parent), m_databaseManager(&DatabaseManager::getInstance())
+    , m_catalog(std::make_shared<CatalogSnapshot>())
+    , m_publishScheduled(false)
+    , m_negativeCacheTtlMs(DefaultNegativeCacheTtlMs)
+    , m_promotionRules(std::make_shared<PromotionRuleSet>())
+    , m_promotionWatcher(new QFutureWatcher<PromotionRuleSetPtr>(this))
+    , m_promotionReloadPending(false)
+    , m_nextBatchLookupId(1)
 {
     connect(m_databaseManager, &DatabaseManager::productsRead, this, &ProductManager::onProductsRead);
     connect(m_databaseManager, &DatabaseManager::productReadByBarcode, this, &ProductManager::onProductReadByBarcode);
+    connect(m_databaseManager, &DatabaseManager::productsReadByBarcodes, this, &ProductManager::onProductsReadByBarcodes);
     
     // Connect DB write operations to PM slots
     connect(m_databaseManager, &DatabaseManager::productSaved, this, &ProductManager::onProductSaved);
     connect(m_databaseManager, &DatabaseManager::productDeleted, this, &ProductManager::onProductDeleted);
+    connect(m_promotionWatcher, &QFutureWatcher<PromotionRuleSetPtr>::finished, this, &ProductManager::onPromotionsLoaded);
 
     // Trigger the initial asynchronous load
     getAllProducts();
@@ -34,14 +58,27 @@ void ProductManager::onProductsRead(const QList<Product*>& products)
 
     for (Product* product : products) {
         m_productCache.insert(product->getProductId(), product);
+        trackProduct(product);
     }
 
+    // A full reload replaces the catalog wholesale; pending deltas are obsolete.
+    m_pendingChangedIds.clear();
+    publishCatalog(CatalogSnapshot::build(products, catalogSnapshot()->version() + 1));
+    m_categoryIndex.rebuild(products);
+
+    emit categoryFacetsChanged();
     emit allProductsChanged(m_productCache.values());
+
+    // Promotions reference products, so they are refreshed with every full load
+    reloadPromotions();
 }
 
 void ProductManager::onProductSaved(bool success, int productId)
 {
     if (success) {
+        // A saved product may carry a barcode that was cached as unknown
+        // while the write was in flight.
+        m_missingBarcodes.clear();
         getAllProducts(); // Refresh cache
     }
     emit productSaved(success);
@@ -55,6 +92,11 @@ void ProductManager::onProductDeleted(bool success, int productId)
         if(m_productCache.contains(productId)) {
             delete m_productCache.take(productId);
         }
+        m_pendingChangedIds.remove(productId);
+        publishCatalog(catalogSnapshot()->withRemoved({productId}));
+        if (m_categoryIndex.remove(productId)) {
+            emit categoryFacetsChanged();
+        }
         emit allProductsChanged(m_productCache.values());
     }
     emit productDeleted(success);
@@ -78,33 +120,213 @@ Product* ProductManager::getProductByName(const QString& name)
 
 void ProductManager::getProductByBarcode(const QString& barcode)
 {
-    // First, check the cache
-    for (Product* product : m_productCache.values()) {
-        if (product->getBarcode() == barcode) {
-            emit productFoundByBarcode(product, barcode);
-            return;
-        }
+    // First, check the published catalog's barcode index
+    if (Product* product = cachedProductByBarcode(barcode)) {
+        emit productFoundByBarcode(product, barcode);
+        return;
     }
     
+    // Recently confirmed as unknown: answer without touching the database
+    if (isKnownMissingBarcode(barcode)) {
+        emit productFoundByBarcode(nullptr, barcode);
+        return;
+    }
+
+    // A query for this barcode is already running: wait for its result
+    auto inFlight = m_inFlightBarcodeLookups.find(barcode);
+    if (inFlight != m_inFlightBarcodeLookups.end()) {
+        ++inFlight.value();
+        return;
+    }
+
     // If not in cache, ask the database asynchronously
+    m_inFlightBarcodeLookups.insert(barcode, 1);
     m_databaseManager->getProductByBarcode(barcode);
 }
 
-void ProductManager::onProductReadByBarcode(Product* product, const QString& barcode)
+void ProductManager::onProductReadByBarcode(Product* product, const QString& barcode, bool succeeded)
 {
-    if (product) {
-        // Add to cache if it's not already there (it shouldn't be)
-        if (!m_productCache.contains(product->getProductId())) {
-             m_productCache.insert(product->getProductId(), product);
+    // Every scan that joined the query gets its own answer
+    int waiters = qMax(1, m_inFlightBarcodeLookups.take(barcode));
+
+    // A failed query proves nothing about the barcode: report it, don't cache it
+    if (!succeeded) {
+        for (int i = 0; i < waiters; ++i) {
+            emit barcodeLookupFailed({barcode});
+        }
+        return;
+    }
+
+    if (!product) {
+        rememberMissingBarcode(barcode);
+    } else {
+        QList<ProductRecord> changed;
+        bool facetsChanged = false;
+        product = adoptProductRow(product, &changed, &facetsChanged);
+        if (!changed.isEmpty()) {
+            publishCatalog(catalogSnapshot()->withUpserted(changed));
+        }
+        if (facetsChanged) {
+            emit categoryFacetsChanged();
         }
     }
     // Emit the result, whether it's a valid product or nullptr
-    emit productFoundByBarcode(product, barcode);
+    for (int i = 0; i < waiters; ++i) {
+        emit productFoundByBarcode(product, barcode);
+    }
+}
+
+void ProductManager::getProductsByBarcodes(const QStringList& barcodes)
+{
+    // Only barcodes that neither the catalog nor the negative cache can
+    // answer go to the database, all in one query.
+    QStringList unresolved;
+    QSet<QString> seen;
+    for (const QString& barcode : barcodes) {
+        if (seen.contains(barcode)) {
+            continue;
+        }
+        seen.insert(barcode);
+        if (!cachedProductByBarcode(barcode) && !isKnownMissingBarcode(barcode)) {
+            unresolved.append(barcode);
+        }
+    }
+
+    if (unresolved.isEmpty()) {
+        finishBarcodeBatch(barcodes);
+        return;
+    }
+
+    const int requestId = m_nextBatchLookupId++;
+    m_batchBarcodeLookups.insert(requestId, barcodes);
+    m_databaseManager->getProductsByBarcodes(requestId, unresolved);
+}
+
+void ProductManager::onProductsReadByBarcodes(int requestId, const QList<Product*>& products, bool succeeded)
+{
+    const QStringList barcodes = m_batchBarcodeLookups.take(requestId);
+
+    // Merge everything the query found into the cache and publish one
+    // catalog version for the whole batch.
+    QList<ProductRecord> changed;
+    bool facetsChanged = false;
+    for (Product* product : products) {
+        adoptProductRow(product, &changed, &facetsChanged);
+    }
+    if (!changed.isEmpty()) {
+        publishCatalog(catalogSnapshot()->withUpserted(changed));
+    }
+    if (facetsChanged) {
+        emit categoryFacetsChanged();
+    }
+
+    // After a failed query the products list may be partial: only a complete
+    // answer proves the remaining barcodes unknown
+    if (succeeded) {
+        for (const QString& barcode : barcodes) {
+            if (!cachedProductByBarcode(barcode)) {
+                rememberMissingBarcode(barcode);
+            }
+        }
+    }
+    finishBarcodeBatch(barcodes, !succeeded);
+}
+
+Product* ProductManager::adoptProductRow(Product* row, QList<ProductRecord>* changed, bool* facetsChanged)
+{
+    Product* cached = m_productCache.value(row->getProductId(), nullptr);
+    if (!cached) {
+        m_productCache.insert(row->getProductId(), row);
+        trackProduct(row);
+        changed->append(ProductRecord::fromProduct(*row));
+        *facetsChanged |= m_categoryIndex.upsert(row->getProductId(), row->getCategory());
+        return row;
+    }
+    if (cached == row) {
+        return cached;
+    }
+
+    // Hand out the cached instance so every holder sees the same object
+    if (cached->getBarcode() != row->getBarcode()) {
+        cached->setBarcode(row->getBarcode());
+        changed->append(ProductRecord::fromProduct(*cached));
+    }
+    delete row;
+    return cached;
+}
+
+void ProductManager::finishBarcodeBatch(const QStringList& barcodes, bool lookupFailed)
+{
+    QList<Product*> found;
+    QStringList missing;
+    QStringList failed;
+    for (const QString& barcode : barcodes) {
+        if (Product* product = cachedProductByBarcode(barcode)) {
+            found.append(product);
+        } else if (lookupFailed && !isKnownMissingBarcode(barcode)) {
+            if (!failed.contains(barcode)) {
+                failed.append(barcode);
+            }
+        } else if (!missing.contains(barcode)) {
+            missing.append(barcode);
+        }
+    }
+    emit productsFoundByBarcodes(found, missing);
+    if (!failed.isEmpty()) {
+        emit barcodeLookupFailed(failed);
+    }
+}
+
+Product* ProductManager::cachedProductByBarcode(const QString& barcode) const
+{
+    CatalogSnapshotPtr catalog = catalogSnapshot();
+    if (const ProductRecord* record = catalog->findByBarcode(barcode)) {
+        Product* product = m_productCache.value(record->productId, nullptr);
+        if (product && product->getBarcode() == barcode) {
+            return product;
+        }
+    }
+    return nullptr;
+}
+
+bool ProductManager::isKnownMissingBarcode(const QString& barcode)
+{
+    auto missing = m_missingBarcodes.find(barcode);
+    if (missing == m_missingBarcodes.end()) {
+        return false;
+    }
+    if (!missing.value().hasExpired()) {
+        return true;
+    }
+    m_missingBarcodes.erase(missing);
+    return false;
+}
+
+void ProductManager::rememberMissingBarcode(const QString& barcode)
+{
+    if (m_negativeCacheTtlMs == 0) {
+        return;
+    }
+
+    if (m_missingBarcodes.size() >= MaxMissingBarcodes && !m_missingBarcodes.contains(barcode)) {
+        for (auto it = m_missingBarcodes.begin(); it != m_missingBarcodes.end();) {
+            it = it.value().hasExpired() ? m_missingBarcodes.erase(it) : std::next(it);
+        }
+        // Still full of live entries: every entry has the same TTL, so the
+        // earliest deadline is the oldest one
+        if (m_missingBarcodes.size() >= MaxMissingBarcodes) {
+            auto oldest = std::min_element(m_missingBarcodes.begin(), m_missingBarcodes.end(),
+                [](const QDeadlineTimer& a, const QDeadlineTimer& b) { return a < b; });
+            m_missingBarcodes.erase(oldest);
+        }
+    }
+    m_missingBarcodes.insert(barcode, QDeadlineTimer(m_negativeCacheTtlMs));
 }
 
 void ProductManager::addProduct(Product* product)
 {
     if (product) {
+        m_missingBarcodes.remove(product->getBarcode());
         m_databaseManager->saveProduct(*product);
     }
 }
@@ -112,6 +334,7 @@ void ProductManager::addProduct(Product* product)
 void ProductManager::updateProduct(Product* product)
 {
     if (product) {
+        m_missingBarcodes.remove(product->getBarcode());
         m_databaseManager->saveProduct(*product);
     }
 }
@@ -136,3 +359,146 @@ QList<Product*> ProductManager::searchProducts(const QString& searchTerm)
     }
     return results;
 }
+
+QList<Product*> ProductManager::searchProducts(const QString& searchTerm, const QString& category)
+{
+    if (category.isEmpty()) {
+        return searchProducts(searchTerm);
+    }
+    if (searchTerm.isEmpty()) {
+        return productsInCategory(category);
+    }
+
+    // Intersect the sorted text matches with the category's sorted id list
+    QList<int> matchIds;
+    for (Product* product : searchProducts(searchTerm)) {
+        matchIds.append(product->getProductId());
+    }
+    std::sort(matchIds.begin(), matchIds.end());
+
+    return productsForIds(CategoryIndex::intersect(matchIds, m_categoryIndex.productIds(indexCategory(category))));
+}
+
+QList<QPair<QString, int>> ProductManager::categoryFacets() const
+{
+    QList<QPair<QString, int>> facets = m_categoryIndex.facetCounts();
+    for (auto& facet : facets) {
+        if (facet.first.isEmpty()) {
+            facet.first = UncategorizedFacet;
+        }
+    }
+    return facets;
+}
+
+QList<Product*> ProductManager::productsInCategory(const QString& category) const
+{
+    return productsForIds(m_categoryIndex.productIds(indexCategory(category)));
+}
+
+QString ProductManager::indexCategory(const QString& category)
+{
+    // The index keys uncategorized products by the empty string
+    return category == UncategorizedFacet ? QString() : category;
+}
+
+QList<Product*> ProductManager::productsForIds(const QList<int>& productIds) const
+{
+    QList<Product*> results;
+    results.reserve(productIds.size());
+    for (int productId : productIds) {
+        if (Product* product = m_productCache.value(productId, nullptr)) {
+            results.append(product);
+        }
+    }
+    return results;
+}
+
+CatalogSnapshotPtr ProductManager::catalogSnapshot() const
+{
+    return std::atomic_load(&m_catalog);
+}
+
+void ProductManager::publishCatalog(CatalogSnapshotPtr snapshot)
+{
+    quint64 version = snapshot->version();
+    std::atomic_store(&m_catalog, CatalogSnapshotPtr(std::move(snapshot)));
+    emit catalogPublished(version);
+}
+
+void ProductManager::trackProduct(Product* product)
+{
+    connect(product, &Product::productChanged, this, &ProductManager::onCachedProductChanged,
+            Qt::UniqueConnection);
+}
+
+void ProductManager::onCachedProductChanged()
+{
+    auto* product = qobject_cast<Product*>(sender());
+    if (!product || m_productCache.value(product->getProductId()) != product) {
+        return;
+    }
+
+    // Coalesce edits (e.g. stock updates after a sale) into one new version
+    m_pendingChangedIds.insert(product->getProductId());
+    if (!m_publishScheduled) {
+        m_publishScheduled = true;
+        QTimer::singleShot(0, this, &ProductManager::publishPendingChanges);
+    }
+}
+
+void ProductManager::publishPendingChanges()
+{
+    m_publishScheduled = false;
+    if (m_pendingChangedIds.isEmpty()) {
+        return;
+    }
+
+    QList<ProductRecord> records;
+    records.reserve(m_pendingChangedIds.size());
+    bool facetsChanged = false;
+    for (int productId : std::as_const(m_pendingChangedIds)) {
+        if (const Product* product = m_productCache.value(productId, nullptr)) {
+            records.append(ProductRecord::fromProduct(*product));
+            facetsChanged |= m_categoryIndex.upsert(productId, product->getCategory());
+        }
+    }
+    m_pendingChangedIds.clear();
+
+    publishCatalog(catalogSnapshot()->withUpserted(records));
+    if (facetsChanged) {
+        emit categoryFacetsChanged();
+    }
+}
+
+void ProductManager::reloadPromotions()
+{
+    if (m_promotionWatcher->isRunning()) {
+        m_promotionReloadPending = true;
+        return;
+    }
+
+    // Query and compile off the GUI thread; the result is shared, never copied per lane
+    DatabaseManager* databaseManager = m_databaseManager;
+    m_promotionWatcher->setFuture(QtConcurrent::run([databaseManager]() {
+        return PromotionRuleSet::compile(databaseManager->getActivePromotions());
+    }));
+}
+
+void ProductManager::onPromotionsLoaded()
+{
+    m_promotionRules = m_promotionWatcher->result();
+    emit promotionRulesChanged(m_promotionRules);
+
+    if (m_promotionReloadPending) {
+        m_promotionReloadPending = false;
+        reloadPromotions();
+    }
+}
+
+void ProductManager::setNegativeCacheTtl(int milliseconds)
+{
+    m_negativeCacheTtlMs = qMax(0, milliseconds);
+    if (m_negativeCacheTtlMs == 0) {
+        m_missingBarcodes.clear();
+    }
+}
@@ -3,6 +3,12 @@
 
 #include <QObject>
 #include <QHash>
+#include <QSet>
+#include <QDeadlineTimer>
+#include <QFutureWatcher>
+#include "../models/CatalogSnapshot.h"
+#include "../models/CategoryIndex.h"
+#include "PromotionEngine.h"
 
 class Product;
 class DatabaseManager;
@@ -11,6 +17,10 @@ class ProductManager : public QObject
 {
     Q_OBJECT
 public:
+    // Facet name of the products whose category is empty; cannot collide
+    // with a real category name.
+    static const QString UncategorizedFacet;
+
     explicit ProductManager(QObject *parent = nullptr);
     ~ProductManager();
 
@@ -19,27 +29,108 @@ public:
     Product* getProductById(int id);
     Product* getProductByName(const QString& name);
     void getProductByBarcode(const QString& barcode);
+    // Resolves a whole batch of scanned barcodes with at most one database
+    // query and answers with a single productsFoundByBarcodes signal.
+    void getProductsByBarcodes(const QStringList& barcodes);
     void addProduct(Product* product);
     void updateProduct(Product* product);
     void deleteProduct(int id);
     QList<Product*> searchProducts(const QString& searchTerm);
+    // Search restricted to one category; an empty category searches everything
+    // and UncategorizedFacet selects the products without a category.
+    QList<Product*> searchProducts(const QString& searchTerm, const QString& category);
+
+    // Category facets: every category with its product count, kept up to date
+    // incrementally as products change. Products without a category are
+    // reported under UncategorizedFacet.
+    QList<QPair<QString, int>> categoryFacets() const;
+    QList<Product*> productsInCategory(const QString& category) const;
+
+    // How long a barcode that the database did not know is answered from
+    // memory before it is queried again.
+    void setNegativeCacheTtl(int milliseconds);
+
+    // Thread-safe: returns the currently published immutable catalog version.
+    // Any thread may hold and read the snapshot without locking.
+    CatalogSnapshotPtr catalogSnapshot() const;
+
+    // Active promotions compiled once and shared by every checkout lane.
+    // Reloaded in the background with each full catalog load; listeners get
+    // promotionRulesChanged when a new rule set is ready.
+    PromotionRuleSetPtr promotionRules() const { return m_promotionRules; }
+    void reloadPromotions();
 
 signals:
     void allProductsChanged(const QList<Product*>& products);
     void productFoundByBarcode(Product* product, const QString& barcode);
+    // The database could not answer (not connected or the query failed);
+    // unlike a nullptr productFoundByBarcode this says nothing about whether
+    // the barcode exists, and it is not cached as unknown.
+    void barcodeLookupFailed(const QStringList& barcodes);
+    // One entry in products per requested barcode that is known, in request
+    // order (a barcode scanned twice appears twice); unknown barcodes once each.
+    void productsFoundByBarcodes(const QList<Product*>& products, const QStringList& missingBarcodes);
     void productSaved(bool success);
     void productUpdated(bool success);
     void productDeleted(bool success);
+    void catalogPublished(quint64 version);
+    void categoryFacetsChanged();
+    void promotionRulesChanged(PromotionRuleSetPtr rules);
 
 private slots:
     void onProductsRead(const QList<Product*>& products);
-    void onProductReadByBarcode(Product* product, const QString& barcode);
+    void onProductReadByBarcode(Product* product, const QString& barcode, bool succeeded);
+    void onProductsReadByBarcodes(int requestId, const QList<Product*>& products, bool succeeded);
     void onProductSaved(bool success, int productId);
     void onProductDeleted(bool success, int productId);
+    void onCachedProductChanged();
+    void publishPendingChanges();
+    void onPromotionsLoaded();
 
 private:
+    void publishCatalog(CatalogSnapshotPtr snapshot);
+    void trackProduct(Product* product);
+    QList<Product*> productsForIds(const QList<int>& productIds) const;
+    static QString indexCategory(const QString& category);
+    Product* cachedProductByBarcode(const QString& barcode) const;
+    bool isKnownMissingBarcode(const QString& barcode);
+    void rememberMissingBarcode(const QString& barcode);
+    // Takes ownership of a product row read from the database and returns the
+    // cached instance for its id; a cached product whose barcode changed in
+    // the database is updated in place. New or changed records are appended
+    // to changed for one catalog publish.
+    Product* adoptProductRow(Product* row, QList<ProductRecord>* changed, bool* facetsChanged);
+    void finishBarcodeBatch(const QStringList& barcodes, bool lookupFailed = false);
+
     DatabaseManager* m_databaseManager;
     QHash<int, Product*> m_productCache;
+
+    // Published catalog version, swapped atomically (RCU style). Only the
+    // GUI thread writes it; readers on any thread load it atomically.
+    CatalogSnapshotPtr m_catalog;
+    QSet<int> m_pendingChangedIds;
+    bool m_publishScheduled;
+
+    // Category -> sorted product ids, maintained alongside the catalog deltas.
+    CategoryIndex m_categoryIndex;
+
+    // Barcode lookups currently running in the database, with the number of
+    // callers waiting on each; repeated scans share one query.
+    QHash<QString, int> m_inFlightBarcodeLookups;
+    // Barcodes recently reported as unknown, with their expiry. Bounded:
+    // expired entries are purged whenever it reaches its capacity.
+    QHash<QString, QDeadlineTimer> m_missingBarcodes;
+    int m_negativeCacheTtlMs;
+
+    // Shared compiled promotions; a reload requested while one is running is
+    // queued behind it instead of starting a second query.
+    PromotionRuleSetPtr m_promotionRules;
+    QFutureWatcher<PromotionRuleSetPtr>* m_promotionWatcher;
+    bool m_promotionReloadPending;
+
+    // Batched barcode lookups waiting for the database, by request id.
+    QHash<int, QStringList> m_batchBarcodeLookups;
+    int m_nextBatchLookupId;
 };
 
 #endif // PRODUCTMANAGER_H
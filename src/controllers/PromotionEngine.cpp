@@ -0,0 +1,309 @@
+#include "PromotionEngine.h"
+#include <QDebug>
+#include <QStringList>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <utility>
+
+bool PromotionRule::isValid() const
+{
+    if (productIds.isEmpty()) {
+        return false;
+    }
+
+    switch (type) {
+    case BuyXGetY:
+        return buyQuantity > 0 && getQuantity > 0 && percentOff > 0.0 && percentOff <= 100.0;
+    case MixAndMatch:
+        return buyQuantity > 1 && !dealPrice.isNegative();
+    case TieredQuantity:
+        return !tiers.isEmpty();
+    case Bundle:
+        return productIds.size() > 1 && !dealPrice.isNegative();
+    }
+    return false;
+}
+
+QString PromotionRule::typeToString(Type type)
+{
+    switch (type) {
+    case BuyXGetY: return "buy_x_get_y";
+    case MixAndMatch: return "mix_and_match";
+    case TieredQuantity: return "tiered";
+    case Bundle: return "bundle";
+    }
+    return "buy_x_get_y";
+}
+
+PromotionRule::Type PromotionRule::stringToType(const QString& str)
+{
+    if (str == "mix_and_match") return MixAndMatch;
+    if (str == "tiered") return TieredQuantity;
+    if (str == "bundle") return Bundle;
+    return BuyXGetY;
+}
+
+QString PromotionRule::tiersToString(const QList<PromotionTier>& tiers)
+{
+    QStringList parts;
+    for (const PromotionTier& tier : tiers) {
+        parts << QString("%1:%2").arg(tier.minQuantity).arg(tier.percentOff);
+    }
+    return parts.join(';');
+}
+
+QList<PromotionTier> PromotionRule::tiersFromString(const QString& str)
+{
+    QList<PromotionTier> tiers;
+    const QStringList parts = str.split(';', Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        const QStringList fields = part.split(':');
+        bool quantityOk = false;
+        bool percentOk = false;
+        PromotionTier tier;
+        if (fields.size() == 2) {
+            tier.minQuantity = fields.at(0).trimmed().toInt(&quantityOk);
+            tier.percentOff = fields.at(1).trimmed().toDouble(&percentOk);
+        }
+        if (!quantityOk || !percentOk || tier.minQuantity <= 0 || tier.percentOff <= 0.0 || tier.percentOff > 100.0) {
+            qWarning() << "忽略无效的促销阶梯:" << part;
+            continue;
+        }
+        tiers.append(tier);
+    }
+    std::sort(tiers.begin(), tiers.end(), [](const PromotionTier& a, const PromotionTier& b) {
+        return a.minQuantity < b.minQuantity;
+    });
+    return tiers;
+}
+
+PromotionRuleSetPtr PromotionRuleSet::compile(const QList<PromotionRule>& rules)
+{
+    auto compiledSet = std::make_shared<PromotionRuleSet>();
+
+    // 按优先级从高到低排序，先到先得即为每个商品选出生效的规则
+    QList<PromotionRule> ordered;
+    for (const PromotionRule& rule : rules) {
+        if (rule.isValid()) {
+            ordered.append(rule);
+        } else {
+            qWarning() << "跳过无效的促销规则:" << rule.ruleId << rule.name;
+        }
+    }
+    std::stable_sort(ordered.begin(), ordered.end(), [](const PromotionRule& a, const PromotionRule& b) {
+        return a.priority != b.priority ? a.priority > b.priority : a.ruleId < b.ruleId;
+    });
+
+    QHash<int, int> ownerRuleId;
+    for (const PromotionRule& rule : std::as_const(ordered)) {
+        for (int productId : rule.productIds) {
+            if (!ownerRuleId.contains(productId)) {
+                ownerRuleId.insert(productId, rule.ruleId);
+            }
+        }
+    }
+
+    compiledSet->m_rules.reserve(ordered.size());
+    for (const PromotionRule& rule : std::as_const(ordered)) {
+        CompiledRule compiled;
+        compiled.rule = rule;
+        for (int productId : rule.productIds) {
+            if (ownerRuleId.value(productId) == rule.ruleId && !compiled.members.contains(productId)) {
+                compiled.members.append(productId);
+            }
+        }
+
+        // 套装缺少任一组成商品就永远无法成套
+        bool incompleteBundle = rule.type == PromotionRule::Bundle
+                                && compiled.members.size() != QSet<int>(rule.productIds.begin(), rule.productIds.end()).size();
+        if (compiled.members.isEmpty() || incompleteBundle) {
+            qWarning() << "促销规则的商品已被更高优先级的规则占用，规则不生效:" << rule.ruleId << rule.name;
+            continue;
+        }
+
+        int index = compiledSet->m_rules.size();
+        for (int productId : std::as_const(compiled.members)) {
+            compiledSet->m_ruleIndexByProduct.insert(productId, index);
+        }
+        compiledSet->m_rules.append(std::move(compiled));
+    }
+    return compiledSet;
+}
+
+PromotionEngine::PromotionEngine()
+    : m_ruleSet(std::make_shared<PromotionRuleSet>())
+{
+}
+
+void PromotionEngine::setRuleSet(PromotionRuleSetPtr rules)
+{
+    m_ruleSet = rules ? std::move(rules) : std::make_shared<PromotionRuleSet>();
+    m_activeRules.clear();
+    m_totalDiscount = Money();
+}
+
+void PromotionEngine::compile(const QList<PromotionRule>& rules)
+{
+    setRuleSet(PromotionRuleSet::compile(rules));
+}
+
+void PromotionEngine::clearCart()
+{
+    m_activeRules.clear();
+    m_totalDiscount = Money();
+}
+
+Money PromotionEngine::updateLine(int productId, int quantity, Money unitPrice)
+{
+    const int index = m_ruleSet->ruleIndexOf(productId);
+    if (index < 0) {
+        return m_totalDiscount;
+    }
+
+    auto state = m_activeRules.find(index);
+    if (quantity > 0) {
+        if (state == m_activeRules.end()) {
+            state = m_activeRules.insert(index, RuleState());
+        }
+        state->lines.insert(productId, Line{quantity, unitPrice});
+    } else if (state != m_activeRules.end()) {
+        state->lines.remove(productId);
+    } else {
+        return m_totalDiscount;
+    }
+
+    // 只重新计算这一条规则，按差值更新总优惠
+    Money discount = evaluate(m_ruleSet->ruleAt(index), state->lines);
+    m_totalDiscount += discount - state->discount;
+    state->discount = discount;
+    if (state->lines.isEmpty()) {
+        m_activeRules.erase(state);
+    }
+    return m_totalDiscount;
+}
+
+QList<AppliedPromotion> PromotionEngine::appliedPromotions() const
+{
+    QList<AppliedPromotion> applied;
+    for (auto it = m_activeRules.constBegin(); it != m_activeRules.constEnd(); ++it) {
+        const PromotionRule& rule = m_ruleSet->ruleAt(it.key()).rule;
+        if (it->discount.isPositive()) {
+            applied.append(AppliedPromotion{rule.ruleId, rule.name, it->discount});
+        }
+    }
+    std::sort(applied.begin(), applied.end(), [](const AppliedPromotion& a, const AppliedPromotion& b) {
+        return a.ruleId < b.ruleId;
+    });
+    return applied;
+}
+
+Money PromotionEngine::evaluate(const CompiledRule& compiled, const QHash<int, Line>& lines)
+{
+    if (lines.isEmpty()) {
+        return Money();
+    }
+
+    switch (compiled.rule.type) {
+    case PromotionRule::BuyXGetY: return evaluateBuyXGetY(compiled, lines);
+    case PromotionRule::MixAndMatch: return evaluateMixAndMatch(compiled, lines);
+    case PromotionRule::TieredQuantity: return evaluateTiered(compiled, lines);
+    case PromotionRule::Bundle: return evaluateBundle(compiled, lines);
+    }
+    return Money();
+}
+
+Money PromotionEngine::evaluateBuyXGetY(const CompiledRule& compiled, const QHash<int, Line>& lines)
+{
+    const PromotionRule& rule = compiled.rule;
+    int totalQuantity = 0;
+    for (const Line& line : lines) {
+        totalQuantity += line.quantity;
+    }
+
+    int sets = totalQuantity / (rule.buyQuantity + rule.getQuantity);
+    if (sets == 0) {
+        return Money();
+    }
+
+    // 赠送的总是最便宜的件
+    Money rewarded = sumUnitPrices(lines, sets * rule.getQuantity, true);
+    return rewarded.percentOf(rule.percentOff);
+}
+
+Money PromotionEngine::evaluateMixAndMatch(const CompiledRule& compiled, const QHash<int, Line>& lines)
+{
+    const PromotionRule& rule = compiled.rule;
+    int totalQuantity = 0;
+    for (const Line& line : lines) {
+        totalQuantity += line.quantity;
+    }
+
+    int groups = totalQuantity / rule.buyQuantity;
+    if (groups == 0) {
+        return Money();
+    }
+
+    // 用最贵的件凑组合，对顾客最有利
+    Money regular = sumUnitPrices(lines, groups * rule.buyQuantity, false);
+    Money discount = regular - rule.dealPrice * groups;
+    return discount.isPositive() ? discount : Money();
+}
+
+Money PromotionEngine::evaluateTiered(const CompiledRule& compiled, const QHash<int, Line>& lines)
+{
+    const PromotionRule& rule = compiled.rule;
+    int totalQuantity = 0;
+    Money subtotal;
+    for (const Line& line : lines) {
+        totalQuantity += line.quantity;
+        subtotal += line.unitPrice * line.quantity;
+    }
+
+    // 阶梯按数量升序，取命中的最高一级
+    const PromotionTier* reached = nullptr;
+    for (const PromotionTier& tier : rule.tiers) {
+        if (totalQuantity >= tier.minQuantity) {
+            reached = &tier;
+        }
+    }
+    return reached ? subtotal.percentOf(reached->percentOff) : Money();
+}
+
+Money PromotionEngine::evaluateBundle(const CompiledRule& compiled, const QHash<int, Line>& lines)
+{
+    int bundles = -1;
+    Money componentPrice;
+    for (int productId : compiled.members) {
+        auto line = lines.constFind(productId);
+        if (line == lines.constEnd()) {
+            return Money();
+        }
+        bundles = bundles < 0 ? line.value().quantity : qMin(bundles, line.value().quantity);
+        componentPrice += line.value().unitPrice;
+    }
+
+    Money discount = (componentPrice - compiled.rule.dealPrice) * qMax(0, bundles);
+    return discount.isPositive() ? discount : Money();
+}
+
+Money PromotionEngine::sumUnitPrices(const QHash<int, Line>& lines, int count, bool cheapestFirst)
+{
+    QVarLengthArray<Line, 16> sorted;
+    for (const Line& line : lines) {
+        sorted.append(line);
+    }
+    std::sort(sorted.begin(), sorted.end(), [cheapestFirst](const Line& a, const Line& b) {
+        return cheapestFirst ? a.unitPrice < b.unitPrice : a.unitPrice > b.unitPrice;
+    });
+
+    Money total;
+    for (const Line& line : sorted) {
+        if (count <= 0) {
+            break;
+        }
+        int taken = qMin(count, line.quantity);
+        total += line.unitPrice * taken;
+        count -= taken;
+    }
+    return total;
+}
@@ -0,0 +1,225 @@
+#ifndef PROMOTIONENGINE_H
+#define PROMOTIONENGINE_H
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "../models/Money.h"
+
+/**
+ * @brief 阶梯折扣的一级
+ */
+struct PromotionTier
+{
+    int minQuantity = 0;        ///< 达到该数量后生效
+    double percentOff = 0.0;    ///< 折扣百分比（0-100）
+};
+
+/**
+ * @brief PromotionRule - 一条促销规则
+ */
+struct PromotionRule
+{
+    /**
+     * @brief 促销类型
+     */
+    enum Type {
+        BuyXGetY = 0,       ///< 买X送Y（赠送件按percentOff折扣，100为免费，取最便宜的件）
+        MixAndMatch,        ///< 任选buyQuantity件组合价dealPrice（取最贵的件组合）
+        TieredQuantity,     ///< 阶梯数量折扣（按总件数命中的最高一级打折）
+        Bundle              ///< 套装：每个商品各一件组成一套，套装价dealPrice
+    };
+
+    int ruleId = -1;            ///< 规则ID
+    QString name;               ///< 规则名称（显示在小票上）
+    Type type = BuyXGetY;       ///< 促销类型
+    int priority = 0;           ///< 优先级，同一商品被多条规则覆盖时取高者
+    QList<int> productIds;      ///< 参与的商品
+    int buyQuantity = 0;        ///< 买X / 任选N件
+    int getQuantity = 0;        ///< 送Y
+    double percentOff = 100.0;  ///< 赠送件折扣百分比
+    Money dealPrice;            ///< 组合价 / 套装价
+    QList<PromotionTier> tiers; ///< 阶梯（TieredQuantity）
+
+    /**
+     * @brief 检查规则参数是否完整
+     * @return 如果规则可以参与计算返回true
+     */
+    bool isValid() const;
+
+    /**
+     * @brief 促销类型转字符串（用于存储）
+     */
+    static QString typeToString(Type type);
+
+    /**
+     * @brief 字符串转促销类型
+     */
+    static Type stringToType(const QString& str);
+
+    /**
+     * @brief 阶梯序列化为 "最小数量:百分比;..." 形式
+     */
+    static QString tiersToString(const QList<PromotionTier>& tiers);
+
+    /**
+     * @brief 从 "最小数量:百分比;..." 解析阶梯（按最小数量升序）
+     */
+    static QList<PromotionTier> tiersFromString(const QString& str);
+};
+
+/**
+ * @brief 已生效的促销及其优惠金额
+ */
+struct AppliedPromotion
+{
+    int ruleId = -1;            ///< 规则ID
+    QString name;               ///< 规则名称
+    Money discount;             ///< 优惠金额
+};
+
+class PromotionRuleSet;
+
+/// 编译好的促销规则，只读，可由多个收银通道共享
+using PromotionRuleSetPtr = std::shared_ptr<const PromotionRuleSet>;
+
+/**
+ * @brief PromotionRuleSet类 - 编译后的促销规则（决策表）
+ *
+ * 把规则编译成按商品索引的决策表：每个商品只归属于覆盖它的、优先级最高的一条规则。
+ * 编译后不再修改，不含任何购物车状态，所有通道的PromotionEngine共享同一份。
+ */
+class PromotionRuleSet
+{
+public:
+    /**
+     * @brief 编译后的一条规则
+     */
+    struct CompiledRule
+    {
+        PromotionRule rule;
+        QList<int> members;         ///< 决策表中归属于本规则的商品
+    };
+
+    /**
+     * @brief 编译规则，生成商品到规则的决策表
+     * @param rules 促销规则
+     * @return 新的规则集
+     */
+    static PromotionRuleSetPtr compile(const QList<PromotionRule>& rules);
+
+    /**
+     * @brief 编译后参与计算的规则数
+     */
+    int ruleCount() const { return m_rules.size(); }
+
+    /**
+     * @brief 商品所属规则的下标，不参与促销时返回-1
+     */
+    int ruleIndexOf(int productId) const { return m_ruleIndexByProduct.value(productId, -1); }
+
+    const CompiledRule& ruleAt(int index) const { return m_rules.at(index); }
+
+private:
+    QVector<CompiledRule> m_rules;          ///< 编译后的规则
+    QHash<int, int> m_ruleIndexByProduct;   ///< 决策表：商品ID到规则下标
+};
+
+/**
+ * @brief PromotionEngine类 - 促销规则引擎
+ *
+ * 在共享的PromotionRuleSet之上保存一个购物车的促销状态。购物车某一行变化时，
+ * 只需查表找到这一条规则，在该规则当前命中的购物车行上重新计算优惠并按差值更新总优惠，
+ * 与规则总数无关。
+ */
+class PromotionEngine
+{
+public:
+    PromotionEngine();
+
+    /**
+     * @brief 换用另一份规则集，并清空购物车状态
+     * @param rules 规则集（为空时表示没有促销）
+     */
+    void setRuleSet(PromotionRuleSetPtr rules);
+    PromotionRuleSetPtr ruleSet() const { return m_ruleSet; }
+
+    /**
+     * @brief 编译规则并换用（只供单独使用引擎的场合，如基准测试）
+     * @param rules 促销规则
+     */
+    void compile(const QList<PromotionRule>& rules);
+
+    /**
+     * @brief 编译后参与计算的规则数
+     */
+    int ruleCount() const { return m_ruleSet->ruleCount(); }
+
+    /**
+     * @brief 商品是否参与某条促销
+     * @param productId 商品ID
+     */
+    bool hasRuleFor(int productId) const { return m_ruleSet->ruleIndexOf(productId) >= 0; }
+
+    /**
+     * @brief 清空购物车状态（规则保留）
+     */
+    void clearCart();
+
+    /**
+     * @brief 更新购物车中一个商品的数量和单价，只重新计算其所属的规则
+     * @param productId 商品ID
+     * @param quantity 数量（0表示移除）
+     * @param unitPrice 单价
+     * @return 更新后的总优惠
+     */
+    Money updateLine(int productId, int quantity, Money unitPrice);
+
+    /**
+     * @brief 当前购物车的总优惠
+     */
+    Money totalDiscount() const { return m_totalDiscount; }
+
+    /**
+     * @brief 当前生效的促销（按规则ID排序）
+     */
+    QList<AppliedPromotion> appliedPromotions() const;
+
+private:
+    struct Line
+    {
+        int quantity = 0;
+        Money unitPrice;
+    };
+
+    /**
+     * @brief 一条规则在本购物车中的状态
+     */
+    struct RuleState
+    {
+        QHash<int, Line> lines;     ///< 本规则当前命中的购物车行
+        Money discount;             ///< 本规则当前的优惠
+    };
+
+    using CompiledRule = PromotionRuleSet::CompiledRule;
+
+    static Money evaluate(const CompiledRule& compiled, const QHash<int, Line>& lines);
+    static Money evaluateBuyXGetY(const CompiledRule& compiled, const QHash<int, Line>& lines);
+    static Money evaluateMixAndMatch(const CompiledRule& compiled, const QHash<int, Line>& lines);
+    static Money evaluateTiered(const CompiledRule& compiled, const QHash<int, Line>& lines);
+    static Money evaluateBundle(const CompiledRule& compiled, const QHash<int, Line>& lines);
+
+    /**
+     * @brief 从最便宜（或最贵）的件开始取count件，返回它们的价格之和
+     */
+    static Money sumUnitPrices(const QHash<int, Line>& lines, int count, bool cheapestFirst);
+
+    PromotionRuleSetPtr m_ruleSet;          ///< 共享的规则集
+    QHash<int, RuleState> m_activeRules;    ///< 购物车中有命中行的规则（按规则下标）
+    Money m_totalDiscount;                  ///< 总优惠
+};
+
+#endif // PROMOTIONENGINE_H
@@ -3,15 +3,65 @@
 #include "../models/Customer.h"
 #include "../models/Sale.h"
 #include "../models/SaleItem.h"
+#include "../models/SaleCodec.h"
+#include "../controllers/PromotionEngine.h"
+#include "../receipt/ReceiptData.h"
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QDebug>
 #include <QDir>
 #include <QStandardPaths>
+#include <QTimeZone>
 #include <QtConcurrent>
 
 QMutex DatabaseManager::s_mutex;
 
+namespace {
+// 金额列仍为REAL，只在这里与Money互相转换；写入的值总是精确到分
+QVariant moneyToSql(Money amount)
+{
+    return amount.toDouble();
+}
+
+Money moneyFromSql(const QVariant& value)
+{
+    return Money::fromDouble(value.toDouble(), Money::Rounding::HalfUp);
+}
+
+// Transactions.timestamp由CURRENT_TIMESTAMP写入，是UTC的"yyyy-MM-dd hh:mm:ss"文本
+const char* const SqlTimestampFormat = "yyyy-MM-dd hh:mm:ss";
+
+QString timestampToSql(const QDateTime& dateTime)
+{
+    return dateTime.toUTC().toString(SqlTimestampFormat);
+}
+
+QDateTime timestampFromSql(const QVariant& value)
+{
+    QDateTime utc = QDateTime::fromString(value.toString(), SqlTimestampFormat);
+    utc.setTimeZone(QTimeZone::utc());
+    return utc.toLocalTime();
+}
+
+// 从Products表的一行创建商品对象（由调用方负责释放）
+Product* productFromQuery(const QSqlQuery& query)
+{
+    Product* product = new Product();
+    product->setProductId(query.value("product_id").toInt());
+    product->setBarcode(query.value("barcode").toString());
+    product->setName(query.value("name").toString());
+    product->setDescription(query.value("description").toString());
+    product->setPrice(moneyFromSql(query.value("price")));
+    product->setStockQuantity(query.value("stock_quantity").toInt());
+    product->setCategory(query.value("category").toString());
+    product->setImagePath(query.value("image_path").toString());
+    return product;
+}
+
+// SQLite旧版本每条语句最多999个参数，IN查询按这个大小分批
+const int MaxInQueryParameters = 500;
+}
+
 DatabaseManager& DatabaseManager::getInstance()
 {
     static DatabaseManager instance;
@@ -126,6 +176,34 @@ bool DatabaseManager::initializeTables()
             subtotal REAL NOT NULL CHECK(subtotal >= 0),
             FOREIGN KEY (transaction_id) REFERENCES Transactions (transaction_id) ON DELETE CASCADE,
             FOREIGN KEY (product_id) REFERENCES Products (product_id)
+        ))",
+        R"(CREATE TABLE IF NOT EXISTS Promotions (
+            rule_id INTEGER PRIMARY KEY AUTOINCREMENT,
+            name TEXT NOT NULL,
+            type TEXT NOT NULL,
+            priority INTEGER DEFAULT 0,
+            buy_quantity INTEGER DEFAULT 0,
+            get_quantity INTEGER DEFAULT 0,
+            percent_off REAL DEFAULT 100 CHECK(percent_off >= 0 AND percent_off <= 100),
+            deal_price REAL DEFAULT 0 CHECK(deal_price >= 0),
+            tiers TEXT,
+            active INTEGER DEFAULT 1
+        ))",
+        R"(CREATE TABLE IF NOT EXISTS PromotionItems (
+            rule_id INTEGER NOT NULL,
+            product_id INTEGER NOT NULL,
+            PRIMARY KEY (rule_id, product_id),
+            FOREIGN KEY (rule_id) REFERENCES Promotions (rule_id) ON DELETE CASCADE,
+            FOREIGN KEY (product_id) REFERENCES Products (product_id) ON DELETE CASCADE
+        ))",
+        R"(CREATE TABLE IF NOT EXISTS ParkedSales (
+            parked_id INTEGER PRIMARY KEY AUTOINCREMENT,
+            label TEXT,
+            item_count INTEGER NOT NULL,
+            total_amount REAL NOT NULL,
+            cashier_name TEXT,
+            parked_at DATETIME DEFAULT CURRENT_TIMESTAMP,
+            payload BLOB NOT NULL
         ))"
     };
 
@@ -140,6 +218,7 @@ bool DatabaseManager::initializeTables()
         "CREATE INDEX IF NOT EXISTS idx_products_barcode ON Products (barcode)",
         "CREATE INDEX IF NOT EXISTS idx_transactions_customer ON Transactions (customer_id)",
         "CREATE INDEX IF NOT EXISTS idx_transactions_timestamp ON Transactions (timestamp)",
+        "CREATE INDEX IF NOT EXISTS idx_promotion_items_product ON PromotionItems (product_id)",
     };
     
     for (const char* indexSql : indices) {
@@ -170,7 +249,7 @@ void DatabaseManager::saveProduct(const Product& product)
             query.addBindValue(product.getBarcode());
             query.addBindValue(product.getName());
             query.addBindValue(product.getDescription());
-            query.addBindValue(product.getPrice());
+            query.addBindValue(moneyToSql(product.getPrice()));
             query.addBindValue(product.getStockQuantity());
             query.addBindValue(product.getCategory());
             query.addBindValue(product.getImagePath());
@@ -188,7 +267,7 @@ void DatabaseManager::saveProduct(const Product& product)
             query.addBindValue(product.getBarcode());
             query.addBindValue(product.getName());
             query.addBindValue(product.getDescription());
-            query.addBindValue(product.getPrice());
+            query.addBindValue(moneyToSql(product.getPrice()));
             query.addBindValue(product.getStockQuantity());
             query.addBindValue(product.getCategory());
             query.addBindValue(product.getImagePath());
@@ -233,15 +312,17 @@ void DatabaseManager::deleteProduct(int productId)
 
 void DatabaseManager::getProductByBarcode(const QString& barcode)
 {
-    auto watcher = new QFutureWatcher<Product*>(this);
-    connect(watcher, &QFutureWatcher<Product*>::finished, this, [this, watcher, barcode]() {
-        handleProductReadByBarcode(watcher->result(), barcode);
+    auto watcher = new QFutureWatcher<QPair<Product*, bool>>(this);
+    connect(watcher, &QFutureWatcher<QPair<Product*, bool>>::finished, this, [this, watcher, barcode]() {
+        const auto result = watcher->result();
+        handleProductReadByBarcode(result.first, barcode, result.second);
         watcher->deleteLater();
     });
 
-    QFuture<Product*> future = QtConcurrent::run([this, barcode]() {
+    // 结果中的bool表示查询是否成功执行，区分"没有这个条码"和数据库故障
+    QFuture<QPair<Product*, bool>> future = QtConcurrent::run([this, barcode]() {
         QMutexLocker locker(&s_mutex);
-        if (!m_connected) return (Product*)nullptr;
+        if (!m_connected) return qMakePair((Product*)nullptr, false);
 
         QSqlQuery query(m_db);
         query.prepare("SELECT * FROM Products WHERE barcode = ?");
@@ -249,23 +330,54 @@ void DatabaseManager::getProductByBarcode(const QString& barcode)
 
         if (!query.exec()) {
             logError("getProductByBarcode_worker", query.lastError());
-            return (Product*)nullptr;
+            return qMakePair((Product*)nullptr, false);
         }
 
         if (query.next()) {
-            Product* product = new Product();
-            product->setProductId(query.value("product_id").toInt());
-            product->setBarcode(query.value("barcode").toString());
-            product->setName(query.value("name").toString());
-            product->setDescription(query.value("description").toString());
-            product->setPrice(query.value("price").toDouble());
-            product->setStockQuantity(query.value("stock_quantity").toInt());
-            product->setCategory(query.value("category").toString());
-            product->setImagePath(query.value("image_path").toString());
-            return product;
+            return qMakePair(productFromQuery(query), true);
         }
 
-        return (Product*)nullptr;
+        return qMakePair((Product*)nullptr, true);
+    });
+
+    watcher->setFuture(future);
+}
+
+void DatabaseManager::getProductsByBarcodes(int requestId, const QStringList& barcodes)
+{
+    auto watcher = new QFutureWatcher<QPair<QList<Product*>, bool>>(this);
+    connect(watcher, &QFutureWatcher<QPair<QList<Product*>, bool>>::finished, this, [this, watcher, requestId]() {
+        const auto result = watcher->result();
+        emit productsReadByBarcodes(requestId, result.first, result.second);
+        watcher->deleteLater();
+    });
+
+    QFuture<QPair<QList<Product*>, bool>> future = QtConcurrent::run([this, barcodes]() {
+        QMutexLocker locker(&s_mutex);
+        QList<Product*> products;
+        if (!m_connected) return qMakePair(products, false);
+
+        for (int first = 0; first < barcodes.size(); first += MaxInQueryParameters) {
+            const QStringList chunk = barcodes.mid(first, MaxInQueryParameters);
+            QStringList placeholders;
+            for (int i = 0; i < chunk.size(); ++i) {
+                placeholders << "?";
+            }
+
+            QSqlQuery query(m_db);
+            query.prepare(QString("SELECT * FROM Products WHERE barcode IN (%1)").arg(placeholders.join(",")));
+            for (const QString& barcode : chunk) {
+                query.addBindValue(barcode);
+            }
+            if (!query.exec()) {
+                logError("getProductsByBarcodes_worker", query.lastError());
+                return qMakePair(products, false);
+            }
+            while (query.next()) {
+                products.append(productFromQuery(query));
+            }
+        }
+        return qMakePair(products, true);
     });
 
     watcher->setFuture(future);
@@ -290,16 +402,7 @@ void DatabaseManager::getAllProducts()
         }
 
         while (query.next()) {
-            Product* product = new Product();
-            product->setProductId(query.value("product_id").toInt());
-            product->setBarcode(query.value("barcode").toString());
-            product->setName(query.value("name").toString());
-            product->setDescription(query.value("description").toString());
-            product->setPrice(query.value("price").toDouble());
-            product->setStockQuantity(query.value("stock_quantity").toInt());
-            product->setCategory(query.value("category").toString());
-            product->setImagePath(query.value("image_path").toString());
-            products.append(product);
+            products.append(productFromQuery(query));
         }
         return products;
     });
@@ -324,8 +427,9 @@ int DatabaseManager::saveTransaction(Sale* sale)
     )");
     
     query.addBindValue(sale->getCustomer() ? QVariant(sale->getCustomer()->getCustomerId()) : QVariant());
-    query.addBindValue(sale->getTotalAmount());
-    query.addBindValue(sale->getDiscountAmount());
+    query.addBindValue(moneyToSql(sale->getTotalAmount()));
+    // 手工折扣和促销优惠合计存入discount_amount
+    query.addBindValue(moneyToSql(sale->getDiscountAmount() + sale->getPromotionDiscount()));
     query.addBindValue(Sale::paymentMethodToString(sale->getPaymentMethod()));
     query.addBindValue(static_cast<int>(sale->getStatus()));
     query.addBindValue(sale->getCashierName());
@@ -346,8 +450,8 @@ int DatabaseManager::saveTransaction(Sale* sale)
         query.addBindValue(transactionId);
         query.addBindValue(item->getProduct()->getProductId());
         query.addBindValue(item->getQuantity());
-        query.addBindValue(item->getUnitPrice());
-        query.addBindValue(item->getSubtotal());
+        query.addBindValue(moneyToSql(item->getUnitPrice()));
+        query.addBindValue(moneyToSql(item->getSubtotal()));
         
         if (!query.exec()) {
             logError("saveTransaction_item", query.lastError());
@@ -381,6 +485,130 @@ bool DatabaseManager::updateProductStock(int productId, int newStock)
     return query.exec();
 }
 
+QList<PromotionRule> DatabaseManager::getActivePromotions()
+{
+    QMutexLocker locker(&s_mutex);
+    QList<PromotionRule> rules;
+    if (!m_connected) return rules;
+
+    QSqlQuery query(m_db);
+    if (!query.exec(R"(
+            SELECT rule_id, name, type, priority, buy_quantity, get_quantity, percent_off, deal_price, tiers
+            FROM Promotions WHERE active = 1
+        )")) {
+        logError("getActivePromotions_rules", query.lastError());
+        return rules;
+    }
+
+    QHash<int, int> indexById;
+    while (query.next()) {
+        PromotionRule rule;
+        rule.ruleId = query.value("rule_id").toInt();
+        rule.name = query.value("name").toString();
+        rule.type = PromotionRule::stringToType(query.value("type").toString());
+        rule.priority = query.value("priority").toInt();
+        rule.buyQuantity = query.value("buy_quantity").toInt();
+        rule.getQuantity = query.value("get_quantity").toInt();
+        rule.percentOff = query.value("percent_off").toDouble();
+        rule.dealPrice = moneyFromSql(query.value("deal_price"));
+        rule.tiers = PromotionRule::tiersFromString(query.value("tiers").toString());
+        indexById.insert(rule.ruleId, rules.size());
+        rules.append(rule);
+    }
+
+    // 一次查询取出全部成员，避免逐条规则查询
+    if (!query.exec("SELECT rule_id, product_id FROM PromotionItems ORDER BY rule_id, product_id")) {
+        logError("getActivePromotions_items", query.lastError());
+        return {};
+    }
+    while (query.next()) {
+        auto index = indexById.constFind(query.value(0).toInt());
+        if (index != indexById.constEnd()) {
+            rules[index.value()].productIds.append(query.value(1).toInt());
+        }
+    }
+
+    return rules;
+}
+
+int DatabaseManager::saveParkedSale(const QString& label, const QString& cashierName, int itemCount,
+                                    Money totalAmount, const QByteArray& payload)
+{
+    QMutexLocker locker(&s_mutex);
+    if (!m_connected) return -1;
+
+    QSqlQuery query(m_db);
+    query.prepare(R"(
+        INSERT INTO ParkedSales (label, item_count, total_amount, cashier_name, payload)
+        VALUES (?, ?, ?, ?, ?)
+    )");
+    query.addBindValue(label);
+    query.addBindValue(itemCount);
+    query.addBindValue(moneyToSql(totalAmount));
+    query.addBindValue(cashierName);
+    query.addBindValue(payload);
+
+    if (!query.exec()) {
+        logError("saveParkedSale", query.lastError());
+        return -1;
+    }
+    return query.lastInsertId().toInt();
+}
+
+QList<ParkedSaleInfo> DatabaseManager::getParkedSales()
+{
+    QMutexLocker locker(&s_mutex);
+    QList<ParkedSaleInfo> parked;
+    if (!m_connected) return parked;
+
+    // 列表只取摘要，不读取payload
+    QSqlQuery query(m_db);
+    if (!query.exec("SELECT parked_id, label, item_count, total_amount, parked_at FROM ParkedSales ORDER BY parked_id")) {
+        logError("getParkedSales", query.lastError());
+        return parked;
+    }
+    while (query.next()) {
+        ParkedSaleInfo info;
+        info.parkedId = query.value("parked_id").toInt();
+        info.label = query.value("label").toString();
+        info.itemCount = query.value("item_count").toInt();
+        info.totalAmount = moneyFromSql(query.value("total_amount"));
+        info.parkedAt = timestampFromSql(query.value("parked_at"));
+        parked.append(info);
+    }
+    return parked;
+}
+
+QByteArray DatabaseManager::getParkedSalePayload(int parkedId)
+{
+    QMutexLocker locker(&s_mutex);
+    if (!m_connected) return QByteArray();
+
+    QSqlQuery query(m_db);
+    query.prepare("SELECT payload FROM ParkedSales WHERE parked_id = ?");
+    query.addBindValue(parkedId);
+    if (!query.exec()) {
+        logError("getParkedSalePayload", query.lastError());
+        return QByteArray();
+    }
+    return query.next() ? query.value(0).toByteArray() : QByteArray();
+}
+
+bool DatabaseManager::deleteParkedSale(int parkedId)
+{
+    QMutexLocker locker(&s_mutex);
+    if (!m_connected) return false;
+
+    QSqlQuery query(m_db);
+    query.prepare("DELETE FROM ParkedSales WHERE parked_id = ?");
+    query.addBindValue(parkedId);
+    if (!query.exec()) {
+        logError("deleteParkedSale", query.lastError());
+        return false;
+    }
+    return query.numRowsAffected() > 0;
+}
+
 QList<int> DatabaseManager::getPopularProducts(int limit, int days)
 {
     // TODO: Implement this properly
@@ -411,9 +639,9 @@ void DatabaseManager::handleProductsRead()
     watcher->deleteLater();
 }
 
-void DatabaseManager::handleProductReadByBarcode(Product* product, const QString& barcode)
+void DatabaseManager::handleProductReadByBarcode(Product* product, const QString& barcode, bool succeeded)
 {
-    emit productReadByBarcode(product, barcode);
+    emit productReadByBarcode(product, barcode, succeeded);
 }
 
 void DatabaseManager::handleProductSaved()
@@ -452,8 +680,10 @@ QFuture<QList<Sale*>> DatabaseManager::getAllTransactions()
             auto sale = new Sale();
             sale->setTransactionId(saleQuery.value("transaction_id").toInt());
             // 客户ID暂时不处理
+            // 整笔交易只在重建完成后通知一次
+            sale->beginUpdate();
             sale->setTimestamp(saleQuery.value("timestamp").toDateTime());
-            sale->setDiscountAmount(saleQuery.value("discount_amount").toDouble());
+            sale->setDiscountAmount(moneyFromSql(saleQuery.value("discount_amount")));
             sale->setPaymentMethod(Sale::stringToPaymentMethod(saleQuery.value("payment_method").toString()));
             sale->setCashierName(saleQuery.value("cashier_name").toString());
 
@@ -479,7 +709,7 @@ QFuture<QList<Sale*>> DatabaseManager::getAllTransactions()
                 product->setBarcode(itemQuery.value("barcode").toString());
                 product->setName(itemQuery.value("name").toString());
                 product->setDescription(itemQuery.value("description").toString());
-                product->setPrice(itemQuery.value("unit_price").toDouble());
+                product->setPrice(moneyFromSql(itemQuery.value("unit_price")));
                 product->setCategory(itemQuery.value("category").toString());
                 product->setImagePath(itemQuery.value("image_path").toString());
 
@@ -490,9 +720,8 @@ QFuture<QList<Sale*>> DatabaseManager::getAllTransactions()
 
                 sale->addItem(saleItem);
             }
-            // Totals are calculated inside addItem, but we might need a final calculation
-            // to be safe, though it's redundant if addItem is always called.
-            sale->calculateTotal();
+            // Totals are maintained incrementally by addItem
+            sale->endUpdate();
             sales.append(sale);
         }
 
@@ -500,6 +729,86 @@ QFuture<QList<Sale*>> DatabaseManager::getAllTransactions()
     });
 }
 
+QList<ReceiptData> DatabaseManager::getReceiptsByDateRange(const QDateTime& startDate, const QDateTime& endDate)
+{
+    QMutexLocker locker(&s_mutex);
+    QList<ReceiptData> receipts;
+    if (!m_connected) return receipts;
+
+    const QString start = timestampToSql(startDate);
+    const QString end = timestampToSql(endDate);
+
+    QSqlQuery saleQuery(m_db);
+    saleQuery.setForwardOnly(true);
+    saleQuery.prepare(R"(
+        SELECT transaction_id, timestamp, total_amount, discount_amount, payment_method, cashier_name
+        FROM Transactions
+        WHERE timestamp >= ? AND timestamp < ?
+        ORDER BY transaction_id
+    )");
+    saleQuery.addBindValue(start);
+    saleQuery.addBindValue(end);
+    if (!saleQuery.exec()) {
+        logError("getReceiptsByDateRange_sales", saleQuery.lastError());
+        return receipts;
+    }
+
+    QHash<int, int> indexById;
+    while (saleQuery.next()) {
+        ReceiptData receipt;
+        receipt.transactionId = saleQuery.value("transaction_id").toInt();
+        receipt.timestamp = timestampFromSql(saleQuery.value("timestamp"));
+        receipt.totalAmount = moneyFromSql(saleQuery.value("total_amount"));
+        // discount_amount是手工折扣和促销优惠的合计
+        receipt.discountAmount = moneyFromSql(saleQuery.value("discount_amount"));
+        receipt.finalAmount = receipt.totalAmount - receipt.discountAmount;
+        if (receipt.finalAmount.isNegative()) {
+            receipt.finalAmount = Money();
+        }
+        receipt.paymentMethod = saleQuery.value("payment_method").toString();
+        receipt.cashierName = saleQuery.value("cashier_name").toString();
+        indexById.insert(receipt.transactionId, receipts.size());
+        receipts.append(receipt);
+    }
+    if (receipts.isEmpty()) {
+        return receipts;
+    }
+
+    // 一次取出范围内全部商品行，按交易归并
+    QSqlQuery itemQuery(m_db);
+    itemQuery.setForwardOnly(true);
+    itemQuery.prepare(R"(
+        SELECT ti.transaction_id, p.name, ti.quantity, ti.unit_price, ti.subtotal
+        FROM TransactionItems ti
+        JOIN Transactions t ON ti.transaction_id = t.transaction_id
+        LEFT JOIN Products p ON ti.product_id = p.product_id
+        WHERE t.timestamp >= ? AND t.timestamp < ?
+        ORDER BY ti.transaction_id, ti.transaction_item_id
+    )");
+    itemQuery.addBindValue(start);
+    itemQuery.addBindValue(end);
+    if (!itemQuery.exec()) {
+        logError("getReceiptsByDateRange_items", itemQuery.lastError());
+        return receipts;
+    }
+
+    while (itemQuery.next()) {
+        auto it = indexById.constFind(itemQuery.value(0).toInt());
+        if (it == indexById.constEnd()) {
+            continue;
+        }
+        ReceiptData& receipt = receipts[it.value()];
+        ReceiptLine line;
+        line.name = itemQuery.value(1).isNull() ? QString("未知商品") : itemQuery.value(1).toString();
+        line.quantity = itemQuery.value(2).toInt();
+        line.unitPrice = moneyFromSql(itemQuery.value(3));
+        line.subtotal = moneyFromSql(itemQuery.value(4));
+        receipt.totalQuantity += line.quantity;
+        receipt.lines.append(line);
+    }
+    return receipts;
+}
+
 // Synchronous methods for contexts that require it (e.g., exiting)
 // These are not yet implemented as they are not currently required by the async flow.
 std::unique_ptr<Product> DatabaseManager::getProduct(int productId) { return nullptr; }
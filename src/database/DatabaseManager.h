@@ -8,11 +8,15 @@
 #include <QMutex>
 #include <QFutureWatcher>
 #include <memory>
+#include "../models/Money.h"
 
 // 前向声明
 class Product;
 class Customer;
 class Sale;
+struct PromotionRule;
+struct ParkedSaleInfo;
+struct ReceiptData;
 
 /**
  * @brief DatabaseManager类 - 数据库管理器（单例模式）
@@ -74,6 +78,13 @@ public:
      */
     void getProductByBarcode(const QString& barcode);
 
+    /**
+     * @brief 用一次IN查询获取多个条码对应的商品（异步，完成后发射productsReadByBarcodes）
+     * @param requestId 调用方的请求ID，原样随结果返回
+     * @param barcodes 条形码列表（不应有重复）
+     */
+    void getProductsByBarcodes(int requestId, const QStringList& barcodes);
+
     /**
      * @brief 获取所有商品
      * @return 商品指针列表（由调用方负责释放）
@@ -161,6 +172,16 @@ public:
      */
     QFuture<QList<Sale*>> getAllTransactions();
 
+    /**
+     * @brief 获取时间范围内交易的小票快照（批量导出/日结使用）
+     *
+     * 只执行两次查询（交易和全部商品行），不创建Sale/Product对象；店铺信息为默认值。
+     * @param startDate 开始时间（含）
+     * @param endDate 结束时间（不含）
+     * @return 按交易ID排序的小票快照列表
+     */
+    QList<ReceiptData> getReceiptsByDateRange(const QDateTime& startDate, const QDateTime& endDate);
+
     // 报表和统计相关
     /**
      * @brief 获取商品销售统计
@@ -184,6 +205,46 @@ public:
      */
     QList<int> getPopularProducts(int limit = 10, int days = 30);
 
+    // 促销相关操作
+    /**
+     * @brief 获取所有启用的促销规则（含参与商品）
+     * @return 促销规则列表
+     */
+    QList<PromotionRule> getActivePromotions();
+
+    // 挂单相关操作
+    /**
+     * @brief 保存挂单
+     * @param label 备注
+     * @param cashierName 收银员名称
+     * @param itemCount 商品总件数
+     * @param totalAmount 应付金额
+     * @param payload SaleCodec编码的购物车内容
+     * @return 如果成功返回挂单ID，失败返回-1
+     */
+    int saveParkedSale(const QString& label, const QString& cashierName, int itemCount,
+                       Money totalAmount, const QByteArray& payload);
+
+    /**
+     * @brief 获取所有挂单的摘要（不含购物车内容）
+     * @return 挂单摘要列表
+     */
+    QList<ParkedSaleInfo> getParkedSales();
+
+    /**
+     * @brief 获取挂单的购物车内容
+     * @param parkedId 挂单ID
+     * @return SaleCodec编码的内容，未找到返回空
+     */
+    QByteArray getParkedSalePayload(int parkedId);
+
+    /**
+     * @brief 删除挂单
+     * @param parkedId 挂单ID
+     * @return 如果成功返回true
+     */
+    bool deleteParkedSale(int parkedId);
+
 signals:
     /**
      * @brief 数据库连接状态改变时发射的信号
@@ -198,7 +259,20 @@ signals:
     void databaseError(const QString& error);
 
     void productsRead(const QList<Product*>& products);
-    void productReadByBarcode(Product* product, const QString& barcode);
+    /**
+     * @brief 按条码查询完成
+     * @param product 查到的商品，未找到或查询失败时为nullptr
+     * @param barcode 条形码
+     * @param succeeded 查询是否成功执行（false表示数据库未连接或查询出错，不代表条码不存在）
+     */
+    void productReadByBarcode(Product* product, const QString& barcode, bool succeeded);
+    /**
+     * @brief 批量条码查询完成
+     * @param requestId 请求ID
+     * @param products 查到的商品（查询失败时可能只有一部分）
+     * @param succeeded 全部查询是否成功执行（false时未返回的条码不代表不存在）
+     */
+    void productsReadByBarcodes(int requestId, const QList<Product*>& products, bool succeeded);
     void productSaved(bool success, int productId);
     void productDeleted(bool success, int productId);
     
@@ -207,7 +281,7 @@ private slots:
     void handleProductSaved();
 
 private:
-    void handleProductReadByBarcode(Product* product, const QString& barcode);
+    void handleProductReadByBarcode(Product* product, const QString& barcode, bool succeeded);
     void handleProductDeleted(bool success, int productId);
     /**
      * @brief 私有构造函数（单例模式）
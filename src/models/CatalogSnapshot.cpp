@@ -0,0 +1,162 @@
+#include "CatalogSnapshot.h"
+#include "Product.h"
+
+ProductRecord ProductRecord::fromProduct(const Product& product)
+{
+    ProductRecord record;
+    record.productId = product.getProductId();
+    record.barcode = product.getBarcode();
+    record.name = product.getName();
+    record.description = product.getDescription();
+    record.price = product.getPrice();
+    record.stockQuantity = product.getStockQuantity();
+    record.category = product.getCategory();
+    record.imagePath = product.getImagePath();
+    return record;
+}
+
+CatalogSnapshot::CatalogSnapshot()
+    : m_version(0)
+    , m_size(0)
+{
+    for (int shard = 0; shard < ShardCount; ++shard) {
+        m_products[shard] = std::make_shared<ProductShard>();
+        m_idByBarcode[shard] = std::make_shared<BarcodeShard>();
+    }
+    m_ownedProducts.set();
+    m_ownedBarcodes.set();
+}
+
+CatalogSnapshotPtr CatalogSnapshot::build(const QList<Product*>& products, quint64 version)
+{
+    auto snapshot = std::make_shared<CatalogSnapshot>();
+    snapshot->m_version = version;
+    for (int shard = 0; shard < ShardCount; ++shard) {
+        snapshot->m_products[shard]->reserve(products.size() / ShardCount + 1);
+        snapshot->m_idByBarcode[shard]->reserve(products.size() / ShardCount + 1);
+    }
+
+    for (const Product* product : products) {
+        if (product) {
+            snapshot->upsert(ProductRecord::fromProduct(*product));
+        }
+    }
+    snapshot->m_ownedProducts.reset();
+    snapshot->m_ownedBarcodes.reset();
+    return snapshot;
+}
+
+CatalogSnapshotPtr CatalogSnapshot::withUpserted(const QList<ProductRecord>& records) const
+{
+    // 拷贝只复制分片指针，被修改的分片在第一次写入时才复制
+    auto next = std::make_shared<CatalogSnapshot>(*this);
+    next->m_version = m_version + 1;
+    for (const ProductRecord& record : records) {
+        next->upsert(record);
+    }
+    next->m_ownedProducts.reset();
+    next->m_ownedBarcodes.reset();
+    return next;
+}
+
+CatalogSnapshotPtr CatalogSnapshot::withRemoved(const QList<int>& productIds) const
+{
+    auto next = std::make_shared<CatalogSnapshot>(*this);
+    next->m_version = m_version + 1;
+    for (int productId : productIds) {
+        next->remove(productId);
+    }
+    next->m_ownedProducts.reset();
+    next->m_ownedBarcodes.reset();
+    return next;
+}
+
+const ProductRecord* CatalogSnapshot::find(int productId) const
+{
+    const ProductShard& products = *m_products[shardOf(productId)];
+    auto it = products.constFind(productId);
+    return it != products.constEnd() ? &it.value() : nullptr;
+}
+
+const ProductRecord* CatalogSnapshot::findByBarcode(const QString& barcode) const
+{
+    const BarcodeShard& barcodes = *m_idByBarcode[shardOf(barcode)];
+    auto it = barcodes.constFind(barcode);
+    return it != barcodes.constEnd() ? find(it.value()) : nullptr;
+}
+
+QList<int> CatalogSnapshot::productIds() const
+{
+    QList<int> ids;
+    ids.reserve(m_size);
+    for (const auto& shard : m_products) {
+        for (auto it = shard->constBegin(); it != shard->constEnd(); ++it) {
+            ids.append(it.key());
+        }
+    }
+    return ids;
+}
+
+int CatalogSnapshot::shardOf(int productId)
+{
+    return static_cast<int>(static_cast<uint>(productId) % ShardCount);
+}
+
+int CatalogSnapshot::shardOf(const QString& barcode)
+{
+    return static_cast<int>(qHash(barcode) % ShardCount);
+}
+
+CatalogSnapshot::ProductShard& CatalogSnapshot::mutableProducts(int shard)
+{
+    if (!m_ownedProducts.test(shard)) {
+        m_products[shard] = std::make_shared<ProductShard>(*m_products[shard]);
+        m_ownedProducts.set(shard);
+    }
+    return *m_products[shard];
+}
+
+CatalogSnapshot::BarcodeShard& CatalogSnapshot::mutableBarcodes(int shard)
+{
+    if (!m_ownedBarcodes.test(shard)) {
+        m_idByBarcode[shard] = std::make_shared<BarcodeShard>(*m_idByBarcode[shard]);
+        m_ownedBarcodes.set(shard);
+    }
+    return *m_idByBarcode[shard];
+}
+
+void CatalogSnapshot::upsert(const ProductRecord& record)
+{
+    const ProductRecord* existing = find(record.productId);
+    if (existing && existing->barcode != record.barcode) {
+        BarcodeShard& barcodes = mutableBarcodes(shardOf(existing->barcode));
+        if (barcodes.value(existing->barcode, -1) == record.productId) {
+            barcodes.remove(existing->barcode);
+        }
+    }
+    if (!existing) {
+        ++m_size;
+    }
+
+    mutableProducts(shardOf(record.productId)).insert(record.productId, record);
+    if (!record.barcode.isEmpty()) {
+        mutableBarcodes(shardOf(record.barcode)).insert(record.barcode, record.productId);
+    }
+}
+
+void CatalogSnapshot::remove(int productId)
+{
+    const ProductRecord* existing = find(productId);
+    if (!existing) {
+        return;
+    }
+
+    const QString barcode = existing->barcode;
+    mutableProducts(shardOf(productId)).remove(productId);
+    --m_size;
+
+    const int barcodeShard = shardOf(barcode);
+    if (m_idByBarcode[barcodeShard]->value(barcode, -1) == productId) {
+        mutableBarcodes(barcodeShard).remove(barcode);
+    }
+}
@@ -0,0 +1,143 @@
+#ifndef CATALOGSNAPSHOT_H
+#define CATALOGSNAPSHOT_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <array>
+#include <bitset>
+#include <memory>
+#include "Money.h"
+
+class Product;
+
+/**
+ * @brief ProductRecord - 商品数据的不可变值副本
+ *
+ * 不是QObject，可以在任意线程间自由拷贝和读取。
+ */
+struct ProductRecord
+{
+    int productId = -1;         ///< 商品ID
+    QString barcode;            ///< 条形码
+    QString name;               ///< 商品名称
+    QString description;        ///< 商品描述
+    Money price;                ///< 价格
+    int stockQuantity = 0;      ///< 库存数量
+    QString category;           ///< 商品分类
+    QString imagePath;          ///< 商品图片路径
+
+    /**
+     * @brief 从商品对象生成值副本
+     * @param product 商品对象
+     * @return 商品记录
+     */
+    static ProductRecord fromProduct(const Product& product);
+};
+
+class CatalogSnapshot;
+
+/// 已发布的目录版本，只读且带引用计数
+using CatalogSnapshotPtr = std::shared_ptr<const CatalogSnapshot>;
+
+/**
+ * @brief CatalogSnapshot类 - 商品目录的不可变快照
+ *
+ * 每个版本发布后不再修改，读者持有CatalogSnapshotPtr即可在任何线程中无锁读取
+ * 价格和库存。写者通过withUpserted/withRemoved在当前版本的基础上按增量构建下一个
+ * 版本，再原子地替换发布指针，正在读取旧版本的线程不受影响，旧版本在最后一个读者释放后
+ * 自动销毁（RCU风格）。
+ *
+ * 商品和条码索引按键分成ShardCount个分片，每个分片由各版本通过shared_ptr共享；
+ * 增量只复制被修改的分片，单个商品的变更约为目录大小的1/ShardCount，而不是整个目录。
+ */
+class CatalogSnapshot
+{
+public:
+    /**
+     * @brief 构造一个空目录（版本0）
+     */
+    CatalogSnapshot();
+
+    /**
+     * @brief 从完整商品列表构建新版本
+     * @param products 商品列表
+     * @param version 版本号
+     * @return 新的快照
+     */
+    static CatalogSnapshotPtr build(const QList<Product*>& products, quint64 version);
+
+    /**
+     * @brief 在当前版本基础上插入或更新若干商品，生成下一个版本
+     * @param records 要插入或更新的商品记录
+     * @return 新的快照
+     */
+    CatalogSnapshotPtr withUpserted(const QList<ProductRecord>& records) const;
+
+    /**
+     * @brief 在当前版本基础上移除若干商品，生成下一个版本
+     * @param productIds 要移除的商品ID
+     * @return 新的快照
+     */
+    CatalogSnapshotPtr withRemoved(const QList<int>& productIds) const;
+
+    quint64 version() const { return m_version; }
+    int size() const { return m_size; }
+    bool isEmpty() const { return m_size == 0; }
+
+    /**
+     * @brief 按ID查找商品
+     * @param productId 商品ID
+     * @return 商品记录指针（在快照生命周期内有效），未找到返回nullptr
+     */
+    const ProductRecord* find(int productId) const;
+
+    /**
+     * @brief 按条码查找商品
+     * @param barcode 条形码
+     * @return 商品记录指针（在快照生命周期内有效），未找到返回nullptr
+     */
+    const ProductRecord* findByBarcode(const QString& barcode) const;
+
+    /**
+     * @brief 获取全部商品ID
+     * @return 商品ID列表（无序）
+     */
+    QList<int> productIds() const;
+
+private:
+    static constexpr int ShardCount = 64;
+
+    using ProductShard = QHash<int, ProductRecord>;
+    using BarcodeShard = QHash<QString, int>;
+
+    static int shardOf(int productId);
+    static int shardOf(const QString& barcode);
+
+    /**
+     * @brief 取得本版本可写的分片（第一次写入时从上一版本复制）
+     */
+    ProductShard& mutableProducts(int shard);
+    BarcodeShard& mutableBarcodes(int shard);
+
+    /**
+     * @brief 插入或更新一条记录并维护条码索引
+     * @param record 商品记录
+     */
+    void upsert(const ProductRecord& record);
+
+    /**
+     * @brief 移除一条记录并维护条码索引
+     * @param productId 商品ID
+     */
+    void remove(int productId);
+
+    quint64 m_version;                                          ///< 版本号
+    int m_size;                                                 ///< 商品数
+    std::array<std::shared_ptr<ProductShard>, ShardCount> m_products;   ///< 商品ID到记录的映射（分片）
+    std::array<std::shared_ptr<BarcodeShard>, ShardCount> m_idByBarcode; ///< 条码到商品ID的索引（分片）
+    std::bitset<ShardCount> m_ownedProducts;                    ///< 构建期间本版本已复制、可以写入的商品分片
+    std::bitset<ShardCount> m_ownedBarcodes;                    ///< 构建期间本版本已复制、可以写入的条码分片
+};
+
+#endif // CATALOGSNAPSHOT_H
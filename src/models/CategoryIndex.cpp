@@ -0,0 +1,116 @@
+#include "CategoryIndex.h"
+#include "Product.h"
+#include <algorithm>
+#include <iterator>
+
+void CategoryIndex::rebuild(const QList<Product*>& products)
+{
+    clear();
+    m_categoryById.reserve(products.size());
+
+    for (const Product* product : products) {
+        if (product) {
+            m_categoryById.insert(product->getProductId(), product->getCategory());
+            m_idsByCategory[product->getCategory()].append(product->getProductId());
+        }
+    }
+
+    // 批量构建后统一排序，比逐个有序插入更快
+    for (auto it = m_idsByCategory.begin(); it != m_idsByCategory.end(); ++it) {
+        std::sort(it.value().begin(), it.value().end());
+    }
+}
+
+bool CategoryIndex::upsert(int productId, const QString& category)
+{
+    auto existing = m_categoryById.find(productId);
+    if (existing != m_categoryById.end()) {
+        if (existing.value() == category) {
+            return false;
+        }
+        eraseSorted(existing.value(), productId);
+        existing.value() = category;
+    } else {
+        m_categoryById.insert(productId, category);
+    }
+
+    insertSorted(category, productId);
+    return true;
+}
+
+bool CategoryIndex::remove(int productId)
+{
+    auto existing = m_categoryById.find(productId);
+    if (existing == m_categoryById.end()) {
+        return false;
+    }
+
+    eraseSorted(existing.value(), productId);
+    m_categoryById.erase(existing);
+    return true;
+}
+
+void CategoryIndex::clear()
+{
+    m_idsByCategory.clear();
+    m_categoryById.clear();
+}
+
+QList<QPair<QString, int>> CategoryIndex::facetCounts() const
+{
+    QList<QPair<QString, int>> facets;
+    facets.reserve(m_idsByCategory.size());
+    for (auto it = m_idsByCategory.constBegin(); it != m_idsByCategory.constEnd(); ++it) {
+        facets.append(qMakePair(it.key(), static_cast<int>(it.value().size())));
+    }
+    std::sort(facets.begin(), facets.end(), [](const QPair<QString, int>& a, const QPair<QString, int>& b) {
+        return a.first.localeAwareCompare(b.first) < 0;
+    });
+    return facets;
+}
+
+int CategoryIndex::count(const QString& category) const
+{
+    auto it = m_idsByCategory.constFind(category);
+    return it != m_idsByCategory.constEnd() ? static_cast<int>(it.value().size()) : 0;
+}
+
+QList<int> CategoryIndex::productIds(const QString& category) const
+{
+    return m_idsByCategory.value(category);
+}
+
+QList<int> CategoryIndex::intersect(const QList<int>& a, const QList<int>& b)
+{
+    QList<int> result;
+    result.reserve(qMin(a.size(), b.size()));
+    std::set_intersection(a.constBegin(), a.constEnd(), b.constBegin(), b.constEnd(),
+                          std::back_inserter(result));
+    return result;
+}
+
+void CategoryIndex::insertSorted(const QString& category, int productId)
+{
+    QList<int>& ids = m_idsByCategory[category];
+    auto pos = std::lower_bound(ids.begin(), ids.end(), productId);
+    if (pos == ids.end() || *pos != productId) {
+        ids.insert(pos, productId);
+    }
+}
+
+void CategoryIndex::eraseSorted(const QString& category, int productId)
+{
+    auto it = m_idsByCategory.find(category);
+    if (it == m_idsByCategory.end()) {
+        return;
+    }
+
+    QList<int>& ids = it.value();
+    auto pos = std::lower_bound(ids.begin(), ids.end(), productId);
+    if (pos != ids.end() && *pos == productId) {
+        ids.erase(pos);
+    }
+    if (ids.isEmpty()) {
+        m_idsByCategory.erase(it);
+    }
+}
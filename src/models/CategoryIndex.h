@@ -0,0 +1,90 @@
+#ifndef CATEGORYINDEX_H
+#define CATEGORYINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+
+class Product;
+
+/**
+ * @brief CategoryIndex类 - 商品分类的分面索引
+ *
+ * 维护 分类 → 有序商品ID列表 的映射，分类下的商品数量即列表长度。
+ * 商品变化时按增量更新，无需全表扫描；有序ID列表可以与搜索结果
+ * 做线性时间的集合求交。
+ */
+class CategoryIndex
+{
+public:
+    /**
+     * @brief 用完整商品列表重建索引
+     * @param products 商品列表
+     */
+    void rebuild(const QList<Product*>& products);
+
+    /**
+     * @brief 插入或更新一个商品的分类（分类变化时从旧分类移到新分类）
+     * @param productId 商品ID
+     * @param category 商品分类
+     * @return 如果索引发生变化返回true
+     */
+    bool upsert(int productId, const QString& category);
+
+    /**
+     * @brief 从索引中移除商品
+     * @param productId 商品ID
+     * @return 如果索引发生变化返回true
+     */
+    bool remove(int productId);
+
+    /**
+     * @brief 清空索引
+     */
+    void clear();
+
+    /**
+     * @brief 获取所有分类及其商品数量（按分类名排序）
+     * @return 分类名和数量的列表
+     */
+    QList<QPair<QString, int>> facetCounts() const;
+
+    /**
+     * @brief 获取分类下的商品数量
+     * @param category 分类名
+     * @return 商品数量
+     */
+    int count(const QString& category) const;
+
+    /**
+     * @brief 获取分类下的商品ID
+     * @param category 分类名
+     * @return 升序排列的商品ID列表
+     */
+    QList<int> productIds(const QString& category) const;
+
+    /**
+     * @brief 求两个升序ID列表的交集
+     * @param a 升序ID列表
+     * @param b 升序ID列表
+     * @return 升序排列的交集
+     */
+    static QList<int> intersect(const QList<int>& a, const QList<int>& b);
+
+private:
+    /**
+     * @brief 将商品ID按序插入分类列表
+     */
+    void insertSorted(const QString& category, int productId);
+
+    /**
+     * @brief 从分类列表中删除商品ID，列表为空时删除分类
+     */
+    void eraseSorted(const QString& category, int productId);
+
+    QHash<QString, QList<int>> m_idsByCategory;  ///< 分类到升序商品ID列表
+    QHash<int, QString> m_categoryById;          ///< 商品ID到分类的反向索引
+};
+
+#endif // CATEGORYINDEX_H
@@ -0,0 +1,182 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <QMetaType>
+#include <QString>
+#include <QtGlobal>
+#include <cmath>
+
+/**
+ * @brief Money类 - 定点金额
+ *
+ * 以最小货币单位（分）的64位整数保存金额。加减、按数量相乘都是精确的整数运算，
+ * 不会产生浮点累加误差，比较时也不需要容差。只有和界面输入框、数据库REAL列
+ * 交互时才与double互相转换，并且转换和按比例计算都要明确指定舍入方式。
+ */
+class Money
+{
+public:
+    /**
+     * @brief 舍入方式
+     */
+    enum class Rounding {
+        HalfUp,     ///< 四舍五入（0.5远离零）
+        HalfEven,   ///< 银行家舍入（0.5舍入到偶数）
+        Down,       ///< 向零截断
+        Up          ///< 远离零进位
+    };
+
+    static constexpr qint64 MinorPerMajor = 100;   ///< 每元的分数
+
+    constexpr Money() noexcept : m_minor(0) {}
+
+    /**
+     * @brief 从最小货币单位构造
+     * @param minorUnits 金额（分）
+     */
+    static constexpr Money fromMinorUnits(qint64 minorUnits) noexcept { return Money(minorUnits); }
+
+    /**
+     * @brief 从浮点金额（元）构造
+     *
+     * 先消除二进制表示误差（如0.285*100=28.4999...），再按指定方式舍入到分。
+     * @param amount 金额（元）
+     * @param rounding 舍入方式
+     */
+    static Money fromDouble(double amount, Rounding rounding = Rounding::HalfUp)
+    {
+        const double scaled = std::round(amount * MinorPerMajor * 1e6) / 1e6;
+        double whole = std::trunc(scaled);
+        const double fraction = std::fabs(scaled - whole);
+        const double away = scaled < 0 ? -1.0 : 1.0;
+
+        if (fraction > 0.0) {
+            switch (rounding) {
+            case Rounding::HalfUp:
+                if (fraction >= 0.5) whole += away;
+                break;
+            case Rounding::HalfEven:
+                if (fraction > 0.5 || (fraction == 0.5 && std::fmod(whole, 2.0) != 0.0)) whole += away;
+                break;
+            case Rounding::Down:
+                break;
+            case Rounding::Up:
+                whole += away;
+                break;
+            }
+        }
+        return Money(static_cast<qint64>(whole));
+    }
+
+    constexpr qint64 minorUnits() const noexcept { return m_minor; }
+
+    /**
+     * @brief 转换为浮点金额（元），仅用于界面输入框和REAL列
+     */
+    double toDouble() const noexcept { return static_cast<double>(m_minor) / MinorPerMajor; }
+
+    /**
+     * @brief 格式化为两位小数的字符串，如 "-12.34"
+     */
+    QString toString() const
+    {
+        const qint64 magnitude = m_minor < 0 ? -m_minor : m_minor;
+        return QString("%1%2.%3")
+               .arg(m_minor < 0 ? "-" : "")
+               .arg(magnitude / MinorPerMajor)
+               .arg(magnitude % MinorPerMajor, 2, 10, QChar('0'));
+    }
+
+    constexpr bool isZero() const noexcept { return m_minor == 0; }
+    constexpr bool isNegative() const noexcept { return m_minor < 0; }
+    constexpr bool isPositive() const noexcept { return m_minor > 0; }
+    constexpr Money abs() const noexcept { return Money(m_minor < 0 ? -m_minor : m_minor); }
+
+    /**
+     * @brief 按百分比计算金额（如折扣），百分比精确到0.01%
+     * @param percentage 百分比（0-100）
+     * @param rounding 舍入方式
+     * @return 金额的percentage%
+     */
+    Money percentOf(double percentage, Rounding rounding = Rounding::HalfUp) const
+    {
+        const qint64 basisPoints = static_cast<qint64>(std::llround(percentage * 100.0));
+        return Money(divideRounded(m_minor * basisPoints, 10000, rounding));
+    }
+
+    /**
+     * @brief 对若干金额求和
+     *
+     * 整数加法满足结合律，编译器可以把这个循环向量化；double累加则不行。
+     * @param values 连续存放的金额
+     * @param count 数量
+     * @return 总和
+     */
+    static Money sum(const Money* values, qsizetype count) noexcept
+    {
+        qint64 total = 0;
+        for (qsizetype i = 0; i < count; ++i) {
+            total += values[i].m_minor;
+        }
+        return Money(total);
+    }
+
+    /**
+     * @brief 带舍入的整数除法
+     * @param numerator 被除数
+     * @param denominator 除数（必须大于0）
+     * @param rounding 舍入方式
+     * @return 商
+     */
+    static constexpr qint64 divideRounded(qint64 numerator, qint64 denominator, Rounding rounding)
+    {
+        const qint64 quotient = numerator / denominator;
+        const qint64 remainder = numerator % denominator;
+        if (remainder == 0) {
+            return quotient;
+        }
+
+        const qint64 away = numerator < 0 ? -1 : 1;
+        const qint64 twiceRemainder = 2 * (remainder < 0 ? -remainder : remainder);
+        switch (rounding) {
+        case Rounding::HalfUp:
+            return twiceRemainder >= denominator ? quotient + away : quotient;
+        case Rounding::HalfEven:
+            if (twiceRemainder == denominator) {
+                return (quotient % 2 != 0) ? quotient + away : quotient;
+            }
+            return twiceRemainder > denominator ? quotient + away : quotient;
+        case Rounding::Down:
+            return quotient;
+        case Rounding::Up:
+            return quotient + away;
+        }
+        return quotient;
+    }
+
+    constexpr Money& operator+=(Money other) noexcept { m_minor += other.m_minor; return *this; }
+    constexpr Money& operator-=(Money other) noexcept { m_minor -= other.m_minor; return *this; }
+    constexpr Money& operator*=(qint64 quantity) noexcept { m_minor *= quantity; return *this; }
+
+    friend constexpr Money operator+(Money a, Money b) noexcept { return Money(a.m_minor + b.m_minor); }
+    friend constexpr Money operator-(Money a, Money b) noexcept { return Money(a.m_minor - b.m_minor); }
+    friend constexpr Money operator-(Money a) noexcept { return Money(-a.m_minor); }
+    friend constexpr Money operator*(Money a, qint64 quantity) noexcept { return Money(a.m_minor * quantity); }
+    friend constexpr Money operator*(qint64 quantity, Money a) noexcept { return Money(a.m_minor * quantity); }
+
+    friend constexpr bool operator==(Money a, Money b) noexcept { return a.m_minor == b.m_minor; }
+    friend constexpr bool operator!=(Money a, Money b) noexcept { return a.m_minor != b.m_minor; }
+    friend constexpr bool operator<(Money a, Money b) noexcept { return a.m_minor < b.m_minor; }
+    friend constexpr bool operator<=(Money a, Money b) noexcept { return a.m_minor <= b.m_minor; }
+    friend constexpr bool operator>(Money a, Money b) noexcept { return a.m_minor > b.m_minor; }
+    friend constexpr bool operator>=(Money a, Money b) noexcept { return a.m_minor >= b.m_minor; }
+
+private:
+    constexpr explicit Money(qint64 minorUnits) noexcept : m_minor(minorUnits) {}
+
+    qint64 m_minor;     ///< 金额（分）
+};
+
+Q_DECLARE_METATYPE(Money)
+
+#endif // MONEY_H
@@ -4,14 +4,14 @@
 Product::Product(QObject *parent)
     : QObject(parent)
     , m_productId(-1)
-    , m_price(0.0)
+    , m_price()
     , m_stockQuantity(0)
     , m_imagePath("") // Default empty path
 {
 }
 
 Product::Product(int productId, const QString& barcode, const QString& name,
-                const QString& description, double price, int stockQuantity,
+                const QString& description, Money price, int stockQuantity,
                 const QString& category, QObject *parent)
     : QObject(parent)
     , m_productId(productId)
@@ -87,9 +87,9 @@ void Product::setDescription(const QString& description)
     }
 }
 
-void Product::setPrice(double price)
+void Product::setPrice(Money price)
 {
-    if (qAbs(m_price - price) > 0.01) { // 避免浮点数比较问题
+    if (m_price != price) {
         m_price = price;
         emit productChanged();
     }
@@ -130,7 +130,7 @@ bool Product::isValid() const
 {
     return !m_barcode.isEmpty() && 
            !m_name.isEmpty() && 
-           m_price >= 0.0 &&
+           !m_price.isNegative() &&
            m_stockQuantity >= 0;
 }
 
@@ -176,7 +176,7 @@ QString Product::toString() const
            .arg(m_productId)
            .arg(m_barcode)
            .arg(m_name)
-           .arg(m_price, 0, 'f', 2)
+           .arg(m_price.toString())
            .arg(m_stockQuantity)
            .arg(m_category)
            .arg(m_imagePath);
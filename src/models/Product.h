@@ -3,6 +3,7 @@
 
 #include <QObject>
 #include <QString>
+#include "Money.h"
 
 /**
  * @brief Product类 - 商品数据模型
@@ -32,7 +33,7 @@ public:
      * @param parent 父对象指针
      */
     Product(int productId, const QString& barcode, const QString& name,
-           const QString& description, double price, int stockQuantity,
+           const QString& description, Money price, int stockQuantity,
            const QString& category, QObject *parent = nullptr);
            
     // 拷贝构造函数
@@ -46,7 +47,7 @@ public:
     QString getBarcode() const { return m_barcode; }
     QString getName() const { return m_name; }
     QString getDescription() const { return m_description; }
-    double getPrice() const { return m_price; }
+    Money getPrice() const { return m_price; }
     int getStockQuantity() const { return m_stockQuantity; }
     QString getCategory() const { return m_category; }
     QString getImagePath() const { return m_imagePath; }
@@ -56,7 +57,7 @@ public:
     void setBarcode(const QString& barcode);
     void setName(const QString& name);
     void setDescription(const QString& description);
-    void setPrice(double price);
+    void setPrice(Money price);
     void setStockQuantity(int stockQuantity);
     void setCategory(const QString& category);
     void setImagePath(const QString& imagePath);
@@ -109,7 +110,7 @@ private:
     QString m_barcode;      ///< 条形码
     QString m_name;         ///< 商品名称
     QString m_description;  ///< 商品描述
-    double m_price;         ///< 价格
+    Money m_price;          ///< 价格
     int m_stockQuantity;    ///< 库存数量
     QString m_category;     ///< 商品分类
     QString m_imagePath;    ///< 商品图片路径
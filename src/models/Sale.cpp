@@ -1,4 +1,5 @@
 #include "Sale.h"
+#include "../utils/Logging.h"
 #include <QDebug>
 #include <algorithm>
 
@@ -6,38 +7,49 @@ Sale::Sale(QObject *parent)
     : QObject(parent)
     , m_transactionId(-1)
     , m_customer(nullptr)
-    , m_totalAmount(0.0)
-    , m_discountAmount(0.0)
+    , m_totalAmount()
+    , m_discountAmount()
+    , m_promotionDiscount()
     , m_paymentMethod(Cash)
     , m_status(InProgress)
     , m_timestamp(QDateTime::currentDateTime())
+    , m_updateDepth(0)
+    , m_saleChangedPending(false)
+    , m_totalChangedPending(false)
 {
-    qDebug() << "Sale 构造, this:" << this << ", parent:" << parent;
-    qDebug() << "Sale 构造, m_items.size:" << m_items.size();
+    POS_TRACE(lcSale) << "Sale 构造, this:" << this << ", parent:" << parent;
+    POS_TRACE(lcSale) << "Sale 构造, m_items.size:" << m_items.size();
 }
 
 Sale::Sale(const Sale& other)
     : QObject(nullptr) // A copied sale shouldn't have a parent initially.
     , m_transactionId(other.m_transactionId)
     , m_customer(other.m_customer) // Shallow copy of customer is acceptable here.
-    , m_totalAmount(other.m_totalAmount)
+    , m_totalAmount() // Re-accumulated from the copied items below
     , m_discountAmount(other.m_discountAmount)
+    , m_promotionDiscount(other.m_promotionDiscount)
     , m_paymentMethod(other.m_paymentMethod)
     , m_status(other.m_status)
     , m_timestamp(other.m_timestamp)
     , m_cashierName(other.m_cashierName)
+    , m_updateDepth(0)
+    , m_saleChangedPending(false)
+    , m_totalChangedPending(false)
 {
     // Deep copy of the sale items
     for (SaleItem* item : other.m_items) {
         SaleItem* newItem = new SaleItem(*item);
         newItem->setParent(this); // The new Sale owns the new SaleItem
+        indexItem(newItem, m_items.size());
         m_items.append(newItem);
+        trackItem(newItem);
     }
+    m_totalChangedPending = false;
 }
 
 Sale::~Sale()
 {
-    qDebug() << "Sale 析构, this:" << this;
+    POS_TRACE(lcSale) << "Sale 析构, this:" << this;
     // No need to manually delete child QObjects. Qt's parent-child
     // memory management system will handle the deletion of m_items
     // automatically since they were created with this Sale object as their parent.
@@ -49,11 +61,15 @@ Sale::Sale(int transactionId, Customer* customer, QObject *parent)
     : QObject(parent)
     , m_transactionId(transactionId)
     , m_customer(customer)
-    , m_totalAmount(0.0)
-    , m_discountAmount(0.0)
+    , m_totalAmount()
+    , m_discountAmount()
+    , m_promotionDiscount()
     , m_paymentMethod(Cash)
     , m_status(InProgress)
     , m_timestamp(QDateTime::currentDateTime())
+    , m_updateDepth(0)
+    , m_saleChangedPending(false)
+    , m_totalChangedPending(false)
 {
 }
 
@@ -61,7 +77,8 @@ void Sale::setTransactionId(int transactionId)
 {
     if (m_transactionId != transactionId) {
         m_transactionId = transactionId;
-        emit saleChanged();
+        markSaleChanged();
+        flushChanges();
     }
 }
 
@@ -69,7 +86,8 @@ void Sale::setCustomer(Customer* customer)
 {
     if (m_customer != customer) {
         m_customer = customer;
-        emit saleChanged();
+        markSaleChanged();
+        flushChanges();
     }
 }
 
@@ -77,7 +95,8 @@ void Sale::setPaymentMethod(PaymentMethod method)
 {
     if (m_paymentMethod != method) {
         m_paymentMethod = method;
-        emit saleChanged();
+        markSaleChanged();
+        flushChanges();
     }
 }
 
@@ -85,7 +104,8 @@ void Sale::setStatus(TransactionStatus status)
 {
     if (m_status != status) {
         m_status = status;
-        emit saleChanged();
+        markSaleChanged();
+        flushChanges();
     }
 }
 
@@ -93,7 +113,8 @@ void Sale::setTimestamp(const QDateTime& timestamp)
 {
     if (m_timestamp != timestamp) {
         m_timestamp = timestamp;
-        emit saleChanged();
+        markSaleChanged();
+        flushChanges();
     }
 }
 
@@ -101,18 +122,35 @@ void Sale::setCashierName(const QString& cashierName)
 {
     if (m_cashierName != cashierName) {
         m_cashierName = cashierName;
-        emit saleChanged();
+        markSaleChanged();
+        flushChanges();
     }
 }
 
-void Sale::setDiscountAmount(double discount)
+void Sale::setDiscountAmount(Money discount)
 {
-    if (qAbs(m_discountAmount - discount) > 0.01 && discount >= 0.0) {
+    if (m_discountAmount != discount && !discount.isNegative()) {
         m_discountAmount = discount;
-        calculateTotal(); // Recalculate and emit signals
+        m_totalChangedPending = true;
+        flushChanges();
     }
 }
 
+void Sale::setPromotionDiscount(Money discount)
+{
+    if (m_promotionDiscount != discount && !discount.isNegative()) {
+        m_promotionDiscount = discount;
+        m_totalChangedPending = true;
+        flushChanges();
+    }
+}
+
+Money Sale::getFinalAmount() const
+{
+    Money finalAmount = m_totalAmount - m_discountAmount - m_promotionDiscount;
+    return finalAmount.isNegative() ? Money() : finalAmount;
+}
+
 void Sale::addItem(SaleItem* item)
 {
     if (!item || !item->isValid()) {
@@ -126,15 +164,16 @@ void Sale::addItem(SaleItem* item)
         item->setParent(this);
     }
 
+    indexItem(item, m_items.size());
     m_items.append(item);
-    
-    connect(item, &SaleItem::itemChanged, this, &Sale::calculateTotal);
+    trackItem(item);
 
     emit itemAdded(item);
-    calculateTotal();
+    markSaleChanged();
+    flushChanges();
 }
 
-void Sale::addItem(Product* product, int quantity, double unitPrice)
+void Sale::addItem(Product* product, int quantity, Money unitPrice)
 {
     if (!product || quantity <= 0) {
         qWarning() << "尝试添加无效的销售项目";
@@ -142,33 +181,25 @@ void Sale::addItem(Product* product, int quantity, double unitPrice)
     }
     
     // 如果没有指定单价，使用商品当前价格
-    if (unitPrice <= 0.0) {
+    if (!unitPrice.isPositive()) {
         unitPrice = product->getPrice();
     }
     
-    // 检查是否已存在相同商品的项目
-    for (SaleItem* item : m_items) {
-        if (item->getProduct() == product && 
-            qAbs(item->getUnitPrice() - unitPrice) < 0.01) {
-            // 增加数量而不是创建新项目
-            item->setQuantity(item->getQuantity() + quantity);
-            // After quantity is set, we need to manually trigger the recalculation and signaling
-            calculateTotal();
-            return;
-        }
+    // 同一商品、同一单价的行已存在：增加数量而不是创建新项目，总额由onItemChanged按差值更新
+    if (SaleItem* existing = findMergeTarget(product, unitPrice)) {
+        existing->setQuantity(existing->getQuantity() + quantity);
+        return;
     }
     
     // 创建新的销售项目
     SaleItem* newItem = new SaleItem(product, quantity, unitPrice, this);
-    
-    // 连接信号
-    connect(newItem, &SaleItem::itemChanged, this, &Sale::calculateTotal);
-    
+    indexItem(newItem, m_items.size());
     m_items.append(newItem);
+    trackItem(newItem);
     
     emit itemAdded(newItem);
-    // No longer emit saleChanged() here, calculateTotal will do it.
-    calculateTotal(); // Update totals
+    markSaleChanged();
+    flushChanges();
 }
 
 bool Sale::removeItem(int index)
@@ -179,14 +210,17 @@ bool Sale::removeItem(int index)
     }
     
     SaleItem* item = m_items.takeAt(index);
+    m_totalAmount -= m_contributions.take(item);
+    unindexRow(index, item);
     // 直接删除，不使用deleteLater()
     delete item;
     
     emit itemRemoved(index);
-    // No longer emit saleChanged() here, calculateTotal will do it.
-    calculateTotal(); // Update totals
+    m_totalChangedPending = true;
+    markSaleChanged();
+    flushChanges();
     
-    qDebug() << "移除销售项目，索引:" << index;
+    qCDebug(lcSale) << "移除销售项目，索引:" << index;
     return true;
 }
 
@@ -196,10 +230,9 @@ bool Sale::removeItem(Product* product)
         return false;
     }
     
-    for (int i = 0; i < m_items.size(); ++i) {
-        if (m_items[i]->getProduct() == product) {
-            return removeItem(i);
-        }
+    int index = indexOfProduct(product->getProductId());
+    if (index >= 0) {
+        return removeItem(index);
     }
     
     qWarning() << "未找到要移除的商品:" << product->getName();
@@ -219,8 +252,7 @@ bool Sale::updateItemQuantity(int index, int quantity)
     }
     
     m_items[index]->setQuantity(quantity);
-    // setQuantity will trigger itemChanged, which calls calculateTotal.
-    // So no extra call is needed here, the connection handles it.
+    // setQuantity triggers itemChanged, which updates the total by delta.
     return true;
 }
 
@@ -231,26 +263,218 @@ void Sale::clearItems()
         delete item;
     }
     m_items.clear();
+    m_contributions.clear();
+    m_rowByProductId.clear();
+    m_lineCountByProductId.clear();
+    m_totalAmount = Money();
     
-    // No longer emit saleChanged() here, calculateTotal will do it.
-    calculateTotal();
+    m_totalChangedPending = true;
+    markSaleChanged();
+    flushChanges();
     
-    qDebug() << "清空所有销售项目";
+    qCDebug(lcSale) << "清空所有销售项目";
 }
 
 void Sale::calculateTotal()
 {
-    m_totalAmount = 0.0;
+    m_contributions.clear();
+    rebuildIndex();
     
+    QVarLengthArray<Money, 64> subtotals;
+    subtotals.reserve(m_items.size());
     for (const SaleItem* item : m_items) {
-        if (item->isValid()) {
-            m_totalAmount += item->getSubtotal();
-        }
+        Money contribution = contributionOf(item);
+        m_contributions.insert(item, contribution);
+        subtotals.append(contribution);
     }
+    m_totalAmount = Money::sum(subtotals.constData(), subtotals.size());
     
-    // Always emit both signals to ensure all listeners are updated
-    emit totalChanged(getFinalAmount());
-    emit saleChanged();
+    m_totalChangedPending = true;
+    markSaleChanged();
+    flushChanges();
+}
+
+void Sale::beginUpdate()
+{
+    ++m_updateDepth;
+}
+
+void Sale::endUpdate()
+{
+    if (m_updateDepth <= 0) {
+        qWarning() << "Sale::endUpdate called without matching beginUpdate";
+        return;
+    }
+    --m_updateDepth;
+    flushChanges();
+}
+
+void Sale::onItemChanged()
+{
+    auto* item = qobject_cast<SaleItem*>(sender());
+    if (!item || !m_contributions.contains(item)) {
+        return;
+    }
+
+    // 只按该项目的差值调整总额，不再遍历全部项目
+    Money contribution = contributionOf(item);
+    Money& previous = m_contributions[item];
+    if (contribution != previous) {
+        m_totalAmount += contribution - previous;
+        previous = contribution;
+        m_totalChangedPending = true;
+    }
+
+    // 通过商品索引定位行号；同一商品有多行（单价不同）时退回线性查找
+    int row = item->getProduct() ? indexOfProduct(item->getProduct()->getProductId()) : -1;
+    if (row < 0 || m_items.at(row) != item) {
+        row = m_items.indexOf(item);
+    }
+    if (row >= 0) {
+        m_changedRows.insert(row);
+    }
+    flushChanges();
+}
+
+void Sale::trackItem(SaleItem* item)
+{
+    Money contribution = contributionOf(item);
+    m_contributions.insert(item, contribution);
+    m_totalAmount += contribution;
+    m_totalChangedPending = true;
+    connect(item, &SaleItem::itemChanged, this, &Sale::onItemChanged, Qt::UniqueConnection);
+}
+
+void Sale::indexItem(const SaleItem* item, int row)
+{
+    if (!item || !item->getProduct()) {
+        return;
+    }
+    const int productId = item->getProduct()->getProductId();
+    if (!m_rowByProductId.contains(productId)) {
+        m_rowByProductId.insert(productId, row);
+    }
+    ++m_lineCountByProductId[productId];
+}
+
+void Sale::unindexRow(int removedRow, const SaleItem* removed)
+{
+    // 被移除的是该商品的第一行时先撤销其索引，下面遇到的同商品行即成为新的第一行
+    if (removed && removed->getProduct()) {
+        const int productId = removed->getProduct()->getProductId();
+        if (--m_lineCountByProductId[productId] <= 0) {
+            m_lineCountByProductId.remove(productId);
+        }
+        if (m_rowByProductId.value(productId, -1) == removedRow) {
+            m_rowByProductId.remove(productId);
+        }
+    }
+
+    // 只有被移除行之后的行号会变化；每个商品的索引只指向其第一行
+    for (int row = removedRow; row < m_items.size(); ++row) {
+        const SaleItem* item = m_items.at(row);
+        if (!item->getProduct()) {
+            continue;
+        }
+        const int productId = item->getProduct()->getProductId();
+        auto it = m_rowByProductId.find(productId);
+        if (it == m_rowByProductId.end()) {
+            m_rowByProductId.insert(productId, row);
+        } else if (it.value() == row + 1) {
+            it.value() = row;
+        }
+    }
+}
+
+void Sale::rebuildIndex()
+{
+    m_rowByProductId.clear();
+    m_lineCountByProductId.clear();
+    for (int row = 0; row < m_items.size(); ++row) {
+        indexItem(m_items.at(row), row);
+    }
+}
+
+SaleItem* Sale::findMergeTarget(const Product* product, Money unitPrice) const
+{
+    const int productId = product->getProductId();
+    const int firstRow = indexOfProduct(productId);
+    if (firstRow < 0) {
+        return nullptr;
+    }
+
+    // 常见情况下每个商品只有一行，直接比较；否则只在该商品第一行之后查找
+    SaleItem* first = m_items.at(firstRow);
+    if (first->getProduct() == product && first->getUnitPrice() == unitPrice) {
+        return first;
+    }
+    if (m_lineCountByProductId.value(productId) > 1) {
+        for (int row = firstRow + 1; row < m_items.size(); ++row) {
+            SaleItem* item = m_items.at(row);
+            if (item->getProduct() == product && item->getUnitPrice() == unitPrice) {
+                return item;
+            }
+        }
+    }
+    return nullptr;
+}
+
+int Sale::quantityOfProduct(int productId) const
+{
+    const int firstRow = indexOfProduct(productId);
+    if (firstRow < 0) {
+        return 0;
+    }
+    if (m_lineCountByProductId.value(productId) <= 1) {
+        return m_items.at(firstRow)->getQuantity();
+    }
+
+    int quantity = 0;
+    for (int row = firstRow; row < m_items.size(); ++row) {
+        const SaleItem* item = m_items.at(row);
+        if (item->getProduct() && item->getProduct()->getProductId() == productId) {
+            quantity += item->getQuantity();
+        }
+    }
+    return quantity;
+}
+
+Money Sale::contributionOf(const SaleItem* item)
+{
+    return (item && item->isValid()) ? item->getSubtotal() : Money();
+}
+
+void Sale::markSaleChanged()
+{
+    m_saleChangedPending = true;
+}
+
+void Sale::flushChanges()
+{
+    if (m_updateDepth > 0) {
+        return;
+    }
+
+    bool saleChangedPending = m_saleChangedPending;
+    bool totalChangedPending = m_totalChangedPending;
+    QList<int> rows;
+    if (!saleChangedPending && !m_changedRows.isEmpty()) {
+        rows = m_changedRows.values();
+        std::sort(rows.begin(), rows.end());
+    }
+    m_saleChangedPending = false;
+    m_totalChangedPending = false;
+    m_changedRows.clear();
+
+    // 结构变化需要整体刷新，已包含所有原地变化的行
+    if (saleChangedPending) {
+        emit saleChanged();
+    } else if (!rows.isEmpty()) {
+        emit itemsChanged(rows);
+    }
+    if (totalChangedPending) {
+        emit totalChanged(getFinalAmount());
+    }
 }
 
 bool Sale::isEmpty() const
@@ -274,21 +498,27 @@ void Sale::applyPercentageDiscount(double percentage)
         return;
     }
     
-    double discount = m_totalAmount * (percentage / 100.0);
+    // 手工折扣作用于促销之后的金额，避免对促销已经优惠的部分再打一次折
+    Money base = m_totalAmount - m_promotionDiscount;
+    if (base.isNegative()) {
+        base = Money();
+    }
+    Money discount = base.percentOf(percentage, Money::Rounding::HalfUp);
     setDiscountAmount(discount);
     
-    qDebug() << "应用百分比折扣:" << percentage << "% 折扣金额:" << discount;
+    qCDebug(lcSale) << "应用百分比折扣:" << percentage << "% 折扣金额:" << discount.toString();
 }
 
-void Sale::applyFixedDiscount(double amount)
+bool Sale::applyFixedDiscount(Money amount)
 {
-    if (amount < 0.0 || amount > m_totalAmount) {
-        qWarning() << "无效的折扣金额:" << amount;
-        return;
+    if (amount.isNegative() || amount > m_totalAmount - m_promotionDiscount) {
+        qWarning() << "无效的折扣金额:" << amount.toString();
+        return false;
     }
     
     setDiscountAmount(amount);
-    qDebug() << "应用固定金额折扣:" << amount;
+    qCDebug(lcSale) << "应用固定金额折扣:" << amount.toString();
+    return true;
 }
 
 QString Sale::paymentMethodToString(PaymentMethod method)
@@ -317,21 +547,13 @@ Sale::PaymentMethod Sale::stringToPaymentMethod(const QString& str)
 
 QString Sale::toString() const
 {
-    return QString("Sale[ID:%1, Items:%2, Total:%3, Discount:%4, Final:%5, Payment:%6, Status:%7]")
+    return QString("Sale[ID:%1, Items:%2, Total:%3, Discount:%4, Promotion:%5, Final:%6, Payment:%7, Status:%8]")
            .arg(m_transactionId)
            .arg(m_items.size())
-           .arg(m_totalAmount, 0, 'f', 2)
-           .arg(m_discountAmount, 0, 'f', 2)
-           .arg(getFinalAmount(), 0, 'f', 2)
+           .arg(m_totalAmount.toString())
+           .arg(m_discountAmount.toString())
+           .arg(m_promotionDiscount.toString())
+           .arg(getFinalAmount().toString())
            .arg(paymentMethodToString(m_paymentMethod))
            .arg(static_cast<int>(m_status));
 }
-
-QList<SaleItem*> Sale::getItems() const
-{
-    qDebug() << "Sale::getItems called, this:" << this << ", m_items.size:" << m_items.size();
-    for (auto* item : m_items) {
-        qDebug() << "Sale::getItems item ptr:" << item;
-    }
-    return m_items;
-}
@@ -3,9 +3,13 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QSet>
+#include <QVarLengthArray>
 #include <QDateTime>
 #include "SaleItem.h"
 #include "Customer.h"
+#include "Money.h"
 
 /**
  * @brief Sale类 - 销售交易数据模型
@@ -69,10 +73,16 @@ public:
     // Getter 方法
     int getTransactionId() const { return m_transactionId; }
     Customer* getCustomer() const { return m_customer; }
-    QList<SaleItem*> getItems() const;
-    double getTotalAmount() const { return m_totalAmount; }
-    double getDiscountAmount() const { return m_discountAmount; }
-    double getFinalAmount() const { return m_totalAmount - m_discountAmount; }
+    const QList<SaleItem*>& getItems() const { return m_items; } ///< 只读视图，不复制列表
+    int itemCount() const { return m_items.size(); }
+    SaleItem* itemAt(int index) const { return m_items.value(index, nullptr); }
+    int indexOfProduct(int productId) const { return m_rowByProductId.value(productId, -1); } ///< O(1)，不在购物车中返回-1
+    SaleItem* findItem(int productId) const { return m_items.value(indexOfProduct(productId), nullptr); }
+    int quantityOfProduct(int productId) const; ///< 该商品所有行的数量之和
+    Money getTotalAmount() const { return m_totalAmount; }
+    Money getDiscountAmount() const { return m_discountAmount; }
+    Money getPromotionDiscount() const { return m_promotionDiscount; }
+    Money getFinalAmount() const;
     PaymentMethod getPaymentMethod() const { return m_paymentMethod; }
     TransactionStatus getStatus() const { return m_status; }
     QDateTime getTimestamp() const { return m_timestamp; }
@@ -85,7 +95,13 @@ public:
     void setStatus(TransactionStatus status);
     void setTimestamp(const QDateTime& timestamp);
     void setCashierName(const QString& cashierName);
-    void setDiscountAmount(double discount);
+    void setDiscountAmount(Money discount);
+    
+    /**
+     * @brief 设置促销优惠金额（由促销引擎计算，与手工折扣分开保存）
+     * @param discount 促销优惠金额
+     */
+    void setPromotionDiscount(Money discount);
     
     /**
      * @brief 添加销售项目
@@ -95,11 +111,13 @@ public:
     
     /**
      * @brief 添加销售项目
+     *
+     * 同一商品以相同单价再次加入时只增加已有行的数量；单价不同则新开一行。
      * @param product 商品指针
      * @param quantity 数量
      * @param unitPrice 单价（如果为0则使用商品当前价格）
      */
-    void addItem(Product* product, int quantity, double unitPrice = 0.0);
+    void addItem(Product* product, int quantity, Money unitPrice = Money());
     
     /**
      * @brief 移除销售项目
@@ -129,10 +147,32 @@ public:
     void clearItems();
     
     /**
-     * @brief 计算总金额
+     * @brief 重新计算总金额
+     *
+     * 日常的增删改通过增量维护总金额，无需调用此函数；
+     * 仅在需要与项目列表完全重新同步时使用。
      */
     void calculateTotal();
     
+    /**
+     * @brief 开始批量更新
+     *
+     * 批量更新期间只累积变化，不发射通知。与endUpdate()成对调用，可以嵌套，
+     * 最外层的endUpdate()合并发射一次通知。
+     */
+    void beginUpdate();
+    
+    /**
+     * @brief 结束批量更新
+     */
+    void endUpdate();
+    
+    /**
+     * @brief 是否处于批量更新中
+     * @return 如果处于批量更新中返回true
+     */
+    bool isUpdating() const { return m_updateDepth > 0; }
+    
     /**
      * @brief 检查销售是否为空
      * @return 如果没有销售项目返回true
@@ -146,16 +186,17 @@ public:
     int getTotalItemCount() const;
     
     /**
-     * @brief 应用百分比折扣
-     * @param percentage 折扣百分比（0-100）
+     * @brief 应用百分比折扣（按扣除促销优惠后的金额计算）
+     * @param percentage 折扣百分比（0-100），折扣金额四舍五入到分
      */
     void applyPercentageDiscount(double percentage);
     
     /**
      * @brief 应用固定金额折扣
-     * @param amount 折扣金额
+     * @param amount 折扣金额（不超过扣除促销优惠后的金额）
+     * @return 如果金额有效并已应用返回true
      */
-    void applyFixedDiscount(double amount);
+    bool applyFixedDiscount(Money amount);
     
     /**
      * @brief 支付方式转字符串
@@ -183,6 +224,14 @@ signals:
      */
     void saleChanged();
     
+    /**
+     * @brief 项目原地发生变化（数量、单价）时发射的信号
+     *
+     * 只在项目列表结构未变化时发射，结构变化时改为发射saleChanged()。
+     * @param rows 发生变化的项目索引（升序）
+     */
+    void itemsChanged(const QList<int>& rows);
+    
     /**
      * @brief 添加项目时发射的信号
      * @param item 新添加的项目
@@ -199,18 +248,81 @@ signals:
      * @brief 总金额变化时发射的信号
      * @param newTotal 新的总金额
      */
-    void totalChanged(double newTotal);
+    void totalChanged(Money newTotal);
+
+private slots:
+    /**
+     * @brief 处理单个项目的变化，按差值更新总金额
+     */
+    void onItemChanged();
 
 private:
+    /**
+     * @brief 开始跟踪项目（连接信号并记录其计入总额的金额）
+     * @param item 销售项目
+     */
+    void trackItem(SaleItem* item);
+    
+    /**
+     * @brief 把项目登记到商品索引（商品已有对应行时保留原行，只增加行数）
+     * @param item 销售项目
+     * @param row 项目索引
+     */
+    void indexItem(const SaleItem* item, int row);
+    
+    /**
+     * @brief 移除一行后更新商品索引：只把该行之后的行号前移一位
+     * @param removedRow 被移除的行
+     * @param removed 被移除的项目（尚未删除）
+     */
+    void unindexRow(int removedRow, const SaleItem* removed);
+    
+    /**
+     * @brief 按当前项目列表重建整个商品索引
+     */
+    void rebuildIndex();
+    
+    /**
+     * @brief 查找同一商品、同一单价的行（用于合并数量）
+     * @return 找到的项目，没有返回nullptr
+     */
+    SaleItem* findMergeTarget(const Product* product, Money unitPrice) const;
+    
+    /**
+     * @brief 项目计入总额的金额（无效项目为0）
+     * @param item 销售项目
+     * @return 金额
+     */
+    static Money contributionOf(const SaleItem* item);
+    
+    /**
+     * @brief 标记销售结构或属性发生变化
+     */
+    void markSaleChanged();
+    
+    /**
+     * @brief 不在批量更新中时发射累积的通知
+     */
+    void flushChanges();
+
     int m_transactionId;            ///< 交易ID
     Customer* m_customer;           ///< 客户指针
     QList<SaleItem*> m_items;       ///< 销售项目列表
-    double m_totalAmount;           ///< 总金额
-    double m_discountAmount;        ///< 折扣金额
+    Money m_totalAmount;            ///< 总金额
+    Money m_discountAmount;         ///< 折扣金额
+    Money m_promotionDiscount;      ///< 促销优惠金额
     PaymentMethod m_paymentMethod;  ///< 支付方式
     TransactionStatus m_status;     ///< 交易状态
     QDateTime m_timestamp;          ///< 交易时间
     QString m_cashierName;          ///< 收银员姓名
+    
+    QHash<const SaleItem*, Money> m_contributions;  ///< 每个项目当前计入总额的金额
+    QHash<int, int> m_rowByProductId;   ///< 商品ID到其第一行的索引
+    QHash<int, int> m_lineCountByProductId; ///< 商品ID对应的行数（同一商品不同单价时多于1）
+    int m_updateDepth;              ///< 批量更新嵌套深度
+    QSet<int> m_changedRows;        ///< 待通知的原地变化项目
+    bool m_saleChangedPending;      ///< 是否有待通知的结构变化
+    bool m_totalChangedPending;     ///< 是否有待通知的总额变化
 };
 
 #endif // SALE_H
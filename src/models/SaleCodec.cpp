@@ -0,0 +1,94 @@
+#include "SaleCodec.h"
+#include "Sale.h"
+#include "SaleItem.h"
+#include "Product.h"
+#include <QDataStream>
+#include <QDebug>
+
+namespace {
+// 每行固定占用：商品ID(4) + 数量(4) + 单价(8)
+const qint64 LineSize = 16;
+}
+
+QByteArray SaleCodec::encode(const Sale& sale)
+{
+    QByteArray payload;
+    payload.reserve(16 + sale.itemCount() * LineSize);
+
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_6_0);
+    out << Magic << FormatVersion
+        << static_cast<qint64>(sale.getDiscountAmount().minorUnits())
+        << static_cast<qint32>(sale.itemCount());
+
+    for (const SaleItem* item : sale.getItems()) {
+        out << static_cast<qint32>(item->getProduct() ? item->getProduct()->getProductId() : -1)
+            << static_cast<qint32>(item->getQuantity())
+            << static_cast<qint64>(item->getUnitPrice().minorUnits());
+    }
+    return payload;
+}
+
+bool SaleCodec::decode(const QByteArray& payload, ParkedSaleData* data)
+{
+    if (!data) {
+        return false;
+    }
+
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_6_0);
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    qint64 discount = 0;
+    qint32 lineCount = 0;
+    in >> magic >> version >> discount >> lineCount;
+    if (in.status() != QDataStream::Ok || magic != Magic) {
+        qWarning() << "挂单数据格式无效";
+        return false;
+    }
+    if (version > FormatVersion) {
+        qWarning() << "不支持的挂单格式版本:" << version;
+        return false;
+    }
+    // 行数必须与剩余字节数相符，防止损坏的数据导致超大分配
+    if (lineCount < 0 || lineCount * LineSize > in.device()->bytesAvailable()) {
+        qWarning() << "挂单数据已损坏，行数:" << lineCount;
+        return false;
+    }
+
+    data->discountAmount = Money::fromMinorUnits(discount);
+    data->lines.clear();
+    data->lines.reserve(lineCount);
+    for (qint32 i = 0; i < lineCount; ++i) {
+        qint32 productId = 0;
+        qint32 quantity = 0;
+        qint64 unitPrice = 0;
+        in >> productId >> quantity >> unitPrice;
+        data->lines.append(ParkedSaleLine{productId, quantity, Money::fromMinorUnits(unitPrice)});
+    }
+    return in.status() == QDataStream::Ok;
+}
+
+int SaleCodec::restore(const ParkedSaleData& data, Sale* sale,
+                       const std::function<Product*(int)>& productLookup)
+{
+    if (!sale) {
+        return data.lines.size();
+    }
+
+    int missing = 0;
+    sale->beginUpdate();
+    for (const ParkedSaleLine& line : data.lines) {
+        Product* product = productLookup ? productLookup(line.productId) : nullptr;
+        if (!product || line.quantity <= 0) {
+            qWarning() << "恢复挂单时跳过不存在的商品:" << line.productId;
+            ++missing;
+            continue;
+        }
+        sale->addItem(new SaleItem(product, line.quantity, line.unitPrice, sale));
+    }
+    sale->setDiscountAmount(data.discountAmount);
+    sale->endUpdate();
+    return missing;
+}
@@ -0,0 +1,84 @@
+#ifndef SALECODEC_H
+#define SALECODEC_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <functional>
+#include "Money.h"
+
+class Product;
+class Sale;
+
+/**
+ * @brief 挂单中的一行（只保存商品ID，不保存商品对象）
+ */
+struct ParkedSaleLine
+{
+    int productId = -1;         ///< 商品ID
+    int quantity = 0;           ///< 数量
+    Money unitPrice;            ///< 挂单时的单价
+};
+
+/**
+ * @brief 解码后的挂单内容（纯数据，不含QObject）
+ */
+struct ParkedSaleData
+{
+    Money discountAmount;           ///< 手工折扣金额
+    QList<ParkedSaleLine> lines;    ///< 购物车行
+};
+
+/**
+ * @brief 挂单列表中的一条摘要
+ */
+struct ParkedSaleInfo
+{
+    int parkedId = -1;          ///< 挂单ID
+    QString label;              ///< 备注（如顾客特征）
+    int itemCount = 0;          ///< 商品总件数
+    Money totalAmount;          ///< 挂单时的应付金额
+    QDateTime parkedAt;         ///< 挂单时间（本地时间）
+};
+
+/**
+ * @brief SaleCodec类 - 销售的紧凑二进制编码
+ *
+ * 格式：魔数、格式版本、折扣（分）、行数，之后每行为 商品ID、数量、单价（分）。
+ * 解码只产生纯数据结构，不创建任何QObject；恢复到Sale时再按商品ID查找商品，
+ * 并在一次批量更新中重建全部项目。
+ */
+class SaleCodec
+{
+public:
+    static constexpr quint32 Magic = 0x53504B31;   ///< "SPK1"
+    static constexpr quint16 FormatVersion = 1;     ///< 当前格式版本
+
+    /**
+     * @brief 编码销售的购物车内容
+     * @param sale 销售对象
+     * @return 编码后的字节
+     */
+    static QByteArray encode(const Sale& sale);
+
+    /**
+     * @brief 解码挂单
+     * @param payload 编码后的字节
+     * @param data 输出的挂单内容
+     * @return 如果格式正确返回true
+     */
+    static bool decode(const QByteArray& payload, ParkedSaleData* data);
+
+    /**
+     * @brief 把挂单内容恢复到销售对象中（在一次批量更新内完成）
+     * @param data 挂单内容
+     * @param sale 目标销售对象（应为空）
+     * @param productLookup 按商品ID查找商品，找不到返回nullptr
+     * @return 未能恢复的行数（商品已不存在）
+     */
+    static int restore(const ParkedSaleData& data, Sale* sale,
+                       const std::function<Product*(int)>& productLookup);
+};
+
+#endif // SALECODEC_H
@@ -5,8 +5,8 @@ SaleItem::SaleItem(QObject *parent)
     : QObject(parent)
     , m_product(nullptr)
     , m_quantity(0)
-    , m_unitPrice(0.0)
-    , m_subtotal(0.0)
+    , m_unitPrice()
+    , m_subtotal()
 {
 }
 
@@ -22,12 +22,12 @@ SaleItem::SaleItem(const SaleItem& other)
     m_product->setParent(this);
 }
 
-SaleItem::SaleItem(Product* product, int quantity, double unitPrice, QObject *parent)
+SaleItem::SaleItem(Product* product, int quantity, Money unitPrice, QObject *parent)
     : QObject(parent)
     , m_product(product)
     , m_quantity(quantity)
     , m_unitPrice(unitPrice)
-    , m_subtotal(0.0)
+    , m_subtotal()
 {
     calculateSubtotal();
 }
@@ -50,9 +50,9 @@ void SaleItem::setQuantity(int quantity)
     }
 }
 
-void SaleItem::setUnitPrice(double unitPrice)
+void SaleItem::setUnitPrice(Money unitPrice)
 {
-    if (qAbs(m_unitPrice - unitPrice) > 0.01 && unitPrice >= 0.0) {
+    if (m_unitPrice != unitPrice && !unitPrice.isNegative()) {
         m_unitPrice = unitPrice;
         calculateSubtotal();
         emit itemChanged();
@@ -61,10 +61,10 @@ void SaleItem::setUnitPrice(double unitPrice)
 
 void SaleItem::calculateSubtotal()
 {
-    double oldSubtotal = m_subtotal;
-    m_subtotal = m_quantity * m_unitPrice;
+    Money oldSubtotal = m_subtotal;
+    m_subtotal = m_unitPrice * m_quantity;
     
-    if (qAbs(oldSubtotal - m_subtotal) > 0.01) {
+    if (oldSubtotal != m_subtotal) {
         emit subtotalChanged(m_subtotal);
     }
 }
@@ -73,7 +73,7 @@ bool SaleItem::isValid() const
 {
     return m_product != nullptr && 
            m_quantity > 0 && 
-           m_unitPrice >= 0.0 &&
+           !m_unitPrice.isNegative() &&
            m_product->isValid();
 }
 
@@ -83,6 +83,6 @@ QString SaleItem::toString() const
     return QString("SaleItem[Product:%1, Quantity:%2, UnitPrice:%3, Subtotal:%4]")
            .arg(productName)
            .arg(m_quantity)
-           .arg(m_unitPrice, 0, 'f', 2)
-           .arg(m_subtotal, 0, 'f', 2);
+           .arg(m_unitPrice.toString())
+           .arg(m_subtotal.toString());
 }
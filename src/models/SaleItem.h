@@ -29,18 +29,18 @@ public:
      * @param unitPrice 单价（销售时的价格）
      * @param parent 父对象指针
      */
-    SaleItem(Product* product, int quantity, double unitPrice, QObject *parent = nullptr);
+    SaleItem(Product* product, int quantity, Money unitPrice, QObject *parent = nullptr);
     
     // Getter 方法
     Product* getProduct() const { return m_product; }
     int getQuantity() const { return m_quantity; }
-    double getUnitPrice() const { return m_unitPrice; }
-    double getSubtotal() const { return m_subtotal; }
+    Money getUnitPrice() const { return m_unitPrice; }
+    Money getSubtotal() const { return m_subtotal; }
     
     // Setter 方法
     void setProduct(Product* product);
     void setQuantity(int quantity);
-    void setUnitPrice(double unitPrice);
+    void setUnitPrice(Money unitPrice);
     
     /**
      * @brief 计算小计
@@ -69,13 +69,13 @@ signals:
      * @brief 小计发生变化时发射的信号
      * @param newSubtotal 新的小计金额
      */
-    void subtotalChanged(double newSubtotal);
+    void subtotalChanged(Money newSubtotal);
 
 private:
     Product* m_product;     ///< 商品指针
     int m_quantity;         ///< 数量
-    double m_unitPrice;     ///< 单价（销售时的价格）
-    double m_subtotal;      ///< 小计金额
+    Money m_unitPrice;      ///< 单价（销售时的价格）
+    Money m_subtotal;       ///< 小计金额
 };
 
 #endif // SALEITEM_H
@@ -0,0 +1,517 @@
+#include "ElectronicJournal.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QtEndian>
+#include <QDebug>
+#include <algorithm>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 文件头：魔数 + 格式版本，小端
+constexpr quint32 DataMagic = 0x314A4553;       // "SEJ1"
+constexpr quint32 IndexMagic = 0x58514A45;      // "EJQX"
+constexpr quint32 TailMagic = 0x574A4553;       // "SEJW"
+constexpr quint32 FormatVersion = 1;
+constexpr qint64 FileHeaderSize = 8;
+
+// 数据块头：压缩后字节数、未压缩字节数
+constexpr qint64 BlockHeaderSize = 8;
+
+// 索引记录：交易ID(4) 保留(4) 时间(8) 块偏移(8) 块内偏移(4) 长度(4)
+constexpr qint64 IndexRecordSize = 32;
+
+// 预写尾部：文件头之后是基准记录数(8)，即尾部第一条小票在全部记录中的下标；
+// 之后每条小票为 交易ID(4) 长度(4) 时间(8) 加UTF-8文本
+constexpr qint64 TailHeaderSize = FileHeaderSize + 8;
+constexpr qint64 TailEntryHeaderSize = 16;
+
+constexpr int DefaultBlockSize = 64 * 1024;
+
+bool writeFileHeader(QFile& file, quint32 magic)
+{
+    uchar header[FileHeaderSize];
+    qToLittleEndian(magic, header);
+    qToLittleEndian(FormatVersion, header + 4);
+    return file.write(reinterpret_cast<const char*>(header), FileHeaderSize) == FileHeaderSize;
+}
+
+// QFile::flush只把数据交给操作系统，断电前还要同步到磁盘
+bool syncFile(QFile& file, bool toDisk)
+{
+    if (!file.flush()) {
+        return false;
+    }
+    if (!toDisk) {
+        return true;
+    }
+#ifdef Q_OS_WIN
+    return _commit(file.handle()) == 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+bool checkFileHeader(QFile& file, quint32 magic)
+{
+    uchar header[FileHeaderSize];
+    if (!file.seek(0) || file.read(reinterpret_cast<char*>(header), FileHeaderSize) != FileHeaderSize) {
+        return false;
+    }
+    return qFromLittleEndian<quint32>(header) == magic && qFromLittleEndian<quint32>(header + 4) == FormatVersion;
+}
+
+// 打开文件，空文件写入文件头，否则校验文件头
+bool openWithHeader(QFile& file, quint32 magic, QString* errorMessage)
+{
+    if (!file.open(QIODevice::ReadWrite)) {
+        *errorMessage = QString("无法打开电子存根文件 %1: %2").arg(file.fileName(), file.errorString());
+        return false;
+    }
+    if (file.size() == 0) {
+        if (!writeFileHeader(file, magic)) {
+            *errorMessage = QString("无法写入电子存根文件 %1").arg(file.fileName());
+            return false;
+        }
+        return true;
+    }
+    if (!checkFileHeader(file, magic)) {
+        *errorMessage = QString("电子存根文件格式不正确: %1").arg(file.fileName());
+        return false;
+    }
+    return true;
+}
+
+}
+
+ElectronicJournal::ElectronicJournal(const QString& basePath)
+    : m_basePath(basePath)
+    , m_blockSize(DefaultBlockSize)
+    , m_syncWrites(true)
+    , m_firstPendingRecord(0)
+    , m_cachedBlockOffset(-1)
+{
+    m_template = ReceiptTemplate::compile(ReceiptTemplate::defaultTextSource(), ReceiptTemplate::PlainText);
+}
+
+ElectronicJournal::~ElectronicJournal()
+{
+    close();
+}
+
+bool ElectronicJournal::open(QString* errorMessage)
+{
+    QMutexLocker locker(&m_mutex);
+    QString error;
+    if (!openLocked(&error)) {
+        qWarning() << error;
+        if (errorMessage) {
+            *errorMessage = error;
+        }
+        m_dataFile.close();
+        m_indexFile.close();
+        m_tailFile.close();
+        return false;
+    }
+    return true;
+}
+
+bool ElectronicJournal::openLocked(QString* errorMessage)
+{
+    if (m_dataFile.isOpen()) {
+        return true;
+    }
+
+    QDir().mkpath(QFileInfo(m_basePath).absolutePath());
+    m_dataFile.setFileName(m_basePath + ".ej");
+    m_indexFile.setFileName(m_basePath + ".ejx");
+    m_tailFile.setFileName(m_basePath + ".ejw");
+    if (!openWithHeader(m_dataFile, DataMagic, errorMessage)
+        || !openWithHeader(m_indexFile, IndexMagic, errorMessage)
+        || !openWithHeader(m_tailFile, TailMagic, errorMessage)) {
+        return false;
+    }
+    return loadIndex(errorMessage) && recoverTail(errorMessage);
+}
+
+bool ElectronicJournal::loadIndex(QString* errorMessage)
+{
+    m_records.clear();
+    m_recordByTransaction.clear();
+    m_recordsByTime.clear();
+    m_pendingBlock.clear();
+    m_cachedBlockOffset = -1;
+    m_cachedBlock.clear();
+
+    // 整个索引一次读入；不足一条的尾部是写了一半的记录
+    const qint64 recordCount = (m_indexFile.size() - FileHeaderSize) / IndexRecordSize;
+    m_indexFile.seek(FileHeaderSize);
+    const QByteArray raw = m_indexFile.read(recordCount * IndexRecordSize);
+    if (raw.size() != recordCount * IndexRecordSize) {
+        *errorMessage = QString("读取电子存根索引失败: %1").arg(m_indexFile.errorString());
+        return false;
+    }
+
+    QVector<IndexRecord> records;
+    records.reserve(recordCount);
+    const uchar* p = reinterpret_cast<const uchar*>(raw.constData());
+    for (qint64 i = 0; i < recordCount; ++i, p += IndexRecordSize) {
+        IndexRecord record;
+        record.transactionId = qFromLittleEndian<qint32>(p);
+        record.timestampMsecs = qFromLittleEndian<qint64>(p + 8);
+        record.blockOffset = qFromLittleEndian<qint64>(p + 16);
+        record.offsetInBlock = qFromLittleEndian<quint32>(p + 24);
+        record.length = qFromLittleEndian<quint32>(p + 28);
+        records.append(record);
+    }
+
+    // 从尾部向前找到最后一个完整写出的数据块，丢弃其后的索引和数据
+    const qint64 dataSize = m_dataFile.size();
+    qint64 dataEnd = FileHeaderSize;
+    while (!records.isEmpty()) {
+        const qint64 blockOffset = records.last().blockOffset;
+        uchar header[BlockHeaderSize];
+        bool complete = blockOffset >= FileHeaderSize
+                        && blockOffset + BlockHeaderSize <= dataSize
+                        && m_dataFile.seek(blockOffset)
+                        && m_dataFile.read(reinterpret_cast<char*>(header), BlockHeaderSize) == BlockHeaderSize;
+        if (complete) {
+            const qint64 blockEnd = blockOffset + BlockHeaderSize + qFromLittleEndian<quint32>(header);
+            const quint32 rawSize = qFromLittleEndian<quint32>(header + 4);
+            complete = blockEnd <= dataSize && records.last().offsetInBlock + records.last().length <= rawSize;
+            if (complete) {
+                dataEnd = blockEnd;
+                break;
+            }
+        }
+        while (!records.isEmpty() && records.last().blockOffset == blockOffset) {
+            records.removeLast();
+        }
+    }
+
+    if (records.size() != recordCount) {
+        qWarning() << "电子存根尾部不完整，丢弃" << recordCount - records.size() << "条记录";
+        m_indexFile.resize(FileHeaderSize + records.size() * IndexRecordSize);
+    }
+    if (dataSize > dataEnd) {
+        m_dataFile.resize(dataEnd);
+    }
+
+    m_records.reserve(records.size());
+    for (const IndexRecord& record : std::as_const(records)) {
+        addRecord(record);
+    }
+    m_firstPendingRecord = m_records.size();
+    return true;
+}
+
+bool ElectronicJournal::recoverTail(QString* errorMessage)
+{
+    // 写基准记录数之前崩溃的尾部没有小票
+    if (m_tailFile.size() < TailHeaderSize) {
+        if (!resetTail()) {
+            *errorMessage = QString("无法写入电子存根文件 %1").arg(m_tailFile.fileName());
+            return false;
+        }
+        return true;
+    }
+
+    uchar header[8];
+    if (!m_tailFile.seek(FileHeaderSize) || m_tailFile.read(reinterpret_cast<char*>(header), 8) != 8) {
+        *errorMessage = QString("读取电子存根预写尾部失败: %1").arg(m_tailFile.errorString());
+        return false;
+    }
+    const qint64 baseRecord = qFromLittleEndian<qint64>(header);
+    const QByteArray raw = m_tailFile.readAll();
+
+    // 下标小于索引记录数的小票已随数据块写出（写出后、清空尾部前崩溃），跳过
+    const qint64 indexedRecords = m_records.size();
+    qint64 position = 0;
+    qint64 entryIndex = baseRecord;
+    int recovered = 0;
+    while (position + TailEntryHeaderSize <= raw.size()) {
+        const uchar* p = reinterpret_cast<const uchar*>(raw.constData() + position);
+        const qint32 transactionId = qFromLittleEndian<qint32>(p);
+        const quint32 length = qFromLittleEndian<quint32>(p + 4);
+        const qint64 timestampMsecs = qFromLittleEndian<qint64>(p + 8);
+        if (position + TailEntryHeaderSize + length > raw.size()) {
+            break;
+        }
+        if (entryIndex >= indexedRecords) {
+            IndexRecord record;
+            record.transactionId = transactionId;
+            record.timestampMsecs = timestampMsecs;
+            record.offsetInBlock = static_cast<quint32>(m_pendingBlock.size());
+            record.length = length;
+            m_pendingBlock.append(raw.constData() + position + TailEntryHeaderSize, length);
+            addRecord(record);
+            ++recovered;
+        }
+        position += TailEntryHeaderSize + length;
+        ++entryIndex;
+    }
+
+    if (recovered > 0) {
+        qWarning() << "电子存根从预写尾部恢复" << recovered << "张小票";
+    }
+    // 全部已写出时清空尾部；否则只截掉写了一半的最后一条
+    if (m_pendingBlock.isEmpty()) {
+        if (!resetTail()) {
+            qWarning() << "清空电子存根预写尾部失败:" << m_tailFile.errorString();
+        }
+        return true;
+    }
+    if (position < raw.size()) {
+        m_tailFile.resize(TailHeaderSize + position);
+    }
+    return true;
+}
+
+bool ElectronicJournal::resetTail()
+{
+    uchar header[8];
+    qToLittleEndian(static_cast<qint64>(m_records.size()), header);
+    return m_tailFile.resize(FileHeaderSize)
+           && m_tailFile.seek(FileHeaderSize)
+           && m_tailFile.write(reinterpret_cast<const char*>(header), 8) == 8
+           && syncFile(m_tailFile, m_syncWrites);
+}
+
+void ElectronicJournal::close()
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_dataFile.isOpen()) {
+        return;
+    }
+    flushLocked();
+    m_dataFile.close();
+    m_indexFile.close();
+    m_tailFile.close();
+}
+
+bool ElectronicJournal::isOpen() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dataFile.isOpen();
+}
+
+void ElectronicJournal::setBlockSize(int bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_blockSize = qMax(1024, bytes);
+}
+
+void ElectronicJournal::setSyncWrites(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    m_syncWrites = enabled;
+}
+
+bool ElectronicJournal::append(const ReceiptData& receipt)
+{
+    QMutexLocker locker(&m_mutex);
+    m_template.render(receipt, &m_renderBuffer);
+    return appendLocked(receipt.transactionId, receipt.timestamp, m_renderBuffer);
+}
+
+bool ElectronicJournal::append(int transactionId, const QDateTime& timestamp, QStringView receiptText)
+{
+    QMutexLocker locker(&m_mutex);
+    return appendLocked(transactionId, timestamp, receiptText);
+}
+
+bool ElectronicJournal::appendLocked(int transactionId, const QDateTime& timestamp, QStringView receiptText)
+{
+    if (!m_dataFile.isOpen()) {
+        qWarning() << "电子存根未打开，无法追加交易" << transactionId;
+        return false;
+    }
+
+    const QByteArray utf8 = receiptText.toUtf8();
+
+    // 先把小票写进预写尾部并同步，之后才算追加成功
+    const qint64 tailSize = m_tailFile.size();
+    uchar header[TailEntryHeaderSize];
+    qToLittleEndian(static_cast<qint32>(transactionId), header);
+    qToLittleEndian(static_cast<quint32>(utf8.size()), header + 4);
+    qToLittleEndian(timestamp.toMSecsSinceEpoch(), header + 8);
+    if (!m_tailFile.seek(tailSize)
+        || m_tailFile.write(reinterpret_cast<const char*>(header), TailEntryHeaderSize) != TailEntryHeaderSize
+        || m_tailFile.write(utf8) != utf8.size()
+        || !syncFile(m_tailFile, m_syncWrites)) {
+        qWarning() << "写入电子存根预写尾部失败:" << m_tailFile.errorString();
+        m_tailFile.resize(tailSize);
+        return false;
+    }
+
+    IndexRecord record;
+    record.transactionId = transactionId;
+    record.timestampMsecs = timestamp.toMSecsSinceEpoch();
+    record.blockOffset = -1;
+    record.offsetInBlock = static_cast<quint32>(m_pendingBlock.size());
+    record.length = static_cast<quint32>(utf8.size());
+    m_pendingBlock.append(utf8);
+    addRecord(record);
+
+    // 小票已在预写尾部，数据块写出失败时留到下次追加或flush再写
+    if (m_pendingBlock.size() >= m_blockSize) {
+        flushLocked();
+    }
+    return true;
+}
+
+bool ElectronicJournal::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    return flushLocked();
+}
+
+bool ElectronicJournal::flushLocked()
+{
+    if (!m_dataFile.isOpen() || m_pendingBlock.isEmpty()) {
+        return true;
+    }
+
+    // 先写数据块，再写指向它的索引记录
+    const QByteArray compressed = qCompress(m_pendingBlock, 9);
+    const qint64 blockOffset = m_dataFile.size();
+    const qint64 indexSize = m_indexFile.size();
+    uchar header[BlockHeaderSize];
+    qToLittleEndian(static_cast<quint32>(compressed.size()), header);
+    qToLittleEndian(static_cast<quint32>(m_pendingBlock.size()), header + 4);
+    if (!m_dataFile.seek(blockOffset)
+        || m_dataFile.write(reinterpret_cast<const char*>(header), BlockHeaderSize) != BlockHeaderSize
+        || m_dataFile.write(compressed) != compressed.size()
+        || !syncFile(m_dataFile, m_syncWrites)) {
+        qWarning() << "写入电子存根数据块失败:" << m_dataFile.errorString();
+        m_dataFile.resize(blockOffset);
+        return false;
+    }
+
+    QByteArray index(static_cast<qsizetype>(m_records.size() - m_firstPendingRecord) * IndexRecordSize, '\0');
+    uchar* p = reinterpret_cast<uchar*>(index.data());
+    for (int i = m_firstPendingRecord; i < m_records.size(); ++i, p += IndexRecordSize) {
+        const IndexRecord& record = m_records.at(i);
+        qToLittleEndian(record.transactionId, p);
+        qToLittleEndian(record.timestampMsecs, p + 8);
+        qToLittleEndian(blockOffset, p + 16);
+        qToLittleEndian(record.offsetInBlock, p + 24);
+        qToLittleEndian(record.length, p + 28);
+    }
+    if (!m_indexFile.seek(indexSize) || m_indexFile.write(index) != index.size()
+        || !syncFile(m_indexFile, m_syncWrites)) {
+        // 两个文件都回到写入前的大小，当前数据块和记录保持不变，下次flush重新写出
+        qWarning() << "写入电子存根索引失败:" << m_indexFile.errorString();
+        m_indexFile.resize(indexSize);
+        m_dataFile.resize(blockOffset);
+        return false;
+    }
+    for (int i = m_firstPendingRecord; i < m_records.size(); ++i) {
+        m_records[i].blockOffset = blockOffset;
+    }
+
+    // 刚写出的块正是下一次补打最可能读取的块
+    m_cachedBlockOffset = blockOffset;
+    m_cachedBlock = m_pendingBlock;
+    m_pendingBlock.clear();
+    m_firstPendingRecord = m_records.size();
+
+    // 清空失败不影响正确性：重新打开时跳过已进入索引的小票
+    if (!resetTail()) {
+        qWarning() << "清空电子存根预写尾部失败:" << m_tailFile.errorString();
+    }
+    return true;
+}
+
+int ElectronicJournal::entryCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_records.size();
+}
+
+bool ElectronicJournal::contains(int transactionId) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_recordByTransaction.contains(transactionId);
+}
+
+QString ElectronicJournal::receiptText(int transactionId)
+{
+    QMutexLocker locker(&m_mutex);
+    auto it = m_recordByTransaction.constFind(transactionId);
+    if (it == m_recordByTransaction.constEnd()) {
+        return QString();
+    }
+
+    const IndexRecord& record = m_records.at(it.value());
+    const QByteArray* block = record.blockOffset < 0 ? &m_pendingBlock : loadBlock(record.blockOffset);
+    if (!block || record.offsetInBlock + record.length > static_cast<quint32>(block->size())) {
+        qWarning() << "电子存根数据块损坏，无法读取交易" << transactionId;
+        return QString();
+    }
+    return QString::fromUtf8(block->constData() + record.offsetInBlock, record.length);
+}
+
+QList<JournalEntry> ElectronicJournal::entries(const QDateTime& from, const QDateTime& to) const
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 fromMsecs = from.toMSecsSinceEpoch();
+    const qint64 toMsecs = to.toMSecsSinceEpoch();
+
+    auto first = std::lower_bound(m_recordsByTime.cbegin(), m_recordsByTime.cend(), qMakePair(fromMsecs, -1));
+    QList<JournalEntry> result;
+    for (auto it = first; it != m_recordsByTime.cend() && it->first < toMsecs; ++it) {
+        const IndexRecord& record = m_records.at(it->second);
+        result.append(JournalEntry{record.transactionId, QDateTime::fromMSecsSinceEpoch(record.timestampMsecs)});
+    }
+    return result;
+}
+
+qint64 ElectronicJournal::diskSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dataFile.isOpen() ? m_dataFile.size() + m_indexFile.size() + m_tailFile.size() : 0;
+}
+
+void ElectronicJournal::addRecord(const IndexRecord& record)
+{
+    const int index = m_records.size();
+    m_records.append(record);
+    m_recordByTransaction.insert(record.transactionId, index);
+
+    // 小票基本按时间追加，插入位置几乎总在末尾
+    const QPair<qint64, int> key(record.timestampMsecs, index);
+    m_recordsByTime.insert(std::upper_bound(m_recordsByTime.begin(), m_recordsByTime.end(), key), key);
+}
+
+const QByteArray* ElectronicJournal::loadBlock(qint64 blockOffset)
+{
+    if (blockOffset == m_cachedBlockOffset) {
+        return &m_cachedBlock;
+    }
+
+    uchar header[BlockHeaderSize];
+    if (!m_dataFile.seek(blockOffset)
+        || m_dataFile.read(reinterpret_cast<char*>(header), BlockHeaderSize) != BlockHeaderSize) {
+        return nullptr;
+    }
+    const quint32 compressedSize = qFromLittleEndian<quint32>(header);
+    const quint32 rawSize = qFromLittleEndian<quint32>(header + 4);
+    const QByteArray compressed = m_dataFile.read(compressedSize);
+    if (compressed.size() != static_cast<qsizetype>(compressedSize)) {
+        return nullptr;
+    }
+
+    QByteArray block = qUncompress(compressed);
+    if (block.size() != static_cast<qsizetype>(rawSize)) {
+        return nullptr;
+    }
+    m_cachedBlockOffset = blockOffset;
+    m_cachedBlock = std::move(block);
+    return &m_cachedBlock;
+}
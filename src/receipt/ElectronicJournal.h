@@ -0,0 +1,179 @@
+#ifndef ELECTRONICJOURNAL_H
+#define ELECTRONICJOURNAL_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QVector>
+#include "ReceiptData.h"
+#include "ReceiptTemplate.h"
+
+/**
+ * @brief 电子存根中一张小票的摘要
+ */
+struct JournalEntry
+{
+    int transactionId = -1;     ///< 交易ID
+    QDateTime timestamp;        ///< 交易时间
+};
+
+/**
+ * @brief ElectronicJournal类 - 只追加的压缩电子存根
+ *
+ * 每张已渲染的小票（纯文本版式）追加到当前数据块，数据块写满后用qCompress压缩，
+ * 整块追加到数据文件（.ej）；同时向旁路索引文件（.ejx）追加定长索引记录
+ * （交易ID、时间、数据块偏移、块内偏移和长度）。
+ *
+ * 打开时把索引整个读入内存，按交易ID和时间查找；补打一张小票只需读一个数据块并解压，
+ * 最近读过的数据块会缓存。先写数据块、后写索引，打开时丢弃写了一半的尾部。
+ *
+ * 每张小票追加时先以未压缩形式写入预写尾部文件（.ejw）并同步到磁盘，再放入内存中的当前数据块；
+ * 数据块写出后清空尾部。崩溃或断电后重新打开时，尾部中尚未进入索引的小票会重新放回当前数据块。
+ * 所有方法都是线程安全的。
+ */
+class ElectronicJournal
+{
+public:
+    /**
+     * @brief 构造函数
+     * @param basePath 存根文件路径（不含扩展名），如 .../journal/receipts
+     */
+    explicit ElectronicJournal(const QString& basePath);
+
+    /**
+     * @brief 析构函数（写出未满的数据块）
+     */
+    ~ElectronicJournal();
+
+    ElectronicJournal(const ElectronicJournal&) = delete;
+    ElectronicJournal& operator=(const ElectronicJournal&) = delete;
+
+    /**
+     * @brief 打开（不存在时创建）存根并加载索引
+     * @param errorMessage 如果不为空，失败时写入错误消息
+     * @return 如果成功返回true
+     */
+    bool open(QString* errorMessage = nullptr);
+
+    /**
+     * @brief 写出未满的数据块并关闭文件
+     */
+    void close();
+
+    bool isOpen() const;
+
+    /**
+     * @brief 设置数据块的未压缩大小（字节），越大压缩率越高
+     */
+    void setBlockSize(int bytes);
+
+    /**
+     * @brief 设置每次写入后是否同步到磁盘（默认是）
+     *
+     * 关闭后只保证进程崩溃不丢小票，断电可能丢失最近写入的小票；用于批量导入。
+     */
+    void setSyncWrites(bool enabled);
+
+    /**
+     * @brief 用纯文本版式渲染小票并追加到存根
+     * @param receipt 小票快照
+     * @return 如果小票已写入预写尾部返回true
+     */
+    bool append(const ReceiptData& receipt);
+
+    /**
+     * @brief 追加已渲染的小票文本
+     * @param transactionId 交易ID
+     * @param timestamp 交易时间
+     * @param receiptText 小票文本
+     * @return 如果小票已写入预写尾部返回true
+     */
+    bool append(int transactionId, const QDateTime& timestamp, QStringView receiptText);
+
+    /**
+     * @brief 把未满的数据块压缩写出，并刷新两个文件
+     * @return 如果成功返回true
+     */
+    bool flush();
+
+    /**
+     * @brief 存根中的小票数
+     */
+    int entryCount() const;
+
+    /**
+     * @brief 是否存有指定交易的小票
+     */
+    bool contains(int transactionId) const;
+
+    /**
+     * @brief 取出小票文本用于补打（同一交易存了多次时取最后一次）
+     * @param transactionId 交易ID
+     * @return 小票文本，不存在时为空字符串
+     */
+    QString receiptText(int transactionId);
+
+    /**
+     * @brief 列出时间范围内的小票
+     * @param from 开始时间（含）
+     * @param to 结束时间（不含）
+     * @return 按时间排序的摘要列表
+     */
+    QList<JournalEntry> entries(const QDateTime& from, const QDateTime& to) const;
+
+    /**
+     * @brief 数据文件、索引文件和预写尾部在磁盘上的总字节数
+     */
+    qint64 diskSize() const;
+
+private:
+    struct IndexRecord
+    {
+        qint32 transactionId = -1;
+        qint64 timestampMsecs = 0;      ///< UTC毫秒
+        qint64 blockOffset = -1;        ///< 数据块在数据文件中的偏移，-1表示仍在内存中的当前块
+        quint32 offsetInBlock = 0;
+        quint32 length = 0;
+    };
+
+    bool openLocked(QString* errorMessage);
+    bool appendLocked(int transactionId, const QDateTime& timestamp, QStringView receiptText);
+    bool flushLocked();
+    bool loadIndex(QString* errorMessage);
+    bool recoverTail(QString* errorMessage);
+    bool resetTail();
+    void addRecord(const IndexRecord& record);
+
+    /**
+     * @brief 读出并解压数据块（命中缓存时直接返回）
+     */
+    const QByteArray* loadBlock(qint64 blockOffset);
+
+    QString m_basePath;                 ///< 存根路径（不含扩展名）
+    QFile m_dataFile;                   ///< 压缩数据块文件
+    QFile m_indexFile;                  ///< 定长索引文件
+    QFile m_tailFile;                   ///< 预写尾部文件（当前数据块中的小票）
+    int m_blockSize;                    ///< 数据块未压缩大小上限
+    bool m_syncWrites;                  ///< 写入后是否同步到磁盘
+
+    QVector<IndexRecord> m_records;                 ///< 按追加顺序的全部索引记录
+    QHash<int, int> m_recordByTransaction;          ///< 交易ID到记录下标
+    QVector<QPair<qint64, int>> m_recordsByTime;    ///< (时间, 记录下标)，按时间排序
+
+    QByteArray m_pendingBlock;          ///< 尚未写出的当前数据块
+    int m_firstPendingRecord;           ///< 当前数据块中第一条记录的下标
+
+    qint64 m_cachedBlockOffset;         ///< 缓存的数据块偏移
+    QByteArray m_cachedBlock;           ///< 缓存的解压数据块
+
+    ReceiptTemplate m_template;         ///< 纯文本小票版式
+    QString m_renderBuffer;             ///< 复用的渲染缓冲区
+
+    mutable QMutex m_mutex;
+};
+
+#endif // ELECTRONICJOURNAL_H
@@ -0,0 +1,326 @@
+#include "EscPosRenderer.h"
+#include <QDebug>
+#include <charconv>
+#include <cstring>
+
+namespace {
+
+// ESC/POS命令字节
+constexpr char ESC = 0x1B;
+constexpr char GS = 0x1D;
+constexpr char FS = 0x1C;
+constexpr char LF = 0x0A;
+
+// 一张普通小票的初始容量，避免前几次渲染时反复扩容
+constexpr int InitialCapacity = 4096;
+
+bool isWideCharacter(char16_t ch)
+{
+    return ch >= 0x1100
+           && (ch <= 0x115F
+               || ch == 0x2329 || ch == 0x232A
+               || (ch >= 0x2E80 && ch <= 0xA4CF && ch != 0x303F)
+               || (ch >= 0xAC00 && ch <= 0xD7A3)
+               || (ch >= 0xF900 && ch <= 0xFAFF)
+               || (ch >= 0xFE30 && ch <= 0xFE4F)
+               || (ch >= 0xFF00 && ch <= 0xFF60)
+               || (ch >= 0xFFE0 && ch <= 0xFFE6));
+}
+
+int charWidth(char16_t ch)
+{
+    if (QChar::isLowSurrogate(ch)) {
+        return 0;   // 代理对按高位计宽
+    }
+    if (QChar::isHighSurrogate(ch)) {
+        return 2;   // 扩展区汉字等
+    }
+    return isWideCharacter(ch) ? 2 : 1;
+}
+
+// 定长ASCII格式化缓冲区（数字、金额），不分配内存
+struct AsciiField
+{
+    char data[48];
+    int size = 0;
+
+    void append(const char* text)
+    {
+        const int length = static_cast<int>(std::strlen(text));
+        std::memcpy(data + size, text, length);
+        size += length;
+    }
+
+    void append(qint64 value)
+    {
+        auto result = std::to_chars(data + size, data + sizeof(data), value);
+        size = static_cast<int>(result.ptr - data);
+    }
+
+    void appendMoney(Money amount)
+    {
+        qint64 minor = amount.minorUnits();
+        if (minor < 0) {
+            data[size++] = '-';
+            minor = -minor;
+        }
+        append(minor / Money::MinorPerMajor);
+        const qint64 cents = minor % Money::MinorPerMajor;
+        data[size++] = '.';
+        data[size++] = static_cast<char>('0' + cents / 10);
+        data[size++] = static_cast<char>('0' + cents % 10);
+    }
+};
+
+}
+
+EscPosRenderer::EscPosRenderer(int columns)
+    : m_encoder("GB18030")
+    , m_gb18030(true)
+    , m_columns(qMax(16, columns))
+{
+    if (!m_encoder.isValid()) {
+        // 没有ICU的Qt只内置UTF编码，退回UTF-8（需打印机设为UTF-8代码页）
+        qWarning() << "GB18030编码不可用，热敏小票改用UTF-8输出";
+        m_encoder = QStringEncoder(QStringEncoder::Utf8);
+        m_gb18030 = false;
+    }
+    m_buffer.reserve(InitialCapacity);
+}
+
+void EscPosRenderer::setColumns(int columns)
+{
+    m_columns = qMax(16, columns);
+}
+
+int EscPosRenderer::displayWidth(QStringView text)
+{
+    int width = 0;
+    for (QChar ch : text) {
+        width += charWidth(ch.unicode());
+    }
+    return width;
+}
+
+const QByteArray& EscPosRenderer::render(const ReceiptData& data)
+{
+    // resize(0)保留已分配的容量
+    m_buffer.resize(0);
+
+    initialize();
+
+    // 店铺抬头：居中、倍宽倍高、加粗
+    setAlignment(AlignCenter);
+    setCharacterSize(2, 2);
+    setBold(true);
+    appendLine(data.store.name);
+    setCharacterSize(1, 1);
+    setBold(false);
+    appendLine(data.store.address);
+    appendText(u"电话: ");
+    appendLine(data.store.phone);
+
+    setAlignment(AlignLeft);
+    appendSeparator('=');
+
+    AsciiField field;
+    field.append(static_cast<qint64>(data.transactionId));
+    appendText(u"小票号: ");
+    m_buffer.append(field.data, field.size);
+    m_buffer.append(LF);
+    appendText(u"收银员: ");
+    appendLine(data.cashierName);
+    appendText(u"时间: ");
+    appendLine(data.timestamp.toString("yyyy-MM-dd hh:mm:ss"));
+    appendSeparator('-');
+
+    // 每件商品两行：名称（过长时折行），然后是“数量 x 单价”和右对齐的小计
+    for (const ReceiptLine& line : data.lines) {
+        appendWrapped(line.name, 0);
+
+        AsciiField left;
+        left.append("  ");
+        left.append(static_cast<qint64>(line.quantity));
+        left.append(" x ");
+        left.appendMoney(line.unitPrice);
+
+        AsciiField right;
+        right.appendMoney(line.subtotal);
+
+        const int spaces = m_columns - left.size - right.size;
+        m_buffer.append(left.data, left.size);
+        if (spaces < 1) {
+            m_buffer.append(LF);
+            appendSpaces(m_columns - right.size);
+        } else {
+            appendSpaces(spaces);
+        }
+        m_buffer.append(right.data, right.size);
+        m_buffer.append(LF);
+    }
+
+    appendSeparator('-');
+
+    field = AsciiField();
+    field.append(static_cast<qint64>(data.totalQuantity));
+    appendColumns(u"商品总数:", QLatin1String(field.data, field.size));
+
+    field = AsciiField();
+    field.appendMoney(data.totalAmount);
+    appendColumns(u"总金额:", QLatin1String(field.data, field.size));
+
+    if (data.discountAmount.isPositive()) {
+        field = AsciiField();
+        field.append("-");
+        field.appendMoney(data.discountAmount);
+        appendColumns(u"优惠金额:", QLatin1String(field.data, field.size));
+    }
+    if (data.promotionDiscount.isPositive()) {
+        field = AsciiField();
+        field.append("-");
+        field.appendMoney(data.promotionDiscount);
+        appendColumns(u"促销优惠:", QLatin1String(field.data, field.size));
+    }
+
+    field = AsciiField();
+    field.appendMoney(data.finalAmount);
+    setBold(true);
+    setCharacterSize(1, 2);
+    appendColumns(u"实付金额:", QLatin1String(field.data, field.size));
+    setCharacterSize(1, 1);
+    setBold(false);
+
+    appendText(u"支付方式: ");
+    appendLine(data.paymentMethod);
+    appendSeparator('=');
+
+    setAlignment(AlignCenter);
+    appendLine(data.store.footer);
+    appendLine(data.store.website);
+
+    feedAndCut();
+    return m_buffer;
+}
+
+const QByteArray& EscPosRenderer::renderText(QStringView text)
+{
+    m_buffer.resize(0);
+    initialize();
+    setAlignment(AlignLeft);
+    appendText(text);
+    if (!text.isEmpty() && !text.endsWith(QLatin1Char('\n'))) {
+        m_buffer.append(LF);
+    }
+    feedAndCut();
+    return m_buffer;
+}
+
+void EscPosRenderer::initialize()
+{
+    // ESC @ 复位打印机
+    m_buffer.append(ESC);
+    m_buffer.append('@');
+    if (m_gb18030) {
+        // FS & 进入汉字模式
+        m_buffer.append(FS);
+        m_buffer.append('&');
+    }
+}
+
+void EscPosRenderer::setAlignment(Alignment alignment)
+{
+    m_buffer.append(ESC);
+    m_buffer.append('a');
+    m_buffer.append(static_cast<char>(alignment));
+}
+
+void EscPosRenderer::setBold(bool bold)
+{
+    m_buffer.append(ESC);
+    m_buffer.append('E');
+    m_buffer.append(static_cast<char>(bold ? 1 : 0));
+}
+
+void EscPosRenderer::setCharacterSize(int widthScale, int heightScale)
+{
+    // GS ! n：高4位为宽度倍数-1，低4位为高度倍数-1
+    const int width = qBound(1, widthScale, 8) - 1;
+    const int height = qBound(1, heightScale, 8) - 1;
+    m_buffer.append(GS);
+    m_buffer.append('!');
+    m_buffer.append(static_cast<char>((width << 4) | height));
+}
+
+void EscPosRenderer::feedAndCut()
+{
+    // GS V 66 n：走纸n点后半切
+    m_buffer.append(GS);
+    m_buffer.append('V');
+    m_buffer.append(static_cast<char>(66));
+    m_buffer.append(static_cast<char>(80));
+}
+
+void EscPosRenderer::appendText(QStringView text)
+{
+    if (text.isEmpty()) {
+        return;
+    }
+    const qsizetype oldSize = m_buffer.size();
+    m_buffer.resize(oldSize + m_encoder.requiredSpace(text.size()));
+    char* end = m_encoder.appendToBuffer(m_buffer.data() + oldSize, text);
+    m_buffer.resize(end - m_buffer.constData());
+}
+
+void EscPosRenderer::appendLine(QStringView text)
+{
+    appendText(text);
+    m_buffer.append(LF);
+}
+
+void EscPosRenderer::appendSpaces(int count)
+{
+    if (count > 0) {
+        m_buffer.append(count, ' ');
+    }
+}
+
+void EscPosRenderer::appendSeparator(char ch)
+{
+    m_buffer.append(m_columns, ch);
+    m_buffer.append(LF);
+}
+
+void EscPosRenderer::appendColumns(QStringView left, QLatin1String right)
+{
+    const int leftWidth = displayWidth(left);
+    const int rightWidth = static_cast<int>(right.size());
+
+    appendText(left);
+    int spaces = m_columns - leftWidth - rightWidth;
+    if (spaces < 1) {
+        m_buffer.append(LF);
+        spaces = m_columns - rightWidth;
+    }
+    appendSpaces(spaces);
+    m_buffer.append(right.data(), right.size());
+    m_buffer.append(LF);
+}
+
+void EscPosRenderer::appendWrapped(QStringView text, int indent)
+{
+    const int available = m_columns - indent;
+    qsizetype start = 0;
+    int width = 0;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const int w = charWidth(text[i].unicode());
+        if (width + w > available && i > start) {
+            appendSpaces(indent);
+            appendLine(text.mid(start, i - start));
+            start = i;
+            width = 0;
+        }
+        width += w;
+    }
+    appendSpaces(indent);
+    appendLine(text.mid(start));
+}
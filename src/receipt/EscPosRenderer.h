@@ -0,0 +1,103 @@
+#ifndef ESCPOSRENDERER_H
+#define ESCPOSRENDERER_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringEncoder>
+#include <QStringView>
+#include "ReceiptData.h"
+
+/**
+ * @brief EscPosRenderer类 - ESC/POS热敏小票字节流生成器
+ *
+ * 直接把ReceiptData写成打印机可识别的ESC/POS命令，不经过HTML/QTextDocument排版。
+ * 中文按GB18030编码（打印机的汉字模式），列宽按显示宽度计算（全角字符占两列），
+ * 80mm纸默认48列，58mm纸32列。
+ *
+ * 输出缓冲区在多次渲染之间复用，扩容到最大小票长度后不再分配内存。
+ * 一个实例只能在一个线程中使用。
+ */
+class EscPosRenderer
+{
+public:
+    /**
+     * @brief 纸宽对应的每行字符列数
+     */
+    enum PaperWidth {
+        Paper58mm = 32,
+        Paper80mm = 48
+    };
+
+    /**
+     * @brief 对齐方式（ESC a n）
+     */
+    enum Alignment {
+        AlignLeft = 0,
+        AlignCenter = 1,
+        AlignRight = 2
+    };
+
+    /**
+     * @brief 构造函数
+     * @param columns 每行列数
+     */
+    explicit EscPosRenderer(int columns = Paper80mm);
+
+    /**
+     * @brief 设置每行列数
+     */
+    void setColumns(int columns);
+    int columns() const { return m_columns; }
+
+    /**
+     * @brief 是否使用GB18030编码（否则退回UTF-8，需要打印机支持）
+     */
+    bool isGb18030() const { return m_gb18030; }
+
+    /**
+     * @brief 把小票渲染成ESC/POS字节流
+     * @param data 小票快照
+     * @return 内部缓冲区的引用，下一次渲染前有效
+     */
+    const QByteArray& render(const ReceiptData& data);
+
+    /**
+     * @brief 把已排好版的小票文本（例如电子存根中的小票）渲染成ESC/POS字节流
+     * @param text 小票文本，按行原样打印
+     * @return 内部缓冲区的引用，下一次渲染前有效
+     */
+    const QByteArray& renderText(QStringView text);
+
+    /**
+     * @brief 计算文本在热敏打印机上的显示宽度（全角字符计2列）
+     * @param text 文本
+     * @return 列数
+     */
+    static int displayWidth(QStringView text);
+
+private:
+    void initialize();
+    void setAlignment(Alignment alignment);
+    void setBold(bool bold);
+    void setCharacterSize(int widthScale, int heightScale);
+    void feedAndCut();
+
+    // 文本输出（按打印机编码写入缓冲区）
+    void appendText(QStringView text);
+    void appendLine(QStringView text);
+    void appendSpaces(int count);
+    void appendSeparator(char ch);
+
+    // 左右两列：左侧文本，右侧文本右对齐到行尾，放不下时右侧换到下一行
+    void appendColumns(QStringView left, QLatin1String right);
+
+    // 商品名超出一行时按显示宽度折行
+    void appendWrapped(QStringView text, int indent);
+
+    QByteArray m_buffer;            ///< 复用的输出缓冲区
+    QStringEncoder m_encoder;       ///< 打印机编码器
+    bool m_gb18030;                 ///< 编码器是否为GB18030
+    int m_columns;                  ///< 每行列数
+};
+
+#endif // ESCPOSRENDERER_H
@@ -0,0 +1,27 @@
+#include "ReceiptData.h"
+#include "../models/Sale.h"
+#include "../models/SaleItem.h"
+#include "../models/Product.h"
+
+ReceiptData ReceiptData::fromSale(const Sale& sale, const StoreInfo& store)
+{
+    ReceiptData data;
+    data.store = store;
+    data.transactionId = sale.getTransactionId();
+    data.cashierName = sale.getCashierName();
+    data.timestamp = sale.getTimestamp();
+    data.totalAmount = sale.getTotalAmount();
+    data.discountAmount = sale.getDiscountAmount();
+    data.promotionDiscount = sale.getPromotionDiscount();
+    data.finalAmount = sale.getFinalAmount();
+    data.paymentMethod = Sale::paymentMethodToString(sale.getPaymentMethod());
+
+    data.lines.reserve(sale.itemCount());
+    for (const SaleItem* item : sale.getItems()) {
+        const Product* product = item->getProduct();
+        data.lines.append(ReceiptLine{product ? product->getName() : QString("未知商品"),
+                                      item->getQuantity(), item->getUnitPrice(), item->getSubtotal()});
+        data.totalQuantity += item->getQuantity();
+    }
+    return data;
+}
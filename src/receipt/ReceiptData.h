@@ -0,0 +1,62 @@
+#ifndef RECEIPTDATA_H
+#define RECEIPTDATA_H
+
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include "../models/Money.h"
+
+class Sale;
+
+/**
+ * @brief 店铺信息（印在小票抬头和页脚）
+ */
+struct StoreInfo
+{
+    QString name = "智能超市";                       ///< 店名
+    QString address = "北京市朝阳区科技大街123号";     ///< 地址
+    QString phone = "400-123-4567";                 ///< 电话
+    QString footer = "谢谢惠顾，欢迎再次光临！";       ///< 页脚
+    QString website = "www.smartpos.com";           ///< 网址
+};
+
+/**
+ * @brief 小票上的一行商品
+ */
+struct ReceiptLine
+{
+    QString name;               ///< 商品名称
+    int quantity = 0;           ///< 数量
+    Money unitPrice;            ///< 单价
+    Money subtotal;             ///< 小计
+};
+
+/**
+ * @brief ReceiptData - 一张小票的纯数据快照
+ *
+ * 不是QObject，不引用Sale或Product，可以交给打印线程、导出线程或电子存根使用。
+ */
+struct ReceiptData
+{
+    StoreInfo store;            ///< 店铺信息
+    int transactionId = -1;     ///< 交易ID
+    QString cashierName;        ///< 收银员
+    QDateTime timestamp;        ///< 交易时间
+    QList<ReceiptLine> lines;   ///< 商品行
+    int totalQuantity = 0;      ///< 商品总件数
+    Money totalAmount;          ///< 总金额
+    Money discountAmount;       ///< 手工折扣
+    Money promotionDiscount;    ///< 促销优惠
+    Money finalAmount;          ///< 实付金额
+    QString paymentMethod;      ///< 支付方式
+
+    /**
+     * @brief 从销售生成小票快照（必须在销售所在线程调用）
+     * @param sale 销售对象
+     * @param store 店铺信息
+     * @return 小票快照
+     */
+    static ReceiptData fromSale(const Sale& sale, const StoreInfo& store = StoreInfo());
+};
+
+#endif // RECEIPTDATA_H
@@ -0,0 +1,549 @@
+#include "ReceiptTemplate.h"
+#include "EscPosRenderer.h"
+#include <QDebug>
+
+namespace {
+
+// 字段槽编号，line.* 字段只能出现在 {#lines} 块内
+enum Field : quint8 {
+    StoreName,
+    StoreAddress,
+    StorePhone,
+    StoreFooter,
+    StoreWebsite,
+    TransactionId,
+    Cashier,
+    Timestamp,
+    PaymentMethod,
+    TotalQuantity,
+    LineCount,
+    TotalAmount,
+    DiscountAmount,
+    PromotionDiscount,
+    FinalAmount,
+    LineName,
+    LineQuantity,
+    LineUnitPrice,
+    LineSubtotal
+};
+
+enum Condition : quint8 {
+    HasDiscount,
+    HasPromotion,
+    HasAnyDiscount
+};
+
+struct NamedSlot
+{
+    const char16_t* name;
+    quint8 slot;
+};
+
+const NamedSlot fieldNames[] = {
+    {u"store.name", StoreName},
+    {u"store.address", StoreAddress},
+    {u"store.phone", StorePhone},
+    {u"store.footer", StoreFooter},
+    {u"store.website", StoreWebsite},
+    {u"transaction_id", TransactionId},
+    {u"cashier", Cashier},
+    {u"timestamp", Timestamp},
+    {u"payment_method", PaymentMethod},
+    {u"total_quantity", TotalQuantity},
+    {u"line_count", LineCount},
+    {u"total", TotalAmount},
+    {u"discount", DiscountAmount},
+    {u"promotion", PromotionDiscount},
+    {u"final", FinalAmount},
+    {u"line.name", LineName},
+    {u"line.quantity", LineQuantity},
+    {u"line.unit_price", LineUnitPrice},
+    {u"line.subtotal", LineSubtotal}
+};
+
+const NamedSlot conditionNames[] = {
+    {u"discount", HasDiscount},
+    {u"promotion", HasPromotion},
+    {u"any_discount", HasAnyDiscount}
+};
+
+template <size_t N>
+int findSlot(const NamedSlot (&table)[N], QStringView name)
+{
+    for (const NamedSlot& entry : table) {
+        if (name == QStringView(entry.name)) {
+            return entry.slot;
+        }
+    }
+    return -1;
+}
+
+// 数字、金额、时间的定长格式化缓冲区，不分配内存
+struct ValueBuffer
+{
+    char16_t data[48];
+    int size = 0;
+
+    void appendChar(char16_t ch) { data[size++] = ch; }
+
+    void appendUnsigned(quint64 value, int minDigits = 1)
+    {
+        char16_t digits[24];
+        int count = 0;
+        do {
+            digits[count++] = static_cast<char16_t>(u'0' + value % 10);
+            value /= 10;
+        } while (value > 0);
+        while (count < minDigits) {
+            digits[count++] = u'0';
+        }
+        while (count > 0) {
+            data[size++] = digits[--count];
+        }
+    }
+
+    void appendInt(qint64 value)
+    {
+        if (value < 0) {
+            appendChar(u'-');
+            appendUnsigned(static_cast<quint64>(-value));
+        } else {
+            appendUnsigned(static_cast<quint64>(value));
+        }
+    }
+
+    // ¥12.50
+    void appendMoney(Money amount)
+    {
+        qint64 minor = amount.minorUnits();
+        if (minor < 0) {
+            appendChar(u'-');
+            minor = -minor;
+        }
+        appendChar(u'¥');
+        appendUnsigned(static_cast<quint64>(minor / Money::MinorPerMajor));
+        appendChar(u'.');
+        appendUnsigned(static_cast<quint64>(minor % Money::MinorPerMajor), 2);
+    }
+
+    // yyyy-MM-dd hh:mm:ss
+    void appendDateTime(const QDateTime& dateTime)
+    {
+        if (!dateTime.isValid()) {
+            return;
+        }
+        const QDate date = dateTime.date();
+        const QTime time = dateTime.time();
+        appendUnsigned(static_cast<quint64>(date.year()), 4);
+        appendChar(u'-');
+        appendUnsigned(static_cast<quint64>(date.month()), 2);
+        appendChar(u'-');
+        appendUnsigned(static_cast<quint64>(date.day()), 2);
+        appendChar(u' ');
+        appendUnsigned(static_cast<quint64>(time.hour()), 2);
+        appendChar(u':');
+        appendUnsigned(static_cast<quint64>(time.minute()), 2);
+        appendChar(u':');
+        appendUnsigned(static_cast<quint64>(time.second()), 2);
+    }
+
+    QStringView view() const { return QStringView(data, size); }
+};
+
+void appendSpaces(int count, QString* out)
+{
+    for (int i = 0; i < count; ++i) {
+        out->append(QLatin1Char(' '));
+    }
+}
+
+}
+
+ReceiptTemplate::ReceiptTemplate()
+    : m_format(PlainText)
+    , m_valid(false)
+{
+}
+
+ReceiptTemplate ReceiptTemplate::compile(const QString& source, Format format, QString* errorMessage)
+{
+    ReceiptTemplate compiled;
+    compiled.m_format = format;
+
+    auto fail = [errorMessage](const QString& message) {
+        qWarning() << "小票模板编译失败:" << message;
+        if (errorMessage) {
+            *errorMessage = message;
+        }
+        return ReceiptTemplate();
+    };
+
+    struct OpenBlock
+    {
+        int pc;
+        QStringView name;
+        bool isLines;
+    };
+    QVector<OpenBlock> openBlocks;
+    bool insideLines = false;
+
+    QString literal;
+    auto flushLiteral = [&compiled, &literal]() {
+        if (literal.isEmpty()) {
+            return;
+        }
+        Instruction ins;
+        ins.op = OpCode::Literal;
+        ins.offset = static_cast<qint32>(compiled.m_literals.size());
+        ins.length = static_cast<qint32>(literal.size());
+        compiled.m_literals += literal;
+        compiled.m_program.append(ins);
+        literal.clear();
+    };
+
+    const QStringView text(source);
+    qsizetype i = 0;
+    while (i < text.size()) {
+        const QChar ch = text[i];
+        if (ch == QLatin1Char('{') && i + 1 < text.size() && text[i + 1] == QLatin1Char('{')) {
+            literal += QLatin1Char('{');
+            i += 2;
+            continue;
+        }
+        if (ch == QLatin1Char('}') && i + 1 < text.size() && text[i + 1] == QLatin1Char('}')) {
+            literal += QLatin1Char('}');
+            i += 2;
+            continue;
+        }
+        if (ch != QLatin1Char('{')) {
+            literal += ch;
+            ++i;
+            continue;
+        }
+
+        const qsizetype close = text.indexOf(QLatin1Char('}'), i + 1);
+        if (close < 0) {
+            return fail(QString("位置%1的占位符没有闭合").arg(i));
+        }
+        const QStringView tag = text.mid(i + 1, close - i - 1).trimmed();
+        i = close + 1;
+        flushLiteral();
+
+        if (tag.startsWith(QLatin1Char('#'))) {
+            const QStringView name = tag.mid(1);
+            if (name != u"lines") {
+                return fail(QString("未知的循环块: %1").arg(name));
+            }
+            if (insideLines) {
+                return fail("商品行循环不能嵌套");
+            }
+            insideLines = true;
+            openBlocks.append(OpenBlock{static_cast<int>(compiled.m_program.size()), name, true});
+            Instruction ins;
+            ins.op = OpCode::BeginLines;
+            compiled.m_program.append(ins);
+        } else if (tag.startsWith(QLatin1Char('?'))) {
+            const QStringView name = tag.mid(1);
+            const int condition = findSlot(conditionNames, name);
+            if (condition < 0) {
+                return fail(QString("未知的条件: %1").arg(name));
+            }
+            openBlocks.append(OpenBlock{static_cast<int>(compiled.m_program.size()), name, false});
+            Instruction ins;
+            ins.op = OpCode::BeginIf;
+            ins.slot = static_cast<quint8>(condition);
+            compiled.m_program.append(ins);
+        } else if (tag.startsWith(QLatin1Char('/'))) {
+            const QStringView name = tag.mid(1);
+            if (openBlocks.isEmpty() || openBlocks.last().name != name) {
+                return fail(QString("块结束标记不匹配: %1").arg(name));
+            }
+            const OpenBlock block = openBlocks.takeLast();
+            Instruction ins;
+            ins.op = block.isLines ? OpCode::EndLines : OpCode::EndIf;
+            compiled.m_program[block.pc].jump = static_cast<qint32>(compiled.m_program.size());
+            compiled.m_program.append(ins);
+            if (block.isLines) {
+                insideLines = false;
+            }
+        } else {
+            const qsizetype colon = tag.indexOf(QLatin1Char(':'));
+            const QStringView name = colon < 0 ? tag : tag.left(colon).trimmed();
+            const int field = findSlot(fieldNames, name);
+            if (field < 0) {
+                return fail(QString("未知的字段: %1").arg(name));
+            }
+            if (field >= LineName && !insideLines) {
+                return fail(QString("字段 %1 只能用在 {#lines} 块内").arg(name));
+            }
+
+            Instruction ins;
+            ins.op = OpCode::Field;
+            ins.slot = static_cast<quint8>(field);
+            if (colon >= 0) {
+                QStringView spec = tag.mid(colon + 1).trimmed();
+                if (spec.endsWith(QLatin1Char('~'))) {
+                    ins.truncate = true;
+                    spec.chop(1);
+                }
+                ins.alignment = Alignment::Left;
+                if (spec.startsWith(QLatin1Char('<'))) {
+                    spec = spec.mid(1);
+                } else if (spec.startsWith(QLatin1Char('>'))) {
+                    ins.alignment = Alignment::Right;
+                    spec = spec.mid(1);
+                } else if (spec.startsWith(QLatin1Char('^'))) {
+                    ins.alignment = Alignment::Center;
+                    spec = spec.mid(1);
+                }
+                bool ok = false;
+                const int width = spec.toInt(&ok);
+                if (!ok || width <= 0 || width > 255) {
+                    return fail(QString("字段 %1 的宽度无效").arg(name));
+                }
+                ins.width = static_cast<qint16>(width);
+            }
+            compiled.m_program.append(ins);
+        }
+    }
+    flushLiteral();
+
+    if (!openBlocks.isEmpty()) {
+        return fail(QString("块没有结束: %1").arg(openBlocks.last().name));
+    }
+
+    compiled.m_literals.squeeze();
+    compiled.m_program.squeeze();
+    compiled.m_valid = true;
+    return compiled;
+}
+
+QString ReceiptTemplate::defaultHtmlSource()
+{
+    return QStringLiteral(
+        "<html><head><meta charset='UTF-8'></head><body>"
+        "<div style='font-family: \"Courier New\", monospace; font-size: 12px; line-height: 1.2;'>"
+        "<div style='text-align: center; margin-bottom: 10px;'>"
+        "<h2 style='margin: 0;'>{store.name}</h2>"
+        "<div>{store.address}</div>"
+        "<div>电话: {store.phone}</div>"
+        "</div>"
+        "<div style='text-align: center; margin: 10px 0;'>========================================</div>"
+        "<div style='margin-bottom: 10px;'>"
+        "<div>小票号: {transaction_id}</div>"
+        "<div>收银员: {cashier}</div>"
+        "<div>时间: {timestamp}</div>"
+        "</div>"
+        "<div style='margin: 10px 0;'>----------------------------------------</div>"
+        "<table style='width: 100%; border-collapse: collapse;'>"
+        "<tr style='border-bottom: 1px solid #ccc;'>"
+        "<th style='text-align: left; padding: 2px;'>商品</th>"
+        "<th style='text-align: center; padding: 2px;'>数量</th>"
+        "<th style='text-align: right; padding: 2px;'>单价</th>"
+        "<th style='text-align: right; padding: 2px;'>小计</th>"
+        "</tr>"
+        "{#lines}<tr>"
+        "<td style='padding: 2px;'>{line.name}</td>"
+        "<td style='text-align: center; padding: 2px;'>{line.quantity}</td>"
+        "<td style='text-align: right; padding: 2px;'>{line.unit_price}</td>"
+        "<td style='text-align: right; padding: 2px;'>{line.subtotal}</td>"
+        "</tr>{/lines}"
+        "</table>"
+        "<div style='margin: 10px 0;'>----------------------------------------</div>"
+        "<div style='text-align: right; margin: 5px 0;'>"
+        "<div>商品总数: {line_count} 件</div>"
+        "<div style='font-size: 14px; font-weight: bold;'>总金额: {total}</div>"
+        "{?promotion}<div>促销优惠: -{promotion}</div>{/promotion}"
+        "{?discount}<div>优惠金额: -{discount}</div>{/discount}"
+        "{?any_discount}<div style='font-size: 14px; font-weight: bold;'>实付金额: {final}</div>{/any_discount}"
+        "</div>"
+        "<div style='margin: 10px 0;'>"
+        "<div>支付方式: {payment_method}</div>"
+        "</div>"
+        "<div style='text-align: center; margin-top: 20px;'>"
+        "========================================"
+        "<div style='margin: 10px 0;'>{store.footer}</div>"
+        "<div style='font-size: 10px;'>{store.website}</div>"
+        "</div>"
+        "</div></body></html>");
+}
+
+QString ReceiptTemplate::defaultTextSource()
+{
+    // 列宽按显示宽度计算，中文表头后的空格数因此少于字符数对齐时的写法
+    return QStringLiteral(
+        "{store.name:^40}\n"
+        "{store.address:^40}\n"
+        "           电话: {store.phone:<23}\n"
+        "========================================\n"
+        "小票号: {transaction_id}\n"
+        "收银员: {cashier}\n"
+        "时间: {timestamp}\n"
+        "----------------------------------------\n"
+        "商品                数量  单价    小计\n"
+        "----------------------------------------\n"
+        "{#lines}{line.name:<20~}{line.quantity:<6}{line.unit_price:<8}{line.subtotal}\n{/lines}"
+        "----------------------------------------\n"
+        "商品总数: {line_count:<4} 件        总金额: {total}\n"
+        "{?promotion}促销优惠:                -{promotion}\n{/promotion}"
+        "{?discount}优惠金额:                -{discount}\n{/discount}"
+        "{?any_discount}实付金额:                {final}\n{/any_discount}"
+        "支付方式: {payment_method}\n"
+        "========================================\n"
+        "{store.footer:^40}\n"
+        "{store.website:^40}\n");
+}
+
+void ReceiptTemplate::render(const ReceiptData& data, QString* out) const
+{
+    // resize(0)保留已分配的容量，复用同一个缓冲区时不再分配内存
+    out->resize(0);
+    if (m_valid) {
+        execute(0, m_program.size(), data, nullptr, out);
+    }
+}
+
+QString ReceiptTemplate::render(const ReceiptData& data) const
+{
+    QString out;
+    render(data, &out);
+    return out;
+}
+
+void ReceiptTemplate::execute(int first, int last, const ReceiptData& data, const ReceiptLine* line, QString* out) const
+{
+    for (int pc = first; pc < last; ++pc) {
+        const Instruction& ins = m_program.at(pc);
+        switch (ins.op) {
+        case OpCode::Literal:
+            out->append(QStringView(m_literals).mid(ins.offset, ins.length));
+            break;
+        case OpCode::Field:
+            appendField(ins, data, line, out);
+            break;
+        case OpCode::BeginLines:
+            for (const ReceiptLine& item : data.lines) {
+                execute(pc + 1, ins.jump, data, &item, out);
+            }
+            pc = ins.jump;
+            break;
+        case OpCode::BeginIf: {
+            bool holds = false;
+            switch (ins.slot) {
+            case HasDiscount:
+                holds = data.discountAmount.isPositive();
+                break;
+            case HasPromotion:
+                holds = data.promotionDiscount.isPositive();
+                break;
+            case HasAnyDiscount:
+                holds = data.discountAmount.isPositive() || data.promotionDiscount.isPositive();
+                break;
+            }
+            if (!holds) {
+                pc = ins.jump;
+            }
+            break;
+        }
+        case OpCode::EndLines:
+        case OpCode::EndIf:
+            break;
+        }
+    }
+}
+
+void ReceiptTemplate::appendField(const Instruction& ins, const ReceiptData& data, const ReceiptLine* line, QString* out) const
+{
+    ValueBuffer buffer;
+    QStringView value;
+    switch (ins.slot) {
+    case StoreName:         value = data.store.name; break;
+    case StoreAddress:      value = data.store.address; break;
+    case StorePhone:        value = data.store.phone; break;
+    case StoreFooter:       value = data.store.footer; break;
+    case StoreWebsite:      value = data.store.website; break;
+    case Cashier:           value = data.cashierName; break;
+    case PaymentMethod:     value = data.paymentMethod; break;
+    case LineName:          value = line->name; break;
+    case TransactionId:     buffer.appendInt(data.transactionId); break;
+    case Timestamp:         buffer.appendDateTime(data.timestamp); break;
+    case TotalQuantity:     buffer.appendInt(data.totalQuantity); break;
+    case LineCount:         buffer.appendInt(data.lines.size()); break;
+    case TotalAmount:       buffer.appendMoney(data.totalAmount); break;
+    case DiscountAmount:    buffer.appendMoney(data.discountAmount); break;
+    case PromotionDiscount: buffer.appendMoney(data.promotionDiscount); break;
+    case FinalAmount:       buffer.appendMoney(data.finalAmount); break;
+    case LineQuantity:      buffer.appendInt(line->quantity); break;
+    case LineUnitPrice:     buffer.appendMoney(line->unitPrice); break;
+    case LineSubtotal:      buffer.appendMoney(line->subtotal); break;
+    }
+    if (buffer.size > 0) {
+        value = buffer.view();
+    }
+
+    if (ins.alignment == Alignment::None) {
+        appendEscaped(value, out);
+        return;
+    }
+
+    int width = EscPosRenderer::displayWidth(value);
+    bool truncated = false;
+    if (ins.truncate && width > ins.width) {
+        // 截断到宽度-2列，留出“..”
+        const int limit = ins.width - 2;
+        int kept = 0;
+        qsizetype end = 0;
+        while (end < value.size()) {
+            const int w = EscPosRenderer::displayWidth(value.mid(end, 1));
+            if (kept + w > limit) {
+                break;
+            }
+            kept += w;
+            ++end;
+        }
+        value = value.left(end);
+        width = kept + 2;
+        truncated = true;
+    }
+
+    const int padding = qMax(0, ins.width - width);
+    int before = 0;
+    if (ins.alignment == Alignment::Right) {
+        before = padding;
+    } else if (ins.alignment == Alignment::Center) {
+        before = padding / 2;
+    }
+
+    appendSpaces(before, out);
+    appendEscaped(value, out);
+    if (truncated) {
+        out->append(QLatin1String(".."));
+    }
+    appendSpaces(padding - before, out);
+}
+
+void ReceiptTemplate::appendEscaped(QStringView text, QString* out) const
+{
+    if (m_format != Html) {
+        out->append(text);
+        return;
+    }
+
+    // 连续的普通字符整段追加，只在需要转义的字符处打断
+    qsizetype runStart = 0;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const char16_t ch = text[i].unicode();
+        QLatin1String entity;
+        switch (ch) {
+        case u'&': entity = QLatin1String("&amp;"); break;
+        case u'<': entity = QLatin1String("&lt;"); break;
+        case u'>': entity = QLatin1String("&gt;"); break;
+        case u'"': entity = QLatin1String("&quot;"); break;
+        default: continue;
+        }
+        out->append(text.mid(runStart, i - runStart));
+        out->append(entity);
+        runStart = i + 1;
+    }
+    out->append(text.mid(runStart));
+}
@@ -0,0 +1,125 @@
+#ifndef RECEIPTTEMPLATE_H
+#define RECEIPTTEMPLATE_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include "ReceiptData.h"
+
+/**
+ * @brief ReceiptTemplate类 - 预编译的小票模板
+ *
+ * 小票版式只在启动时编译一次：模板源码被拆成静态文本段和带类型的字段槽，
+ * 渲染时按指令顺序一次写入调用方复用的QString，不再逐张拼接HTML/表头/分隔线，
+ * 也不使用QString::arg。输出缓冲区扩容到最长小票后，渲染不再分配内存。
+ *
+ * 模板语法：
+ *   {field}              字段，例如 {store.name}、{total}、{line.subtotal}
+ *   {field:<20}          左对齐补齐到20列（全角字符占两列），> 右对齐，^ 居中
+ *   {field:<20~}         超出宽度时截断并以“..”结尾
+ *   {#lines}...{/lines}  对每一行商品重复，其中可以使用 line.* 字段
+ *   {?promotion}...{/promotion}  条件段：promotion、discount、any_discount 金额为正时输出
+ *   {{                   输出字面量 {
+ *
+ * 编译后的模板是只读的，可以在多个线程中同时渲染。
+ */
+class ReceiptTemplate
+{
+public:
+    /**
+     * @brief 输出格式（HTML会转义字段中的 & < > "）
+     */
+    enum Format {
+        PlainText,
+        Html
+    };
+
+    /**
+     * @brief 构造空模板（渲染结果为空）
+     */
+    ReceiptTemplate();
+
+    /**
+     * @brief 编译模板源码
+     * @param source 模板源码
+     * @param format 输出格式
+     * @param errorMessage 如果不为空，编译失败时写入错误消息
+     * @return 编译后的模板，失败时isValid()为false
+     */
+    static ReceiptTemplate compile(const QString& source, Format format, QString* errorMessage = nullptr);
+
+    /**
+     * @brief 默认的HTML小票版式（PDF导出使用）
+     */
+    static QString defaultHtmlSource();
+
+    /**
+     * @brief 默认的40列纯文本小票版式
+     */
+    static QString defaultTextSource();
+
+    bool isValid() const { return m_valid; }
+    Format format() const { return m_format; }
+
+    /**
+     * @brief 编译后的指令数
+     */
+    int instructionCount() const { return m_program.size(); }
+
+    /**
+     * @brief 渲染小票到调用方的缓冲区
+     * @param data 小票快照
+     * @param out 输出缓冲区（先清空，保留容量）
+     */
+    void render(const ReceiptData& data, QString* out) const;
+
+    /**
+     * @brief 渲染小票，返回新字符串
+     */
+    QString render(const ReceiptData& data) const;
+
+private:
+    enum class OpCode : quint8 {
+        Literal,        ///< 输出静态文本段
+        Field,          ///< 输出字段
+        BeginLines,     ///< 商品行循环开始，jump指向对应的EndLines
+        EndLines,
+        BeginIf,        ///< 条件段开始，jump指向对应的EndIf
+        EndIf
+    };
+
+    enum class Alignment : quint8 {
+        None,
+        Left,
+        Right,
+        Center
+    };
+
+    struct Instruction
+    {
+        OpCode op = OpCode::Literal;
+        quint8 slot = 0;            ///< 字段或条件编号
+        Alignment alignment = Alignment::None;
+        bool truncate = false;      ///< 超宽时截断
+        qint16 width = 0;           ///< 对齐宽度（列）
+        qint32 offset = 0;          ///< 静态文本在m_literals中的偏移
+        qint32 length = 0;          ///< 静态文本长度
+        qint32 jump = 0;            ///< 块结束指令的位置
+    };
+
+    /**
+     * @brief 执行[first, last)范围内的指令
+     * @param line 当前商品行（循环体外为nullptr）
+     */
+    void execute(int first, int last, const ReceiptData& data, const ReceiptLine* line, QString* out) const;
+
+    void appendField(const Instruction& ins, const ReceiptData& data, const ReceiptLine* line, QString* out) const;
+    void appendEscaped(QStringView text, QString* out) const;
+
+    QVector<Instruction> m_program;     ///< 指令序列
+    QString m_literals;                 ///< 所有静态文本段
+    Format m_format;                    ///< 输出格式
+    bool m_valid;                       ///< 是否编译成功
+};
+
+#endif // RECEIPTTEMPLATE_H
@@ -0,0 +1,166 @@
+#include "ThermalPrintSpooler.h"
+#include "EscPosRenderer.h"
+#include <QThread>
+#include <QFile>
+#include <QDeadlineTimer>
+#include <QDebug>
+
+namespace {
+
+// 先写入的头部字节数（初始化指令和店名），打印机收到后即可开始打印
+const qint64 FirstChunkSize = 256;
+
+}
+
+ThermalPrintSpooler::ThermalPrintSpooler(const QString& devicePath, QObject *parent)
+    : QObject(parent)
+    , m_busy(false)
+    , m_stopping(false)
+    , m_nextJobId(1)
+    , m_devicePath(devicePath)
+    , m_columns(EscPosRenderer::Paper80mm)
+    , m_thread(nullptr)
+{
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("ThermalPrintSpooler");
+    m_thread->start();
+}
+
+ThermalPrintSpooler::~ThermalPrintSpooler()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_jobAvailable.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void ThermalPrintSpooler::setDevicePath(const QString& devicePath)
+{
+    QMutexLocker locker(&m_mutex);
+    m_devicePath = devicePath;
+}
+
+QString ThermalPrintSpooler::devicePath() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_devicePath;
+}
+
+void ThermalPrintSpooler::setColumns(int columns)
+{
+    QMutexLocker locker(&m_mutex);
+    m_columns = columns;
+}
+
+int ThermalPrintSpooler::enqueue(const ReceiptData& receipt)
+{
+    QMutexLocker locker(&m_mutex);
+    Job job{m_nextJobId++, receipt, QString(), QElapsedTimer()};
+    job.queuedAt.start();
+    m_queue.push_back(std::move(job));
+    m_jobAvailable.wakeOne();
+    return m_queue.back().jobId;
+}
+
+int ThermalPrintSpooler::enqueueText(const QString& receiptText)
+{
+    QMutexLocker locker(&m_mutex);
+    Job job{m_nextJobId++, ReceiptData(), receiptText, QElapsedTimer()};
+    job.queuedAt.start();
+    m_queue.push_back(std::move(job));
+    m_jobAvailable.wakeOne();
+    return m_queue.back().jobId;
+}
+
+int ThermalPrintSpooler::pendingJobs() const
+{
+    QMutexLocker locker(&m_mutex);
+    return static_cast<int>(m_queue.size()) + (m_busy ? 1 : 0);
+}
+
+bool ThermalPrintSpooler::waitForIdle(int msecs)
+{
+    QDeadlineTimer deadline(msecs);  // -1 永不超时
+    QMutexLocker locker(&m_mutex);
+    while (!m_queue.empty() || m_busy) {
+        if (!m_idle.wait(&m_mutex, deadline)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void ThermalPrintSpooler::run()
+{
+    // 渲染器和设备只在打印线程中使用，缓冲区和文件句柄在任务之间复用
+    EscPosRenderer renderer;
+    QFile device;
+
+    QMutexLocker locker(&m_mutex);
+    forever {
+        while (m_queue.empty() && !m_stopping) {
+            m_jobAvailable.wait(&m_mutex);
+        }
+        if (m_queue.empty()) {
+            break;  // 停止前已打印完队列中的小票
+        }
+
+        Job job = std::move(m_queue.front());
+        m_queue.pop_front();
+        const qint64 queueWaitNsecs = job.queuedAt.nsecsElapsed();
+        m_busy = true;
+        const QString devicePath = m_devicePath;
+        renderer.setColumns(m_columns);
+        locker.unlock();
+
+        QString error;
+        qint64 firstByteNsecs = -1;
+        qint64 bytesWritten = 0;
+
+        if (device.isOpen() && device.fileName() != devicePath) {
+            device.close();
+        }
+        if (devicePath.isEmpty()) {
+            error = QString("未设置打印设备");
+        } else if (!device.isOpen()) {
+            device.setFileName(devicePath);
+            // 不经过QFile缓冲，write返回时数据已交给设备
+            if (!device.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered)) {
+                error = QString("无法打开打印设备 %1: %2").arg(devicePath, device.errorString());
+            }
+        }
+
+        if (error.isEmpty()) {
+            const QByteArray& bytes = job.text.isEmpty() ? renderer.render(job.receipt)
+                                                         : renderer.renderText(job.text);
+            const qint64 firstChunk = qMin<qint64>(bytes.size(), FirstChunkSize);
+            bytesWritten = device.write(bytes.constData(), firstChunk);
+            firstByteNsecs = job.queuedAt.nsecsElapsed();
+            if (bytesWritten == firstChunk && firstChunk < bytes.size()) {
+                const qint64 rest = device.write(bytes.constData() + firstChunk, bytes.size() - firstChunk);
+                bytesWritten = rest < 0 ? rest : bytesWritten + rest;
+            }
+            if (bytesWritten != bytes.size()) {
+                error = QString("写入打印设备失败: %1").arg(device.errorString());
+                device.close();
+            }
+        }
+
+        if (error.isEmpty()) {
+            emit jobCompleted(job.jobId, queueWaitNsecs, firstByteNsecs, bytesWritten);
+        } else {
+            qWarning() << "热敏小票打印失败:" << error;
+            emit jobFailed(job.jobId, error);
+        }
+
+        locker.relock();
+        m_busy = false;
+        if (m_queue.empty()) {
+            m_idle.wakeAll();
+        }
+    }
+    m_idle.wakeAll();
+}
@@ -0,0 +1,121 @@
+#ifndef THERMALPRINTSPOOLER_H
+#define THERMALPRINTSPOOLER_H
+
+#include <QObject>
+#include <QString>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QElapsedTimer>
+#include <deque>
+#include "ReceiptData.h"
+
+class QThread;
+
+/**
+ * @brief ThermalPrintSpooler类 - 热敏小票打印队列
+ *
+ * 界面线程只把小票快照放入队列并立即返回；专用的打印线程依次用EscPosRenderer
+ * 生成ESC/POS字节流，写入打印设备。设备可以是打印机设备文件（如/dev/usb/lp0）、
+ * 命名管道或普通文件（用作本地替身）。设备在第一次打印时打开并保持打开。
+ * 小票头部先单独写入一小段，打印机收到后即可开始走纸，其余部分随后写入。
+ *
+ * jobCompleted/jobFailed在打印线程中发射，连接到界面对象时自动排队到界面线程。
+ */
+class ThermalPrintSpooler : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 构造函数（启动打印线程）
+     * @param devicePath 打印设备路径
+     * @param parent 父对象指针
+     */
+    explicit ThermalPrintSpooler(const QString& devicePath, QObject *parent = nullptr);
+
+    /**
+     * @brief 析构函数（打印完队列中剩余的小票后停止打印线程）
+     */
+    ~ThermalPrintSpooler();
+
+    /**
+     * @brief 设置打印设备路径（下一张小票起生效）
+     */
+    void setDevicePath(const QString& devicePath);
+    QString devicePath() const;
+
+    /**
+     * @brief 设置每行列数（80mm纸48列，58mm纸32列）
+     */
+    void setColumns(int columns);
+
+    /**
+     * @brief 把小票放入打印队列
+     * @param receipt 小票快照
+     * @return 打印任务ID
+     */
+    int enqueue(const ReceiptData& receipt);
+
+    /**
+     * @brief 把已排好版的小票文本放入打印队列（补打电子存根中的小票）
+     * @param receiptText 小票文本
+     * @return 打印任务ID
+     */
+    int enqueueText(const QString& receiptText);
+
+    /**
+     * @brief 队列中等待或正在打印的任务数
+     */
+    int pendingJobs() const;
+
+    /**
+     * @brief 等待队列清空
+     * @param msecs 超时时间（毫秒），-1表示一直等待
+     * @return 如果队列已清空返回true
+     */
+    bool waitForIdle(int msecs = -1);
+
+signals:
+    /**
+     * @brief 小票写入设备后发射的信号
+     * @param jobId 打印任务ID
+     * @param queueWaitNsecs 从入队到打印线程取出任务的耗时（纳秒）
+     * @param firstByteNsecs 从入队到第一段数据写入设备的耗时（纳秒，包含排队时间）
+     * @param bytesWritten 写入的字节数
+     */
+    void jobCompleted(int jobId, qint64 queueWaitNsecs, qint64 firstByteNsecs, qint64 bytesWritten);
+
+    /**
+     * @brief 打印失败时发射的信号
+     * @param jobId 打印任务ID
+     * @param errorMessage 错误消息
+     */
+    void jobFailed(int jobId, const QString& errorMessage);
+
+private:
+    struct Job
+    {
+        int jobId;
+        ReceiptData receipt;
+        QString text;               ///< 非空时直接打印该文本
+        QElapsedTimer queuedAt;
+    };
+
+    /**
+     * @brief 打印线程主循环
+     */
+    void run();
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_jobAvailable;          ///< 有新任务或要求停止
+    QWaitCondition m_idle;                  ///< 队列清空
+    std::deque<Job> m_queue;                ///< 待打印任务
+    bool m_busy;                            ///< 打印线程正在处理任务
+    bool m_stopping;                        ///< 要求打印线程退出
+    int m_nextJobId;                        ///< 下一个任务ID
+    QString m_devicePath;                   ///< 打印设备路径
+    int m_columns;                          ///< 每行列数
+    QThread* m_thread;                      ///< 打印线程
+};
+
+#endif // THERMALPRINTSPOOLER_H
@@ -5,6 +5,7 @@
 #include "../controllers/ProductManager.h"
 #include "../ai/AIRecommender.h"
 #include "../barcode/BarcodeScanner.h"
+#include "../barcode/KeyboardWedgeFilter.h"
 #include "../models/Sale.h"
 #include "../models/Product.h"
 #include "ProductDialog.h"
@@ -12,10 +13,15 @@
 #include "ProductManagementDialog.h"
 #include "SalesReportDialog.h"
 #include "../utils/ReceiptPrinter.h"
+#include "../utils/ReceiptBatchExporter.h"
+#include "../receipt/ElectronicJournal.h"
 #include "ui/CartDelegate.h"
 #include "ui/RecommendationItemWidget.h"
+#include "ui/ProductListModel.h"
+#include "../utils/Logging.h"
 
 #include <QPainter>
+#include <QSettings>
 #include <QApplication>
 #include <QMenuBar>
 #include <QToolBar>
@@ -29,11 +35,13 @@
 #include <QLineEdit>
 #include <QLabel>
 #include <QListWidget>
+#include <QListView>
 #include <QTableView>
 #include <QStandardItemModel>
 #include <QSpinBox>
 #include <QDoubleSpinBox>
 #include <QComboBox>
+#include <QCheckBox>
 #include <QTimer>
 #include <QDateTime>
 #include <QMessageBox>
@@ -42,6 +50,8 @@
 #include <QCloseEvent>
 #include <QDebug>
 #include <QFileDialog>
+#include <QStandardPaths>
+#include <climits>
 #include <QFileInfo>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -52,13 +62,37 @@ MainWindow::MainWindow(QWidget *parent)
     , m_currentUser("收银员")
     , m_scanAnimationLabel(nullptr)
 {
-    qDebug() << "MainWindow 构造函数开始";
+    qCDebug(lcUi) << "MainWindow 构造函数开始";
     
     // 初始化控制器
     m_checkoutController = std::make_unique<CheckoutController>(this);
     m_productManager = std::make_unique<ProductManager>(this);
     m_aiRecommender = std::make_unique<AIRecommender>(this);
     m_barcodeScanner = std::make_unique<BarcodeScanner>(this);
+    // 解码结果缓存：重扫同一批标签图片时不再重新解码
+    m_barcodeScanner->setDecodeCacheFile(QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/barcodes.sbc");
+
+    // 扫码枪的按键在到达输入框之前就被识别出来，直接进入条码查找
+    m_keyboardWedge = new KeyboardWedgeFilter(this);
+    m_keyboardWedge->setScope(this);
+    qApp->installEventFilter(m_keyboardWedge);
+    m_receiptPrinter = std::make_unique<ReceiptPrinter>(this);
+    // 热敏打印设备在配置中指定（打印机设备文件、命名管道或本地文件），未配置时只模拟打印
+    QSettings settings;
+    const QString thermalDevice = settings.value("printer/thermalDevice").toString();
+    if (!thermalDevice.isEmpty()) {
+        m_receiptPrinter->setThermalDevice(thermalDevice, settings.value("printer/thermalColumns", 48).toInt());
+        qCInfo(lcUi) << "热敏打印设备:" << thermalDevice;
+    }
+    m_receiptExporter = std::make_unique<ReceiptBatchExporter>(this);
+    m_receiptExporter->setStoreInfo(m_receiptPrinter->storeInfo());
+
+    // 电子存根：每笔完成的交易都存一份小票，供补打
+    QString journalPath = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation) + "/journal/receipts";
+    m_journal = std::make_unique<ElectronicJournal>(journalPath);
+    if (!m_journal->open()) {
+        qWarning() << "电子存根打开失败，本次运行的小票不会存档:" << journalPath;
+    }
     
     // 初始化UI
     initializeUI();
@@ -81,39 +115,39 @@ MainWindow::MainWindow(QWidget *parent)
     timer->start(1000);
     updateTime(); // Initial call
     
-    qDebug() << "主窗口初始化完成";
+    qCDebug(lcUi) << "主窗口初始化完成";
 }
 
 MainWindow::~MainWindow()
 {
-    qDebug() << "MainWindow 析构函数开始";
+    qCDebug(lcUi) << "MainWindow 析构函数开始";
     // Clean up the saved last sale to prevent memory leaks
     if (m_lastCompletedSale) {
         delete m_lastCompletedSale;
     }
-    qDebug() << "MainWindow 析构函数结束";
+    qCDebug(lcUi) << "MainWindow 析构函数结束";
 }
 
 void MainWindow::initializeUI()
 {
-    qDebug() << "MainWindow::initializeUI called";
+    qCDebug(lcUi) << "MainWindow::initializeUI called";
     setWindowTitle("智能超市收银系统 v1.0");
     setMinimumSize(1200, 800);
     resize(1400, 900);
     
-    qDebug() << "MainWindow::initializeUI 准备调用 setupUi(this)";
+    qCDebug(lcUi) << "MainWindow::initializeUI 准备调用 setupUi(this)";
     try {
         ui->setupUi(this);
-        qDebug() << "MainWindow ui.setupUi(this) 完成";
+        qCDebug(lcUi) << "MainWindow ui.setupUi(this) 完成";
     } catch (...) {
-        qDebug() << "MainWindow::initializeUI setupUi(this) 异常";
+        qCDebug(lcUi) << "MainWindow::initializeUI setupUi(this) 异常";
         return;
     }
     
-    qDebug() << "MainWindow::initializeUI 检查 UI 组件";
-    qDebug() << "cartTableView:" << ui->cartTableView;
-    qDebug() << "productListWidget:" << ui->productListWidget;
-    qDebug() << "recommendationListWidget:" << ui->recommendationListWidget;
+    qCDebug(lcUi) << "MainWindow::initializeUI 检查 UI 组件";
+    qCDebug(lcUi) << "cartTableView:" << ui->cartTableView;
+    qCDebug(lcUi) << "productListView:" << ui->productListView;
+    qCDebug(lcUi) << "recommendationListWidget:" << ui->recommendationListWidget;
     
     m_productModel = new QStandardItemModel(this);
     m_productModel->setHorizontalHeaderLabels({"商品名称", "数量", "单价", "小计", "操作"});
@@ -137,6 +171,15 @@ void MainWindow::initializeUI()
     if (ui->removeFromCartButton) {
         ui->removeFromCartButton->setVisible(false);
     }
+
+    // 商品列表使用虚拟化模型，只为可见行取数据
+    m_productListModel = new ProductListModel(m_productManager.get(), this);
+    if (ui->productListView) {
+        ui->productListView->setModel(m_productListModel);
+        ui->productListView->setUniformItemSizes(true);
+        ui->productListView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        ui->productListView->setSelectionMode(QAbstractItemView::SingleSelection);
+    }
     
     // Setup scan animation label
     if (ui->imageDisplayLabel) {
@@ -161,7 +204,7 @@ void MainWindow::initializeUI()
         updateRecommendationDisplay();
     });
     
-    qDebug() << "MainWindow::initializeUI 完成";
+    qCDebug(lcUi) << "MainWindow::initializeUI 完成";
 }
 
 void MainWindow::connectSignals()
@@ -169,6 +212,8 @@ void MainWindow::connectSignals()
     if (ui->newSaleButton) connect(ui->newSaleButton, &QPushButton::clicked, this, &MainWindow::onNewSale);
     if (ui->checkoutButton) connect(ui->checkoutButton, &QPushButton::clicked, this, &MainWindow::onProcessPayment);
     if (ui->clearCartButton) connect(ui->clearCartButton, &QPushButton::clicked, this, &MainWindow::onClearSale);
+    if (ui->parkSaleButton) connect(ui->parkSaleButton, &QPushButton::clicked, this, &MainWindow::onParkSale);
+    if (ui->resumeSaleButton) connect(ui->resumeSaleButton, &QPushButton::clicked, this, &MainWindow::onResumeSale);
     if (ui->addToCartButton) connect(ui->addToCartButton, &QPushButton::clicked, this, &MainWindow::onAddToCart);
     if (ui->manageProductsButton) connect(ui->manageProductsButton, &QPushButton::clicked, this, &MainWindow::onManageProducts);
     if (ui->printReceiptButton) connect(ui->printReceiptButton, &QPushButton::clicked, this, &MainWindow::onPrintReceipt);
@@ -177,16 +222,32 @@ void MainWindow::connectSignals()
     if (ui->searchButton) connect(ui->searchButton, &QPushButton::clicked, this, &MainWindow::onSearchOrScan);
     if (ui->selectImageButton) connect(ui->selectImageButton, &QPushButton::clicked, this, &MainWindow::onSelectImage);
     if (ui->selectFolderButton) connect(ui->selectFolderButton, &QPushButton::clicked, this, &MainWindow::onSelectFolder);
+    if (ui->cameraScanButton) connect(ui->cameraScanButton, &QPushButton::clicked, this, &MainWindow::onToggleCameraScan);
+    if (ui->selectVideoButton) connect(ui->selectVideoButton, &QPushButton::clicked, this, &MainWindow::onSelectVideo);
+    if (ui->multiBarcodeCheckBox) connect(ui->multiBarcodeCheckBox, &QCheckBox::toggled, m_barcodeScanner.get(), &BarcodeScanner::setMultiBarcodeMode);
+    connect(m_barcodeScanner.get(), &BarcodeScanner::barcodesDetected, this, &MainWindow::onBarcodesScanned);
+    connect(m_keyboardWedge, &KeyboardWedgeFilter::barcodeScanned, this, &MainWindow::onBarcodeScanned, Qt::DirectConnection);
     connect(m_barcodeScanner.get(), &BarcodeScanner::barcodeDetected, this, &MainWindow::onBarcodeScanned);
     connect(m_barcodeScanner.get(), &BarcodeScanner::imageLoaded, this, &MainWindow::onImageLoaded);
     connect(m_barcodeScanner.get(), &BarcodeScanner::scanProgressUpdated, this, &MainWindow::onScanProgressUpdated);
     connect(m_barcodeScanner.get(), &BarcodeScanner::scanAnimationFinished, this, &MainWindow::onScanAnimationFinished);
+    connect(m_barcodeScanner.get(), &BarcodeScanner::imageScanned, this, &MainWindow::onFolderImageScanned);
+    connect(m_barcodeScanner.get(), &BarcodeScanner::folderScanFinished, this, &MainWindow::onFolderScanFinished);
+    connect(m_barcodeScanner.get(), &BarcodeScanner::videoStatisticsUpdated, this, &MainWindow::onVideoStatisticsUpdated);
+    connect(m_barcodeScanner.get(), &BarcodeScanner::statusChanged, this, [this](BarcodeScanner::ScannerStatus status) {
+        if (ui->cameraScanButton) {
+            ui->cameraScanButton->setText(status == BarcodeScanner::ScanningVideo ? "停止扫码" : "摄像头扫码");
+        }
+    });
     if (ui->refreshRecommendationButton) connect(ui->refreshRecommendationButton, &QPushButton::clicked, this, &MainWindow::onRefreshRecommendations);
     if (ui->discountButton) connect(ui->discountButton, &QPushButton::clicked, this, &MainWindow::onApplyDiscount);
 
     // This is a robust connection. When a sale is structurally changed (item added/removed),
     // CheckoutController will emit saleUpdated(), which triggers a full refresh.
     connect(m_checkoutController.get(), &CheckoutController::saleUpdated, this, &MainWindow::updateCartDisplay);
+    // In-place quantity/price changes only touch the affected rows and the totals.
+    connect(m_checkoutController.get(), &CheckoutController::saleItemsChanged, this, &MainWindow::updateCartRows);
+    connect(m_checkoutController.get(), &CheckoutController::saleTotalChanged, this, &MainWindow::updateTotals);
     connect(m_checkoutController.get(), &CheckoutController::saleSuccessfullyCompleted, this, &MainWindow::onSaleCompleted);
     
     // Delegate and model signals
@@ -194,14 +255,26 @@ void MainWindow::connectSignals()
     connect(m_productModel, &QStandardItemModel::itemChanged, this, &MainWindow::onItemQuantityChanged);
 
     // Product Manager signal
-    connect(m_productManager.get(), &ProductManager::allProductsChanged, this, &MainWindow::updateProductDisplay);
+    connect(m_productManager.get(), &ProductManager::allProductsChanged, this, &MainWindow::onAllProductsChanged);
+    // 促销规则由ProductManager在后台加载和编译，这里只换用新的规则集
+    connect(m_productManager.get(), &ProductManager::promotionRulesChanged,
+            m_checkoutController.get(), &CheckoutController::setPromotionRules);
+    m_checkoutController->setPromotionRules(m_productManager->promotionRules());
+    connect(m_productManager.get(), &ProductManager::categoryFacetsChanged, this, &MainWindow::onCategoryFacetsChanged);
+    if (ui->categoryComboBox) connect(ui->categoryComboBox, &QComboBox::currentIndexChanged, this, &MainWindow::onCategoryFilterChanged);
     connect(m_productManager.get(), &ProductManager::productFoundByBarcode, this, &MainWindow::onProductFoundByBarcode);
+    connect(m_productManager.get(), &ProductManager::productsFoundByBarcodes, this, &MainWindow::onProductsFoundByBarcodes);
+    connect(m_productManager.get(), &ProductManager::barcodeLookupFailed, this, &MainWindow::onBarcodeLookupFailed);
 
     if (ui->actionNewSale) connect(ui->actionNewSale, &QAction::triggered, this, &MainWindow::onNewSale);
     if (ui->actionManageProducts) connect(ui->actionManageProducts, &QAction::triggered, this, &MainWindow::onManageProducts);
     if (ui->actionRefreshProducts) connect(ui->actionRefreshProducts, &QAction::triggered, this, &MainWindow::onRefreshProducts);
     if (ui->actionExit) connect(ui->actionExit, &QAction::triggered, this, &QWidget::close);
     if (ui->actionAbout) connect(ui->actionAbout, &QAction::triggered, this, &MainWindow::onAbout);
+    if (ui->actionPrintReceipt) connect(ui->actionPrintReceipt, &QAction::triggered, this, &MainWindow::onPrintReceipt);
+    if (ui->actionExportReceipts) connect(ui->actionExportReceipts, &QAction::triggered, this, &MainWindow::onExportReceipts);
+    if (ui->actionReprintReceipt) connect(ui->actionReprintReceipt, &QAction::triggered, this, &MainWindow::onReprintReceipt);
+    connect(m_receiptExporter.get(), &ReceiptBatchExporter::exportFinished, this, &MainWindow::onReceiptsExported);
 }
 
 
@@ -270,33 +343,33 @@ void MainWindow::setupStyleSheet()
 
 void MainWindow::onNewSale()
 {
-    qDebug() << "MainWindow::onNewSale called, m_currentSale:" << m_currentSale;
+    POS_TRACE(lcUi) << "MainWindow::onNewSale called, m_currentSale:" << m_currentSale;
     if (m_currentSale) {
         // 先通知CheckoutController断开信号连接
         m_checkoutController->setCurrentSale(nullptr);
         m_currentSale->deleteLater(); // Use deleteLater for safety with QObjects
-        qDebug() << "MainWindow::onNewSale scheduled old m_currentSale for deletion";
+        POS_TRACE(lcUi) << "MainWindow::onNewSale scheduled old m_currentSale for deletion";
     }
     m_currentSale = new Sale(this);
-    qDebug() << "MainWindow::onNewSale created new m_currentSale:" << m_currentSale;
+    POS_TRACE(lcUi) << "MainWindow::onNewSale created new m_currentSale:" << m_currentSale;
     m_checkoutController->setCurrentSale(m_currentSale);
-    qDebug() << "MainWindow::onNewSale calling updateCartDisplay";
+    POS_TRACE(lcUi) << "MainWindow::onNewSale calling updateCartDisplay";
     updateCartDisplay();
-    qDebug() << "MainWindow::onNewSale calling showSuccessMessage";
+    POS_TRACE(lcUi) << "MainWindow::onNewSale calling showSuccessMessage";
     showSuccessMessage("开始新的销售");
-    qDebug() << "MainWindow::onNewSale completed";
+    POS_TRACE(lcUi) << "MainWindow::onNewSale completed";
 }
 
 void MainWindow::onSaleUpdated()
 {
     // This slot is now disconnected and unused, but kept for safety.
     // The main connection is now directly from CheckoutController::saleUpdated to updateCartDisplay.
-    qDebug() << "onSaleUpdated (legacy) called. This should not happen frequently.";
+    qCDebug(lcUi) << "onSaleUpdated (legacy) called. This should not happen frequently.";
 }
 
 void MainWindow::onBarcodeScanned(const QString& barcode)
 {
-    qDebug() << "扫描到条码:" << barcode;
+    POS_TRACE(lcUi) << "扫描到条码:" << barcode;
     
     if (!m_currentSale) {
         onNewSale();
@@ -308,6 +381,7 @@ void MainWindow::onBarcodeScanned(const QString& barcode)
 
 void MainWindow::onProductFoundByBarcode(Product* product, const QString& barcode)
 {
+    m_keyboardWedge->lookupFinished(barcode);
     if (product) {
         m_checkoutController->addItemToSale(product, 1);
         showSuccessMessage(QString("添加商品: %1").arg(product->getName()));
@@ -316,13 +390,60 @@ void MainWindow::onProductFoundByBarcode(Product* product, const QString& barcod
     }
 }
 
+void MainWindow::onBarcodesScanned(const QList<DecodedBarcode>& barcodes)
+{
+    POS_TRACE(lcUi) << "多码识别到" << barcodes.size() << "个条码";
+
+    // 在预览图上框出识别到的条码
+    QPixmap marked = m_barcodeScanner->getCurrentImage();
+    if (!marked.isNull() && ui->imageDisplayLabel) {
+        QPainter painter(&marked);
+        painter.setPen(QPen(QColor(0, 200, 0), qMax(2, marked.width() / 300)));
+        for (const DecodedBarcode& barcode : barcodes) {
+            painter.drawPolygon(barcode.position);
+        }
+        painter.end();
+        ui->imageDisplayLabel->setPixmap(marked.scaled(ui->imageDisplayLabel->size(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    }
+
+    if (!m_currentSale) {
+        onNewSale();
+    }
+
+    // 全部条码一次查询、一次加入购物车
+    QStringList codes;
+    codes.reserve(barcodes.size());
+    for (const DecodedBarcode& barcode : barcodes) {
+        codes.append(barcode.text);
+    }
+    m_productManager->getProductsByBarcodes(codes);
+}
+
+void MainWindow::onProductsFoundByBarcodes(const QList<Product*>& products, const QStringList& missingBarcodes)
+{
+    const int added = products.isEmpty() ? 0 : m_checkoutController->addItemsToSale(products);
+    if (!missingBarcodes.isEmpty()) {
+        showErrorMessage(QString("添加 %1 件商品，未找到条码: %2").arg(added).arg(missingBarcodes.join(", ")));
+    } else {
+        showSuccessMessage(QString("添加 %1 件商品").arg(added));
+    }
+}
+
+void MainWindow::onBarcodeLookupFailed(const QStringList& barcodes)
+{
+    for (const QString& barcode : barcodes) {
+        m_keyboardWedge->lookupFinished(barcode);
+    }
+    showErrorMessage(QString("数据库查询失败，请重新扫描: %1").arg(barcodes.join(", ")));
+}
+
 void MainWindow::onSearchProduct()
 {
-    qDebug() << "onSearchProduct triggered";
+    POS_TRACE(lcUi) << "onSearchProduct triggered";
     QString searchText = ui->searchLineEdit->text().trimmed();
     if (!searchText.isEmpty()) {
         // 搜索商品逻辑
-        auto products = m_productManager->searchProducts(searchText);
+        auto products = m_productManager->searchProducts(searchText, currentCategory());
         updateProductDisplay(products);
         showSuccessMessage(QString("找到 %1 个商品").arg(products.size()));
     } else {
@@ -330,6 +451,60 @@ void MainWindow::onSearchProduct()
     }
 }
 
+void MainWindow::onCategoryFacetsChanged()
+{
+    if (!ui->categoryComboBox) {
+        return;
+    }
+
+    // 重建下拉项时按数据（而不是行号）恢复当前选择，且不触发重新筛选
+    const QVariant selected = ui->categoryComboBox->currentData();
+    QSignalBlocker blocker(ui->categoryComboBox);
+    ui->categoryComboBox->clear();
+
+    const auto facets = m_productManager->categoryFacets();
+    int total = 0;
+    for (const auto& facet : facets) {
+        total += facet.second;
+    }
+    ui->categoryComboBox->addItem(QString("全部分类 (%1)").arg(total), QString());
+
+    for (const auto& facet : facets) {
+        QString label = facet.first == ProductManager::UncategorizedFacet ? QString("未分类") : facet.first;
+        ui->categoryComboBox->addItem(QString("%1 (%2)").arg(label).arg(facet.second), facet.first);
+    }
+
+    int index = selected.isValid() ? ui->categoryComboBox->findData(selected) : 0;
+    ui->categoryComboBox->setCurrentIndex(qMax(0, index));
+}
+
+void MainWindow::onCategoryFilterChanged(int index)
+{
+    Q_UNUSED(index);
+    QString searchText = ui->searchLineEdit ? ui->searchLineEdit->text().trimmed() : QString();
+    updateProductDisplay(m_productManager->searchProducts(searchText, currentCategory()));
+}
+
+void MainWindow::onAllProductsChanged(const QList<Product*>& products)
+{
+    // 选择了分类时只显示该分类，直接取分类索引中的商品，无需全表过滤
+    QString category = currentCategory();
+    if (category.isEmpty()) {
+        updateProductDisplay(products);
+    } else {
+        updateProductDisplay(m_productManager->productsInCategory(category));
+    }
+}
+
+QString MainWindow::currentCategory() const
+{
+    // “全部分类”的数据为空字符串，“未分类”为ProductManager::UncategorizedFacet
+    if (!ui->categoryComboBox) {
+        return QString();
+    }
+    return ui->categoryComboBox->currentData().toString();
+}
+
 void MainWindow::onSearchOrScan()
 {
     QString input = ui->searchLineEdit->text().trimmed();
@@ -351,12 +526,12 @@ void MainWindow::onSearchOrScan()
 
 void MainWindow::onAddToCart()
 {
-    qDebug() << "onAddToCart triggered";
+    POS_TRACE(lcUi) << "onAddToCart triggered";
     // 从商品列表中选择商品添加到购物车
-    auto currentItem = ui->productListWidget->currentItem();
-    if (currentItem) {
+    QModelIndex currentIndex = ui->productListView->currentIndex();
+    if (currentIndex.isValid()) {
         bool ok;
-        int productId = currentItem->data(Qt::UserRole).toInt(&ok);
+        int productId = currentIndex.data(ProductListModel::ProductIdRole).toInt(&ok);
         if(ok) {
             auto product = m_productManager->getProductById(productId);
             if (product && m_currentSale) {
@@ -386,7 +561,7 @@ void MainWindow::onApplyDiscount()
                                                    "请输入折扣百分比 (0-100):", 
                                                    0.0, 0.0, 100.0, 2, &ok);
     if (ok) {
-        m_currentSale->setDiscountAmount(m_currentSale->getTotalAmount() * discountPercent / 100.0);
+        m_currentSale->applyPercentageDiscount(discountPercent);
         updateCartDisplay();
         showSuccessMessage(QString("应用折扣: %1%%").arg(discountPercent));
     }
@@ -395,9 +570,8 @@ void MainWindow::onApplyDiscount()
 void MainWindow::onPrintReceipt()
 {
     if (m_lastCompletedSale) {
-        ReceiptPrinter printer;
-        if(printer.printReceipt(*m_lastCompletedSale, m_lastCompletedSale->getItems())) {
-            showSuccessMessage("小票已打印");
+        if (m_receiptPrinter->printReceipt(*m_lastCompletedSale, m_lastCompletedSale->getItems())) {
+            showSuccessMessage("小票已送往打印机");
         } else {
             showErrorMessage("打印小票失败");
         }
@@ -406,6 +580,84 @@ void MainWindow::onPrintReceipt()
     }
 }
 
+void MainWindow::onReprintReceipt()
+{
+    if (!m_journal->isOpen()) {
+        showErrorMessage("电子存根不可用");
+        return;
+    }
+
+    bool ok;
+    int defaultId = m_lastCompletedSale ? m_lastCompletedSale->getTransactionId() : 1;
+    int transactionId = QInputDialog::getInt(this, "补打小票", "交易号:", defaultId, 1, INT_MAX, 1, &ok);
+    if (!ok) {
+        return;
+    }
+
+    QString receiptText = m_journal->receiptText(transactionId);
+    if (receiptText.isEmpty()) {
+        showErrorMessage(QString("电子存根中没有交易 %1 的小票").arg(transactionId));
+        return;
+    }
+    if (m_receiptPrinter->reprintText(receiptText)) {
+        showSuccessMessage(QString("交易 %1 的小票已送往打印机").arg(transactionId));
+    } else {
+        showErrorMessage("补打小票失败");
+    }
+}
+
+void MainWindow::onExportReceipts()
+{
+    bool ok;
+    QString dayText = QInputDialog::getText(this, "导出日结小票", "日期 (yyyy-MM-dd):", QLineEdit::Normal,
+                                            QDate::currentDate().toString("yyyy-MM-dd"), &ok);
+    if (!ok) {
+        return;
+    }
+    QDate day = QDate::fromString(dayText.trimmed(), "yyyy-MM-dd");
+    if (!day.isValid()) {
+        showErrorMessage("日期格式不正确");
+        return;
+    }
+
+    const QStringList modes = {"合并为一个PDF", "每笔交易一个PDF"};
+    QString mode = QInputDialog::getItem(this, "导出日结小票", "导出方式:", modes, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+
+    QString defaultDir = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation) + "/SmartPOS/Receipts";
+    QString outputPath;
+    ReceiptBatchExporter::Mode exportMode;
+    if (mode == modes.first()) {
+        exportMode = ReceiptBatchExporter::SingleDocument;
+        outputPath = QFileDialog::getSaveFileName(this, "保存日结小票",
+                                                  defaultDir + QString("/receipts_%1.pdf").arg(day.toString("yyyyMMdd")),
+                                                  "PDF文件 (*.pdf)");
+    } else {
+        exportMode = ReceiptBatchExporter::PerSale;
+        outputPath = QFileDialog::getExistingDirectory(this, "选择导出目录", defaultDir);
+    }
+    if (outputPath.isEmpty()) {
+        return;
+    }
+
+    m_receiptExporter->exportDateRange(day.startOfDay(), day.addDays(1).startOfDay(), outputPath, exportMode);
+    statusBar()->showMessage(QString("正在导出 %1 的小票...").arg(day.toString("yyyy-MM-dd")));
+}
+
+void MainWindow::onReceiptsExported(const ReceiptExportResult& result)
+{
+    if (!result.success) {
+        showErrorMessage(QString("导出小票失败: %1").arg(result.errorMessage));
+        return;
+    }
+    showSuccessMessage(QString("已导出 %1 张小票，共 %2 页（%3 页/秒）")
+                       .arg(result.receiptCount)
+                       .arg(result.pageCount)
+                       .arg(result.pagesPerSecond(), 0, 'f', 1));
+}
+
 void MainWindow::onRefreshRecommendations()
 {
     if (m_currentSale && !m_currentSale->isEmpty()) {
@@ -442,7 +694,7 @@ void MainWindow::onRecommendationSelected()
 
 void MainWindow::onProcessPayment()
 {
-    qDebug() << "onProcessPayment triggered";
+    qCDebug(lcUi) << "onProcessPayment triggered";
     if (!m_currentSale || m_currentSale->isEmpty()) {
         showErrorMessage("购物车为空，无法结算");
         return;
@@ -465,10 +717,10 @@ void MainWindow::onProcessPayment()
 
 void MainWindow::updateCartDisplay()
 {
-    qDebug() << "MainWindow::updateCartDisplay called, m_productTable:" << ui->cartTableView << ", m_totalLabel:" << ui->totalValueLabel;
+    POS_TRACE(lcUi) << "MainWindow::updateCartDisplay called, m_productTable:" << ui->cartTableView << ", m_totalLabel:" << ui->totalValueLabel;
     
     if (!ui->cartTableView || !m_productModel) {
-        qDebug() << "MainWindow::updateCartDisplay cartTableView or m_productModel is null, skipping";
+        POS_TRACE(lcUi) << "MainWindow::updateCartDisplay cartTableView or m_productModel is null, skipping";
         return;
     }
     
@@ -484,10 +736,10 @@ void MainWindow::updateCartDisplay()
 
                 auto quantityItem = new QStandardItem(QString::number(item->getQuantity()));
                 
-                auto priceItem = new QStandardItem(QString("¥%1").arg(item->getProduct()->getPrice(), 0, 'f', 2));
+                auto priceItem = new QStandardItem(QString("¥%1").arg(item->getProduct()->getPrice().toString()));
                 priceItem->setFlags(priceItem->flags() & ~Qt::ItemIsEditable);
                 
-                auto subtotalItem = new QStandardItem(QString("¥%1").arg(item->getSubtotal(), 0, 'f', 2));
+                auto subtotalItem = new QStandardItem(QString("¥%1").arg(item->getSubtotal().toString()));
                 subtotalItem->setFlags(subtotalItem->flags() & ~Qt::ItemIsEditable);
 
                 auto actionItem = new QStandardItem();
@@ -502,6 +754,33 @@ void MainWindow::updateCartDisplay()
     updateTotals();
 }
 
+void MainWindow::updateCartRows(const QList<int>& rows)
+{
+    if (!ui->cartTableView || !m_productModel || !m_currentSale) {
+        return;
+    }
+
+    const auto& items = m_currentSale->getItems();
+    if (m_productModel->rowCount() != items.size()) {
+        // 模型与销售不同步时退回整体刷新
+        updateCartDisplay();
+        return;
+    }
+
+    // 修改数量列会触发itemChanged，这里只是同步显示，不需要回写；
+    // setText由模型自己发出dataChanged，视图只重绘这些单元格
+    m_syncingCartRows = true;
+    for (int row : rows) {
+        if (row < 0 || row >= items.size()) {
+            continue;
+        }
+        const SaleItem* item = items.at(row);
+        m_productModel->item(row, 1)->setText(QString::number(item->getQuantity()));
+        m_productModel->item(row, 3)->setText(QString("¥%1").arg(item->getSubtotal().toString()));
+    }
+    m_syncingCartRows = false;
+}
+
 void MainWindow::updateTotals()
 {
     if (!m_currentSale) {
@@ -512,13 +791,13 @@ void MainWindow::updateTotals()
     }
 
     if (ui->subtotalValueLabel) {
-        ui->subtotalValueLabel->setText(QString("¥%1").arg(m_currentSale->getTotalAmount(), 0, 'f', 2));
+        ui->subtotalValueLabel->setText(QString("¥%1").arg(m_currentSale->getTotalAmount().toString()));
     }
     if (ui->discountValueLabel) {
-        ui->discountValueLabel->setText(QString("-¥%1").arg(m_currentSale->getDiscountAmount(), 0, 'f', 2));
+        ui->discountValueLabel->setText(QString("-¥%1").arg((m_currentSale->getDiscountAmount() + m_currentSale->getPromotionDiscount()).toString()));
     }
     if (ui->totalValueLabel) {
-        ui->totalValueLabel->setText(QString("¥%1").arg(m_currentSale->getFinalAmount(), 0, 'f', 2));
+        ui->totalValueLabel->setText(QString("¥%1").arg(m_currentSale->getFinalAmount().toString()));
     }
 }
 
@@ -529,8 +808,8 @@ void MainWindow::onProductDoubleClicked(const QModelIndex& index)
     }
 
     int row = index.row();
-    if (row >= 0 && row < m_currentSale->getItems().size()) {
-        SaleItem* item = m_currentSale->getItems().at(row);
+    if (row >= 0 && row < m_currentSale->itemCount()) {
+        SaleItem* item = m_currentSale->itemAt(row);
         Product* product = item->getProduct();
         
         bool ok;
@@ -546,20 +825,14 @@ void MainWindow::onProductDoubleClicked(const QModelIndex& index)
 
 void MainWindow::updateProductDisplay(const QList<Product*>& products)
 {
-    qDebug() << "updateProductDisplay called with products count:" << products.size();
-    if (!ui->productListWidget) {
-        qDebug() << "updateProductDisplay: productListWidget is null";
+    POS_TRACE(lcUi) << "updateProductDisplay called with products count:" << products.size();
+    if (!m_productListModel) {
+        POS_TRACE(lcUi) << "updateProductDisplay: product list model is null";
         return;
     }
     
-    ui->productListWidget->clear();
-    
-    for (auto* product : products) {
-        if (product) {
-            QListWidgetItem* item = new QListWidgetItem(product->getName(), ui->productListWidget);
-            item->setData(Qt::UserRole, product->getProductId());
-        }
-    }
+    // 按商品ID做差量更新，不再清空并为整个目录重建列表项
+    m_productListModel->setProducts(products);
 }
 
 void MainWindow::showErrorMessage(const QString& message)
@@ -574,7 +847,7 @@ void MainWindow::showErrorMessage(const QString& message)
 
 void MainWindow::showSuccessMessage(const QString& message)
 {
-    qDebug() << "MainWindow::showSuccessMessage called:" << message;
+    POS_TRACE(lcUi) << "MainWindow::showSuccessMessage called:" << message;
     if (ui->statusbar) {
         ui->statusbar->setStyleSheet("background-color: #28a745; color: white; font-weight: bold;");
         ui->statusbar->showMessage(message, 3000);
@@ -590,27 +863,29 @@ void MainWindow::onRefreshProducts()
 // 占位符实现（其他槽函数）
 void MainWindow::onItemQuantityChanged(QStandardItem *item)
 {
-    if (!m_currentSale || !item || item->column() != 1) {
+    if (m_syncingCartRows || !m_currentSale || !item || item->column() != 1) {
         return; 
     }
 
     bool ok;
     int newQuantity = item->text().toInt(&ok);
     int row = item->row();
-    SaleItem* saleItem = m_currentSale->getItems().at(row);
+    SaleItem* saleItem = m_currentSale->itemAt(row);
+    if (!saleItem) {
+        return;
+    }
 
     if (!ok || newQuantity < 0) {
         // Revert invalid edits without triggering a full refresh
-        QSignalBlocker blocker(m_productModel);
+        m_syncingCartRows = true;
         item->setText(QString::number(saleItem->getQuantity()));
+        m_syncingCartRows = false;
         return;
     }
 
-    // This directly updates the model, which triggers signals that bubble up.
+    // This directly updates the model; the changed row and the totals are
+    // refreshed through saleItemsChanged/saleTotalChanged.
     m_checkoutController->updateItemQuantity(saleItem->getProduct()->getProductId(), newQuantity);
-    
-    // We only need to update totals, as the view itself is already edited.
-    updateTotals();
 }
 
 void MainWindow::onRemoveItem()
@@ -626,8 +901,8 @@ void MainWindow::onRemoveItemFromCart(const QModelIndex &index)
     }
 
     int row = index.row();
-    if (row >= 0 && row < m_currentSale->getItems().size()) {
-        SaleItem* item = m_currentSale->getItems().at(row);
+    if (row >= 0 && row < m_currentSale->itemCount()) {
+        SaleItem* item = m_currentSale->itemAt(row);
         m_checkoutController->removeItemFromSale(item->getProduct()->getProductId());
         showSuccessMessage("商品已移除");
     }
@@ -635,7 +910,7 @@ void MainWindow::onRemoveItemFromCart(const QModelIndex &index)
 
 void MainWindow::onClearSale()
 {
-    qDebug() << "onClearSale triggered";
+    qCDebug(lcUi) << "onClearSale triggered";
     if (m_currentSale) {
         m_checkoutController->cancelSale();
         updateCartDisplay();
@@ -646,6 +921,65 @@ void MainWindow::onClearSale()
     }
 }
 
+void MainWindow::onParkSale()
+{
+    if (!m_currentSale || m_currentSale->isEmpty()) {
+        showErrorMessage("购物车为空，无需挂单");
+        return;
+    }
+
+    bool ok;
+    QString label = QInputDialog::getText(this, "挂单", "备注（可选）:", QLineEdit::Normal, QString(), &ok);
+    if (!ok) {
+        return;
+    }
+
+    int parkedId = m_checkoutController->parkCurrentSale(label.trimmed());
+    if (parkedId >= 0) {
+        if (ui->recommendationListWidget) {
+            ui->recommendationListWidget->clear();
+        }
+        showSuccessMessage(QString("已挂单，单号: %1").arg(parkedId));
+    }
+}
+
+void MainWindow::onResumeSale()
+{
+    const QList<ParkedSaleInfo> parked = m_checkoutController->parkedSales();
+    if (parked.isEmpty()) {
+        showErrorMessage("没有挂单");
+        return;
+    }
+    if (m_currentSale && !m_currentSale->isEmpty()) {
+        showErrorMessage("请先完成或挂起当前销售");
+        return;
+    }
+
+    QStringList entries;
+    for (const ParkedSaleInfo& info : parked) {
+        entries << QString("#%1  %2  %3件  ¥%4  %5")
+                   .arg(info.parkedId)
+                   .arg(info.parkedAt.toString("hh:mm"))
+                   .arg(info.itemCount)
+                   .arg(info.totalAmount.toString())
+                   .arg(info.label);
+    }
+
+    bool ok;
+    QString choice = QInputDialog::getItem(this, "取单", "选择挂单:", entries, 0, false, &ok);
+    if (!ok) {
+        return;
+    }
+
+    const ParkedSaleInfo& info = parked.at(entries.indexOf(choice));
+    ProductManager* productManager = m_productManager.get();
+    if (m_checkoutController->resumeParkedSale(info.parkedId, [productManager](int productId) {
+            return productManager->getProductById(productId);
+        })) {
+        showSuccessMessage(QString("已恢复挂单: %1").arg(info.parkedId));
+    }
+}
+
 void MainWindow::onManageProducts()
 {
     ProductManagementDialog dialog(m_productManager.get(), this);
@@ -656,7 +990,7 @@ void MainWindow::onManageProducts()
 
 void MainWindow::onRecommendationsUpdated(const QList<int>& productIds)
 {
-    qDebug() << "onRecommendationsUpdated triggered, productIds:" << productIds;
+    POS_TRACE(lcUi) << "onRecommendationsUpdated triggered, productIds:" << productIds;
     updateRecommendationDisplay(productIds);
 }
 
@@ -674,7 +1008,7 @@ void MainWindow::updateRecommendationDisplay()
 void MainWindow::updateRecommendationDisplay(const QList<int>& productIds)
 {
     if (!ui->recommendationListWidget) {
-        qDebug() << "updateRecommendationDisplay: recommendationListWidget is null";
+        qCDebug(lcUi) << "updateRecommendationDisplay: recommendationListWidget is null";
         return;
     }
     
@@ -723,7 +1057,17 @@ void MainWindow::onSaleCompleted(Sale* sale)
     // Create a deep copy of the completed sale.
     // This requires Sale to have a proper copy constructor.
     m_lastCompletedSale = new Sale(*sale);
-    qDebug() << "Last completed sale has been stored. Transaction ID:" << m_lastCompletedSale->getTransactionId();
+    qCDebug(lcUi) << "Last completed sale has been stored. Transaction ID:" << m_lastCompletedSale->getTransactionId();
+
+    if (m_journal->isOpen()
+        && !m_journal->append(ReceiptData::fromSale(*m_lastCompletedSale, m_receiptPrinter->storeInfo()))) {
+        qWarning() << "小票未能写入电子存根，交易:" << m_lastCompletedSale->getTransactionId();
+    }
+
+    // 收银控制器不再负责打印，交易保存后由界面打印票据
+    if (!m_receiptPrinter->printReceipt(*m_lastCompletedSale, m_lastCompletedSale->getItems())) {
+        qWarning() << "打印票据失败，但交易已保存";
+    }
 }
 
 void MainWindow::updateTime()
@@ -748,7 +1092,7 @@ void MainWindow::closeEvent(QCloseEvent *event)
     if (reply == QMessageBox::Yes) {
         m_isClosing = true;
         // Perform any cleanup here if necessary
-        qDebug() << "Application is closing.";
+        qCDebug(lcUi) << "Application is closing.";
         event->accept();
         QApplication::quit(); // Ensure the application quits properly
     } else {
@@ -779,6 +1123,87 @@ void MainWindow::onSelectFolder()
     }
 }
 
+void MainWindow::onFolderImageScanned(const BarcodeScanResult& result, int total)
+{
+    if (ui->scanProgressBar) {
+        ui->scanProgressBar->setValue((result.index + 1) * 100 / total);
+    }
+    if (ui->scanStatusLabel) {
+        ui->scanStatusLabel->setText(tr("已扫描 %1/%2: %3").arg(result.index + 1).arg(total)
+                                     .arg(QFileInfo(result.filePath).fileName()));
+    }
+}
+
+void MainWindow::onFolderScanFinished(const QList<BarcodeScanResult>& results, double seconds)
+{
+    int found = 0;
+    int cached = 0;
+    double decodeMsecs = 0.0;
+    for (const BarcodeScanResult& result : results) {
+        if (result.found()) {
+            ++found;
+        }
+        if (result.fromCache) {
+            ++cached;
+        }
+        decodeMsecs += result.decodeMsecs;
+    }
+
+    if (ui->scanProgressBar) {
+        ui->scanProgressBar->setValue(0);
+    }
+    if (ui->scanStatusLabel) {
+        ui->scanStatusLabel->setText(QString("文件夹扫描完成: %1/%2 张识别成功 (%5 张取自缓存), 用时 %3 秒 (%4 张/秒)")
+                                     .arg(found)
+                                     .arg(results.size())
+                                     .arg(seconds, 0, 'f', 2)
+                                     .arg(seconds > 0.0 ? results.size() / seconds : 0.0, 0, 'f', 1)
+                                     .arg(cached));
+    }
+    qCDebug(lcUi) << "文件夹扫描:" << results.size() << "张," << found << "张识别成功, 平均解码"
+                  << (results.isEmpty() ? 0.0 : decodeMsecs / results.size()) << "ms, 各阶段命中"
+                  << m_barcodeScanner->stageHits();
+}
+
+void MainWindow::onToggleCameraScan()
+{
+    if (m_barcodeScanner->getStatus() == BarcodeScanner::ScanningVideo) {
+        m_barcodeScanner->stopScanning();
+        ui->scanStatusLabel->setText("扫描状态: 就绪");
+        return;
+    }
+    if (m_barcodeScanner->getStatus() != BarcodeScanner::Stopped) {
+        showErrorMessage("扫描器正在运行，请先停止。");
+        return;
+    }
+
+    if (m_barcodeScanner->startCameraScan()) {
+        ui->scanStatusLabel->setText("状态: 摄像头扫码中...");
+    }
+}
+
+void MainWindow::onSelectVideo()
+{
+    if (m_barcodeScanner->getStatus() != BarcodeScanner::Stopped) {
+        showErrorMessage("扫描器正在运行，请先停止。");
+        return;
+    }
+
+    QString filePath = QFileDialog::getOpenFileName(this, "选择条码视频", "", "视频文件 (*.mp4 *.mov *.avi *.mkv *.webm)");
+    if (!filePath.isEmpty() && m_barcodeScanner->scanVideoFile(filePath)) {
+        ui->scanStatusLabel->setText(tr("正在扫描视频: %1").arg(QFileInfo(filePath).fileName()));
+    }
+}
+
+void MainWindow::onVideoStatisticsUpdated(double framesPerSecond, double latencyMsecs)
+{
+    if (ui->scanStatusLabel) {
+        ui->scanStatusLabel->setText(QString("视频扫码: %1 帧/秒, 延迟 %2 ms")
+                                     .arg(framesPerSecond, 0, 'f', 1)
+                                     .arg(latencyMsecs, 0, 'f', 1));
+    }
+}
+
 void MainWindow::onImageLoaded(const QPixmap& image, const QString& filePath)
 {
     if (ui->imageDisplayLabel) {
@@ -819,7 +1244,7 @@ void MainWindow::onScanAnimationFinished()
         ui->scanStatusLabel->setText("扫描完成");
     }
     
-    qDebug() << "扫描动画完成";
+    qCDebug(lcUi) << "扫描动画完成";
     if(m_scanAnimationLabel) {
         m_scanAnimationLabel->hide();
     }
@@ -39,9 +39,17 @@ class CheckoutController;
 class ProductManager;
 class AIRecommender;
 class BarcodeScanner;
+struct BarcodeScanResult;
+struct DecodedBarcode;
+class ReceiptPrinter;
+class ReceiptBatchExporter;
+class ElectronicJournal;
+class KeyboardWedgeFilter;
+struct ReceiptExportResult;
 class Product;
 class Sale;
 class CartDelegate;
+class ProductListModel;
 
 /**
  * @brief MainWindow类 - 主窗口界面
@@ -80,6 +88,8 @@ private slots:
     void onProcessPayment();
     void onClearSale();
     void onRemoveItemFromCart(const QModelIndex &index);
+    void onParkSale();
+    void onResumeSale();
     
     // 商品管理槽函数
     void onManageProducts();
@@ -88,7 +98,15 @@ private slots:
     // 条码扫描槽函数
     void onBarcodeScanned(const QString& barcode);
     void onProductFoundByBarcode(Product* product, const QString& barcode);
+    void onBarcodesScanned(const QList<DecodedBarcode>& barcodes);
+    void onProductsFoundByBarcodes(const QList<Product*>& products, const QStringList& missingBarcodes);
+    void onBarcodeLookupFailed(const QStringList& barcodes);
     void onSearchProduct();
+
+    // 分类浏览槽函数
+    void onCategoryFacetsChanged();
+    void onCategoryFilterChanged(int index);
+    void onAllProductsChanged(const QList<Product*>& products);
     
     // 图片扫描槽函数
     void onSelectImage();
@@ -96,6 +114,13 @@ private slots:
     void onImageLoaded(const QPixmap& image, const QString& filePath);
     void onScanProgressUpdated(double progress);
     void onScanAnimationFinished();
+    void onFolderImageScanned(const BarcodeScanResult& result, int total);
+    void onFolderScanFinished(const QList<BarcodeScanResult>& results, double seconds);
+
+    // 视频流扫描槽函数
+    void onToggleCameraScan();
+    void onSelectVideo();
+    void onVideoStatisticsUpdated(double framesPerSecond, double latencyMsecs);
     
     // AI推荐槽函数
     void onRecommendationSelected();
@@ -110,6 +135,9 @@ private slots:
     void onAddToCart();
     void onApplyDiscount();
     void onPrintReceipt();
+    void onExportReceipts();
+    void onReprintReceipt();
+    void onReceiptsExported(const ReceiptExportResult& result);
     void onRefreshProducts();
     
     // 系统槽函数
@@ -148,11 +176,23 @@ private:
      */
     void updateCartDisplay();
     
+    /**
+     * @brief 只更新购物车中发生变化的行
+     * @param rows 发生变化的项目索引
+     */
+    void updateCartRows(const QList<int>& rows);
+    
     /**
      * @brief 更新商品列表显示
      */
     void updateProductDisplay(const QList<Product*>& products);
     
+    /**
+     * @brief 获取当前选中的分类
+     * @return 分类名，未选择分类（全部）时返回空字符串
+     */
+    QString currentCategory() const;
+    
     /**
      * @brief 更新推荐商品显示
      */
@@ -192,10 +232,16 @@ private:
     std::unique_ptr<ProductManager> m_productManager;
     std::unique_ptr<AIRecommender> m_aiRecommender;
     std::unique_ptr<BarcodeScanner> m_barcodeScanner;
+    std::unique_ptr<ReceiptPrinter> m_receiptPrinter;
+    std::unique_ptr<ReceiptBatchExporter> m_receiptExporter;
+    std::unique_ptr<ElectronicJournal> m_journal;
+    KeyboardWedgeFilter* m_keyboardWedge = nullptr;    ///< 扫码枪输入识别（应用程序级事件过滤器）
     CartDelegate* m_cartDelegate;
     
     // UI文件中的组件引用（通过UI文件自动生成）
     QStandardItemModel* m_productModel;
+    ProductListModel* m_productListModel = nullptr;
+    bool m_syncingCartRows = false;    ///< 正在把销售数据写回购物车表格，onItemQuantityChanged忽略这些修改
 
     // 状态保存
     Sale* m_lastCompletedSale = nullptr;
@@ -9,10 +9,10 @@
 
 #include "../controllers/CheckoutController.h"
 
-PaymentDialog::PaymentDialog(double totalAmount, CheckoutController* checkoutController, QWidget *parent)
+PaymentDialog::PaymentDialog(Money totalAmount, CheckoutController* checkoutController, QWidget *parent)
     : QDialog(parent)
     , m_totalAmount(totalAmount)
-    , m_changeAmount(0.0)
+    , m_changeAmount()
     , m_result(Cancelled)
     , m_selectedMethod(Cash)
     , m_checkoutController(checkoutController) // Initialize controller
@@ -38,7 +38,7 @@ void PaymentDialog::setupUI()
     auto *amountGroup = new QGroupBox(tr("订单信息"), this);
     auto *amountLayout = new QFormLayout(amountGroup);
 
-    m_totalLabel = new QLabel(QString("¥%1").arg(m_totalAmount, 0, 'f', 2), this);
+    m_totalLabel = new QLabel(QString("¥%1").arg(m_totalAmount.toString()), this);
     amountLayout->addRow(tr("总金额:"), m_totalLabel);
 
     m_changeLabel = new QLabel("¥0.00", this);
@@ -77,7 +77,7 @@ void PaymentDialog::setupUI()
     m_cashAmountSpinBox->setRange(0.0, 999999.99);
     m_cashAmountSpinBox->setDecimals(2);
     m_cashAmountSpinBox->setSuffix(" 元");
-    m_cashAmountSpinBox->setValue(m_totalAmount);
+    m_cashAmountSpinBox->setValue(m_totalAmount.toDouble());
     m_cashAmountSpinBox->setButtonSymbols(QAbstractSpinBox::NoButtons);
     inputLayout->addRow(m_cashAmountLabel, m_cashAmountSpinBox);
 
@@ -145,7 +145,7 @@ void PaymentDialog::onPaymentMethodChanged()
     m_cashAmountSpinBox->setVisible(isCash);
 
     if (isCash) {
-        m_cashAmountSpinBox->setValue(m_totalAmount);
+        m_cashAmountSpinBox->setValue(m_totalAmount.toDouble());
         m_cashAmountSpinBox->setFocus();
         m_cashAmountSpinBox->selectAll();
     }
@@ -161,7 +161,7 @@ void PaymentDialog::onCashAmountChanged()
 
 void PaymentDialog::calculateChange()
 {
-    double paidAmount = 0;
+    Money paidAmount;
     if (m_selectedMethod == Cash) {
         paidAmount = getCashAmount();
     } else {
@@ -170,12 +170,12 @@ void PaymentDialog::calculateChange()
 
     m_changeAmount = paidAmount - m_totalAmount;
     
-    if (m_changeAmount < 0) {
-        m_changeLabel->setText(QString("还需: ¥%1").arg(-m_changeAmount, 0, 'f', 2));
+    if (m_changeAmount.isNegative()) {
+        m_changeLabel->setText(QString("还需: ¥%1").arg((-m_changeAmount).toString()));
         m_changeLabel->setStyleSheet("font-size: 16px; font-weight: bold; color: #d32f2f;");
         m_processButton->setEnabled(false);
     } else {
-        m_changeLabel->setText(QString("¥%1").arg(m_changeAmount, 0, 'f', 2));
+        m_changeLabel->setText(QString("¥%1").arg(m_changeAmount.toString()));
         m_changeLabel->setStyleSheet("font-size: 16px; font-weight: bold; color: #388e3c;");
         m_processButton->setEnabled(true);
     }
@@ -200,8 +200,8 @@ void PaymentDialog::updatePaymentDisplay()
         break;
     }
 
-    bool hasChange = m_changeAmount > 0;
-    m_changeLabel->setText(QString("¥%1").arg(m_changeAmount, 0, 'f', 2));
+    bool hasChange = m_changeAmount.isPositive();
+    m_changeLabel->setText(QString("¥%1").arg(m_changeAmount.toString()));
 }
 
 void PaymentDialog::processPayment()
@@ -219,7 +219,7 @@ void PaymentDialog::processPayment()
         default: methodStr = "Unknown";
     }
 
-    double paidAmount = (m_selectedMethod == Cash) ? getCashAmount() : m_totalAmount;
+    Money paidAmount = (m_selectedMethod == Cash) ? getCashAmount() : m_totalAmount;
 
     // Delegate payment processing to the controller
     bool success = m_checkoutController->processPayment(methodStr, m_totalAmount, paidAmount);
@@ -361,22 +361,23 @@ PaymentDialog::PaymentMethod PaymentDialog::getPaymentMethod() const
     return m_selectedMethod;
 }
 
-double PaymentDialog::getCashAmount() const
+Money PaymentDialog::getCashAmount() const
 {
-    return m_cashAmountSpinBox->value();
+    // 输入框的两位小数值转换为分，避免与应付金额比较时的浮点误差
+    return Money::fromDouble(m_cashAmountSpinBox->value());
 }
 
-double PaymentDialog::getCardAmount() const
+Money PaymentDialog::getCardAmount() const
 {
-    return (m_selectedMethod == Card) ? m_totalAmount : 0.0;
+    return (m_selectedMethod == Card) ? m_totalAmount : Money();
 }
 
-double PaymentDialog::getMobileAmount() const
+Money PaymentDialog::getMobileAmount() const
 {
-    return (m_selectedMethod == Mobile) ? m_totalAmount : 0.0;
+    return (m_selectedMethod == Mobile) ? m_totalAmount : Money();
 }
 
-double PaymentDialog::getChangeAmount() const
+Money PaymentDialog::getChangeAmount() const
 {
     return m_changeAmount;
 }
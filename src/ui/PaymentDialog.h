@@ -10,6 +10,7 @@
 #include <QButtonGroup>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
+#include "../models/Money.h"
 #include <QFormLayout>
 #include <QGroupBox>
 #include <QTimer>
@@ -46,13 +47,13 @@ public:
      * @param checkoutController 收银控制器
      * @param parent 父窗口指针
      */
-    PaymentDialog(double totalAmount, CheckoutController* checkoutController, QWidget *parent = nullptr);
+    PaymentDialog(Money totalAmount, CheckoutController* checkoutController, QWidget *parent = nullptr);
 
     PaymentMethod getPaymentMethod() const;
-    double getCashAmount() const;
-    double getCardAmount() const;
-    double getMobileAmount() const;
-    double getChangeAmount() const;
+    Money getCashAmount() const;
+    Money getCardAmount() const;
+    Money getMobileAmount() const;
+    Money getChangeAmount() const;
     PaymentResult getResult() const;
 
 private slots:
@@ -95,8 +96,8 @@ private:
     QLabel *m_statusLabel;
     
     // Data
-    double m_totalAmount;
-    double m_changeAmount;
+    Money m_totalAmount;
+    Money m_changeAmount;
     PaymentResult m_result;
     PaymentMethod m_selectedMethod;
     CheckoutController* m_checkoutController; // Add controller member
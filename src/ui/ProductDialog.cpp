@@ -1,4 +1,5 @@
 #include "ProductDialog.h"
+#include "../barcode/KeyboardWedgeFilter.h"
 #include <QRegularExpression>
 #include <QStandardPaths>
 #include <QDir>
@@ -56,6 +57,8 @@ void ProductDialog::setupUI()
 
     m_barcodeEdit = new QLineEdit(this);
     m_barcodeEdit->setPlaceholderText(tr("请输入或生成条形码"));
+    // 扫码枪扫入的是新商品的条码，不能被当成收银扫码
+    m_barcodeEdit->setProperty(KeyboardWedgeFilter::ExemptProperty, true);
     auto *barcodeLayout = new QHBoxLayout();
     barcodeLayout->addWidget(m_barcodeEdit);
     m_generateBarcodeButton = new QPushButton(tr("生成"), this);
@@ -272,7 +275,7 @@ std::unique_ptr<Product> ProductDialog::getProduct() const
     product->setName(m_nameEdit->text().trimmed());
     product->setBarcode(m_barcodeEdit->text().trimmed());
     product->setDescription(m_descriptionEdit->toPlainText().trimmed());
-    product->setPrice(m_priceSpinBox->value());
+    product->setPrice(Money::fromDouble(m_priceSpinBox->value()));
     product->setStockQuantity(m_stockSpinBox->value());
     product->setCategory(m_categoryCombo->currentText().trimmed());
     if (m_editMode) {
@@ -291,7 +294,7 @@ void ProductDialog::setProduct(const Product *product)
     
     m_nameEdit->setText(m_product.getName());
     m_barcodeEdit->setText(m_product.getBarcode());
-    m_priceSpinBox->setValue(m_product.getPrice());
+    m_priceSpinBox->setValue(m_product.getPrice().toDouble());
     m_stockSpinBox->setValue(m_product.getStockQuantity());
     
     int categoryIndex = m_categoryCombo->findText(m_product.getCategory());
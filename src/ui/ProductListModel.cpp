@@ -0,0 +1,244 @@
+#include "ProductListModel.h"
+#include "../controllers/ProductManager.h"
+#include "../models/Product.h"
+#include <algorithm>
+#include <utility>
+
+namespace {
+// 每次fetchMore向视图暴露的行数
+const int DefaultFetchBatchSize = 200;
+}
+
+ProductListModel::ProductListModel(ProductManager* productManager, QObject *parent)
+    : QAbstractListModel(parent)
+    , m_productManager(productManager)
+    , m_loadedCount(0)
+    , m_fetchBatchSize(DefaultFetchBatchSize)
+{
+}
+
+int ProductListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_loadedCount;
+}
+
+QVariant ProductListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_loadedCount) {
+        return QVariant();
+    }
+
+    int productId = m_productIds.at(index.row());
+    if (role == ProductIdRole) {
+        return productId;
+    }
+
+    // 只在视图真正需要绘制该行时才访问商品对象
+    const Product* product = m_productManager ? m_productManager->getProductById(productId) : nullptr;
+    if (!product) {
+        return QVariant();
+    }
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return product->getName();
+    case Qt::ToolTipRole:
+        return QString("条码: %1\n价格: ¥%2\n库存: %3")
+               .arg(product->getBarcode())
+               .arg(product->getPrice().toString())
+               .arg(product->getStockQuantity());
+    case BarcodeRole:
+        return product->getBarcode();
+    case PriceRole:
+        return QVariant::fromValue(product->getPrice());
+    case StockRole:
+        return product->getStockQuantity();
+    default:
+        return QVariant();
+    }
+}
+
+bool ProductListModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && m_loadedCount < m_productIds.size();
+}
+
+void ProductListModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid()) {
+        return;
+    }
+
+    int remaining = m_productIds.size() - m_loadedCount;
+    int itemsToFetch = qMin(m_fetchBatchSize, remaining);
+    if (itemsToFetch <= 0) {
+        return;
+    }
+
+    beginInsertRows(QModelIndex(), m_loadedCount, m_loadedCount + itemsToFetch - 1);
+    m_loadedCount += itemsToFetch;
+    endInsertRows();
+}
+
+void ProductListModel::setProducts(const QList<Product*>& products)
+{
+    QHash<int, Product*> incoming;
+    QList<int> incomingIds;
+    incoming.reserve(products.size());
+    incomingIds.reserve(products.size());
+    for (Product* product : products) {
+        if (product && !incoming.contains(product->getProductId())) {
+            incoming.insert(product->getProductId(), product);
+            incomingIds.append(product->getProductId());
+        }
+    }
+
+    // 已存在的商品在旧列表中的相对顺序必须与新列表相同，否则只靠插入和删除得不到新顺序
+    QList<int> survivorOrder;
+    for (int productId : std::as_const(incomingIds)) {
+        if (m_rowById.contains(productId)) {
+            survivorOrder.append(productId);
+        }
+    }
+    int survivors = survivorOrder.size();
+    int added = incomingIds.size() - survivors;
+    bool sameOrder = true;
+    int next = 0;
+    for (int productId : std::as_const(m_productIds)) {
+        if (incoming.contains(productId) && survivorOrder.at(next++) != productId) {
+            sameOrder = false;
+            break;
+        }
+    }
+
+    // 变化超过一半时（如清空搜索条件），直接重置比逐行通知更便宜。
+    // 由于数据是按需读取的，重置本身并不昂贵。
+    if (m_productIds.isEmpty() || !sameOrder || survivors < m_productIds.size() / 2 || added > survivors) {
+        beginResetModel();
+        m_productIds = incomingIds;
+        m_loadedCount = qMin(m_fetchBatchSize, m_productIds.size());
+        reindexFrom(0);
+        endResetModel();
+        return;
+    }
+
+    removeMissingRows(incoming);
+    reindexFrom(0);
+
+    // 已存在的行只需通知视图重新读取数据，视图只会重绘可见部分
+    if (m_loadedCount > 0) {
+        emit dataChanged(index(0), index(m_loadedCount - 1));
+    }
+
+    // 新增商品插入到它在新列表中的位置，结果与整体重置的行顺序一致
+    int firstInserted = -1;
+    int row = 0;
+    while (row < incomingIds.size()) {
+        if (row < m_productIds.size() && m_productIds.at(row) == incomingIds.at(row)) {
+            ++row;
+            continue;
+        }
+
+        int first = row;
+        while (row < incomingIds.size() && !m_rowById.contains(incomingIds.at(row))) {
+            ++row;
+        }
+        if (row == first) {
+            break;
+        }
+        insertIds(first, incomingIds.mid(first, row - first));
+        if (firstInserted < 0) {
+            firstInserted = first;
+        }
+    }
+    if (firstInserted >= 0) {
+        reindexFrom(firstInserted);
+    }
+}
+
+int ProductListModel::productIdAt(int row) const
+{
+    if (row < 0 || row >= m_loadedCount) {
+        return -1;
+    }
+    return m_productIds.at(row);
+}
+
+int ProductListModel::rowOfProduct(int productId) const
+{
+    int row = m_rowById.value(productId, -1);
+    return row < m_loadedCount ? row : -1;
+}
+
+void ProductListModel::setFetchBatchSize(int batchSize)
+{
+    m_fetchBatchSize = qMax(1, batchSize);
+}
+
+void ProductListModel::removeMissingRows(const QHash<int, Product*>& keep)
+{
+    // 从后向前查找连续的待删除区间，每个区间只发一次通知
+    for (int last = m_productIds.size() - 1; last >= 0; --last) {
+        if (keep.contains(m_productIds.at(last))) {
+            continue;
+        }
+
+        int first = last;
+        while (first > 0 && !keep.contains(m_productIds.at(first - 1))) {
+            --first;
+        }
+
+        // 尚未暴露给视图的部分直接删除，不需要通知
+        int visibleLast = last;
+        if (last >= m_loadedCount) {
+            int hiddenFirst = qMax(first, m_loadedCount);
+            m_productIds.remove(hiddenFirst, last - hiddenFirst + 1);
+            visibleLast = hiddenFirst - 1;
+        }
+
+        if (first <= visibleLast) {
+            beginRemoveRows(QModelIndex(), first, visibleLast);
+            m_productIds.remove(first, visibleLast - first + 1);
+            m_loadedCount -= visibleLast - first + 1;
+            endRemoveRows();
+        }
+
+        last = first;
+    }
+}
+
+void ProductListModel::insertIds(int row, const QList<int>& productIds)
+{
+    const int count = productIds.size();
+    const bool fullyLoaded = (m_loadedCount == m_productIds.size());
+
+    // 插在已暴露的行之间必须通知视图；插在末尾时只有已全部加载才需要主动暴露，
+    // 否则视图会通过fetchMore取到
+    int visibleCount = 0;
+    if (row < m_loadedCount) {
+        visibleCount = count;
+    } else if (row == m_loadedCount && fullyLoaded) {
+        visibleCount = qMin(count, m_fetchBatchSize);
+    }
+
+    if (visibleCount > 0) {
+        beginInsertRows(QModelIndex(), row, row + visibleCount - 1);
+    }
+    m_productIds.insert(row, count, 0);
+    std::copy(productIds.begin(), productIds.end(), m_productIds.begin() + row);
+    m_loadedCount += visibleCount;
+    if (visibleCount > 0) {
+        endInsertRows();
+    }
+}
+
+void ProductListModel::reindexFrom(int fromRow)
+{
+    if (fromRow == 0) {
+        m_rowById.clear();
+        m_rowById.reserve(m_productIds.size());
+    }
+    for (int row = fromRow; row < m_productIds.size(); ++row) {
+        m_rowById.insert(m_productIds.at(row), row);
+    }
+}
@@ -0,0 +1,99 @@
+#ifndef PRODUCTLISTMODEL_H
+#define PRODUCTLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QHash>
+#include <QList>
+
+class Product;
+class ProductManager;
+
+/**
+ * @brief ProductListModel类 - 商品列表的虚拟化数据模型
+ *
+ * 模型只保存商品ID，显示数据在视图请求时才从ProductManager的缓存中读取，
+ * 因此视图只会为可见行取数据。行通过canFetchMore/fetchMore分批暴露给视图，
+ * 商品列表变化时按ID做差量，只对新增、删除和修改的行发出细粒度通知，
+ * 而不是清空后整体重建。
+ */
+class ProductListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 自定义数据角色
+     */
+    enum Roles {
+        ProductIdRole = Qt::UserRole,   ///< 商品ID（与原QListWidgetItem的UserRole保持一致）
+        BarcodeRole,                    ///< 条形码
+        PriceRole,                      ///< 价格（Money）
+        StockRole                       ///< 库存数量
+    };
+
+    /**
+     * @brief 构造函数
+     * @param productManager 商品管理器（非拥有指针，用于按ID查找商品）
+     * @param parent 父对象指针
+     */
+    explicit ProductListModel(ProductManager* productManager, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+    /**
+     * @brief 用新的商品列表更新模型（按商品ID做差量更新）
+     * @param products 新的商品列表
+     */
+    void setProducts(const QList<Product*>& products);
+
+    /**
+     * @brief 获取指定行的商品ID
+     * @param row 行号
+     * @return 商品ID，行号无效时返回-1
+     */
+    int productIdAt(int row) const;
+
+    /**
+     * @brief 获取商品所在的行
+     * @param productId 商品ID
+     * @return 行号，未找到或尚未加载时返回-1
+     */
+    int rowOfProduct(int productId) const;
+
+    /**
+     * @brief 设置每次fetchMore暴露的行数
+     * @param batchSize 批大小
+     */
+    void setFetchBatchSize(int batchSize);
+
+private:
+    /**
+     * @brief 移除不再存在的商品行（合并连续行为一次通知）
+     * @param keep 仍然存在的商品ID集合
+     */
+    void removeMissingRows(const QHash<int, Product*>& keep);
+
+    /**
+     * @brief 在指定行插入一段新增的商品ID（只对已暴露给视图的部分发出通知）
+     * @param row 插入位置
+     * @param productIds 新增的商品ID
+     */
+    void insertIds(int row, const QList<int>& productIds);
+
+    /**
+     * @brief 重建商品ID到行号的索引
+     * @param fromRow 起始行
+     */
+    void reindexFrom(int fromRow);
+
+    ProductManager* m_productManager;   ///< 商品管理器（非拥有）
+    QList<int> m_productIds;            ///< 全部商品ID（按显示顺序）
+    QHash<int, int> m_rowById;          ///< 商品ID到行号的索引
+    int m_loadedCount;                  ///< 已暴露给视图的行数
+    int m_fetchBatchSize;               ///< 每批加载的行数
+};
+
+#endif // PRODUCTLISTMODEL_H
@@ -2,10 +2,11 @@
 #include "../controllers/ProductManager.h"
 #include "../models/Product.h"
 #include "ProductDialog.h"
+#include "ProductListModel.h"
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
-#include <QListWidget>
+#include <QListView>
 #include <QPushButton>
 #include <QMessageBox>
 
@@ -26,7 +27,12 @@ void ProductManagementDialog::setupUi()
     setWindowTitle("商品管理");
     setMinimumSize(600, 400);
 
-    m_productListWidget = new QListWidget(this);
+    m_productListModel = new ProductListModel(m_productManager, this);
+    m_productListView = new QListView(this);
+    m_productListView->setModel(m_productListModel);
+    m_productListView->setUniformItemSizes(true);
+    m_productListView->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_productListView->setSelectionMode(QAbstractItemView::SingleSelection);
     m_addButton = new QPushButton("添加商品", this);
     m_editButton = new QPushButton("编辑商品", this);
     m_deleteButton = new QPushButton("删除商品", this);
@@ -40,7 +46,7 @@ void ProductManagementDialog::setupUi()
     buttonLayout->addWidget(m_closeButton);
 
     QVBoxLayout* mainLayout = new QVBoxLayout(this);
-    mainLayout->addWidget(m_productListWidget);
+    mainLayout->addWidget(m_productListView);
     mainLayout->addLayout(buttonLayout);
 
     setLayout(mainLayout);
@@ -68,18 +74,14 @@ void ProductManagementDialog::connectSignals()
 
 void ProductManagementDialog::refreshProductList()
 {
+    // 先用已缓存的商品立即填充列表，再异步刷新
+    m_productListModel->setProducts(m_productManager->searchProducts(QString()));
     m_productManager->getAllProducts();
 }
 
 void ProductManagementDialog::onAllProductsChanged(const QList<Product*>& products)
 {
-    m_productListWidget->clear();
-    for (Product* product : products) {
-        if (product) {
-             QListWidgetItem* item = new QListWidgetItem(product->getName(), m_productListWidget);
-             item->setData(Qt::UserRole, QVariant::fromValue(product->getProductId()));
-        }
-    }
+    m_productListModel->setProducts(products);
 }
 
 
@@ -96,13 +98,13 @@ void ProductManagementDialog::onAddProduct()
 
 void ProductManagementDialog::onEditProduct()
 {
-    QListWidgetItem* selectedItem = m_productListWidget->currentItem();
-    if (!selectedItem) {
+    QModelIndex selectedIndex = m_productListView->currentIndex();
+    if (!selectedIndex.isValid()) {
         QMessageBox::warning(this, "错误", "请先选择要编辑的商品");
         return;
     }
 
-    int productId = selectedItem->data(Qt::UserRole).toInt();
+    int productId = selectedIndex.data(ProductListModel::ProductIdRole).toInt();
     Product* product = m_productManager->getProductById(productId);
 
     if (product) {
@@ -121,14 +123,14 @@ void ProductManagementDialog::onEditProduct()
 
 void ProductManagementDialog::onDeleteProduct()
 {
-    QListWidgetItem* selectedItem = m_productListWidget->currentItem();
-    if (!selectedItem) {
+    QModelIndex selectedIndex = m_productListView->currentIndex();
+    if (!selectedIndex.isValid()) {
         QMessageBox::warning(this, "错误", "请先选择要删除的商品");
         return;
     }
     
-    int productId = selectedItem->data(Qt::UserRole).toInt();
-    QString productName = selectedItem->text();
+    int productId = selectedIndex.data(ProductListModel::ProductIdRole).toInt();
+    QString productName = selectedIndex.data(Qt::DisplayRole).toString();
 
 
     QMessageBox::StandardButton reply = QMessageBox::question(
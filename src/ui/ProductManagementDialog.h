@@ -6,7 +6,8 @@
 
 class Product;
 class ProductManager;
-class QListWidget;
+class QListView;
+class ProductListModel;
 class QPushButton;
 
 class ProductManagementDialog : public QDialog
@@ -32,7 +33,8 @@ private:
 
     ProductManager* m_productManager; // Non-owning pointer
 
-    QListWidget* m_productListWidget;
+    QListView* m_productListView;
+    ProductListModel* m_productListModel;
     QPushButton* m_addButton;
     QPushButton* m_editButton;
     QPushButton* m_deleteButton;
@@ -43,7 +43,7 @@ void RecommendationItemWidget::setupUi()
     layout->addWidget(m_nameLabel);
 
     // Product Price
-    m_priceLabel = new QLabel(QString("¥%1").arg(m_product->getPrice(), 0, 'f', 2), this);
+    m_priceLabel = new QLabel(QString("¥%1").arg(m_product->getPrice().toString()), this);
     m_priceLabel->setAlignment(Qt::AlignCenter);
     // m_priceLabel->setStyleSheet("font-weight: bold; color: #d32f2f;");
     layout->addWidget(m_priceLabel);
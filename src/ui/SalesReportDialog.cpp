@@ -67,8 +67,8 @@ void SalesReportDialog::populateTable(const QList<Sale*>& sales)
         row.append(new QStandardItem(sale->getTimestamp().toString("yyyy-MM-dd hh:mm:ss")));
         row.append(new QStandardItem(sale->getCashierName()));
         row.append(new QStandardItem(QString::number(sale->getTotalItemCount())));
-        row.append(new QStandardItem(QString::asprintf("%.2f", sale->getDiscountAmount())));
-        row.append(new QStandardItem(QString::asprintf("%.2f", sale->getFinalAmount())));
+        row.append(new QStandardItem(sale->getDiscountAmount().toString()));
+        row.append(new QStandardItem(sale->getFinalAmount().toString()));
 
         for (auto item : row) {
             item->setTextAlignment(Qt::AlignCenter);
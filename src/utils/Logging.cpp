@@ -0,0 +1,6 @@
+#include "Logging.h"
+
+Q_LOGGING_CATEGORY(lcSale, "smartpos.sale", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcCheckout, "smartpos.checkout", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcUi, "smartpos.ui", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcScanner, "smartpos.scanner", QtInfoMsg)
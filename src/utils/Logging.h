@@ -0,0 +1,30 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QLoggingCategory>
+
+/**
+ * @brief 日志分类
+ *
+ * 调试输出按模块分类，默认只输出info及以上级别，关闭的分类在调用处
+ * 只做一次开关判断，不会格式化任何参数。运行时可通过环境变量打开，例如：
+ * QT_LOGGING_RULES="smartpos.sale.debug=true"
+ */
+Q_DECLARE_LOGGING_CATEGORY(lcSale)      ///< smartpos.sale - 销售与购物车模型
+Q_DECLARE_LOGGING_CATEGORY(lcCheckout)  ///< smartpos.checkout - 收银流程
+Q_DECLARE_LOGGING_CATEGORY(lcUi)        ///< smartpos.ui - 主界面
+Q_DECLARE_LOGGING_CATEGORY(lcScanner)   ///< smartpos.scanner - 条码扫描
+
+/**
+ * @brief 热路径跟踪输出（每次扫描、每个购物车项目都会执行的位置）
+ *
+ * 默认在编译期整体移除；使用 -DSMARTPOS_TRACE_LOGGING=ON 配置后才编译进来，
+ * 之后与qCDebug一样受日志分类开关控制。
+ */
+#ifdef SMARTPOS_TRACE_LOGGING
+#define POS_TRACE(category) qCDebug(category)
+#else
+#define POS_TRACE(category) while (false) qCDebug(category)
+#endif
+
+#endif // LOGGING_H
@@ -0,0 +1,208 @@
+#include "ReceiptBatchExporter.h"
+#include "../database/DatabaseManager.h"
+#include "../utils/Logging.h"
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QPdfWriter>
+#include <QPainter>
+#include <QPageSize>
+#include <QFont>
+#include <QDir>
+#include <QFileInfo>
+#include <QThread>
+#include <QDebug>
+
+namespace {
+
+// PDF分辨率取254dpi，一个设备点正好是0.1mm，下面的尺寸都以0.1mm为单位
+constexpr int Resolution = 254;
+constexpr int PageWidth = 800;          // 80mm热敏纸
+constexpr int Margin = 40;
+constexpr int LineHeight = 38;
+constexpr int FontPixelSize = 30;
+constexpr int MaxLinesPerPage = 70;     // 约A4高度，超长小票分成多页
+
+struct LaidOutReceipt
+{
+    int transactionId = -1;
+    QDateTime timestamp;
+    QList<QStringList> pages;
+};
+
+LaidOutReceipt layoutReceipt(const ReceiptTemplate& layout, const ReceiptData& receipt)
+{
+    LaidOutReceipt result;
+    result.transactionId = receipt.transactionId;
+    result.timestamp = receipt.timestamp;
+
+    QString text;
+    layout.render(receipt, &text);
+    QStringList lines = text.split(QLatin1Char('\n'));
+    if (!lines.isEmpty() && lines.last().isEmpty()) {
+        lines.removeLast();
+    }
+    for (qsizetype first = 0; first < lines.size(); first += MaxLinesPerPage) {
+        result.pages.append(lines.mid(first, MaxLinesPerPage));
+    }
+    return result;
+}
+
+QPageSize pageSizeFor(int lineCount)
+{
+    const qreal heightMm = (2 * Margin + lineCount * LineHeight) / 10.0;
+    return QPageSize(QSizeF(PageWidth / 10.0, heightMm), QPageSize::Millimeter, QString(), QPageSize::ExactMatch);
+}
+
+QFont receiptFont()
+{
+    QFont font("Courier New");
+    font.setStyleHint(QFont::Monospace);
+    font.setPixelSize(FontPixelSize);
+    return font;
+}
+
+/**
+ * 把已排版的小票依次写入一个PDF，返回页数；失败返回-1
+ */
+int writePdf(const QString& filePath, const LaidOutReceipt* receipts, qsizetype count, QString* errorMessage)
+{
+    QPdfWriter writer(filePath);
+    writer.setResolution(Resolution);
+    writer.setCreator("SmartPOS");
+    writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+
+    QPainter painter;
+    int pages = 0;
+    for (qsizetype i = 0; i < count; ++i) {
+        for (const QStringList& page : receipts[i].pages) {
+            writer.setPageSize(pageSizeFor(page.size()));
+            if (pages == 0) {
+                if (!painter.begin(&writer)) {
+                    *errorMessage = QString("无法写入PDF文件: %1").arg(filePath);
+                    return -1;
+                }
+                painter.setFont(receiptFont());
+            } else {
+                writer.newPage();
+            }
+
+            int baseline = Margin + FontPixelSize;
+            for (const QString& line : page) {
+                painter.drawText(QPoint(Margin, baseline), line);
+                baseline += LineHeight;
+            }
+            ++pages;
+        }
+    }
+    if (pages > 0) {
+        painter.end();
+    }
+    return pages;
+}
+
+struct FileResult
+{
+    QString filePath;
+    int pages = 0;
+    QString errorMessage;
+};
+
+}
+
+ReceiptBatchExporter::ReceiptBatchExporter(QObject *parent)
+    : QObject(parent)
+{
+    m_template = ReceiptTemplate::compile(ReceiptTemplate::defaultTextSource(), ReceiptTemplate::PlainText);
+    m_pool.setMaxThreadCount(QThread::idealThreadCount());
+}
+
+void ReceiptBatchExporter::setStoreInfo(const StoreInfo& store)
+{
+    m_store = store;
+}
+
+void ReceiptBatchExporter::setMaxThreads(int threads)
+{
+    m_pool.setMaxThreadCount(qMax(1, threads));
+}
+
+ReceiptExportResult ReceiptBatchExporter::exportReceipts(QList<ReceiptData> receipts, const QString& outputPath, Mode mode)
+{
+    ReceiptExportResult result;
+    QElapsedTimer timer;
+    timer.start();
+
+    for (ReceiptData& receipt : receipts) {
+        receipt.store = m_store;
+    }
+    result.receiptCount = receipts.size();
+
+    if (mode == PerSale) {
+        if (!QDir().mkpath(outputPath)) {
+            result.errorMessage = QString("无法创建导出目录: %1").arg(outputPath);
+            return result;
+        }
+        const QDir dir(outputPath);
+        // 每笔交易独立排版并写文件，整个过程并行
+        const QList<FileResult> files = QtConcurrent::blockingMapped<QList<FileResult>>(&m_pool, receipts,
+            [this, &dir](const ReceiptData& receipt) {
+                const LaidOutReceipt laidOut = layoutReceipt(m_template, receipt);
+                FileResult file;
+                file.filePath = dir.filePath(QString("receipt_%1_%2.pdf")
+                                             .arg(receipt.transactionId)
+                                             .arg(receipt.timestamp.toString("yyyyMMdd_hhmmss")));
+                file.pages = writePdf(file.filePath, &laidOut, 1, &file.errorMessage);
+                return file;
+            });
+
+        for (const FileResult& file : files) {
+            if (file.pages < 0) {
+                if (result.errorMessage.isEmpty()) {
+                    result.errorMessage = file.errorMessage;
+                }
+                continue;
+            }
+            result.pageCount += file.pages;
+            result.files.append(file.filePath);
+        }
+    } else {
+        // 并行排版，然后按交易顺序写入同一个PDF
+        const QList<LaidOutReceipt> laidOut = QtConcurrent::blockingMapped<QList<LaidOutReceipt>>(&m_pool, receipts,
+            [this](const ReceiptData& receipt) {
+                return layoutReceipt(m_template, receipt);
+            });
+
+        if (!laidOut.isEmpty()) {
+            const QFileInfo info(outputPath);
+            QDir().mkpath(info.absolutePath());
+            const int pages = writePdf(outputPath, laidOut.constData(), laidOut.size(), &result.errorMessage);
+            if (pages >= 0) {
+                result.pageCount = pages;
+                result.files.append(outputPath);
+            }
+        }
+    }
+
+    result.seconds = timer.nsecsElapsed() / 1e9;
+    result.success = result.errorMessage.isEmpty();
+
+    qCInfo(lcUi) << "批量导出小票:" << result.receiptCount << "张," << result.pageCount << "页,"
+             << result.seconds << "秒," << result.pagesPerSecond() << "页/秒";
+    return result;
+}
+
+void ReceiptBatchExporter::exportDateRange(const QDateTime& startDate, const QDateTime& endDate,
+                                           const QString& outputPath, Mode mode)
+{
+    auto watcher = new QFutureWatcher<ReceiptExportResult>(this);
+    connect(watcher, &QFutureWatcher<ReceiptExportResult>::finished, this, [this, watcher]() {
+        emit exportFinished(watcher->result());
+        watcher->deleteLater();
+    });
+
+    // 外层任务在全局线程池中运行，排版和写PDF使用m_pool，不会互相占满
+    watcher->setFuture(QtConcurrent::run([this, startDate, endDate, outputPath, mode]() {
+        QList<ReceiptData> receipts = DatabaseManager::getInstance().getReceiptsByDateRange(startDate, endDate);
+        return exportReceipts(std::move(receipts), outputPath, mode);
+    }));
+}
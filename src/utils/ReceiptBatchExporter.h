@@ -0,0 +1,101 @@
+#ifndef RECEIPTBATCHEXPORTER_H
+#define RECEIPTBATCHEXPORTER_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QDateTime>
+#include <QThreadPool>
+#include "../receipt/ReceiptData.h"
+#include "../receipt/ReceiptTemplate.h"
+
+/**
+ * @brief 批量导出的结果
+ */
+struct ReceiptExportResult
+{
+    bool success = false;       ///< 是否全部成功
+    int receiptCount = 0;       ///< 导出的小票数
+    int pageCount = 0;          ///< 生成的PDF页数
+    double seconds = 0.0;       ///< 总耗时（秒）
+    QStringList files;          ///< 生成的PDF文件
+    QString errorMessage;       ///< 第一个错误
+
+    /**
+     * @brief 每秒生成的页数
+     */
+    double pagesPerSecond() const { return seconds > 0.0 ? pageCount / seconds : 0.0; }
+};
+
+/**
+ * @brief ReceiptBatchExporter类 - 日结小票批量PDF导出器
+ *
+ * 按时间范围从数据库取出小票快照，用预编译的文本版式排版成80mm宽的小票页，
+ * 写入一个分页的PDF或每笔交易一个PDF。与ReceiptPrinter::exportToPDF不同，
+ * 这里不创建QPrinter、不使用QTextDocument，也不打开PDF阅读器。
+ *
+ * 排版在工作线程中并行进行；每笔一个PDF时连写文件也并行，单个PDF只能顺序写入，
+ * 由调用线程按交易顺序输出已排好的页。
+ */
+class ReceiptBatchExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief 输出方式
+     */
+    enum Mode {
+        SingleDocument,     ///< 所有小票写入一个分页PDF（outputPath为文件）
+        PerSale             ///< 每笔交易一个PDF（outputPath为目录）
+    };
+
+    /**
+     * @brief 构造函数
+     * @param parent 父对象指针
+     */
+    explicit ReceiptBatchExporter(QObject *parent = nullptr);
+
+    /**
+     * @brief 设置印在每张小票上的店铺信息（须在导出开始前设置）
+     */
+    void setStoreInfo(const StoreInfo& store);
+
+    /**
+     * @brief 设置并行工作线程数（默认为CPU核数）
+     */
+    void setMaxThreads(int threads);
+
+    /**
+     * @brief 同步导出给定的小票（可在任意线程调用）
+     * @param receipts 小票快照
+     * @param outputPath PDF文件路径或输出目录
+     * @param mode 输出方式
+     * @return 导出结果
+     */
+    ReceiptExportResult exportReceipts(QList<ReceiptData> receipts, const QString& outputPath, Mode mode);
+
+    /**
+     * @brief 在后台导出时间范围内的全部小票，完成后发射exportFinished
+     * @param startDate 开始时间（含）
+     * @param endDate 结束时间（不含）
+     * @param outputPath PDF文件路径或输出目录
+     * @param mode 输出方式
+     */
+    void exportDateRange(const QDateTime& startDate, const QDateTime& endDate,
+                         const QString& outputPath, Mode mode);
+
+signals:
+    /**
+     * @brief 后台导出完成时发射的信号
+     * @param result 导出结果
+     */
+    void exportFinished(const ReceiptExportResult& result);
+
+private:
+    ReceiptTemplate m_template;     ///< 预编译的纯文本版式
+    StoreInfo m_store;              ///< 店铺信息
+    QThreadPool m_pool;             ///< 排版和写PDF的线程池
+};
+
+#endif // RECEIPTBATCHEXPORTER_H
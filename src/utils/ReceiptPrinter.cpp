@@ -1,10 +1,12 @@
 #include "ReceiptPrinter.h"
 #include "../database/DatabaseManager.h"
+#include "../receipt/ThermalPrintSpooler.h"
 
 ReceiptPrinter::ReceiptPrinter(QObject *parent)
     : QObject(parent)
     , m_printerType(ThermalPrinter)
     , m_printer(nullptr)
+    , m_thermalSpooler(nullptr)
     , m_storeName("智能超市")
     , m_storeAddress("北京市朝阳区科技大街123号")
     , m_storePhone("400-123-4567")
@@ -12,6 +14,20 @@ ReceiptPrinter::ReceiptPrinter(QObject *parent)
     , m_footerText("谢谢惠顾，欢迎再次光临！")
 {
     setupPrinter();
+
+    // 版式只编译一次，之后每张小票只填充字段
+    m_htmlTemplate = ReceiptTemplate::compile(ReceiptTemplate::defaultHtmlSource(), ReceiptTemplate::Html);
+    m_textTemplate = ReceiptTemplate::compile(ReceiptTemplate::defaultTextSource(), ReceiptTemplate::PlainText);
+
+    // 默认不设打印设备，调用setThermalDevice后热敏小票才写入设备
+    m_thermalSpooler = new ThermalPrintSpooler(QString(), this);
+    connect(m_thermalSpooler, &ThermalPrintSpooler::jobCompleted, this, [this]() {
+        emit printFinished(true);
+    });
+    connect(m_thermalSpooler, &ThermalPrintSpooler::jobFailed, this, [this](int, const QString &error) {
+        emit printError(error);
+        emit printFinished(false);
+    });
 }
 
 void ReceiptPrinter::setupPrinter()
@@ -33,9 +49,16 @@ void ReceiptPrinter::setupPrinter()
 
 bool ReceiptPrinter::printReceipt(const Sale &sale, const QList<SaleItem*> &items)
 {
+    if (m_printerType == ThermalPrinter && !thermalDevice().isEmpty()) {
+        // 界面线程只生成快照，ESC/POS渲染和设备写入在打印线程完成，结果通过printFinished通知
+        emit printStarted();
+        m_thermalSpooler->enqueue(ReceiptData::fromSale(sale, storeInfo()));
+        return true;
+    }
+
     // 简化版本：只输出到调试信息
     qDebug() << "打印收据（模拟）:";
-    qDebug() << "总金额:" << sale.getTotalAmount();
+    qDebug() << "总金额:" << sale.getTotalAmount().toString();
     qDebug() << "商品数量:" << items.size();
     
     // 在实际项目中，这里会生成PDF或打印到打印机
@@ -43,6 +66,23 @@ bool ReceiptPrinter::printReceipt(const Sale &sale, const QList<SaleItem*> &item
     return true;
 }
 
+bool ReceiptPrinter::reprintText(const QString &receiptText)
+{
+    if (receiptText.isEmpty()) {
+        emit printError("没有可补打的小票内容");
+        return false;
+    }
+    if (m_printerType == ThermalPrinter && !thermalDevice().isEmpty()) {
+        emit printStarted();
+        m_thermalSpooler->enqueueText(receiptText);
+        return true;
+    }
+
+    qDebug().noquote() << "补打小票（模拟）:\n" << receiptText;
+    emit printFinished(true);
+    return true;
+}
+
 bool ReceiptPrinter::exportToPDF(const Sale &sale, const QList<SaleItem> &items, const QString &fileName)
 {
     QString documentsPath = QStandardPaths::writableLocation(QStandardPaths::DocumentsLocation);
@@ -80,141 +120,29 @@ bool ReceiptPrinter::exportToPDF(const Sale &sale, const QList<SaleItem> &items,
 
 QString ReceiptPrinter::generateReceiptHTML(const Sale &sale, const QList<SaleItem> &items)
 {
-    QString html;
-    html += "<html><head><meta charset='UTF-8'></head><body>";
-    html += "<div style='font-family: \"Courier New\", monospace; font-size: 12px; line-height: 1.2;'>";
-    
-    // 店铺信息
-    html += "<div style='text-align: center; margin-bottom: 10px;'>";
-    html += QString("<h2 style='margin: 0;'>%1</h2>").arg(m_storeName);
-    html += QString("<div>%1</div>").arg(m_storeAddress);
-    html += QString("<div>电话: %1</div>").arg(m_storePhone);
-    html += "</div>";
-    
-    // 分隔线
-    html += "<div style='text-align: center; margin: 10px 0;'>";
-    html += repeatChar('=', 40);
-    html += "</div>";
-    
-    // 小票信息
-    html += "<div style='margin-bottom: 10px;'>";
-    html += QString("<div>小票号: %1</div>").arg(sale.getTransactionId());
-    html += QString("<div>收银员: %1</div>").arg(sale.getCashierName());
-    html += QString("<div>时间: %1</div>").arg(formatDateTime(sale.getTimestamp()));
-    html += "</div>";
-    
-    // 商品列表
-    html += "<div style='margin: 10px 0;'>";
-    html += repeatChar('-', 40);
-    html += "</div>";
-    
-    html += "<table style='width: 100%; border-collapse: collapse;'>";
-    html += "<tr style='border-bottom: 1px solid #ccc;'>";
-    html += "<th style='text-align: left; padding: 2px;'>商品</th>";
-    html += "<th style='text-align: center; padding: 2px;'>数量</th>";
-    html += "<th style='text-align: right; padding: 2px;'>单价</th>";
-    html += "<th style='text-align: right; padding: 2px;'>小计</th>";
-    html += "</tr>";
-    
-    for (const SaleItem& item : items) {
-        // 获取商品信息直接从SaleItem
-        Product* product = item.getProduct();
-        
-        html += "<tr>";
-        html += QString("<td style='padding: 2px;'>%1</td>").arg(product ? product->getName() : "未知商品");
-        html += QString("<td style='text-align: center; padding: 2px;'>%1</td>").arg(item.getQuantity());
-        html += QString("<td style='text-align: right; padding: 2px;'>%1</td>").arg(formatCurrency(item.getUnitPrice()));
-        html += QString("<td style='text-align: right; padding: 2px;'>%1</td>").arg(formatCurrency(item.getSubtotal()));
-        html += "</tr>";
-    }
-    
-    html += "</table>";
-    
-    // 合计信息
-    html += "<div style='margin: 10px 0;'>";
-    html += repeatChar('-', 40);
-    html += "</div>";
-    
-    html += "<div style='text-align: right; margin: 5px 0;'>";
-    html += QString("<div>商品总数: %1 件</div>").arg(items.size());
-    html += QString("<div style='font-size: 14px; font-weight: bold;'>总金额: %1</div>").arg(formatCurrency(sale.getTotalAmount()));
-    
-    if (sale.getDiscountAmount() > 0) {
-        html += QString("<div>优惠金额: -%1</div>").arg(formatCurrency(sale.getDiscountAmount()));
-        html += QString("<div style='font-size: 14px; font-weight: bold;'>实付金额: %1</div>").arg(formatCurrency(sale.getTotalAmount() - sale.getDiscountAmount()));
-    }
-    html += "</div>";
-    
-    // 支付信息
-    html += "<div style='margin: 10px 0;'>";
-    html += QString("<div>支付方式: %1</div>").arg(sale.getPaymentMethod());
-    html += "</div>";
-    
-    // 页脚
-    html += "<div style='text-align: center; margin-top: 20px;'>";
-    html += repeatChar('=', 40);
-    html += QString("<div style='margin: 10px 0;'>%1</div>").arg(m_footerText);
-    html += "<div style='font-size: 10px;'>www.smartpos.com</div>";
-    html += "</div>";
-    
-    html += "</div></body></html>";
-    
-    return html;
+    return m_htmlTemplate.render(snapshot(sale, items));
 }
 
 QString ReceiptPrinter::generateReceiptText(const Sale &sale, const QList<SaleItem> &items)
 {
-    QString text;
-    
-    // 店铺信息
-    text += centerText(m_storeName) + "\n";
-    text += centerText(m_storeAddress) + "\n";
-    text += centerText(QString("电话: %1").arg(m_storePhone)) + "\n";
-    text += repeatChar('=', 40) + "\n";
-    
-    // 小票信息
-    text += QString("小票号: %1\n").arg(sale.getTransactionId());
-    text += QString("收银员: %1\n").arg(sale.getCashierName());
-    text += QString("时间: %1\n").arg(formatDateTime(sale.getTimestamp()));
-    text += repeatChar('-', 40) + "\n";
-    
-    // 商品列表表头
-    text += padRight("商品", 20) + padRight("数量", 6) + padRight("单价", 8) + "小计\n";
-    text += repeatChar('-', 40) + "\n";
-    
-    // auto& db = DatabaseManager::getInstance(); // Not needed for this implementation
+    return m_textTemplate.render(snapshot(sale, items));
+}
+
+ReceiptData ReceiptPrinter::snapshot(const Sale &sale, const QList<SaleItem> &items) const
+{
+    ReceiptData data = ReceiptData::fromSale(sale, storeInfo());
+
+    // 以调用方传入的商品行为准
+    data.lines.clear();
+    data.totalQuantity = 0;
+    data.lines.reserve(items.size());
     for (const SaleItem& item : items) {
         Product* product = item.getProduct();
-        
-        QString name = product ? product->getName() : "未知商品";
-        if (name.length() > 18) {
-            name = name.left(18) + "..";
-        }
-        
-        text += padRight(name, 20);
-        text += padRight(QString::number(item.getQuantity()), 6);
-        text += padRight(formatCurrency(item.getUnitPrice()), 8);
-        text += formatCurrency(item.getSubtotal()) + "\n";
+        data.lines.append(ReceiptLine{product ? product->getName() : QString("未知商品"),
+                                      item.getQuantity(), item.getUnitPrice(), item.getSubtotal()});
+        data.totalQuantity += item.getQuantity();
     }
-    
-    // 合计信息
-    text += repeatChar('-', 40) + "\n";
-    text += padRight(QString("商品总数: %1 件").arg(items.size()), 25);
-    text += QString("总金额: %1\n").arg(formatCurrency(sale.getTotalAmount()));
-    
-    if (sale.getDiscountAmount() > 0) {
-        text += padRight("优惠金额:", 25) + QString("-%1\n").arg(formatCurrency(sale.getDiscountAmount()));
-        text += padRight("实付金额:", 25) + QString("%1\n").arg(formatCurrency(sale.getTotalAmount() - sale.getDiscountAmount()));
-    }
-    
-    text += QString("支付方式: %1\n").arg(sale.getPaymentMethod());
-    
-    // 页脚
-    text += repeatChar('=', 40) + "\n";
-    text += centerText(m_footerText) + "\n";
-    text += centerText("www.smartpos.com") + "\n";
-    
-    return text;
+    return data;
 }
 
 void ReceiptPrinter::setPrinterType(PrinterType type)
@@ -235,36 +163,28 @@ void ReceiptPrinter::setStoreInfo(const QString &name, const QString &address, c
     m_storePhone = phone;
 }
 
-void ReceiptPrinter::onPrintFinished()
+StoreInfo ReceiptPrinter::storeInfo() const
 {
-    emit printFinished(true);
+    StoreInfo info;
+    info.name = m_storeName;
+    info.address = m_storeAddress;
+    info.phone = m_storePhone;
+    info.footer = m_footerText;
+    return info;
 }
 
-QString ReceiptPrinter::formatCurrency(double amount) const
+void ReceiptPrinter::setThermalDevice(const QString &devicePath, int columns)
 {
-    return QString("¥%1").arg(amount, 0, 'f', 2);
+    m_thermalSpooler->setDevicePath(devicePath);
+    m_thermalSpooler->setColumns(columns);
 }
 
-QString ReceiptPrinter::formatDateTime(const QDateTime &dateTime) const
+QString ReceiptPrinter::thermalDevice() const
 {
-    return dateTime.toString("yyyy-MM-dd hh:mm:ss");
+    return m_thermalSpooler->devicePath();
 }
 
-QString ReceiptPrinter::centerText(const QString &text, int width) const
-{
-    if (text.length() >= width) return text;
-    
-    int padding = (width - text.length()) / 2;
-    return QString(padding, ' ') + text + QString(width - text.length() - padding, ' ');
-}
-
-QString ReceiptPrinter::padRight(const QString &text, int width) const
-{
-    if (text.length() >= width) return text.left(width);
-    return text + QString(width - text.length(), ' ');
-}
-
-QString ReceiptPrinter::repeatChar(char ch, int count) const
+void ReceiptPrinter::onPrintFinished()
 {
-    return QString(count, ch);
+    emit printFinished(true);
 }
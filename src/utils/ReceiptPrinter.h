@@ -18,6 +18,10 @@
 #include "../models/Sale.h"
 #include "../models/SaleItem.h"
 #include "../models/Product.h"
+#include "../receipt/ReceiptData.h"
+#include "../receipt/ReceiptTemplate.h"
+
+class ThermalPrintSpooler;
 
 class ReceiptPrinter : public QObject
 {
@@ -36,12 +40,21 @@ public:
     // 打印小票
     bool printReceipt(const Sale &sale, const QList<SaleItem*> &items);
     
+    // 补打已排好版的小票文本（来自电子存根）
+    bool reprintText(const QString &receiptText);
+    
     // 设置打印机类型
     void setPrinterType(PrinterType type);
     PrinterType getPrinterType() const;
     
     // 设置商店信息
     void setStoreInfo(const QString &name, const QString &address, const QString &phone);
+    StoreInfo storeInfo() const;
+    
+    // 设置热敏打印设备（打印机设备文件、命名管道或本地文件），未设置时热敏小票只输出到调试信息。
+    // 主窗口从配置项 printer/thermalDevice 和 printer/thermalColumns 读取
+    void setThermalDevice(const QString &devicePath, int columns = 48);
+    QString thermalDevice() const;
     
     // 导出小票为PDF
     bool exportToPDF(const Sale &sale, const QList<SaleItem> &items, const QString &fileName = QString());
@@ -62,14 +75,13 @@ private slots:
 
 private:
     void setupPrinter();
-    QString formatCurrency(double amount) const;
-    QString formatDateTime(const QDateTime &dateTime) const;
-    QString centerText(const QString &text, int width = 40) const;
-    QString padRight(const QString &text, int width) const;
-    QString repeatChar(char ch, int count) const;
+    ReceiptData snapshot(const Sale &sale, const QList<SaleItem> &items) const;
 
     PrinterType m_printerType;
     QPrinter *m_printer;
+    ThermalPrintSpooler *m_thermalSpooler;  // 热敏小票在打印线程中生成和写入
+    ReceiptTemplate m_htmlTemplate;         // 预编译的PDF小票版式
+    ReceiptTemplate m_textTemplate;         // 预编译的纯文本小票版式
     
     // 商店信息
     QString m_storeName;
@@ -53,6 +53,8 @@ private slots:
     void testAddItemToSale();
     void testCartDisplay();
     void testPaymentProcess();
+    void testPromotionWithPercentageDiscount();
+    void testSaleLinesByProductAndPrice();
     
     // 条码扫描测试
     void testBarcodeScanner();
@@ -418,6 +420,51 @@ void DebugGUITest::testCartDisplay()
     }
 }
 
+void DebugGUITest::testPromotionWithPercentageDiscount()
+{
+    qDebug() << "测试: 促销与百分比折扣叠加";
+
+    Product product(9001, "6900000009001", "测试商品", QString(), Money::fromMinorUnits(1000), 100, QString());
+    Sale sale;
+    sale.addItem(&product, 10);
+    QCOMPARE(sale.getTotalAmount(), Money::fromMinorUnits(10000));
+
+    // 促销优惠20元后再打九折：折扣按80元计算
+    sale.setPromotionDiscount(Money::fromMinorUnits(2000));
+    sale.applyPercentageDiscount(10.0);
+    QCOMPARE(sale.getDiscountAmount(), Money::fromMinorUnits(800));
+    QCOMPARE(sale.getFinalAmount(), Money::fromMinorUnits(7200));
+
+    // 固定折扣不能超过促销后的金额
+    QVERIFY(!sale.applyFixedDiscount(Money::fromMinorUnits(9000)));
+    QCOMPARE(sale.getDiscountAmount(), Money::fromMinorUnits(800));
+}
+
+void DebugGUITest::testSaleLinesByProductAndPrice()
+{
+    qDebug() << "测试: 购物车按商品和单价合并行";
+
+    Product first(9101, "6900000009101", "商品A", QString(), Money::fromMinorUnits(500), 100, QString());
+    Product second(9102, "6900000009102", "商品B", QString(), Money::fromMinorUnits(300), 100, QString());
+    Sale sale;
+    sale.addItem(&first, 1);
+    sale.addItem(&second, 1);
+    sale.addItem(&first, 2, Money::fromMinorUnits(450));
+    sale.addItem(&first, 1);
+
+    // 相同单价合并，不同单价另起一行
+    QCOMPARE(sale.itemCount(), 3);
+    QCOMPARE(sale.itemAt(0)->getQuantity(), 2);
+    QCOMPARE(sale.quantityOfProduct(first.getProductId()), 4);
+
+    // 移除第一行后，后面的行号前移，商品A的索引指向剩下的那一行
+    QVERIFY(sale.removeItem(0));
+    QCOMPARE(sale.indexOfProduct(second.getProductId()), 0);
+    QCOMPARE(sale.indexOfProduct(first.getProductId()), 1);
+    QCOMPARE(sale.quantityOfProduct(first.getProductId()), 2);
+    QCOMPARE(sale.getTotalAmount(), Money::fromMinorUnits(300 + 900));
+}
+
 void DebugGUITest::testPaymentProcess()
 {
     qDebug() << "测试: 支付流程";
@@ -132,7 +132,7 @@ void TestGUIInterface::addTestData()
     testProduct1->setBarcode(QString("TEST%1001").arg(testCounter));
     testProduct1->setName("测试商品1");
     testProduct1->setDescription("这是一个测试商品");
-    testProduct1->setPrice(12.50);
+    testProduct1->setPrice(Money::fromMinorUnits(1250));
     testProduct1->setStockQuantity(100);
     testProduct1->setCategory("测试分类");
     
@@ -140,7 +140,7 @@ void TestGUIInterface::addTestData()
     testProduct2->setBarcode(QString("TEST%1002").arg(testCounter));
     testProduct2->setName("测试商品2");
     testProduct2->setDescription("这是第二个测试商品");
-    testProduct2->setPrice(25.00);
+    testProduct2->setPrice(Money::fromMinorUnits(2500));
     testProduct2->setStockQuantity(50);
     testProduct2->setCategory("测试分类");
     